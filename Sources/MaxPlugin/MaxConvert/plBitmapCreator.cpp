@@ -47,7 +47,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "plGImage/plMipmap.h"
 #include "hsExceptionStack.h"
-#include "plGImage/hsCodecManager.h"
+#include "plGImage/hsDXTSoftwareCodec.h"
 
 #include "plBitmapCreator.h"
 
@@ -236,7 +236,8 @@ plMipmap *plBitmapCreator::ICreateBitmap(plBitmapData *bd)
 
     if (!(bd->texFlags & plMipmap::kForceNonCompressed) && !bd->usePNG)
         {
-            plMipmap *compressed = hsCodecManager::Instance().CreateCompressedMipmap(plMipmap::kDirectXCompression, hBitmap);
+            // Export happens once, so take the slower but better endpoint fit
+            plMipmap *compressed = hsDXTSoftwareCodec::Instance().CreateCompressedMipmap(hBitmap, hsDXTSoftwareCodec::kQualityHigh);
 
             if (compressed)
             {
@@ -1666,6 +1666,7 @@ bool plClient::IUpdate()
     //plCaptureRender::Update(fPipeline);
     plCaptureRender::Update();
     cyMisc::Update(currTime);
+    PythonInterface::FlushOutput();
 
     // This TimeMsg doesn't really do much, except somehow it flushes the dispatch
     // after the NetClientMgr updates, delivering any SelfDestruct messages in the
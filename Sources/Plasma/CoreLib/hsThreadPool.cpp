@@ -0,0 +1,172 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "hsThreadPool.h"
+#include "hsThread.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+hsThreadPool::hsThreadPool(size_t numWorkers, const ST::string& name)
+    : fQuit(false)
+{
+    fWorkers.reserve(numWorkers);
+    for (size_t i = 0; i < numWorkers; ++i)
+        fWorkers.emplace_back(hsThread::StartSimpleThread([this, name] { IWorkerProc(name); }));
+}
+
+hsThreadPool::~hsThreadPool()
+{
+    {
+        hsLockGuard(fMutex);
+        fQuit = true;
+    }
+    fCondition.notify_all();
+
+    for (std::thread& worker : fWorkers)
+        worker.join();
+}
+
+hsThreadPool& hsThreadPool::Instance()
+{
+    // Leave a core for the main thread, which usually ends up waiting on us
+    // in ParallelFor anyway.
+    static hsThreadPool sInstance(std::max(std::thread::hardware_concurrency(), 2U) - 1);
+    return sInstance;
+}
+
+std::future<void> hsThreadPool::Submit(Task task)
+{
+    // std::function must be copyable, std::packaged_task is not...
+    auto packaged = std::make_shared<std::packaged_task<void()>>(std::move(task));
+    std::future<void> result = packaged->get_future();
+
+    if (fWorkers.empty()) {
+        (*packaged)();
+        return result;
+    }
+
+    {
+        hsLockGuard(fMutex);
+        fTasks.emplace_back([packaged] { (*packaged)(); });
+    }
+    fCondition.notify_one();
+    return result;
+}
+
+void hsThreadPool::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& func)
+{
+    if (count == 0)
+        return;
+
+    grainSize = std::max<size_t>(grainSize, 1);
+    const size_t numChunks = (count + grainSize - 1) / grainSize;
+    if (numChunks == 1 || fWorkers.empty()) {
+        for (size_t begin = 0; begin < count; begin += grainSize)
+            func(begin, std::min(begin + grainSize, count));
+        return;
+    }
+
+    // Helpers that are still queued when we finish will find nothing left
+    // to claim, so they must not touch anything on our stack but this.
+    struct Range
+    {
+        std::atomic<size_t>     fNext;
+        size_t                  fDone;
+        std::mutex              fMutex;
+        std::condition_variable fCondition;
+    };
+    auto range = std::make_shared<Range>();
+    range->fNext = 0;
+    range->fDone = 0;
+
+    auto drain = [range, numChunks, count, grainSize, &func] {
+        size_t finished = 0;
+        for (size_t chunk = range->fNext++; chunk < numChunks; chunk = range->fNext++) {
+            size_t begin = chunk * grainSize;
+            func(begin, std::min(begin + grainSize, count));
+            ++finished;
+        }
+
+        if (finished) {
+            hsLockGuard(range->fMutex);
+            range->fDone += finished;
+            if (range->fDone == numChunks)
+                range->fCondition.notify_all();
+        }
+    };
+
+    const size_t numHelpers = std::min(numChunks - 1, fWorkers.size());
+    {
+        hsLockGuard(fMutex);
+        for (size_t i = 0; i < numHelpers; ++i)
+            fTasks.emplace_back(drain);
+    }
+    if (numHelpers == 1)
+        fCondition.notify_one();
+    else
+        fCondition.notify_all();
+
+    drain();
+
+    std::unique_lock<std::mutex> lock(range->fMutex);
+    range->fCondition.wait(lock, [&range, numChunks] { return range->fDone == numChunks; });
+}
+
+void hsThreadPool::IWorkerProc(const ST::string& name)
+{
+    hsThread::SetThisThreadName(name);
+
+    for (;;) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(fMutex);
+            fCondition.wait(lock, [this] { return fQuit || !fTasks.empty(); });
+            if (fTasks.empty())
+                return;
+            task = std::move(fTasks.front());
+            fTasks.pop_front();
+        }
+        task();
+    }
+}
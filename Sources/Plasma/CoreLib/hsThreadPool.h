@@ -0,0 +1,100 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+#ifndef hsThreadPool_Defined
+#define hsThreadPool_Defined
+
+#include "HeadSpin.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <string_theory/string>
+
+//////////////////////////////////////////////////////////////////////////////
+// A fixed set of worker threads servicing a FIFO of tasks.
+//
+// Most code should just use hsThreadPool::Instance(), which is started on
+// first use with one worker per spare hardware thread. Work that has to
+// finish before the caller can continue goes through ParallelFor, which
+// has the calling thread pick up chunks too -- so it is safe to call from
+// inside another task.
+
+class hsThreadPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    explicit hsThreadPool(size_t numWorkers, const ST::string& name = ST_LITERAL("hsThreadPool"));
+    ~hsThreadPool();
+
+    hsThreadPool(const hsThreadPool&) = delete;
+    hsThreadPool& operator=(const hsThreadPool&) = delete;
+
+    static hsThreadPool& Instance();
+
+    size_t GetNumWorkers() const { return fWorkers.size(); }
+
+    // Queue up a task to run on one of the workers. The returned future
+    // becomes ready when the task has finished.
+    std::future<void> Submit(Task task);
+
+    // Calls func(begin, end) for consecutive ranges of at most grainSize
+    // items covering [0, count), and returns once all of them are done.
+    // Ranges are handed out in order, but may complete in any order.
+    void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& func);
+
+private:
+    void IWorkerProc(const ST::string& name);
+
+    std::vector<std::thread>    fWorkers;
+    std::deque<Task>            fTasks;
+    std::mutex                  fMutex;
+    std::condition_variable     fCondition;
+    bool                        fQuit;
+};
+
+#endif
@@ -427,6 +427,16 @@ PF_CONSOLE_CMD(Audio, SetStreamFromRAMCutoff, "float cutoffInSecs", "Sets the cu
     PrintString( "Changes won't take effect until you restart the audio system." );
 }
 
+PF_CONSOLE_CMD(Audio, SetDecodedCacheBudget, "int megabytes", "Sets how much decoded sound data is kept for sounds that aren't playing.")
+{
+    plgAudioSys::SetDecodedCacheBudget( (size_t)(int)params[ 0 ] * 1024 * 1024 );
+}
+
+PF_CONSOLE_CMD(Audio, ShowDecodedCacheStats, "", "Prints how much decoded sound data is being kept and how often it's reused.")
+{
+    PrintString( plgAudioSys::GetDecodedCacheStats() );
+}
+
 PF_CONSOLE_CMD(Audio, SetPriorityCutoff, "int cutoff", "Stops sounds from loading whose priority is greater than this cutoff.")
 {
     plgAudioSys::SetPriorityCutoff( (int)params[ 0 ] );
@@ -133,7 +133,9 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plParticleSystem/plParticleEffect.h"
 #include "plParticleSystem/plParticleGenerator.h"
 #include "plParticleSystem/plParticleSystem.h"
+#include "plPhysX/plPXPhysical.h"
 #include "plPhysX/plPXPhysicalControllerCore.h"
+#include "plPhysX/plPXSimulation.h"
 #include "plPhysX/plSimulationMgr.h"
 #include "plPhysical/plPhysicalSDLModifier.h"
 #include "plPipeline/plDebugText.h"
@@ -145,6 +147,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plResMgr/plResManager.h"
 #include "plResMgr/plResManagerHelper.h"
 #include "plResMgr/plResMgrSettings.h"
+#include "plResMgr/plRegistryHelpers.h"
+#include "plResMgr/plRegistryNode.h"
 #include "plScene/plPageTreeMgr.h"
 #include "plScene/plPostEffectMod.h"
 #include "plScene/plSceneNode.h"
@@ -171,6 +175,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "pfMessage/pfKIMsg.h"
 #include "pfPython/cyMisc.h"
 #include "pfPython/cyPythonInterface.h"
+#include "pfPython/plPythonProfiler.h"
 #include "pfPython/plPythonSDLModifier.h"
 #include "pfSurface/plFadeOpacityMod.h"
 #include "pfSurface/plGrabCubeMap.h"
@@ -5066,6 +5071,103 @@ PF_CONSOLE_CMD(Physics,
     plSimulationMgr::GetInstance()->ResetKickables();
 }
 
+PF_CONSOLE_CMD(Physics,
+               PrewarmMeshCache,
+               "string age",
+               "Cooks the physics meshes of every page in an Age into the on-disk mesh cache")
+{
+    plPXMeshCache* cache = plSimulationMgr::GetInstance()->GetPhysX()->GetMeshCache();
+    if (!cache) {
+        PrintString("The mesh cache is not available");
+        return;
+    }
+
+    class plAgePageCollector : public plRegistryPageIterator
+    {
+        ST::string fAge;
+
+    public:
+        std::vector<plRegistryPageNode*> fPages;
+
+        plAgePageCollector(ST::string age) : fAge(std::move(age)) { }
+
+        bool EatPage(plRegistryPageNode* page) override
+        {
+            if (page->GetPageInfo().GetAge().compare_i(fAge) == 0)
+                fPages.push_back(page);
+            return true;
+        }
+    };
+
+    ST::string age = params[0];
+    plResManager* resMgr = (plResManager*)hsgResMgr::ResMgr();
+    plAgePageCollector pages(age);
+    resMgr->IterateAllPages(&pages);
+
+    size_t numMeshes = 0;
+    for (plRegistryPageNode* page : pages.fPages) {
+        bool wasLoaded = page->IsFullyLoaded();
+        resMgr->LoadPageKeys(page);
+
+        {
+            std::set<plKey> keys;
+            plKeyCollector collector(keys);
+            page->IterateKeys(&collector, CLASS_INDEX_SCOPED(plPXPhysical));
+
+            hsStream* stream = page->OpenStream();
+            if (stream) {
+                for (const plKey& key : keys) {
+                    plKeyImp* imp = plKeyImp::GetFromKey(key);
+                    stream->SetPosition(imp->GetStartPos());
+                    stream->ReadLE16(); // class index
+                    if (plPXPhysical::PrewarmMeshCache(stream))
+                        numMeshes++;
+                }
+                page->CloseStream();
+            }
+        }
+
+        // Don't leave behind keys for pages that weren't loaded to begin with
+        if (!wasLoaded)
+            resMgr->DumpUnusedKeys(page);
+    }
+
+    PrintString(ST::format("Cached {} meshes from {} pages, cache is now {}", numMeshes,
+                           pages.fPages.size(), plFileSystem::ConvertFileSize(cache->GetSize())));
+}
+
+PF_CONSOLE_CMD(Physics,
+               SetSubStepBudget,
+               "float ms",
+               "Sets how many milliseconds per frame may be spent simulating physics substeps individually")
+{
+    float ms = params[0];
+    plSimulationMgr::GetInstance()->GetPhysX()->SetSubStepBudget(ms / 1000.f);
+}
+
+PF_CONSOLE_CMD(Physics,
+               LogSubworldStats,
+               "",
+               "Writes how active each subworld has been to Simulation.log")
+{
+    plSimulationMgr::GetInstance()->GetPhysX()->LogWorldStats();
+}
+
+PF_CONSOLE_CMD(Physics,
+               Benchmark,
+               "",
+               "Toggle recording physics step times, written to Simulation.log when stopped")
+{
+    plPXSimulation* sim = plSimulationMgr::GetInstance()->GetPhysX();
+    if (sim->IsBenchmarking()) {
+        sim->EndBenchmark();
+        PrintString("Physics benchmark stopped, see Simulation.log");
+    } else {
+        sim->BeginBenchmark();
+        PrintString("Physics benchmark started");
+    }
+}
+
 #endif // LIMIT_CONSOLE_COMMANDS
 
 
@@ -6074,6 +6176,55 @@ PF_CONSOLE_CMD( Python,
     PrintString(PythonInterface::getOutputAndReset());
 }
 
+PF_CONSOLE_CMD( Python,
+                ShowScriptStats,
+                "...",
+                "Lists the script handlers that have taken the most time (default 10)" )
+{
+    int count = numParams > 0 ? static_cast<const ST::string&>(params[0]).to_int(10) : 10;
+    std::vector<ST::string> lines = plPythonProfiler::Instance().GetTopHandlers(std::max(count, 1));
+    if (lines.empty())
+        PrintString("No script handlers have run");
+    for (const ST::string& line : lines)
+        PrintString(line);
+}
+
+PF_CONSOLE_CMD( Python,
+                ResetScriptStats,
+                "",
+                "Clears the script handler call counts and timings" )
+{
+    plPythonProfiler::Instance().ResetStats();
+    PrintString("Script stats reset");
+}
+
+PF_CONSOLE_CMD( Python,
+                StartSampling,
+                "...",
+                "Starts sampling the Python call stacks every n milliseconds (default 1)" )
+{
+    int interval = numParams > 0 ? static_cast<const ST::string&>(params[0]).to_int(10) : 1;
+    plPythonProfiler::Instance().StartSampling(std::max(interval, 1));
+    PrintString(ST::format("Sampling Python every {} ms", std::max(interval, 1)));
+}
+
+PF_CONSOLE_CMD( Python,
+                StopSampling,
+                "",
+                "Stops sampling and writes the collapsed stacks to the log folder" )
+{
+    if (!plPythonProfiler::Instance().IsSampling()) {
+        PrintString("Not sampling");
+        return;
+    }
+
+    plFileName path = plPythonProfiler::Instance().StopSampling();
+    if (path.IsValid())
+        PrintString(ST::format("Stacks written to {}", path));
+    else
+        PrintString("Couldn't write the stacks out");
+}
+
 #endif // LIMIT_CONSOLE_COMMANDS
 
 
@@ -387,6 +387,7 @@ protected:
     hsGDeviceRef    *MakeTextureRef( plLayerInterface* layer, plMipmap *b );
     void            IReloadTexture( plDXTextureRef *ref );
     void            IFillD3DTexture( plDXTextureRef *ref );
+    bool            IRefillTextureRegion( plDXTextureRef *ref, plMipmap *b );
     void            IFillD3DCubeTexture( plDXCubeTextureRef *ref );
     void            IGetD3DTextureFormat( plBitmap *b, D3DFORMAT &formatType, uint32_t& texSize );
     void            IFormatTextureData( uint32_t formatType, uint32_t numPix, hsRGBAColor32* const src, void *dst );
@@ -402,12 +403,6 @@ protected:
     void            IMakeOcclusionSnap();
 
     bool            IAvatarSort(plDrawableSpans* d, const std::vector<int16_t>& visList);
-    void            IBlendVertsIntoBuffer( plSpan* span, 
-                                            hsMatrix44* matrixPalette, int numMatrices,
-                                            const uint8_t *src, uint8_t format, uint32_t srcStride, 
-                                            uint8_t *dest, uint32_t destStride, uint32_t count, uint16_t localUVWChans )
-                                                { blend_vert_buffer.call(span, matrixPalette, numMatrices, src, format, srcStride, dest, destStride, count, localUVWChans); };
-    bool            ISoftwareVertexBlend(plDrawableSpans* drawable, const std::vector<int16_t>& visList);
 
 
     void            ILinkDevRef( plDXDeviceRef *ref, plDXDeviceRef **refList );
@@ -607,13 +602,6 @@ public:
 
     void RenderSpans(plDrawableSpans *ice, const std::vector<int16_t>& visList) override;
 
-    //  CPU-optimized functions
-protected:
-    typedef void(*blend_vert_buffer_ptr)(plSpan*, hsMatrix44*, int, const uint8_t *,
-                                         uint8_t , uint32_t, uint8_t *, uint32_t,
-                                         uint32_t, uint16_t);
-    static hsCpuFunctionDispatcher<blend_vert_buffer_ptr> blend_vert_buffer;
-
 private:
     static plDXEnumerate enumerator;
 };
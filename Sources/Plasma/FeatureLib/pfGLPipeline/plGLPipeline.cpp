@@ -51,6 +51,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include <string_theory/string>
 
+#include "plAvatar/plAvatarClothing.h"
 #include "plPipeline/hsWinRef.h"
 
 #include "plGLPipeline.h"
@@ -179,7 +180,10 @@ void plGLPipeline::RefreshScreenMatrices()
 {}
 
 void plGLPipeline::SubmitClothingOutfit(plClothingOutfit* co)
-{}
+{
+    // No render-to-texture here yet, so the outfit builds its own
+    co->CompositeTexture();
+}
 
 bool plGLPipeline::SetGamma(float eR, float eG, float eB)
 {
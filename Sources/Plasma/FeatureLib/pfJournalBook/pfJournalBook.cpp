@@ -2992,6 +2992,7 @@ void    pfJournalBook::IDrawMipmap( pfEsHTMLChunk *chunk, uint16_t x, uint16_t y
             opts.fOpacity = (uint8_t)(chunk->fCurrOpacity * 255.f);
         }
         dtMap->Composite(copy.Get(), x, y, &opts);
+        dtMap->AddDirtyRect(x, y, copy->GetWidth(), copy->GetHeight());
     }
 
     if( chunk->fFlags & pfEsHTMLChunk::kCanLink )
@@ -48,6 +48,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "plMetalDevice.h"
 
+#include <algorithm>
+
 #include "hsDarwin.h"
 #include "hsThread.h"
 
@@ -927,6 +929,23 @@ void plMetalDevice::MakeTextureRef(plMetalDevice::TextureRef* tRef, plMipmap* im
         return;
     }
 
+    // Only part of an uncompressed, single level texture changed (usually a
+    // plDynamicTextMap), so just replace that region of the existing texture.
+    if (tRef->fTexture && tRef->HasDirtyRegion() && !img->IsCompressed() && img->GetNumLevels() == 1 &&
+        img->GetPixelSize() == 32 && tRef->fTexture->width() == img->GetWidth() && tRef->fTexture->height() == img->GetHeight()) {
+        uint16_t left, top, right, bottom;
+        tRef->GetDirtyRegion(left, top, right, bottom);
+        right = std::min<uint16_t>(right, img->GetWidth());
+        bottom = std::min<uint16_t>(bottom, img->GetHeight());
+
+        if (left < right && top < bottom) {
+            img->SetCurrLevel(0);
+            tRef->fTexture->replaceRegion(MTL::Region::Make2D(left, top, right - left, bottom - top), 0, 0, img->GetAddr32(left, top), img->GetRowBytes(), 0);
+        }
+        tRef->SetDirty(false);
+        return;
+    }
+
     if (tRef->fTexture) {
         tRef->fTexture->release();
     }
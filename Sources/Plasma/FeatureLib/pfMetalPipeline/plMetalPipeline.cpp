@@ -96,7 +96,6 @@ plProfile_Extern(MatChange);
 
 plProfile_CreateTimer("PrepShadows", "PipeT", PrepShadows);
 plProfile_CreateTimer("PrepDrawable", "PipeT", PrepDrawable);
-plProfile_CreateTimer("  Skin", "PipeT", Skin);
 plProfile_CreateTimer("RenderSpan", "PipeT", RenderSpan);
 plProfile_CreateTimer("  MergeCheck", "PipeT", MergeCheck);
 plProfile_CreateTimer("  MergeSpan", "PipeT", MergeSpan);
@@ -117,7 +116,6 @@ plProfile_CreateCounter("AvRTPoolUsed", "PipeC", AvRTPoolUsed);
 plProfile_CreateCounter("AvRTPoolCount", "PipeC", AvRTPoolCount);
 plProfile_CreateCounter("AvRTPoolRes", "PipeC", AvRTPoolRes);
 plProfile_CreateCounter("AvRTShrinkTime", "PipeC", AvRTShrinkTime);
-plProfile_CreateCounter("NumSkin", "PipeC", NumSkin);
 
 #ifndef PLASMA_FORCE_PER_PIXEL_LIGHTING
 #define PLASMA_FORCE_PER_PIXEL_LIGHTING 0
@@ -309,7 +307,7 @@ bool plMetalPipeline::PrepForRender(plDrawable* drawable, std::vector<int16_t>&
     ice->PrepForRender(this);
 
     // Any skinning necessary
-    if (!ISoftwareVertexBlend(ice, visList)) {
+    if (!ISoftwareVertexBlend(ice, visList, false)) {
         plProfile_EndTiming(PrepDrawable);
         return false;
     }
@@ -3150,7 +3148,7 @@ bool plMetalPipeline::IPrepShadowCaster(const plShadowCaster* caster)
             drawable->PrepForRender(this);
 
             // Do any software skinning.
-            if (!ISoftwareVertexBlend(drawable, visList))
+            if (!ISoftwareVertexBlend(drawable, visList, false))
                 return false;
         }
     }
@@ -4011,237 +4009,6 @@ plMetalDevice* plMetalPipeline::GetMetalDevice()  const
     return &fDevice;
 }
 
-//// Local Static Stuff ///////////////////////////////////////////////////////
-
-// FIXME: CPU avatar stuff that should be evaluated once this moves onto the GPU.
-
-template <typename T>
-static inline void inlCopy(uint8_t*& src, uint8_t*& dst)
-{
-    T* src_ptr = reinterpret_cast<T*>(src);
-    T* dst_ptr = reinterpret_cast<T*>(dst);
-    *dst_ptr = *src_ptr;
-    src += sizeof(T);
-    dst += sizeof(T);
-}
-
-template <typename T>
-static inline const uint8_t* inlExtract(const uint8_t* src, T* val)
-{
-    const T* ptr = reinterpret_cast<const T*>(src);
-    *val = *ptr++;
-    return reinterpret_cast<const uint8_t*>(ptr);
-}
-
-template <>
-inline const uint8_t* inlExtract<hsPoint3>(const uint8_t* src, hsPoint3* val)
-{
-    const float* src_ptr = reinterpret_cast<const float*>(src);
-    float*       dst_ptr = reinterpret_cast<float*>(val);
-    *dst_ptr++ = *src_ptr++;
-    *dst_ptr++ = *src_ptr++;
-    *dst_ptr++ = *src_ptr++;
-    *dst_ptr = 1.f;
-    return reinterpret_cast<const uint8_t*>(src_ptr);
-}
-
-template <>
-inline const uint8_t* inlExtract<hsVector3>(const uint8_t* src, hsVector3* val)
-{
-    const float* src_ptr = reinterpret_cast<const float*>(src);
-    float*       dst_ptr = reinterpret_cast<float*>(val);
-    *dst_ptr++ = *src_ptr++;
-    *dst_ptr++ = *src_ptr++;
-    *dst_ptr++ = *src_ptr++;
-    *dst_ptr = 0.f;
-    return reinterpret_cast<const uint8_t*>(src_ptr);
-}
-
-template <typename T, size_t N>
-static inline void inlSkip(uint8_t*& src)
-{
-    src += sizeof(T) * N;
-}
-
-template <typename T>
-static inline uint8_t* inlStuff(uint8_t* dst, const T* val)
-{
-    T* ptr = reinterpret_cast<T*>(dst);
-    *ptr++ = *val;
-    return reinterpret_cast<uint8_t*>(ptr);
-}
-
-//// ISoftwareVertexBlend ///////////////////////////////////////////////////////
-// Emulate matrix palette operations in software. The big difference between the hardware
-// and software versions is we only want to lock the vertex buffer once and blend all the
-// verts we're going to in software, so the vertex blend happens once for an entire drawable.
-// In hardware, we want the opposite, to break it into managable chunks, manageable meaning
-// few enough matrices to fit into hardware registers. So for hardware version, we set up
-// our palette, draw a span or few, setup our matrix palette with new matrices, draw, repeat.
-bool plMetalPipeline::ISoftwareVertexBlend(plDrawableSpans* drawable, const std::vector<int16_t>& visList)
-{
-    if (IsDebugFlagSet(plPipeDbg::kFlagNoSkinning))
-        return true;
-
-    if (drawable->GetSkinTime() == fRenderCnt)
-        return true;
-
-    const hsBitVector& blendBits = drawable->GetBlendingSpanVector();
-
-    if (drawable->GetBlendingSpanVector().Empty()) {
-        // This sucker doesn't have any skinning spans anyway. Just return
-        drawable->SetSkinTime(fRenderCnt);
-        return true;
-    }
-
-    plProfile_BeginTiming(Skin);
-
-    // lock the data buffer
-
-    // First, figure out which buffers we need to blend.
-    const int   kMaxBufferGroups = 20;
-    const int   kMaxVertexBuffers = 20;
-    static char blendBuffers[kMaxBufferGroups][kMaxVertexBuffers];
-    memset(blendBuffers, 0, kMaxBufferGroups * kMaxVertexBuffers * sizeof(**blendBuffers));
-
-    hsAssert(kMaxBufferGroups >= drawable->GetNumBufferGroups(), "Bigger than we counted on num groups skin.");
-
-    const std::vector<plSpan*>& spans = drawable->GetSpanArray();
-    int                         i;
-    for (i = 0; i < visList.size(); i++) {
-        if (blendBits.IsBitSet(visList[i])) {
-            const plVertexSpan& vSpan = *(plVertexSpan*)spans[visList[i]];
-            hsAssert(kMaxVertexBuffers > vSpan.fVBufferIdx, "Bigger than we counted on num buffers skin.");
-
-            blendBuffers[vSpan.fGroupIdx][vSpan.fVBufferIdx] = 1;
-            drawable->SetBlendingSpanVectorBit(visList[i], false);
-        }
-    }
-
-    // Now go through each of the group/buffer (= a real vertex buffer) pairs we found,
-    // and blend into it. We'll lock the buffer once, and then for each span that
-    // uses it, set the matrix palette and and then do the blend for that span.
-    // When we've done all the spans for a group/buffer, we unlock it and move on.
-    int j;
-    for (i = 0; i < kMaxBufferGroups; i++) {
-        for (j = 0; j < kMaxVertexBuffers; j++) {
-            if (blendBuffers[i][j]) {
-                // Found one. Do the lock.
-                plMetalVertexBufferRef* vRef = (plMetalVertexBufferRef*)drawable->GetVertexRef(i, j);
-
-                hsAssert(vRef->fData, "Going into skinning with no place to put results!");
-
-                uint8_t* destPtr = vRef->fData;
-
-                int k;
-                for (k = 0; k < visList.size(); k++) {
-                    const plIcicle& span = *(plIcicle*)spans[visList[k]];
-                    if (span.fGroupIdx == i && span.fVBufferIdx == j) {
-                        plProfile_Inc(NumSkin);
-
-                        hsMatrix44* matrixPalette = drawable->GetMatrixPalette(span.fBaseMatrix);
-                        matrixPalette[0] = span.fLocalToWorld;
-
-                        uint8_t* ptr = vRef->fOwner->GetVertBufferData(vRef->fIndex);
-                        ptr += span.fVStartIdx * vRef->fOwner->GetVertexSize();
-                        IBlendVertBuffer((plSpan*)&span,
-                                         matrixPalette, span.fNumMatrices,
-                                         ptr,
-                                         vRef->fOwner->GetVertexFormat(),
-                                         vRef->fOwner->GetVertexSize(),
-                                         destPtr + span.fVStartIdx * vRef->fVertexSize,
-                                         vRef->fVertexSize,
-                                         span.fVLength,
-                                         span.fLocalUVWChans);
-                        vRef->SetDirty(true);
-                    }
-                }
-                // Unlock and move on.
-            }
-        }
-    }
-
-    plProfile_EndTiming(Skin);
-
-    if (drawable->GetBlendingSpanVector().Empty()) {
-        // Only do this if we've blended ALL of the spans. Thus, this becomes a trivial
-        // rejection for all the skinning flags being cleared
-        drawable->SetSkinTime(fRenderCnt);
-    }
-
-    return true;
-}
-
-//// IBlendVertsIntoBuffer ////////////////////////////////////////////////////
-//  Given a pointer into a buffer of verts that have blending data in the D3D
-//  format, blends them into the destination buffer given without the blending
-//  info.
-
-void plMetalPipeline::IBlendVertBuffer(plSpan* span, hsMatrix44* matrixPalette, int numMatrices,
-                                       const uint8_t* src, uint8_t format, uint32_t srcStride,
-                                       uint8_t* dest, uint32_t destStride, uint32_t count,
-                                       uint16_t localUVWChans)
-{
-    simd_float4      pt_buf = {0.f, 0.f, 0.f, 1.f};
-    simd_float4      vec_buf = {0.f, 0.f, 0.f, 0.f};
-    hsPoint3*  pt = reinterpret_cast<hsPoint3*>(&pt_buf);
-    hsVector3* vec = reinterpret_cast<hsVector3*>(&vec_buf);
-
-    uint32_t indices;
-    float    weights[4];
-
-    // Dropped support for localUVWChans at templatization of code
-    hsAssert(localUVWChans == 0, "support for skinned UVWs dropped. reimplement me?");
-    const size_t uvChanSize = plGBufferGroup::CalcNumUVs(format) * sizeof(float) * 3;
-    uint8_t      numWeights = (format & plGBufferGroup::kSkinWeightMask) >> 4;
-
-    for (uint32_t i = 0; i < count; ++i) {
-        // Extract data
-        src = inlExtract<hsPoint3>(src, pt);
-
-        float weightSum = 0.f;
-        for (uint8_t j = 0; j < numWeights; ++j) {
-            src = inlExtract<float>(src, &weights[j]);
-            weightSum += weights[j];
-        }
-        weights[numWeights] = 1.f - weightSum;
-
-        if (format & plGBufferGroup::kSkinIndices)
-            src = inlExtract<uint32_t>(src, &indices);
-        else
-            indices = 1 << 8;
-        src = inlExtract<hsVector3>(src, vec);
-
-        // Destination buffers (float4 for SSE alignment)
-        simd_float4 destNorm_buf = (simd_float4){0.f, 0.f, 0.f, 0.f};
-        simd_float4 destPt_buf = (simd_float4){0.f, 0.f, 0.f, 1.f};
-
-        // Blend
-        for (uint32_t j = 0; j < numWeights + 1; ++j) {
-            float weight = weights[j];
-            if (weight) {
-                const simd_float4x4& simdMatrix = hsMatrix2SIMD(matrixPalette[indices & 0xFF]);
-                // Note: This bit is different than GL/DirectX. It's using acclerate so this is also accelerated on ARM through NEON or maybe even the Neural Engine.
-                destPt_buf += simd_mul(pt_buf, simdMatrix) * weight;
-                destNorm_buf += simd_mul(vec_buf, simdMatrix) * weight;
-            }
-            // ISkinVertexSSE41(matrixPalette[indices & 0xFF], weights[j], pt_buf, destPt_buf, vec_buf, destNorm_buf);
-            indices >>= 8;
-        }
-        // Probably don't really need to renormalize this. There errors are
-        // going to be subtle and "smooth".
-        /* hsFastMath::NormalizeAppr(destNorm); */
-
-        // Slam data into position now
-        dest = inlStuff<hsPoint3>(dest, reinterpret_cast<hsPoint3*>(&destPt_buf));
-        dest = inlStuff<hsVector3>(dest, reinterpret_cast<hsVector3*>(&destNorm_buf));
-
-        // Jump past colors and UVws
-        dest += sizeof(uint32_t) * 2 + uvChanSize;
-        src += sizeof(uint32_t) * 2 + uvChanSize;
-    }
-}
-
 // Resource checking
 
 // CheckTextureRef //////////////////////////////////////////////////////
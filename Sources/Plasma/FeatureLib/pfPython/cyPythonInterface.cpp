@@ -64,6 +64,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "plPythonCallable.h"
 #include "cyPythonInterface.h"
+#include "plPythonProfiler.h"
 
 #include "pyEnum.h"
 #include "cyDraw.h"
@@ -616,6 +617,15 @@ public:
         return obj->fData.to_string();
     }
 
+    // returns true if anything has been written since the last clear
+    static bool HasData(PyObject *redirector)
+    {
+        if (!pyOutputRedirector::Check(redirector))
+            return false; // it's not a redirector object
+        pyOutputRedirector *obj = pyOutputRedirector::ConvertFrom(redirector);
+        return obj->fData.size() != 0;
+    }
+
     // clears the internal buffer out
     static void ClearData(PyObject *redirector)
     {
@@ -1265,6 +1275,11 @@ void PythonInterface::finiPython()
     initialized--;
     if ( initialized < 1 && Py_IsInitialized() != 0 && IsInShutdown )
     {
+        // don't lose whatever the scripts said on their way out
+        FlushOutput();
+        if (plPythonProfiler::Instance().IsSampling())
+            plPythonProfiler::Instance().StopSampling();
+
 #if defined(HAVE_CYPYTHONIDE) && !defined(PLASMA_EXTERNAL_RELEASE)
         if (usePythonDebugger)
             debugServer.Disconnect();
@@ -1328,6 +1343,21 @@ PyObject* PythonInterface::GetStdErr()
     return stdErr;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Function   : FlushOutput
+//  PARAMETERS : none
+//
+//  PURPOSE    : send anything the scripts printed since the last flush on to
+//               the log and the debug window. Scripts no longer do this after
+//               every callback, so the client calls it once a frame.
+//
+void PythonInterface::FlushOutput()
+{
+    if (stdOut != nullptr && pyOutputRedirector::HasData(stdOut))
+        getOutputAndReset();
+}
+
 /////////////////////////////////////////////////////////////////////////////
 //
 //  Function   : getOutputAndReset
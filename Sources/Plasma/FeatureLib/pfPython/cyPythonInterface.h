@@ -131,6 +131,9 @@ public:
     // get the Output to the error file to be displayed
     static ST::string getOutputAndReset();
 
+    // pass on any Output the scripts have made since last time (once a frame)
+    static void FlushOutput();
+
     // Writes 'text' to the Python log
     static void WriteToLog(const ST::string& text);
 
@@ -134,6 +134,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "pyGameScoreMsg.h"
 
+#include "plPythonProfiler.h"
 #include "plPythonSDLModifier.h"
 
 #include "plMessage/plTimerCallbackMsg.h"
@@ -268,7 +269,7 @@ bool plPythonFileMod::fAtConvertTime = false;
 plPythonFileMod::plPythonFileMod()
     : fModule(), fLocalNotify(true), fIsFirstTimeEval(true),
       fVaultCallback(), fSDLMod(), fSelfKey(), fInstance(), fKeyCatcher(),
-      fPipe(), fAmIAttachedToClone()
+      fPipe(), fAmIAttachedToClone(), fScriptStats()
 {
     // assume that all the functions are not available
     // ...if the functions are defined in the module, then we'll call 'em
@@ -328,11 +329,84 @@ plPythonFileMod::~plPythonFileMod()
 }
 
 template<typename T>
-T* plPythonFileMod::IScriptWantsMsg(func_num methodId, plMessage* msg) const
+static bool IsMsgOfType(plMessage* msg)
 {
-    if (fPyFunctionInstances[methodId])
-        return T::ConvertNoRef(msg);
-    return nullptr;
+    return T::ConvertNoRef(msg) != nullptr;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Function   : IGetMsgRoute
+//  PARAMETERS : msg   - the message that came to us.
+//
+//  PURPOSE    : Figure out which part of MsgReceive wants this kind of message.
+//               Whether a message converts to a type only depends on its class,
+//               so the answer is worked out once per class and remembered.
+//
+int plPythonFileMod::IGetMsgRoute(plMessage* msg)
+{
+    auto it = fMsgRoutes.find(msg->ClassIndex());
+    if (it != fMsgRoutes.end())
+        return it->second;
+
+    struct MsgRoute
+    {
+        int     route;
+        int     func;   // script method that must exist, or -1
+        bool    (*isMsg)(plMessage*);
+    };
+
+    // in the order MsgReceive has always checked for them
+    static const MsgRoute kRoutes[] = {
+        { kRoute_GenRef, -1, IsMsgOfType<plGenRefMsg> },
+        { kRoute_AgeLoaded, -1, IsMsgOfType<plAgeLoadedMsg> },
+        { kRoute_Render, -1, IsMsgOfType<plRenderMsg> },
+        { kfunc_OnNotify, kfunc_OnNotify, IsMsgOfType<plNotifyMsg> },
+        { kfunc_OnControlKeyEvent, kfunc_OnControlKeyEvent, IsMsgOfType<plControlEventMsg> },
+        { kfunc_OnTimer, kfunc_OnTimer, IsMsgOfType<plTimerCallbackMsg> },
+        { kfunc_OnGUINotify, kfunc_OnGUINotify, IsMsgOfType<pfGUINotifyMsg> },
+        { kfunc_OnPageLoad, kfunc_OnPageLoad, IsMsgOfType<plRoomLoadNotifyMsg> },
+        { kfunc_OnClothingUpdate, kfunc_OnClothingUpdate, IsMsgOfType<plClothingUpdateBCMsg> },
+        { kfunc_OnKIMsg, kfunc_OnKIMsg, IsMsgOfType<pfKIMsg> },
+        { kfunc_OnKIMsg, kfunc_OnRTChat, IsMsgOfType<pfKIMsg> },
+        { kfunc_OnMemberUpdate, kfunc_OnMemberUpdate, IsMsgOfType<plMemberUpdateMsg> },
+        { kfunc_OnRemoteAvatarInfo, kfunc_OnRemoteAvatarInfo, IsMsgOfType<plRemoteAvatarInfoMsg> },
+        { kfunc_OnCCRMsg, kfunc_OnCCRMsg, IsMsgOfType<plCCRCommunicationMsg> },
+        { kfunc_OnVaultNotify, kfunc_OnVaultNotify, IsMsgOfType<plVaultNotifyMsg> },
+        { kfunc_AvatarPage, kfunc_AvatarPage, IsMsgOfType<plPlayerPageMsg> },
+        { kfunc_BeginAgeUnLoad, kfunc_BeginAgeUnLoad, IsMsgOfType<plAgeBeginLoadingMsg> },
+        { kRoute_InitialStateLoaded, -1, IsMsgOfType<plInitialAgeStateLoadedMsg> },
+        { kfunc_OnSDLNotify, kfunc_OnSDLNotify, IsMsgOfType<plSDLNotificationMsg> },
+        { kfunc_OnOwnershipChanged, kfunc_OnOwnershipChanged, IsMsgOfType<plNetOwnershipMsg> },
+        { kfunc_OnMarkerMsg, kfunc_OnMarkerMsg, IsMsgOfType<pfMarkerMsg> },
+#ifndef PLASMA_EXTERNAL_RELEASE
+        { kfunc_OnBackdoorMsg, kfunc_OnBackdoorMsg, IsMsgOfType<pfBackdoorMsg> },
+#endif  //PLASMA_EXTERNAL_RELEASE
+        { kfunc_OnLOSNotify, kfunc_OnLOSNotify, IsMsgOfType<plLOSHitMsg> },
+        { kfunc_OnBehaviorNotify, kfunc_OnBehaviorNotify, IsMsgOfType<plAvatarBehaviorNotifyMsg> },
+        { kfunc_OnMovieEvent, kfunc_OnMovieEvent, IsMsgOfType<pfMovieEventMsg> },
+        { kfunc_OnScreenCaptureDone, kfunc_OnScreenCaptureDone, IsMsgOfType<plCaptureRenderMsg> },
+        { kfunc_OnClimbingBlockerEvent, kfunc_OnClimbingBlockerEvent, IsMsgOfType<plClimbEventMsg> },
+        { kfunc_OnAvatarSpawn, kfunc_OnAvatarSpawn, IsMsgOfType<plAvatarSpawnNotifyMsg> },
+        { kfunc_OnAccountUpdate, kfunc_OnAccountUpdate, IsMsgOfType<plAccountUpdateMsg> },
+        { kfunc_gotPublicAgeList, kfunc_gotPublicAgeList, IsMsgOfType<plNetCommPublicAgeListMsg> },
+        { kfunc_OnAIMsg, kfunc_OnAIMsg, IsMsgOfType<plAIMsg> },
+        { kfunc_OnGameScoreMsg, kfunc_OnGameScoreMsg, IsMsgOfType<pfGameScoreMsg> },
+        { kfunc_OnSubtitleMsg, kfunc_OnSubtitleMsg, IsMsgOfType<plSubtitleMsg> },
+    };
+
+    int route = kRoute_None;
+    for (const MsgRoute& candidate : kRoutes) {
+        if (candidate.func != -1 && !fPyFunctionInstances[candidate.func])
+            continue;
+        if (candidate.isMsg(msg)) {
+            route = candidate.route;
+            break;
+        }
+    }
+
+    fMsgRoutes[msg->ClassIndex()] = route;
+    return route;
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -358,10 +432,13 @@ void plPythonFileMod::ICallScriptMethod(func_num methodId, Args&&... args)
     if (!callable)
         return;
 
+    plPythonScriptTimer timer(fScriptStats, methodId);
+
+    // Anything the script printed is picked up by PythonInterface::FlushOutput() at
+    // the start of the next frame, not here; most callbacks don't print anything.
     pyObjectRef retVal = plPython::CallObject(callable, std::forward<Args>(args)...);
     if (!retVal)
         ReportError();
-    DisplayPythonOutput();
 }
 
 void plPythonFileMod::IInitialStateLoaded()
@@ -597,6 +674,8 @@ void plPythonFileMod::AddTarget(plSceneObject* sobj)
 
             //  - find functions in class they've defined.
             PythonInterface::CheckInstanceForFunctions(fInstance, fFunctionNames, fPyFunctionInstances);
+            fMsgRoutes.clear();
+            fScriptStats = plPythonProfiler::Instance().GetScriptStats(fPythonFile, fFunctionNames);
 
             // register for PageLoaded message if needed
             if (fPyFunctionInstances[kfunc_OnPageLoad])
@@ -880,728 +959,732 @@ bool plPythonFileMod::IEval(double secs, float del, uint32_t dirty)
 //  PARAMETERS : msg   - the message that came to us.
 //
 //  PURPOSE    : Handle all the different types of messages that we recv
+//               (IGetMsgRoute says which, if any, part of this wants them)
 //
 bool plPythonFileMod::MsgReceive(plMessage* msg)
 {
-    plGenRefMsg* genRefMsg = plGenRefMsg::ConvertNoRef(msg);
-    if (genRefMsg) {
-        // is it a ref for a named activator that we need to add to notify?
-        if ((genRefMsg->GetContext() & plRefMsg::kOnCreate) && genRefMsg->fWhich == kAddNotify) {
-            if (plLogicModifier* logic = plLogicModifier::ConvertNoRef(genRefMsg->GetRef())) {
-                logic->AddNotifyReceiver(GetKey());
-            } else if (plPythonFileMod* pymod = plPythonFileMod::ConvertNoRef(genRefMsg->GetRef())) {
-                pymod->AddToNotifyList(GetKey());
+    switch (IGetMsgRoute(msg)) {
+        case kRoute_GenRef: {
+            plGenRefMsg* genRefMsg = plGenRefMsg::ConvertNoRef(msg);
+            // is it a ref for a named activator that we need to add to notify?
+            if ((genRefMsg->GetContext() & plRefMsg::kOnCreate) && genRefMsg->fWhich == kAddNotify) {
+                if (plLogicModifier* logic = plLogicModifier::ConvertNoRef(genRefMsg->GetRef())) {
+                    logic->AddNotifyReceiver(GetKey());
+                } else if (plPythonFileMod* pymod = plPythonFileMod::ConvertNoRef(genRefMsg->GetRef())) {
+                    pymod->AddToNotifyList(GetKey());
+                }
             }
+            break;
         }
-    }
 
-    plAgeLoadedMsg* ageLoadedMsg = plAgeLoadedMsg::ConvertNoRef(msg);
-    if (ageLoadedMsg && ageLoadedMsg->fLoaded) {
-        for (const auto& comp : fNamedCompQueue) {
-            if (comp.isActivator)
-                IFindActivatorAndAdd(comp.name, comp.id);
-            else
-                IFindResponderAndAdd(comp.name, comp.id);
+        case kRoute_AgeLoaded: {
+            plAgeLoadedMsg* ageLoadedMsg = plAgeLoadedMsg::ConvertNoRef(msg);
+            if (ageLoadedMsg->fLoaded) {
+                for (const auto& comp : fNamedCompQueue) {
+                    if (comp.isActivator)
+                        IFindActivatorAndAdd(comp.name, comp.id);
+                    else
+                        IFindResponderAndAdd(comp.name, comp.id);
+                }
+                fNamedCompQueue.clear();
+                plgDispatch::Dispatch()->UnRegisterForExactType(plAgeLoadedMsg::Index(), GetKey());
+            }
+            break;
         }
-        fNamedCompQueue.clear();
-        plgDispatch::Dispatch()->UnRegisterForExactType(plAgeLoadedMsg::Index(), GetKey());
-    }
-
-    // if this is a render message, then we are just trying to get a pointer to the Pipeline
-    plRenderMsg* rMsg = plRenderMsg::ConvertNoRef(msg);
-    if (rMsg) {
-        fPipe = rMsg->Pipeline();
-        plgDispatch::Dispatch()->UnRegisterForExactType(plRenderMsg::Index(), GetKey());
-        return true;
-    }
 
-    // are they looking for an Notify message? should be coming from a proActivator
-    auto pNtfyMsg = IScriptWantsMsg<plNotifyMsg>(kfunc_OnNotify, msg);
-    if (pNtfyMsg) {
-        // Cache the whether or not this is a local notification for calls to PtWasLocallyNotified()
-        fLocalNotify = !pNtfyMsg->HasBCastFlag(plMessage::kNetNonLocal);
-
-        PyObject* levents = PyTuple_New(pNtfyMsg->GetEventCount());
-        for (size_t i = 0; i < pNtfyMsg->GetEventCount(); i++) {
-            proEventData* pED = pNtfyMsg->GetEventRecord(i);
-            switch (pED->fEventType) {
-                case proEventData::kCollision:
-                    {
-                        proCollisionEventData* eventData = (proCollisionEventData*)pED;
-
-                        PyObject* event = PyTuple_New(4);
-                        PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kCollision));
-                        PyTuple_SET_ITEM(event, 1, PyLong_FromLong(eventData->fEnter ? 1 : 0));
-                        PyTuple_SET_ITEM(event, 2, pySceneObject::New(eventData->fHitter, fSelfKey));
-                        PyTuple_SET_ITEM(event, 3, pySceneObject::New(eventData->fHittee, fSelfKey));
-                        PyTuple_SET_ITEM(levents, i, event);
-                    }
-                    break;
-                        
-                case proEventData::kSpawned:
-                    {
-                        proSpawnedEventData* eventData = (proSpawnedEventData*)pED;
-
-                        PyObject* event = PyTuple_New(3);
-                        PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kSpawned));
-                        PyTuple_SET_ITEM(event, 1, pySceneObject::New(eventData->fSpawner, fSelfKey));
-                        PyTuple_SET_ITEM(event, 2, pySceneObject::New(eventData->fSpawnee, fSelfKey));
-                        PyTuple_SET_ITEM(levents, i, event);
-                    }
-                    break;
+        case kRoute_Render: {
+            // if this is a render message, then we are just trying to get a pointer to the Pipeline
+            plRenderMsg* rMsg = plRenderMsg::ConvertNoRef(msg);
+            fPipe = rMsg->Pipeline();
+            plgDispatch::Dispatch()->UnRegisterForExactType(plRenderMsg::Index(), GetKey());
+            return true;
+        }
 
-                case proEventData::kPicked:
-                    {
-                        proPickedEventData* eventData = (proPickedEventData*)pED;
-                        PyObject* event = PyTuple_New(6);
-                        PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kPicked));
-                        PyTuple_SET_ITEM(event, 1, PyLong_FromLong(eventData->fEnabled ? 1 : 0));
-                        PyTuple_SET_ITEM(event, 2, pySceneObject::New(eventData->fPicker, fSelfKey));
-                        PyTuple_SET_ITEM(event, 3, pySceneObject::New(eventData->fPicked, fSelfKey));
-                        PyTuple_SET_ITEM(event, 4, pyPoint3::New(eventData->fHitPoint));
-
-                        // make it in the local space
-                        hsPoint3 tolocal;
-                        if (eventData->fPicked){
-                            plSceneObject* obj = plSceneObject::ConvertNoRef(eventData->fPicked->ObjectIsLoaded());
-                            if (obj) {
-                                const plCoordinateInterface* ci = obj->GetCoordinateInterface();
-                                if (ci)
-                                    tolocal = (hsMatrix44)ci->GetWorldToLocal() * eventData->fHitPoint;
+        case kRoute_InitialStateLoaded:
+            // initial server update complete message
+            IInitialStateLoaded();
+            return true;
+
+        case kfunc_OnNotify: {
+            // are they looking for an Notify message? should be coming from a proActivator
+            plNotifyMsg* pNtfyMsg = plNotifyMsg::ConvertNoRef(msg);
+            // Cache the whether or not this is a local notification for calls to PtWasLocallyNotified()
+            fLocalNotify = !pNtfyMsg->HasBCastFlag(plMessage::kNetNonLocal);
+
+            PyObject* levents = PyTuple_New(pNtfyMsg->GetEventCount());
+            for (size_t i = 0; i < pNtfyMsg->GetEventCount(); i++) {
+                proEventData* pED = pNtfyMsg->GetEventRecord(i);
+                switch (pED->fEventType) {
+                    case proEventData::kCollision:
+                        {
+                            proCollisionEventData* eventData = (proCollisionEventData*)pED;
+
+                            PyObject* event = PyTuple_New(4);
+                            PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kCollision));
+                            PyTuple_SET_ITEM(event, 1, PyLong_FromLong(eventData->fEnter ? 1 : 0));
+                            PyTuple_SET_ITEM(event, 2, pySceneObject::New(eventData->fHitter, fSelfKey));
+                            PyTuple_SET_ITEM(event, 3, pySceneObject::New(eventData->fHittee, fSelfKey));
+                            PyTuple_SET_ITEM(levents, i, event);
+                        }
+                        break;
+                            
+                    case proEventData::kSpawned:
+                        {
+                            proSpawnedEventData* eventData = (proSpawnedEventData*)pED;
+
+                            PyObject* event = PyTuple_New(3);
+                            PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kSpawned));
+                            PyTuple_SET_ITEM(event, 1, pySceneObject::New(eventData->fSpawner, fSelfKey));
+                            PyTuple_SET_ITEM(event, 2, pySceneObject::New(eventData->fSpawnee, fSelfKey));
+                            PyTuple_SET_ITEM(levents, i, event);
+                        }
+                        break;
+
+                    case proEventData::kPicked:
+                        {
+                            proPickedEventData* eventData = (proPickedEventData*)pED;
+                            PyObject* event = PyTuple_New(6);
+                            PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kPicked));
+                            PyTuple_SET_ITEM(event, 1, PyLong_FromLong(eventData->fEnabled ? 1 : 0));
+                            PyTuple_SET_ITEM(event, 2, pySceneObject::New(eventData->fPicker, fSelfKey));
+                            PyTuple_SET_ITEM(event, 3, pySceneObject::New(eventData->fPicked, fSelfKey));
+                            PyTuple_SET_ITEM(event, 4, pyPoint3::New(eventData->fHitPoint));
+
+                            // make it in the local space
+                            hsPoint3 tolocal;
+                            if (eventData->fPicked){
+                                plSceneObject* obj = plSceneObject::ConvertNoRef(eventData->fPicked->ObjectIsLoaded());
+                                if (obj) {
+                                    const plCoordinateInterface* ci = obj->GetCoordinateInterface();
+                                    if (ci)
+                                        tolocal = (hsMatrix44)ci->GetWorldToLocal() * eventData->fHitPoint;
+                                }
                             }
+                            PyTuple_SET_ITEM(event, 5, pyPoint3::New(tolocal));
+                            PyTuple_SET_ITEM(levents, i, event);
                         }
-                        PyTuple_SET_ITEM(event, 5, pyPoint3::New(tolocal));
-                        PyTuple_SET_ITEM(levents, i, event);
-                    }
-                    break;
+                        break;
 
-                case proEventData::kControlKey:
-                    {
-                        proControlKeyEventData* eventData = (proControlKeyEventData*)pED;
+                    case proEventData::kControlKey:
+                        {
+                            proControlKeyEventData* eventData = (proControlKeyEventData*)pED;
 
-                        PyObject* event = PyTuple_New(3);
-                        PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kControlKey));
-                        PyTuple_SET_ITEM(event, 1, PyLong_FromLong(eventData->fControlKey));
-                        PyTuple_SET_ITEM(event, 2, PyLong_FromLong(eventData->fDown ? 1 : 0));
-                        PyTuple_SET_ITEM(levents, i, event);
-                    }
-                    break;
-
-                case proEventData::kVariable:
-                    {
-                        proVariableEventData* eventData = (proVariableEventData*)pED;
-                        // create event list
-                        PyObject* event = PyTuple_New(4);
-                        PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kVariable));
-                        PyTuple_SET_ITEM(event, 1, PyUnicode_FromSTString(eventData->fName));
-                        PyTuple_SET_ITEM(event, 2, PyLong_FromLong(eventData->fDataType));
-
-                        // depending on the data type create the data
-                        switch ( eventData->fDataType ) {
-                            case proEventData::kFloat:
-                                PyTuple_SET_ITEM(event, 3, PyFloat_FromDouble(eventData->fNumber.f));
-                                break;
-                            case proEventData::kKey:
-                                PyTuple_SET_ITEM(event, 3, pyKey::New(eventData->fKey));
-                                break;
-                            case proEventData::kInt:
-                                PyTuple_SET_ITEM(event, 3, PyLong_FromLong(eventData->fNumber.i));
-                                break;
-                            default:
-                                Py_INCREF(Py_None);
-                                PyTuple_SET_ITEM(event, 3, Py_None);
-                                break;
+                            PyObject* event = PyTuple_New(3);
+                            PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kControlKey));
+                            PyTuple_SET_ITEM(event, 1, PyLong_FromLong(eventData->fControlKey));
+                            PyTuple_SET_ITEM(event, 2, PyLong_FromLong(eventData->fDown ? 1 : 0));
+                            PyTuple_SET_ITEM(levents, i, event);
                         }
-                        PyTuple_SET_ITEM(levents, i, event);
-                    }
-                    break;
+                        break;
+
+                    case proEventData::kVariable:
+                        {
+                            proVariableEventData* eventData = (proVariableEventData*)pED;
+                            // create event list
+                            PyObject* event = PyTuple_New(4);
+                            PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kVariable));
+                            PyTuple_SET_ITEM(event, 1, PyUnicode_FromSTString(eventData->fName));
+                            PyTuple_SET_ITEM(event, 2, PyLong_FromLong(eventData->fDataType));
+
+                            // depending on the data type create the data
+                            switch ( eventData->fDataType ) {
+                                case proEventData::kFloat:
+                                    PyTuple_SET_ITEM(event, 3, PyFloat_FromDouble(eventData->fNumber.f));
+                                    break;
+                                case proEventData::kKey:
+                                    PyTuple_SET_ITEM(event, 3, pyKey::New(eventData->fKey));
+                                    break;
+                                case proEventData::kInt:
+                                    PyTuple_SET_ITEM(event, 3, PyLong_FromLong(eventData->fNumber.i));
+                                    break;
+                                default:
+                                    Py_INCREF(Py_None);
+                                    PyTuple_SET_ITEM(event, 3, Py_None);
+                                    break;
+                            }
+                            PyTuple_SET_ITEM(levents, i, event);
+                        }
+                        break;
+
+                    case proEventData::kFacing:
+                        {
+                            proFacingEventData* eventData = (proFacingEventData*)pED;
+                            PyObject* event = PyTuple_New(5);
+                            PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kFacing));
+                            PyTuple_SET_ITEM(event, 1, PyLong_FromLong(eventData->enabled ? 1 : 0));
+                            PyTuple_SET_ITEM(event, 2, pySceneObject::New(eventData->fFacer, fSelfKey));
+                            PyTuple_SET_ITEM(event, 3, pySceneObject::New(eventData->fFacee, fSelfKey));
+                            PyTuple_SET_ITEM(event, 4, PyFloat_FromDouble(eventData->dot));
+                            PyTuple_SET_ITEM(levents, i, event);
+                        }
+                        break;
+
+                    case proEventData::kContained:
+                        {
+                            proContainedEventData* eventData = (proContainedEventData*)pED;
+
+                            PyObject* event = PyTuple_New(4);
+                            PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kContained));
+                            PyTuple_SET_ITEM(event, 1, PyLong_FromLong(eventData->fEntering ? 1 : 0));
+                            PyTuple_SET_ITEM(event, 2, pySceneObject::New(eventData->fContained, fSelfKey));
+                            PyTuple_SET_ITEM(event, 3, pySceneObject::New(eventData->fContainer, fSelfKey));
+                            PyTuple_SET_ITEM(levents, i, event);
+                        }
+                        break;
 
-                case proEventData::kFacing:
-                    {
-                        proFacingEventData* eventData = (proFacingEventData*)pED;
-                        PyObject* event = PyTuple_New(5);
-                        PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kFacing));
-                        PyTuple_SET_ITEM(event, 1, PyLong_FromLong(eventData->enabled ? 1 : 0));
-                        PyTuple_SET_ITEM(event, 2, pySceneObject::New(eventData->fFacer, fSelfKey));
-                        PyTuple_SET_ITEM(event, 3, pySceneObject::New(eventData->fFacee, fSelfKey));
-                        PyTuple_SET_ITEM(event, 4, PyFloat_FromDouble(eventData->dot));
-                        PyTuple_SET_ITEM(levents, i, event);
-                    }
-                    break;
+                    case proEventData::kActivate:
+                        {
+                            proActivateEventData* eventData = (proActivateEventData*)pED;
 
-                case proEventData::kContained:
-                    {
-                        proContainedEventData* eventData = (proContainedEventData*)pED;
+                            PyObject* event = PyTuple_New(3);
+                            PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kActivate));
+                            PyTuple_SET_ITEM(event, 1, PyLong_FromLong(eventData->fActive ? 1 : 0));
+                            PyTuple_SET_ITEM(event, 2, PyLong_FromLong(eventData->fActivate ? 1 : 0));
+                            PyTuple_SET_ITEM(levents, i, event);
+                        }
+                        break;
 
-                        PyObject* event = PyTuple_New(4);
-                        PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kContained));
-                        PyTuple_SET_ITEM(event, 1, PyLong_FromLong(eventData->fEntering ? 1 : 0));
-                        PyTuple_SET_ITEM(event, 2, pySceneObject::New(eventData->fContained, fSelfKey));
-                        PyTuple_SET_ITEM(event, 3, pySceneObject::New(eventData->fContainer, fSelfKey));
-                        PyTuple_SET_ITEM(levents, i, event);
-                    }
-                    break;
+                    case proEventData::kCallback:
+                        {
+                            proCallbackEventData* eventData = (proCallbackEventData*)pED;
 
-                case proEventData::kActivate:
-                    {
-                        proActivateEventData* eventData = (proActivateEventData*)pED;
+                            PyObject* event = PyTuple_New(2);
+                            PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kCallback));
+                            PyTuple_SET_ITEM(event, 1, PyLong_FromLong(eventData->fEventType));
+                            PyTuple_SET_ITEM(levents, i, event);
+                        }
+                        break;
 
-                        PyObject* event = PyTuple_New(3);
-                        PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kActivate));
-                        PyTuple_SET_ITEM(event, 1, PyLong_FromLong(eventData->fActive ? 1 : 0));
-                        PyTuple_SET_ITEM(event, 2, PyLong_FromLong(eventData->fActivate ? 1 : 0));
-                        PyTuple_SET_ITEM(levents, i, event);
-                    }
-                    break;
+                    case proEventData::kResponderState:
+                        {
+                            proResponderStateEventData* eventData = (proResponderStateEventData*)pED;
 
-                case proEventData::kCallback:
-                    {
-                        proCallbackEventData* eventData = (proCallbackEventData*)pED;
+                            PyObject* event = PyTuple_New(2);
+                            PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kResponderState));
+                            PyTuple_SET_ITEM(event, 1, PyLong_FromLong(eventData->fState));
+                            PyTuple_SET_ITEM(levents, i, event);
+                        }
+                        break;
+
+                    case proEventData::kMultiStage:
+                        {
+                            proMultiStageEventData* eventData = (proMultiStageEventData*)pED;
+
+                            PyObject* event = PyTuple_New(4);
+                            PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kMultiStage));
+                            PyTuple_SET_ITEM(event, 1, PyLong_FromLong(eventData->fStage));
+                            PyTuple_SET_ITEM(event, 2, PyLong_FromLong(eventData->fEvent));
+                            PyTuple_SET_ITEM(event, 3, pySceneObject::New(eventData->fAvatar, fSelfKey));
+                            PyTuple_SET_ITEM(levents, i, event);
+                        }
+                        break;
+                    case proEventData::kOfferLinkingBook:
+                        {
+                            proOfferLinkingBookEventData* eventData = (proOfferLinkingBookEventData*)pED;
+
+                            PyObject* event = PyTuple_New(4);
+                            PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kOfferLinkingBook));
+                            PyTuple_SET_ITEM(event, 1, pySceneObject::New(eventData->offerer, fSelfKey));
+                            PyTuple_SET_ITEM(event, 2, PyLong_FromLong(eventData->targetAge));
+                            PyTuple_SET_ITEM(event, 3, PyLong_FromLong(eventData->offeree));
+                            PyTuple_SET_ITEM(levents, i, event);
+                        }
+                        break;
+                    case proEventData::kBook:
+                        {
+                            proBookEventData* eventData = (proBookEventData*)pED;
+
+                            PyObject* event = PyTuple_New(3);
+                            PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kBook));
+                            PyTuple_SET_ITEM(event, 1, PyLong_FromUnsignedLong(eventData->fEvent));
+                            PyTuple_SET_ITEM(event, 2, PyLong_FromUnsignedLong(eventData->fLinkID));
+                            PyTuple_SET_ITEM(levents, i, event);
+                        }
+                        break;
+                }
+            }
 
-                        PyObject* event = PyTuple_New(2);
-                        PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kCallback));
-                        PyTuple_SET_ITEM(event, 1, PyLong_FromLong(eventData->fEventType));
-                        PyTuple_SET_ITEM(levents, i, event);
+            // Need to determine which of the Activators sent this plNotifyMsg
+            // and set the ID appropriately
+            int32_t id = -1;  // assume that none was found
+            if (pNtfyMsg->GetSender()) {
+                // loop throught the parameters and set them by id
+                // (will need to create the appropiate Python object for each type)
+                for (int npm = 0; npm<GetParameterListCount(); npm++) {
+                    plPythonParameter parameter = GetParameterItem(npm);
+                    // is it something that could produce a plNotifiyMsg?
+                    if (parameter.fValueType == plPythonParameter::kActivatorList
+                        || parameter.fValueType == plPythonParameter::kBehavior
+                        || parameter.fValueType == plPythonParameter::kResponderList) {
+                        // is there an actual ObjectKey to look at?
+                        if (parameter.fObjectKey) {
+                            // is it the same as the sender of the notify message?
+                            if (pNtfyMsg->GetSender()->GetUoid() == parameter.fObjectKey->GetUoid()) {
+                                // match! Then return that as the ID
+                                id = parameter.fID;
+                            }
+                        }
                     }
-                    break;
-
-                case proEventData::kResponderState:
-                    {
-                        proResponderStateEventData* eventData = (proResponderStateEventData*)pED;
+                }
+            }
 
-                        PyObject* event = PyTuple_New(2);
-                        PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kResponderState));
-                        PyTuple_SET_ITEM(event, 1, PyLong_FromLong(eventData->fState));
-                        PyTuple_SET_ITEM(levents, i, event);
-                    }
-                    break;
+            ICallScriptMethod(kfunc_OnNotify, pNtfyMsg->fState, id, levents);
+            return true;
+        }
 
-                case proEventData::kMultiStage:
-                    {
-                        proMultiStageEventData* eventData = (proMultiStageEventData*)pED;
+        case kfunc_OnControlKeyEvent: {
+            // are they looking for a key event message?
+            plControlEventMsg* pEMsg = plControlEventMsg::ConvertNoRef(msg);
+            ICallScriptMethod(kfunc_OnControlKeyEvent, pEMsg->GetControlCode(), pEMsg->ControlActivated());
+            return true;
+        }
 
-                        PyObject* event = PyTuple_New(4);
-                        PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kMultiStage));
-                        PyTuple_SET_ITEM(event, 1, PyLong_FromLong(eventData->fStage));
-                        PyTuple_SET_ITEM(event, 2, PyLong_FromLong(eventData->fEvent));
-                        PyTuple_SET_ITEM(event, 3, pySceneObject::New(eventData->fAvatar, fSelfKey));
-                        PyTuple_SET_ITEM(levents, i, event);
-                    }
-                    break;
-                case proEventData::kOfferLinkingBook:
-                    {
-                        proOfferLinkingBookEventData* eventData = (proOfferLinkingBookEventData*)pED;
-
-                        PyObject* event = PyTuple_New(4);
-                        PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kOfferLinkingBook));
-                        PyTuple_SET_ITEM(event, 1, pySceneObject::New(eventData->offerer, fSelfKey));
-                        PyTuple_SET_ITEM(event, 2, PyLong_FromLong(eventData->targetAge));
-                        PyTuple_SET_ITEM(event, 3, PyLong_FromLong(eventData->offeree));
-                        PyTuple_SET_ITEM(levents, i, event);
-                    }
-                    break;
-                case proEventData::kBook:
-                    {
-                        proBookEventData* eventData = (proBookEventData*)pED;
-
-                        PyObject* event = PyTuple_New(3);
-                        PyTuple_SET_ITEM(event, 0, PyLong_FromLong((long)proEventData::kBook));
-                        PyTuple_SET_ITEM(event, 1, PyLong_FromUnsignedLong(eventData->fEvent));
-                        PyTuple_SET_ITEM(event, 2, PyLong_FromUnsignedLong(eventData->fLinkID));
-                        PyTuple_SET_ITEM(levents, i, event);
-                    }
-                    break;
-            }
+        case kfunc_OnTimer: {
+            // are they looking for an Timer message?
+            plTimerCallbackMsg* pTimerMsg = plTimerCallbackMsg::ConvertNoRef(msg);
+            ICallScriptMethod(kfunc_OnTimer, pTimerMsg->fID);
+            return true;
         }
 
-        // Need to determine which of the Activators sent this plNotifyMsg
-        // and set the ID appropriately
-        int32_t id = -1;  // assume that none was found
-        if (pNtfyMsg->GetSender()) {
-            // loop throught the parameters and set them by id
-            // (will need to create the appropiate Python object for each type)
-            for (int npm = 0; npm<GetParameterListCount(); npm++) {
-                plPythonParameter parameter = GetParameterItem(npm);
-                // is it something that could produce a plNotifiyMsg?
-                if (parameter.fValueType == plPythonParameter::kActivatorList
-                    || parameter.fValueType == plPythonParameter::kBehavior
-                    || parameter.fValueType == plPythonParameter::kResponderList) {
-                    // is there an actual ObjectKey to look at?
-                    if (parameter.fObjectKey) {
-                        // is it the same as the sender of the notify message?
-                        if (pNtfyMsg->GetSender()->GetUoid() == parameter.fObjectKey->GetUoid()) {
-                            // match! Then return that as the ID
-                            id = parameter.fID;
+        case kfunc_OnGUINotify: {
+            // are they looking for an GUINotify message?
+            pfGUINotifyMsg* pGUIMsg = pfGUINotifyMsg::ConvertNoRef(msg);
+            pyObjectRef pyControl;
+            if (pGUIMsg->GetControlKey()) {
+                // now create the control... but first we need to find out what it is
+                pyControl = pyGUIDialog::ConvertControl(pGUIMsg->GetControlKey());
+                if (!pyControl) {
+                    // we don't know what it is... just send 'em the pyKey
+                    pyControl = pyKey::New(pGUIMsg->GetControlKey());
+                }
+            }
+            // Need to determine which of the GUIDialogs sent this plGUINotifyMsg
+            // and set the ID appropriately
+            int32_t id = -1;  // assume that none was found
+            if (pGUIMsg->GetSender()) {
+                // loop throught the parameters and set them by id
+                // (will need to create the appropiate Python object for each type)
+                for (int npm = 0; npm < GetParameterListCount(); npm++) {
+                    plPythonParameter parameter = GetParameterItem(npm);
+                    // is it something that could produce a plNotifiyMsg?
+                    if (parameter.fValueType == plPythonParameter::kGUIDialog || parameter.fValueType == plPythonParameter::kGUIPopUpMenu) {
+                        // is there an actual ObjectKey to look at?
+                        if (parameter.fObjectKey) {
+                            // is it the same of the sender of the notify message?
+                            if (pGUIMsg->GetSender()->GetUoid() == parameter.fObjectKey->GetUoid()) {
+                                // match! then set the ID to what the parameter is, so the python programmer can find it
+                                id = parameter.fID;
+                            }
                         }
                     }
                 }
             }
+
+            // make sure that we found a control to go with this
+            if (!pyControl)
+                pyControl.SetPyNone();
+
+            // call their OnGUINotify method
+            ICallScriptMethod(kfunc_OnGUINotify, id, std::move(pyControl), pGUIMsg->GetEvent());
+            return true;
         }
 
-        ICallScriptMethod(kfunc_OnNotify, pNtfyMsg->fState, id, levents);
-        return true;
-    }
+        case kfunc_OnPageLoad: {
+            // are they looking for an RoomLoadNotify message?
+            plRoomLoadNotifyMsg* pRLNMsg = plRoomLoadNotifyMsg::ConvertNoRef(msg);
+            ICallScriptMethod(kfunc_OnPageLoad, pRLNMsg->GetWhatHappen(),
+                              pRLNMsg->GetRoom() ? pRLNMsg->GetRoom()->GetName() : ST::string());
+            return true;
+        }
 
-    // are they looking for a key event message?
-    auto pEMsg = IScriptWantsMsg<plControlEventMsg>(kfunc_OnControlKeyEvent, msg);
-    if (pEMsg) {
-        ICallScriptMethod(kfunc_OnControlKeyEvent, pEMsg->GetControlCode(), pEMsg->ControlActivated());
-        return true;
-    }
+        case kfunc_OnClothingUpdate: {
+            // are they looking for an ClothingUpdate message?
+            ICallScriptMethod(kfunc_OnClothingUpdate);
+            return true;
+        }
 
-    // are they looking for an Timer message?
-    auto pTimerMsg = IScriptWantsMsg<plTimerCallbackMsg>(kfunc_OnTimer, msg);
-    if (pTimerMsg) {
-        ICallScriptMethod(kfunc_OnTimer, pTimerMsg->fID);
-        return true;
-    }
+        case kfunc_OnKIMsg: {
+            pfKIMsg* pkimsg = pfKIMsg::ConvertNoRef(msg);
+
+            // are they looking for a RealTimeChat message?
+            if (pkimsg->GetCommand() == pfKIMsg::kHACKChatMsg) {
+                if (fPyFunctionInstances[kfunc_OnRTChat] && !VaultAmIgnoringPlayer(pkimsg->GetPlayerID())) {
+                    PyObject* player;
+                    plNetTransportMember *mbr = plNetClientMgr::GetInstance()->TransportMgr().GetMemberByID(pkimsg->GetPlayerID());
+                    if (mbr) {
+                        player = pyPlayer::New(mbr->GetAvatarKey(), pkimsg->GetUser(), mbr->GetPlayerID(), mbr->GetDistSq());
+                    } else {
+                        // else if we could not find the player in our list, then just return a string of the user's name
+                        ST::string fromName = pkimsg->GetUser();
+                        if (fromName.empty())
+                            fromName = ST_LITERAL("Anonymous Coward");
+                        player = pyPlayer::New(plNetClientMgr::GetInstance()->GetLocalPlayerKey(), fromName, pkimsg->GetPlayerID(), 0.0);
+                    }
 
-    // are they looking for an GUINotify message?
-    auto pGUIMsg = IScriptWantsMsg<pfGUINotifyMsg>(kfunc_OnGUINotify, msg);
-    if (pGUIMsg) {
-        pyObjectRef pyControl;
-        if (pGUIMsg->GetControlKey()) {
-            // now create the control... but first we need to find out what it is
-            pyControl = pyGUIDialog::ConvertControl(pGUIMsg->GetControlKey());
-            if (!pyControl) {
-                // we don't know what it is... just send 'em the pyKey
-                pyControl = pyKey::New(pGUIMsg->GetControlKey());
+                    ICallScriptMethod(kfunc_OnRTChat, player, pkimsg->GetString(), pkimsg->GetFlags());
+                }
+                break;
             }
-        }
-        // Need to determine which of the GUIDialogs sent this plGUINotifyMsg
-        // and set the ID appropriately
-        int32_t id = -1;  // assume that none was found
-        if (pGUIMsg->GetSender()) {
-            // loop throught the parameters and set them by id
-            // (will need to create the appropiate Python object for each type)
-            for (int npm = 0; npm < GetParameterListCount(); npm++) {
-                plPythonParameter parameter = GetParameterItem(npm);
-                // is it something that could produce a plNotifiyMsg?
-                if (parameter.fValueType == plPythonParameter::kGUIDialog || parameter.fValueType == plPythonParameter::kGUIPopUpMenu) {
-                    // is there an actual ObjectKey to look at?
-                    if (parameter.fObjectKey) {
-                        // is it the same of the sender of the notify message?
-                        if (pGUIMsg->GetSender()->GetUoid() == parameter.fObjectKey->GetUoid()) {
-                            // match! then set the ID to what the parameter is, so the python programmer can find it
-                            id = parameter.fID;
+
+            // are they looking for an KIMsg message?
+            if (fPyFunctionInstances[kfunc_OnKIMsg]) {
+                pyObjectRef value;
+                switch (pkimsg->GetCommand()) {
+                    case pfKIMsg::kSetChatFadeDelay:
+                        value = PyFloat_FromDouble(pkimsg->GetDelay());
+                        break;
+                    case pfKIMsg::kSetTextChatAdminMode:
+                        value = PyLong_FromLong(pkimsg->GetFlags()&pfKIMsg::kAdminMsg ? 1 : 0 );
+                        break;
+                    case pfKIMsg::kYesNoDialog:
+                        value = PyTuple_New(2);
+                        PyTuple_SET_ITEM(value.Get(), 0, PyUnicode_FromSTString(pkimsg->GetString()));
+                        PyTuple_SET_ITEM(value.Get(), 1, pyKey::New(pkimsg->GetSender()));
+                        break;
+                    case pfKIMsg::kGZInRange:
+                        value = PyTuple_New(2);
+                        PyTuple_SET_ITEM(value.Get(), 0, PyLong_FromLong(pkimsg->GetIntValue()));
+                        PyTuple_SET_ITEM(value.Get(), 1, pyKey::New(pkimsg->GetSender()));
+                        break;
+                    case pfKIMsg::kRateIt:
+                        value = PyTuple_New(3);
+                        PyTuple_SET_ITEM(value.Get(), 0, PyUnicode_FromSTString(pkimsg->GetUser()));
+                        PyTuple_SET_ITEM(value.Get(), 1, PyUnicode_FromSTString(pkimsg->GetString()));
+                        PyTuple_SET_ITEM(value.Get(), 2, PyLong_FromLong(pkimsg->GetIntValue()));
+                        break;
+                    case pfKIMsg::kRegisterImager:
+                        value = PyTuple_New(2);
+                        PyTuple_SET_ITEM(value.Get(), 0, PyUnicode_FromSTString(pkimsg->GetString()));
+                        PyTuple_SET_ITEM(value.Get(), 1, pyKey::New(pkimsg->GetSender()));
+                        break;
+                    case pfKIMsg::kAddPlayerDevice:
+                    case pfKIMsg::kRemovePlayerDevice:
+                        {
+                            ST::string str = pkimsg->GetString();
+                            if (str.empty())
+                                value.SetPyNone();
+                            else
+                                value = PyUnicode_FromSTString(str);
                         }
-                    }
+                        break;
+                    case pfKIMsg::kKIChatStatusMsg:
+                    case pfKIMsg::kKILocalChatStatusMsg:
+                    case pfKIMsg::kKILocalChatErrorMsg:
+                    case pfKIMsg::kKIOKDialog:
+                    case pfKIMsg::kKIOKDialogNoQuit:
+                    case pfKIMsg::kGZFlashUpdate:
+                    case pfKIMsg::kKICreateMarkerNode:
+                        value = PyUnicode_FromSTString(pkimsg->GetString());
+                        break;
+                    case pfKIMsg::kMGStartCGZGame:
+                    case pfKIMsg::kMGStopCGZGame:
+                    case pfKIMsg::kFriendInviteSent:
+                    default:
+                        value = PyLong_FromLong(pkimsg->GetIntValue());
+                        break;
                 }
+
+                ICallScriptMethod(kfunc_OnKIMsg, pkimsg->GetCommand(), std::move(value));
+                return true;
             }
+            break;
         }
 
-        // make sure that we found a control to go with this
-        if (!pyControl)
-            pyControl.SetPyNone();
+        case kfunc_OnMemberUpdate: {
+            // are they looking for an MemberUpdate message?
+            ICallScriptMethod(kfunc_OnMemberUpdate);
+            return true;
+        }
 
-        // call their OnGUINotify method
-        ICallScriptMethod(kfunc_OnGUINotify, id, std::move(pyControl), pGUIMsg->GetEvent());
-        return true;
-    }
+        case kfunc_OnRemoteAvatarInfo: {
+            // are they looking for a RemoteAvatar Info message?
+            plRemoteAvatarInfoMsg* pramsg = plRemoteAvatarInfoMsg::ConvertNoRef(msg);
+            pyObjectRef player;
+            if (pramsg->GetAvatarKey()) {
+                // try to create the pyPlayer for where this message came from
+                plNetTransportMember *mbr = plNetClientMgr::GetInstance()->TransportMgr().GetMemberByKey(pramsg->GetAvatarKey());
+                if (mbr)
+                    player = pyPlayer::New(mbr->GetAvatarKey(), mbr->GetPlayerName(), mbr->GetPlayerID(), mbr->GetDistSq());
+            }
+            if (!player)
+                player = PyLong_FromLong(0);
+            ICallScriptMethod(kfunc_OnRemoteAvatarInfo, std::move(player));
+            return true;
+        }
 
-    // are they looking for an RoomLoadNotify message?
-    auto pRLNMsg = IScriptWantsMsg<plRoomLoadNotifyMsg>(kfunc_OnPageLoad, msg);
-    if (pRLNMsg) {
-        ICallScriptMethod(kfunc_OnPageLoad, pRLNMsg->GetWhatHappen(),
-                          pRLNMsg->GetRoom() ? pRLNMsg->GetRoom()->GetName() : ST::string());
-        return true;
-    }
+        case kfunc_OnCCRMsg: {
+            // are they looking for a CCR communication message?
+            plCCRCommunicationMsg* ccrmsg = plCCRCommunicationMsg::ConvertNoRef(msg);
+            ICallScriptMethod(kfunc_OnCCRMsg, (int)ccrmsg->GetType(), ccrmsg->GetMessageText(), ccrmsg->GetCCRPlayerID());
+            return true;
+        }
 
+        case kfunc_OnVaultNotify: {
+            // are they looking for a VaultNotify message?
+            plVaultNotifyMsg* vaultNotifyMsg = plVaultNotifyMsg::ConvertNoRef(msg);
+            if (IS_NET_SUCCESS(vaultNotifyMsg->GetResultCode())) {
+                // Create a tuple for second argument according to msg type.
+                // Default to an empty tuple.
+                pyObjectRef ptuple;
+                switch (vaultNotifyMsg->GetType()) {
+                    case plVaultNotifyMsg::kRegisteredOwnedAge:
+                    case plVaultNotifyMsg::kRegisteredVisitAge:
+                    case plVaultNotifyMsg::kUnRegisteredOwnedAge:
+                    case plVaultNotifyMsg::kUnRegisteredVisitAge: {
+                        if (hsRef<RelVaultNode> rvn = VaultGetNode(vaultNotifyMsg->GetArgs()->GetInt(plNetCommon::VaultTaskArgs::kAgeLinkNode))) {
+                            ptuple = PyTuple_New(1);
+                            PyTuple_SET_ITEM(ptuple.Get(), 0, pyVaultAgeLinkNode::New(rvn));
+                        }
+                    }
+                    break;
 
-    // are they looking for an ClothingUpdate message?
-    auto pCUMsg = IScriptWantsMsg<plClothingUpdateBCMsg>(kfunc_OnClothingUpdate, msg);
-    if (pCUMsg) {
-        ICallScriptMethod(kfunc_OnClothingUpdate);
-        return true;
-    }
+                    case plVaultNotifyMsg::kPublicAgeCreated:
+                    case plVaultNotifyMsg::kPublicAgeRemoved: {
+                        ST::string ageName = vaultNotifyMsg->GetArgs()->GetString(plNetCommon::VaultTaskArgs::kAgeFilename);
+                        if (!ageName.empty()) {
+                            ptuple = PyTuple_New(1);
+                            PyTuple_SET_ITEM(ptuple.Get(), 0, PyUnicode_FromSTString(ageName));
+                        }
+                    }
+                    break;
 
-    // are they looking for an KIMsg message?
-    auto pkimsg = IScriptWantsMsg<pfKIMsg>(kfunc_OnKIMsg, msg);
-    if (pkimsg && pkimsg->GetCommand() != pfKIMsg::kHACKChatMsg) {
-        pyObjectRef value;
-        switch (pkimsg->GetCommand()) {
-            case pfKIMsg::kSetChatFadeDelay:
-                value = PyFloat_FromDouble(pkimsg->GetDelay());
-                break;
-            case pfKIMsg::kSetTextChatAdminMode:
-                value = PyLong_FromLong(pkimsg->GetFlags()&pfKIMsg::kAdminMsg ? 1 : 0 );
-                break;
-            case pfKIMsg::kYesNoDialog:
-                value = PyTuple_New(2);
-                PyTuple_SET_ITEM(value.Get(), 0, PyUnicode_FromSTString(pkimsg->GetString()));
-                PyTuple_SET_ITEM(value.Get(), 1, pyKey::New(pkimsg->GetSender()));
-                break;
-            case pfKIMsg::kGZInRange:
-                value = PyTuple_New(2);
-                PyTuple_SET_ITEM(value.Get(), 0, PyLong_FromLong(pkimsg->GetIntValue()));
-                PyTuple_SET_ITEM(value.Get(), 1, pyKey::New(pkimsg->GetSender()));
-                break;
-            case pfKIMsg::kRateIt:
-                value = PyTuple_New(3);
-                PyTuple_SET_ITEM(value.Get(), 0, PyUnicode_FromSTString(pkimsg->GetUser()));
-                PyTuple_SET_ITEM(value.Get(), 1, PyUnicode_FromSTString(pkimsg->GetString()));
-                PyTuple_SET_ITEM(value.Get(), 2, PyLong_FromLong(pkimsg->GetIntValue()));
-                break;
-            case pfKIMsg::kRegisterImager:
-                value = PyTuple_New(2);
-                PyTuple_SET_ITEM(value.Get(), 0, PyUnicode_FromSTString(pkimsg->GetString()));
-                PyTuple_SET_ITEM(value.Get(), 1, pyKey::New(pkimsg->GetSender()));
-                break;
-            case pfKIMsg::kAddPlayerDevice:
-            case pfKIMsg::kRemovePlayerDevice:
-                {
-                    ST::string str = pkimsg->GetString();
-                    if (str.empty())
-                        value.SetPyNone();
-                    else
-                        value = PyUnicode_FromSTString(str);
+                    default:
+                        ptuple = PyTuple_New(0);
+                        break;
                 }
-                break;
-            case pfKIMsg::kKIChatStatusMsg:
-            case pfKIMsg::kKILocalChatStatusMsg:
-            case pfKIMsg::kKILocalChatErrorMsg:
-            case pfKIMsg::kKIOKDialog:
-            case pfKIMsg::kKIOKDialogNoQuit:
-            case pfKIMsg::kGZFlashUpdate:
-            case pfKIMsg::kKICreateMarkerNode:
-                value = PyUnicode_FromSTString(pkimsg->GetString());
-                break;
-            case pfKIMsg::kMGStartCGZGame:
-            case pfKIMsg::kMGStopCGZGame:
-            case pfKIMsg::kFriendInviteSent:
-            default:
-                value = PyLong_FromLong(pkimsg->GetIntValue());
-                break;
-        }
 
-        ICallScriptMethod(kfunc_OnKIMsg, pkimsg->GetCommand(), std::move(value));
-        return true;
-    }
+                ICallScriptMethod(kfunc_OnVaultNotify, vaultNotifyMsg->GetType(), std::move(ptuple));
+            }
+            return true;
+        }
 
-    // are they looking for an MemberUpdate message?
-    auto pmumsg = IScriptWantsMsg<plMemberUpdateMsg>(kfunc_OnMemberUpdate, msg);
-    if (pmumsg) {
-        ICallScriptMethod(kfunc_OnMemberUpdate);
-        return true;
-    }
+        case kfunc_AvatarPage: {
+            plPlayerPageMsg* ppMsg = plPlayerPageMsg::ConvertNoRef(msg);
+            pyObjectRef pSobj = pySceneObject::New(ppMsg->fPlayer, fSelfKey);
+            plSynchEnabler ps(true);    // enable dirty state tracking during shutdown
+            ICallScriptMethod(kfunc_AvatarPage, std::move(pSobj), !ppMsg->fUnload, ppMsg->fLastOut);
+            return true;
+        }
 
-    // are they looking for a RemoteAvatar Info message?
-    auto pramsg = IScriptWantsMsg<plRemoteAvatarInfoMsg>(kfunc_OnRemoteAvatarInfo, msg);
-    if (pramsg) {
-        pyObjectRef player;
-        if (pramsg->GetAvatarKey()) {
-            // try to create the pyPlayer for where this message came from
-            plNetTransportMember *mbr = plNetClientMgr::GetInstance()->TransportMgr().GetMemberByKey(pramsg->GetAvatarKey());
-            if (mbr)
-                player = pyPlayer::New(mbr->GetAvatarKey(), mbr->GetPlayerName(), mbr->GetPlayerID(), mbr->GetDistSq());
+        case kfunc_BeginAgeUnLoad: {
+            plAgeBeginLoadingMsg* pABLMsg = plAgeBeginLoadingMsg::ConvertNoRef(msg);
+            pyObjectRef pSobj = pySceneObject::New(plNetClientMgr::GetInstance()->GetLocalPlayerKey(), fSelfKey);
+            plSynchEnabler ps(true);    // enable dirty state tracking during shutdowny
+            ICallScriptMethod(kfunc_BeginAgeUnLoad, std::move(pSobj));
+            return true;
         }
-        if (!player)
-            player = PyLong_FromLong(0);
-        ICallScriptMethod(kfunc_OnRemoteAvatarInfo, std::move(player));
-        return true;
-    }
 
+        case kfunc_OnSDLNotify: {
+            plSDLNotificationMsg* sn = plSDLNotificationMsg::ConvertNoRef(msg);
+            ICallScriptMethod(kfunc_OnSDLNotify, sn->fVar->GetName(), sn->fSDLName,
+                              sn->fPlayerID, sn->fHintString);
+            return true;
+        }
 
-    // are they looking for a CCR communication message?
-    auto ccrmsg = IScriptWantsMsg<plCCRCommunicationMsg>(kfunc_OnCCRMsg, msg);
-    if (ccrmsg) {
-        ICallScriptMethod(kfunc_OnCCRMsg, (int)ccrmsg->GetType(), ccrmsg->GetMessageText(), ccrmsg->GetCCRPlayerID());
-        return true;
-    }
+        case kfunc_OnOwnershipChanged: {
+            // are they looking for a plNetOwnershipMsg message?
+            ICallScriptMethod(kfunc_OnOwnershipChanged);
+            return true;
+        }
 
-    // are they looking for a VaultNotify message?
-    auto vaultNotifyMsg = IScriptWantsMsg<plVaultNotifyMsg>(kfunc_OnVaultNotify, msg);
-    if (vaultNotifyMsg) {
-        if (IS_NET_SUCCESS(vaultNotifyMsg->GetResultCode())) {
-            // Create a tuple for second argument according to msg type.
-            // Default to an empty tuple.
+        case kfunc_OnMarkerMsg: {
+            // are they looking for a pfMarkerMsg message?
+            pfMarkerMsg* markermsg = pfMarkerMsg::ConvertNoRef(msg);
             pyObjectRef ptuple;
-            switch (vaultNotifyMsg->GetType()) {
-                case plVaultNotifyMsg::kRegisteredOwnedAge:
-                case plVaultNotifyMsg::kRegisteredVisitAge:
-                case plVaultNotifyMsg::kUnRegisteredOwnedAge:
-                case plVaultNotifyMsg::kUnRegisteredVisitAge: {
-                    if (hsRef<RelVaultNode> rvn = VaultGetNode(vaultNotifyMsg->GetArgs()->GetInt(plNetCommon::VaultTaskArgs::kAgeLinkNode))) {
-                        ptuple = PyTuple_New(1);
-                        PyTuple_SET_ITEM(ptuple.Get(), 0, pyVaultAgeLinkNode::New(rvn));
-                    }
-                }
-                break;
-
-                case plVaultNotifyMsg::kPublicAgeCreated:
-                case plVaultNotifyMsg::kPublicAgeRemoved: {
-                    ST::string ageName = vaultNotifyMsg->GetArgs()->GetString(plNetCommon::VaultTaskArgs::kAgeFilename);
-                    if (!ageName.empty()) {
-                        ptuple = PyTuple_New(1);
-                        PyTuple_SET_ITEM(ptuple.Get(), 0, PyUnicode_FromSTString(ageName));
-                    }
-                }
-                break;
+            switch (markermsg->fType) {
+                case pfMarkerMsg::kMarkerCaptured:
+                    // Sent when we collide with a marker
+                    ptuple = PyTuple_New(1);
+                    PyTuple_SET_ITEM(ptuple.Get(), 0, PyLong_FromUnsignedLong(markermsg->fMarkerID));
+                    break;
 
                 default:
                     ptuple = PyTuple_New(0);
                     break;
             }
 
-            ICallScriptMethod(kfunc_OnVaultNotify, vaultNotifyMsg->GetType(), std::move(ptuple));
+            ICallScriptMethod(kfunc_OnMarkerMsg, (int)markermsg->fType, std::move(ptuple));
+            return true;
         }
-        return true;
-    }
 
-    // are they looking for a RealTimeChat message?
-    pkimsg = IScriptWantsMsg<pfKIMsg>(kfunc_OnRTChat, msg);
-    if (pkimsg && pkimsg->GetCommand() == pfKIMsg::kHACKChatMsg) {
-        if (!VaultAmIgnoringPlayer(pkimsg->GetPlayerID())) {
-            PyObject* player;
-            plNetTransportMember *mbr = plNetClientMgr::GetInstance()->TransportMgr().GetMemberByID(pkimsg->GetPlayerID());
-            if (mbr) {
-                player = pyPlayer::New(mbr->GetAvatarKey(), pkimsg->GetUser(), mbr->GetPlayerID(), mbr->GetDistSq());
+#ifndef PLASMA_EXTERNAL_RELEASE
+        case kfunc_OnBackdoorMsg: {
+            // are they looking for a pfBackdoorMsg message?
+            pfBackdoorMsg* dt = pfBackdoorMsg::ConvertNoRef(msg);
+            ICallScriptMethod(kfunc_OnBackdoorMsg, dt->GetTarget(), dt->GetString());
+            return true;
+        }
+#endif  //PLASMA_EXTERNAL_RELEASE
+
+        case kfunc_OnLOSNotify: {
+            // are they looking for a plLOSHitMsg message?
+            plLOSHitMsg* pLOSMsg = plLOSHitMsg::ConvertNoRef(msg);
+            pyObjectRef scobj;
+            pyObjectRef hitpoint;
+            if (pLOSMsg->fObj && plSceneObject::ConvertNoRef(pLOSMsg->fObj->ObjectIsLoaded())) {
+                scobj = pySceneObject::New(pLOSMsg->fObj);
+                hitpoint = pyPoint3::New(pLOSMsg->fHitPoint);
             } else {
-                // else if we could not find the player in our list, then just return a string of the user's name
-                ST::string fromName = pkimsg->GetUser();
-                if (fromName.empty())
-                    fromName = ST_LITERAL("Anonymous Coward");
-                player = pyPlayer::New(plNetClientMgr::GetInstance()->GetLocalPlayerKey(), fromName, pkimsg->GetPlayerID(), 0.0);
+                scobj.SetPyNone();
+                hitpoint.SetPyNone();
             }
 
-            ICallScriptMethod(kfunc_OnRTChat, player, pkimsg->GetString(), pkimsg->GetFlags());
+            ICallScriptMethod(
+                kfunc_OnLOSNotify,
+                pLOSMsg->fRequestID,
+                pLOSMsg->fNoHit,
+                std::move(scobj),
+                std::move(hitpoint),
+                pLOSMsg->fDistance
+            );
+            return true;
         }
-    }
-
-    auto ppMsg = IScriptWantsMsg<plPlayerPageMsg>(kfunc_AvatarPage, msg);
-    if (ppMsg) {
-        pyObjectRef pSobj = pySceneObject::New(ppMsg->fPlayer, fSelfKey);
-        plSynchEnabler ps(true);    // enable dirty state tracking during shutdown
-        ICallScriptMethod(kfunc_AvatarPage, std::move(pSobj), !ppMsg->fUnload, ppMsg->fLastOut);
-        return true;
-    }
 
-    auto pABLMsg = IScriptWantsMsg<plAgeBeginLoadingMsg>(kfunc_BeginAgeUnLoad, msg);
-    if (pABLMsg) {
-        pyObjectRef pSobj = pySceneObject::New(plNetClientMgr::GetInstance()->GetLocalPlayerKey(), fSelfKey);
-        plSynchEnabler ps(true);    // enable dirty state tracking during shutdowny
-        ICallScriptMethod(kfunc_BeginAgeUnLoad, std::move(pSobj));
-        return true;
-    }
+        case kfunc_OnBehaviorNotify: {
+            // are they looking for a plAvatarBehaviorNotifyMsg message?
+            plAvatarBehaviorNotifyMsg* behNotifymsg = plAvatarBehaviorNotifyMsg::ConvertNoRef(msg);
+            // the parent of the sender should be the avatar that did the behavior
+            pyObjectRef pSobj;
 
-    // initial server update complete message
-    if (plInitialAgeStateLoadedMsg::ConvertNoRef(msg)) {
-        IInitialStateLoaded();
-        return true;
-    }
-
-    auto sn = IScriptWantsMsg<plSDLNotificationMsg>(kfunc_OnSDLNotify, msg);
-    if (sn) {
-        ICallScriptMethod(kfunc_OnSDLNotify, sn->fVar->GetName(), sn->fSDLName,
-                          sn->fPlayerID, sn->fHintString);
-        return true;
-    }
-
-    // are they looking for a plNetOwnershipMsg message?
-    auto nom = IScriptWantsMsg<plNetOwnershipMsg>(kfunc_OnOwnershipChanged, msg);
-    if (nom) {
-        ICallScriptMethod(kfunc_OnOwnershipChanged);
-        return true;
-    }
-
-    // are they looking for a pfMarkerMsg message?
-    auto markermsg = IScriptWantsMsg<pfMarkerMsg>(kfunc_OnMarkerMsg, msg);
-    if (markermsg) {
-        pyObjectRef ptuple;
-        switch (markermsg->fType) {
-            case pfMarkerMsg::kMarkerCaptured:
-                // Sent when we collide with a marker
-                ptuple = PyTuple_New(1);
-                PyTuple_SET_ITEM(ptuple.Get(), 0, PyLong_FromUnsignedLong(markermsg->fMarkerID));
-                break;
+            plModifier* avmod = plModifier::ConvertNoRef(behNotifymsg->GetSender()->ObjectIsLoaded());
+            if (avmod && avmod->GetNumTargets())
+                pSobj = pySceneObject::New(avmod->GetTarget(0)->GetKey(), fSelfKey);
+            else
+                pSobj.SetPyNone();
 
-            default:
-                ptuple = PyTuple_New(0);
-                break;
+            ICallScriptMethod(
+                kfunc_OnBehaviorNotify,
+                behNotifymsg->fType,
+                std::move(pSobj),
+                behNotifymsg->state
+            );
+            return true;
         }
 
-        ICallScriptMethod(kfunc_OnMarkerMsg, (int)markermsg->fType, std::move(ptuple));
-        return true;
-    }
-
-#ifndef PLASMA_EXTERNAL_RELEASE
-    // are they looking for a pfBackdoorMsg message?
-    auto dt = IScriptWantsMsg<pfBackdoorMsg>(kfunc_OnBackdoorMsg, msg);
-    if (dt) {
-        ICallScriptMethod(kfunc_OnBackdoorMsg, dt->GetTarget(), dt->GetString());
-        return true;
-    }
-#endif  //PLASMA_EXTERNAL_RELEASE
+        case kfunc_OnMovieEvent: {
+            // are they looking for a pfMovieEventMsg message?
+            pfMovieEventMsg* moviemsg = pfMovieEventMsg::ConvertNoRef(msg);
+            ICallScriptMethod(kfunc_OnMovieEvent, moviemsg->fMovieName.AsString(),
+                              (int)moviemsg->fReason);
+            return true;
+        }
 
-    // are they looking for a plLOSHitMsg message?
-    auto pLOSMsg = IScriptWantsMsg<plLOSHitMsg>(kfunc_OnLOSNotify, msg);
-    if (pLOSMsg) {
-        pyObjectRef scobj;
-        pyObjectRef hitpoint;
-        if (pLOSMsg->fObj && plSceneObject::ConvertNoRef(pLOSMsg->fObj->ObjectIsLoaded())) {
-            scobj = pySceneObject::New(pLOSMsg->fObj);
-            hitpoint = pyPoint3::New(pLOSMsg->fHitPoint);
-        } else {
-            scobj.SetPyNone();
-            hitpoint.SetPyNone();
+        case kfunc_OnScreenCaptureDone: {
+            // are they looking for a plCaptureRenderMsg message?
+            plCaptureRenderMsg* capturemsg = plCaptureRenderMsg::ConvertNoRef(msg);
+            pyObjectRef pSobj;
+            if (capturemsg->GetMipmap())
+                pSobj = pyImage::New(capturemsg->GetMipmap());
+            else
+                pSobj.SetPyNone();
+            ICallScriptMethod(kfunc_OnScreenCaptureDone, std::move(pSobj));
+            return true;
         }
 
-        ICallScriptMethod(
-            kfunc_OnLOSNotify,
-            pLOSMsg->fRequestID,
-            pLOSMsg->fNoHit,
-            std::move(scobj),
-            std::move(hitpoint),
-            pLOSMsg->fDistance
-        );
-        return true;
-    }
+        case kfunc_OnClimbingBlockerEvent: {
+            plClimbEventMsg* pEvent = plClimbEventMsg::ConvertNoRef(msg);
+            pyObjectRef pSobj = pySceneObject::New(pEvent->GetSender(), fSelfKey);
+            ICallScriptMethod(kfunc_OnClimbingBlockerEvent, std::move(pSobj));
+            return true;
+        }
 
-    // are they looking for a plAvatarBehaviorNotifyMsg message?
-    auto behNotifymsg = IScriptWantsMsg<plAvatarBehaviorNotifyMsg>(kfunc_OnBehaviorNotify, msg);
-    if (behNotifymsg) {
-        // the parent of the sender should be the avatar that did the behavior
-        pyObjectRef pSobj;
-
-        plModifier* avmod = plModifier::ConvertNoRef(behNotifymsg->GetSender()->ObjectIsLoaded());
-        if (avmod && avmod->GetNumTargets())
-            pSobj = pySceneObject::New(avmod->GetTarget(0)->GetKey(), fSelfKey);
-        else
-            pSobj.SetPyNone();
-
-        ICallScriptMethod(
-            kfunc_OnBehaviorNotify,
-            behNotifymsg->fType,
-            std::move(pSobj),
-            behNotifymsg->state
-        );
-        return true;
-    }
+        case kfunc_OnAvatarSpawn: {
+            ICallScriptMethod(kfunc_OnAvatarSpawn, true);
+            return true;
+        }
 
-    // are they looking for a pfMovieEventMsg message?
-    auto moviemsg = IScriptWantsMsg<pfMovieEventMsg>(kfunc_OnMovieEvent, msg);
-    if (moviemsg) {
-        ICallScriptMethod(kfunc_OnMovieEvent, moviemsg->fMovieName.AsString(),
-                          (int)moviemsg->fReason);
-        return true;
-    }
+        case kfunc_OnAccountUpdate: {
+            plAccountUpdateMsg* pUpdateMsg = plAccountUpdateMsg::ConvertNoRef(msg);
+            ICallScriptMethod(kfunc_OnAccountUpdate, pUpdateMsg->GetUpdateType(), pUpdateMsg->GetResult(),
+                              pUpdateMsg->GetPlayerInt());
+            return true;
+        }
 
-    // are they looking for a plCaptureRenderMsg message?
-    auto capturemsg = IScriptWantsMsg<plCaptureRenderMsg>(kfunc_OnScreenCaptureDone, msg);
-    if (capturemsg) {
-        pyObjectRef pSobj;
-        if (capturemsg->GetMipmap())
-            pSobj = pyImage::New(capturemsg->GetMipmap());
-        else
-            pSobj.SetPyNone();
-        ICallScriptMethod(kfunc_OnScreenCaptureDone, std::move(pSobj));
-        return true;
-    }
+        case kfunc_gotPublicAgeList: {
+            plNetCommPublicAgeListMsg* pPubAgeMsg = plNetCommPublicAgeListMsg::ConvertNoRef(msg);
+            PyObject* pyEL = PyTuple_New(pPubAgeMsg->ages.size());
+            for (size_t i = 0; i < pPubAgeMsg->ages.size(); ++i) {
+                plAgeInfoStruct ageInfo;
+                ageInfo.CopyFrom(pPubAgeMsg->ages[i]);
+                unsigned nPlayers = pPubAgeMsg->ages[i].currentPopulation;
+                unsigned nOwners = pPubAgeMsg->ages[i].population;
+
+                PyObject* t = PyTuple_New(3);
+                PyTuple_SET_ITEM(t, 0, pyAgeInfoStruct::New(&ageInfo));
+                PyTuple_SET_ITEM(t, 1, PyLong_FromUnsignedLong(nPlayers));
+                PyTuple_SET_ITEM(t, 2, PyLong_FromUnsignedLong(nOwners));
+                PyTuple_SET_ITEM(pyEL, i, t);
+            }
 
-    auto pEvent = IScriptWantsMsg<plClimbEventMsg>(kfunc_OnClimbingBlockerEvent, msg);
-    if (pEvent) {
-        pyObjectRef pSobj = pySceneObject::New(pEvent->GetSender(), fSelfKey);
-        ICallScriptMethod(kfunc_OnClimbingBlockerEvent, std::move(pSobj));
-        return true;
-    }
+            ICallScriptMethod(kfunc_gotPublicAgeList, pyEL);
+            return true;
+        }
 
-    auto pSpawn = IScriptWantsMsg<plAvatarSpawnNotifyMsg>(kfunc_OnAvatarSpawn, msg);
-    if (pSpawn) {
-        ICallScriptMethod(kfunc_OnAvatarSpawn, true);
-        return true;
-    }
+        case kfunc_OnAIMsg: {
+            plAIMsg* aiMsg = plAIMsg::ConvertNoRef(msg);
+            // grab the sender (the armature mod that has our brain)
+            plArmatureMod* armMod = plArmatureMod::ConvertNoRef(aiMsg->GetSender()->ObjectIsLoaded());
+            pyObjectRef brainObj;
+            if (armMod) {
+                plArmatureBrain* brain = armMod->FindBrainByClass(plAvBrainCritter::Index());
+                plAvBrainCritter* critterBrain = plAvBrainCritter::ConvertNoRef(brain);
+                if (critterBrain)
+                    brainObj = pyCritterBrain::New(critterBrain);
+            }
+            if (!brainObj)
+                brainObj.SetPyNone();
+
+            // set up the msg type and any args, based on the message we got
+            int msgType = plAIMsg::kAIMsg_Unknown;
+            pyObjectRef args;
+
+            if (plAIBrainCreatedMsg::ConvertNoRef(aiMsg)) {
+                msgType = plAIMsg::kAIMsg_BrainCreated;
+            } else if (auto* arrivedMsg = plAIArrivedAtGoalMsg::ConvertNoRef(aiMsg)) {
+                msgType = plAIMsg::kAIMsg_ArrivedAtGoal;
+                args = PyTuple_New(1);
+                PyTuple_SetItem(args.Get(), 0, pyPoint3::New(arrivedMsg->Goal()));
+            } else if (plAIBrainDestroyedMsg::ConvertNoRef(aiMsg)) {
+                msgType = plAIMsg::kAIMsg_BrainDestroyed;
+            } else if (auto* goToMsg = plAIGoToGoalMsg::ConvertNoRef(aiMsg)) {
+                msgType = plAIMsg::kAIMsg_GoToGoal;
+                args = plPython::ConvertFrom(
+                    plPython::ToTuple,
+                    pyPoint3::New(goToMsg->Goal()),
+                    goToMsg->AvoidingAvatars()
+                );
+            }
 
-    auto pUpdateMsg = IScriptWantsMsg<plAccountUpdateMsg>(kfunc_OnAccountUpdate, msg);
-    if (pUpdateMsg) {
-        ICallScriptMethod(kfunc_OnAccountUpdate, pUpdateMsg->GetUpdateType(), pUpdateMsg->GetResult(),
-                          pUpdateMsg->GetPlayerInt());
-        return true;
-    }
+            // if no args were set, simply set to none
+            if (!args)
+                args.SetPyNone();
 
-    auto pPubAgeMsg = IScriptWantsMsg<plNetCommPublicAgeListMsg>(kfunc_gotPublicAgeList, msg);
-    if (pPubAgeMsg) {
-        PyObject* pyEL = PyTuple_New(pPubAgeMsg->ages.size());
-        for (size_t i = 0; i < pPubAgeMsg->ages.size(); ++i) {
-            plAgeInfoStruct ageInfo;
-            ageInfo.CopyFrom(pPubAgeMsg->ages[i]);
-            unsigned nPlayers = pPubAgeMsg->ages[i].currentPopulation;
-            unsigned nOwners = pPubAgeMsg->ages[i].population;
-
-            PyObject* t = PyTuple_New(3);
-            PyTuple_SET_ITEM(t, 0, pyAgeInfoStruct::New(&ageInfo));
-            PyTuple_SET_ITEM(t, 1, PyLong_FromUnsignedLong(nPlayers));
-            PyTuple_SET_ITEM(t, 2, PyLong_FromUnsignedLong(nOwners));
-            PyTuple_SET_ITEM(pyEL, i, t);
+            ICallScriptMethod(
+                kfunc_OnAIMsg,
+                std::move(brainObj),
+                msgType,
+                aiMsg->BrainUserString(),
+                std::move(args)
+            );
+            return true;
         }
 
-        ICallScriptMethod(kfunc_gotPublicAgeList, pyEL);
-        return true;
-    }
-
-    auto aiMsg = IScriptWantsMsg<plAIMsg>(kfunc_OnAIMsg, msg);
-    if (aiMsg) {
-        // grab the sender (the armature mod that has our brain)
-        plArmatureMod* armMod = plArmatureMod::ConvertNoRef(aiMsg->GetSender()->ObjectIsLoaded());
-        pyObjectRef brainObj;
-        if (armMod) {
-            plArmatureBrain* brain = armMod->FindBrainByClass(plAvBrainCritter::Index());
-            plAvBrainCritter* critterBrain = plAvBrainCritter::ConvertNoRef(brain);
-            if (critterBrain)
-                brainObj = pyCritterBrain::New(critterBrain);
-        }
-        if (!brainObj)
-            brainObj.SetPyNone();
-
-        // set up the msg type and any args, based on the message we got
-        int msgType = plAIMsg::kAIMsg_Unknown;
-        pyObjectRef args;
-
-        if (plAIBrainCreatedMsg::ConvertNoRef(aiMsg)) {
-            msgType = plAIMsg::kAIMsg_BrainCreated;
-        } else if (auto* arrivedMsg = plAIArrivedAtGoalMsg::ConvertNoRef(aiMsg)) {
-            msgType = plAIMsg::kAIMsg_ArrivedAtGoal;
-            args = PyTuple_New(1);
-            PyTuple_SetItem(args.Get(), 0, pyPoint3::New(arrivedMsg->Goal()));
-        } else if (plAIBrainDestroyedMsg::ConvertNoRef(aiMsg)) {
-            msgType = plAIMsg::kAIMsg_BrainDestroyed;
-        } else if (auto* goToMsg = plAIGoToGoalMsg::ConvertNoRef(aiMsg)) {
-            msgType = plAIMsg::kAIMsg_GoToGoal;
-            args = plPython::ConvertFrom(
-                plPython::ToTuple,
-                pyPoint3::New(goToMsg->Goal()),
-                goToMsg->AvoidingAvatars()
+        case kfunc_OnGameScoreMsg: {
+            pfGameScoreMsg* pScoreMsg = pfGameScoreMsg::ConvertNoRef(msg);
+            pyObjectRef score = pyGameScoreMsg::CreateFinal(pScoreMsg);
+            ICallScriptMethod(
+                kfunc_OnGameScoreMsg,
+                std::move(score)
             );
+            return true;
         }
 
-        // if no args were set, simply set to none
-        if (!args)
-            args.SetPyNone();
-
-        ICallScriptMethod(
-            kfunc_OnAIMsg,
-            std::move(brainObj),
-            msgType,
-            aiMsg->BrainUserString(),
-            std::move(args)
-        );
-        return true;
-    }
-
-    auto pScoreMsg = IScriptWantsMsg<pfGameScoreMsg>(kfunc_OnGameScoreMsg, msg);
-    if (pScoreMsg) {
-        pyObjectRef score = pyGameScoreMsg::CreateFinal(pScoreMsg);
-        ICallScriptMethod(
-            kfunc_OnGameScoreMsg,
-            std::move(score)
-        );
-        return true;
-    }
-
-    // are they looking for a subtitle notification message?
-    auto pSubMsg = IScriptWantsMsg<plSubtitleMsg>(kfunc_OnSubtitleMsg, msg);
-    if (pSubMsg) {
-        ICallScriptMethod(kfunc_OnSubtitleMsg, pSubMsg->GetText(), pSubMsg->GetSpeaker());
-        return true;
+        case kfunc_OnSubtitleMsg: {
+            // are they looking for a subtitle notification message?
+            plSubtitleMsg* pSubMsg = plSubtitleMsg::ConvertNoRef(msg);
+            ICallScriptMethod(kfunc_OnSubtitleMsg, pSubMsg->GetText(), pSubMsg->GetSpeaker());
+            return true;
+        }
     }
 
     return plModifier::MsgReceive(msg);
@@ -1616,6 +1699,9 @@ bool plPythonFileMod::MsgReceive(plMessage* msg)
 //
 void plPythonFileMod::ReportError()
 {
+    // keep anything the script printed before it failed ahead of the error
+    PythonInterface::FlushOutput();
+
     ST::string objectName = this->GetKeyName();
     objectName += " - ";
 
@@ -50,6 +50,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 //
 //////////////////////////////////////////////////////////////////////
 
+#include <unordered_map>
+
 #include "pnModifier/plMultiModifier.h"
 #include "plPythonParameter.h"
 
@@ -57,6 +59,7 @@ class PythonVaultCallback;
 class plPythonSDLModifier;
 class pfPythonKeyCatcher;
 class plPipeline;
+class plPythonScriptStats;
 
 typedef struct _object PyObject;
 
@@ -108,8 +111,20 @@ private:
         kfunc_lastone
     };
 
-    template<typename T>
-    T* IScriptWantsMsg(func_num methodId, plMessage* msg) const;
+    /** Parts of MsgReceive that aren't a script method */
+    enum msg_route
+    {
+        kRoute_None = kfunc_lastone,
+        kRoute_GenRef,
+        kRoute_AgeLoaded,
+        kRoute_Render,
+        kRoute_InitialStateLoaded,
+    };
+
+    /** Where each class of message we've been sent goes, either a func_num or a msg_route */
+    std::unordered_map<uint16_t, int> fMsgRoutes;
+
+    int IGetMsgRoute(plMessage* msg);
 
     /**
      * \brief Calls a bound method in this Python script.
@@ -168,6 +183,9 @@ protected:
     /** This python script is attached to a cloned key */
     bool        fAmIAttachedToClone;
 
+    /** Call counts and timings for this script's handlers (shared with other copies of it) */
+    plPythonScriptStats* fScriptStats;
+
     // callback class for the KI
     PythonVaultCallback* fVaultCallback;
     pfPythonKeyCatcher * fKeyCatcher;
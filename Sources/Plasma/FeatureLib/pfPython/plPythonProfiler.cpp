@@ -0,0 +1,269 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <Python.h>
+#include <frameobject.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string_theory/format>
+#include <string_theory/string_stream>
+
+#include "HeadSpin.h"
+#include "hsTimer.h"
+#include "plFileSystem.h"
+#include "plProfile.h"
+
+#include "plPythonProfiler.h"
+#include "cyPythonInterface.h"
+#include "pyGlueHelpers.h"
+
+plProfile_CreateTimer("Scripts", "Python", PythonScripts);
+plProfile_CreateCounter("Script Calls", "Python", PythonScriptCalls);
+
+static const ST::string kStacksFile = ST_LITERAL("PythonStacks.txt");
+
+/////////////////////////////////////////////////////////////////////////////
+
+plPythonScriptStats::plPythonScriptStats(ST::string script, const char* const* handlerNames)
+    : fScript(std::move(script)), fHandlerNames(handlerNames)
+{
+    size_t numHandlers = 0;
+    while (handlerNames[numHandlers])
+        ++numHandlers;
+    fHandlers.resize(numHandlers);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+plPythonProfiler::plPythonProfiler()
+    : fCurrScript(), fCurrHandler(), fDepth(),
+      fSampling(), fSampleInterval(), fNextSample(), fNumSamples()
+{
+}
+
+plPythonProfiler& plPythonProfiler::Instance()
+{
+    static plPythonProfiler theInstance;
+    return theInstance;
+}
+
+plPythonScriptStats* plPythonProfiler::GetScriptStats(const ST::string& script, const char* const* handlerNames)
+{
+    auto it = fScripts.find(script);
+    if (it == fScripts.end())
+        it = fScripts.emplace(std::piecewise_construct, std::forward_as_tuple(script),
+                              std::forward_as_tuple(script, handlerNames)).first;
+    return &it->second;
+}
+
+void plPythonProfiler::ResetStats()
+{
+    // the plPythonFileMods hang on to their stats, so just zero them
+    for (auto& script : fScripts)
+        std::fill(script.second.fHandlers.begin(), script.second.fHandlers.end(), plPythonScriptStats::Handler());
+}
+
+std::vector<ST::string> plPythonProfiler::GetTopHandlers(size_t count) const
+{
+    std::vector<std::pair<const plPythonScriptStats*, size_t>> handlers;
+    for (const auto& script : fScripts) {
+        for (size_t i = 0; i < script.second.fHandlers.size(); ++i) {
+            if (script.second.fHandlers[i].fCalls)
+                handlers.emplace_back(&script.second, i);
+        }
+    }
+
+    count = std::min(count, handlers.size());
+    std::partial_sort(handlers.begin(), handlers.begin() + count, handlers.end(),
+        [](const auto& lhs, const auto& rhs) {
+            return lhs.first->fHandlers[lhs.second].fTotal > rhs.first->fHandlers[rhs.second].fTotal;
+        }
+    );
+
+    std::vector<ST::string> lines;
+    lines.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const plPythonScriptStats* script = handlers[i].first;
+        const plPythonScriptStats::Handler& handler = script->fHandlers[handlers[i].second];
+        double total = hsTimer::GetMilliSeconds<double>(handler.fTotal);
+        lines.emplace_back(ST::format("{}.{}: {} calls, {.2f} ms total, {.3f} ms avg, {.3f} ms max",
+                                      script->fScript, script->fHandlerNames[handlers[i].second],
+                                      handler.fCalls, total, total / handler.fCalls,
+                                      hsTimer::GetMilliSeconds<double>(handler.fMax)));
+    }
+    return lines;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Sampling
+//
+//  Python only lets us hook into calls and returns, so rather than a timer
+//  interrupting the scripts we take a sample at the first call or return
+//  after each interval. That's plenty to see which scripts and functions
+//  the time goes to, and it costs nothing when it isn't turned on.
+//
+
+void plPythonProfiler::StartSampling(uint32_t intervalMs)
+{
+    fStacks.clear();
+    fNumSamples = 0;
+    // hsTimer ticks are in the high resolution clock's units
+    auto interval = std::chrono::milliseconds(std::max(intervalMs, 1U));
+    fSampleInterval = std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(interval).count();
+    fNextSample = hsTimer::GetTicks() + fSampleInterval;
+
+    fSampling = true;
+    PyEval_SetProfile(ISampleHook, nullptr);
+}
+
+plFileName plPythonProfiler::StopSampling()
+{
+    if (!fSampling)
+        return {};
+
+    PyEval_SetProfile(nullptr, nullptr);
+    fSampling = false;
+
+    plFileName path = plFileName::Join(plFileSystem::GetLogPath(), kStacksFile);
+    FILE* file = plFileSystem::Open(path, "wb");
+    if (!file)
+        return {};
+
+    for (const auto& stack : fStacks)
+        fputs(ST::format("{} {}\n", stack.first, stack.second).c_str(), file);
+    fclose(file);
+
+    PythonInterface::WriteToLog(ST::format("Wrote {} Python samples ({} stacks) to {}",
+                                           fNumSamples, fStacks.size(), path));
+    fStacks.clear();
+    return path;
+}
+
+int plPythonProfiler::ISampleHook(PyObject* obj, PyFrameObject* frame, int what, PyObject* arg)
+{
+    plPythonProfiler& profiler = Instance();
+    uint64_t now = hsTimer::GetTicks();
+    if (now >= profiler.fNextSample) {
+        profiler.fNextSample = now + profiler.fSampleInterval;
+        profiler.ISample(frame);
+    }
+    return 0;
+}
+
+static ST::string GetFrameName(PyCodeObject* code)
+{
+    plFileName file = PyUnicode_AsSTString(code->co_filename);
+    return ST::format("{}:{}", file.GetFileNameNoExt(), PyUnicode_AsSTString(code->co_name));
+}
+
+void plPythonProfiler::ISample(void* frameObj)
+{
+    // Collapsed stacks go outermost first, separated by semicolons
+    std::vector<ST::string> frames;
+#if PY_VERSION_HEX >= 0x03090000
+    PyFrameObject* frame = (PyFrameObject*)frameObj;
+    Py_XINCREF(frame);
+    while (frame) {
+        PyCodeObject* code = PyFrame_GetCode(frame);
+        frames.emplace_back(GetFrameName(code));
+        Py_DECREF(code);
+
+        PyFrameObject* back = PyFrame_GetBack(frame);
+        Py_DECREF(frame);
+        frame = back;
+    }
+#else
+    for (PyFrameObject* frame = (PyFrameObject*)frameObj; frame; frame = frame->f_back)
+        frames.emplace_back(GetFrameName(frame->f_code));
+#endif
+
+    ST::string_stream stack;
+    if (fCurrScript)
+        stack << fCurrScript->fScript << '.' << fCurrScript->fHandlerNames[fCurrHandler];
+    else
+        stack << "(no script)";
+    for (auto it = frames.rbegin(); it != frames.rend(); ++it)
+        stack << ';' << *it;
+
+    fStacks[stack.to_string()]++;
+    fNumSamples++;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+plPythonScriptTimer::plPythonScriptTimer(plPythonScriptStats* script, size_t handler)
+    : fScript(script), fHandler(handler), fStart()
+{
+    plPythonProfiler& profiler = plPythonProfiler::Instance();
+    fPrevScript = profiler.fCurrScript;
+    fPrevHandler = profiler.fCurrHandler;
+    profiler.fCurrScript = script;
+    profiler.fCurrHandler = handler;
+
+    // scripts can end up calling into other scripts; only the outermost one goes in the
+    // profile display, so nothing gets counted twice there
+    if (profiler.fDepth++ == 0 && script)
+        plProfile_BeginLap(PythonScripts, script->fScript);
+    plProfile_Inc(PythonScriptCalls);
+
+    fStart = hsTimer::GetTicks();
+}
+
+plPythonScriptTimer::~plPythonScriptTimer()
+{
+    uint64_t elapsed = hsTimer::GetTicks() - fStart;
+
+    plPythonProfiler& profiler = plPythonProfiler::Instance();
+    if (--profiler.fDepth == 0 && fScript)
+        plProfile_EndLap(PythonScripts, fScript->fScript);
+    profiler.fCurrScript = fPrevScript;
+    profiler.fCurrHandler = fPrevHandler;
+
+    if (fScript) {
+        plPythonScriptStats::Handler& handler = fScript->fHandlers[fHandler];
+        handler.fCalls++;
+        handler.fTotal += elapsed;
+        handler.fMax = std::max(handler.fMax, elapsed);
+    }
+}
@@ -0,0 +1,146 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+#ifndef _plPythonProfiler_h_
+#define _plPythonProfiler_h_
+
+//////////////////////////////////////////////////////////////////////
+//
+// plPythonProfiler   - keeps track of where the Python scripts spend
+//                      their time
+//
+// Every script callback is counted and timed per script file and
+// handler. It's only a couple of clock reads per call, so it's always
+// on. A sampling profiler that writes collapsed stacks (for flame graph
+// tools) can be turned on from the console as well.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "HeadSpin.h"
+
+#include <map>
+#include <string_theory/string>
+#include <unordered_map>
+#include <vector>
+
+class plFileName;
+typedef struct _object PyObject;
+
+class plPythonScriptStats
+{
+public:
+    struct Handler
+    {
+        uint32_t    fCalls;
+        uint64_t    fTotal;     // hsTimer ticks
+        uint64_t    fMax;
+
+        Handler() : fCalls(), fTotal(), fMax() { }
+    };
+
+    ST::string              fScript;
+    const char* const*      fHandlerNames;
+    std::vector<Handler>    fHandlers;
+
+    plPythonScriptStats(ST::string script, const char* const* handlerNames);
+};
+
+class plPythonProfiler
+{
+    friend class plPythonScriptTimer;
+
+    std::map<ST::string, plPythonScriptStats, ST::less_i> fScripts;
+
+    // what's running right now, for the sampler
+    const plPythonScriptStats*  fCurrScript;
+    size_t                      fCurrHandler;
+    uint32_t                    fDepth;
+
+    bool        fSampling;
+    uint64_t    fSampleInterval;
+    uint64_t    fNextSample;
+    uint32_t    fNumSamples;
+    std::unordered_map<ST::string, uint32_t, ST::hash> fStacks;
+
+    plPythonProfiler();
+
+    void ISample(void* frame);
+    static int ISampleHook(PyObject* obj, struct _frame* frame, int what, PyObject* arg);
+
+public:
+    static plPythonProfiler& Instance();
+
+    /**
+     * Gets the stats for every plPythonFileMod running this script.
+     * \param handlerNames nullptr terminated list of the script's handlers
+     */
+    plPythonScriptStats* GetScriptStats(const ST::string& script, const char* const* handlerNames);
+
+    void ResetStats();
+
+    /** Lines describing the top handlers by total time, worst first */
+    std::vector<ST::string> GetTopHandlers(size_t count) const;
+
+    bool IsSampling() const { return fSampling; }
+    void StartSampling(uint32_t intervalMs);
+
+    /** Stops sampling and writes the stacks out; returns where they were written */
+    plFileName StopSampling();
+};
+
+/** Times one script callback for as long as it's in scope */
+class plPythonScriptTimer
+{
+    plPythonScriptStats*        fScript;
+    size_t                      fHandler;
+    uint64_t                    fStart;
+    const plPythonScriptStats*  fPrevScript;
+    size_t                      fPrevHandler;
+
+public:
+    plPythonScriptTimer(plPythonScriptStats* script, size_t handler);
+    ~plPythonScriptTimer();
+
+    plPythonScriptTimer(const plPythonScriptTimer&) = delete;
+    plPythonScriptTimer(plPythonScriptTimer&&) = delete;
+};
+
+#endif // _plPythonProfiler_h_
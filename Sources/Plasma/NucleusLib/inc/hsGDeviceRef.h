@@ -51,12 +51,18 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "hsRefCnt.h"
 
+#include <algorithm>
+
 
 class hsGDeviceRef : public hsRefCnt
 {
 protected:
     uint32_t      fFlags;
 
+    // Sub-rectangle of a dirty surface that actually changed, as
+    // [left, right) x [top, bottom) in pixels. Empty means all of it.
+    uint16_t      fDirtyLeft, fDirtyTop, fDirtyRight, fDirtyBottom;
+
 public:
     // Note, derived classes define more flags. Take care if adding flags here.
     // Currently have flags 0x0 - 0x8 reserved.
@@ -68,9 +74,47 @@ public:
     uint32_t                  fUseTime;       // time stamp when last used - stat gather only
 
     bool IsDirty() const { return (fFlags & kDirty); }
-    void SetDirty(bool on) { if(on)fFlags |= kDirty; else fFlags &= ~kDirty; }
-
-    hsGDeviceRef() : fFlags(0), fUseTime(0) {}
+    void SetDirty(bool on)
+    {
+        if(on)fFlags |= kDirty; else fFlags &= ~kDirty;
+        fDirtyLeft = fDirtyTop = fDirtyRight = fDirtyBottom = 0;
+    }
+
+    // Dirties only part of a surface, so the pipeline can refill just that
+    // region. Regions accumulate until the ref is cleaned, and never shrink
+    // a ref that was already dirtied as a whole.
+    void AddDirtyRegion(uint16_t left, uint16_t top, uint16_t right, uint16_t bottom)
+    {
+        if (left >= right || top >= bottom)
+            return;
+        if (!IsDirty())
+        {
+            fFlags |= kDirty;
+            fDirtyLeft = left;
+            fDirtyTop = top;
+            fDirtyRight = right;
+            fDirtyBottom = bottom;
+        }
+        else if (HasDirtyRegion())
+        {
+            fDirtyLeft = std::min(fDirtyLeft, left);
+            fDirtyTop = std::min(fDirtyTop, top);
+            fDirtyRight = std::max(fDirtyRight, right);
+            fDirtyBottom = std::max(fDirtyBottom, bottom);
+        }
+    }
+    bool HasDirtyRegion() const { return IsDirty() && fDirtyLeft < fDirtyRight && fDirtyTop < fDirtyBottom; }
+    void GetDirtyRegion(uint16_t& left, uint16_t& top, uint16_t& right, uint16_t& bottom) const
+    {
+        left = fDirtyLeft;
+        top = fDirtyTop;
+        right = fDirtyRight;
+        bottom = fDirtyBottom;
+    }
+
+    hsGDeviceRef()
+        : fFlags(0), fDirtyLeft(0), fDirtyTop(0), fDirtyRight(0), fDirtyBottom(0), fUseTime(0)
+    { }
     virtual ~hsGDeviceRef() {}
 };
 
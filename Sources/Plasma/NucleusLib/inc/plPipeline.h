@@ -89,6 +89,7 @@ class plFogEnvironment;
 class plLightInfo;
 class plMipmap;
 class plVisMgr;
+struct plDrawVisList;
 
 class plViewTransform;
 
@@ -171,6 +172,9 @@ public:
     // Called once per scene render. 
     // Returns true if rendering should proceed.
     virtual bool                        PrepForRender(plDrawable* drawable, std::vector<int16_t>& visList, plVisMgr* visMgr=nullptr) = 0;
+    // PrepLightsForRender - optional. Called with all of the drawables about to go through PrepForRender this
+    // render, so the lighting for them can be worked out together instead of one PrepForRender at a time.
+    virtual void                        PrepLightsForRender(const std::vector<plDrawVisList>& drawList, plVisMgr* visMgr) { }
     // Render - draw the drawable to the current render target.
     // visList is read only. On input, visList is SORTED visible spans. May not be the complete list of visible spans
     // for this drawable.
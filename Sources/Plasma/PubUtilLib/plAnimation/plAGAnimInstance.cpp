@@ -55,6 +55,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plAGAnim.h"
 #include "plAGModifier.h"
 #include "plAGMasterMod.h"
+#include "plMatrixChannel.h"
 
 // global
 #include "hsTimer.h"        // just when debugging for GetSysSeconds
@@ -155,6 +156,9 @@ plAGAnimInstance::plAGAnimInstance(plAGAnim * anim, plAGMasterMod * master,
                 IRegisterDetach(channelName, topNode);
             }
 
+            if (plMatrixChannel *leaf = plMatrixChannel::ConvertNoRef(topNode))
+                fKeyLeaves.push_back(leaf);
+
             if(useAmplitude)
             {
                 // amplitude is rarely used and expensive, so only alloc if asked
@@ -278,6 +282,25 @@ void plAGAnimInstance::SearchForGlobals()
     }
 }
 
+// GetKeyRequests ---------------------
+// ---------------
+void plAGAnimInstance::GetKeyRequests(std::vector<plAffineKeyProgram::Request> &requests)
+{
+    if (!fTimeConvert)
+        return;
+
+    // This is the time our plATCChannel hands down to the leaves
+    float time = fTimeConvert->CurrentAnimTime();
+    bool forwards = fTimeConvert->IsForewards();
+
+    plAffineKeyProgram::Request request;
+    for (plMatrixChannel *leaf : fKeyLeaves)
+    {
+        if (leaf->MakeKeyRequest(time, forwards, request))
+            requests.push_back(request);
+    }
+}
+
 void plAGAnimInstance::IRegisterDetach(const ST::string &channelName, plAGChannel *channel)
 {
     plDetachMap::value_type newPair(channelName, channel);
@@ -344,6 +367,7 @@ void plAGAnimInstance::DetachChannels()
         delete fCleanupChannels[j];
     }
     fCleanupChannels.clear();
+    fKeyLeaves.clear();
 
 #ifdef SHOW_AG_CHANGES
     hsStatusMessageF("\nFinished DETACHING anim <{}>", GetName());
@@ -55,6 +55,9 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 // local
 #include "plScalarChannel.h"
 
+// global
+#include "plInterp/plAffineKeyProgram.h"
+
 // declarations
 class plAGChannel;
 class plAGAnim;
@@ -63,6 +66,7 @@ class plAGChannelApplicator;
 class plAnimCmdMsg;
 class plAnimTimeConvert;
 class plATCAnim;
+class plMatrixChannel;
 class plOneShotCallbacks;
 
 /////////////////
@@ -215,6 +219,12 @@ public:
     
     void ProcessFade(float elapsed);             // process any outstanding fades    
     void SearchForGlobals(); // Util function to setup SDL channels
+
+    /** Add requests to evaluate our transform leaves at the time convert's
+        current time to the list, so they can all be done in one pass.
+        Only worth it right after the time convert was advanced to the
+        time the graph is about to be evaluated at. \sa plAffineKeyProgram */
+    void GetKeyRequests(std::vector<plAffineKeyProgram::Request> &requests);
 protected:
     /** Set up bookkeeping for a fade. */
     void ISetupFade(float goal, float rate, bool detach, uint8_t type);
@@ -233,6 +243,7 @@ protected:
 
     std::vector<plAGChannel*> fCleanupChannels;
     std::vector<plScalarSDLChannel*> fSDLChannels;
+    std::vector<plMatrixChannel*> fKeyLeaves;   // transform leaves at the bottom of our graph
 
     plScalarConstant fBlend;        // blend factor vs. previous animations
     plScalarConstant fAmplitude;    // for animation scaling
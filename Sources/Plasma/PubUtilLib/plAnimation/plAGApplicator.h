@@ -137,6 +137,17 @@ public:
     /** Apply our channel's data to the scene object, via the modifier.
         This is the only function that actually changes perceivable scene state. */
     void Apply(const plAGModifier *mod, double time, bool force = false); // Apply our channel's data to the modifier
+
+    /** Evaluate our channel ahead of the next Apply(), without touching any
+        scene state, so it is safe to call from a worker thread as long as
+        nobody else is evaluating the same channels. The next Apply() then
+        just hands the prepared value to the scene object.
+        Returns false if this applicator doesn't support that, in which
+        case Apply() does all of the work as usual. \sa plAGMasterMod */
+    bool Prepare(double time) { return fEnabled ? IPrepare(time) : false; }
+
+    /** Forget anything Prepare() stored, so the next Apply() re-evaluates. */
+    virtual void DiscardPrepared() { }
     
     // this is pretty much a HACK to support applicators that want to stick around when
     // their channel is gone so they can operate on the next channel that comes in
@@ -154,6 +165,7 @@ public:
 protected:
     // -- methods --
     virtual void IApply(const plAGModifier *mod, double time) = 0;
+    virtual bool IPrepare(double time) { return false; }
 
     // give derived classes access to the object interfaces
     plAudioInterface * IGetAI(const plAGModifier *modifier) const;
@@ -47,12 +47,17 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plAGAnimInstance.h"
 #include "plAGModifier.h"
 #include "plMatrixChannel.h"
+#include "plPointChannel.h"
+#include "plScalarChannel.h"
 
 // global
 #include "hsResMgr.h"
+#include "hsThreadPool.h"
 #include "plgDispatch.h"
 
+#include <algorithm>
 #include <string_theory/format>
+#include <unordered_set>
 
 // other
 #include "plInterp/plAnimEaseTypes.h"
@@ -72,6 +77,10 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 // Coordinates the activities of a bunch of plAGModifiers
 // std::map<char *, plAGMasterMod *, stringISorter> plAGMasterMod::fInstances;
 
+std::vector<plAGMasterMod*> plAGMasterMod::fBatchMods;
+double plAGMasterMod::fLastBatchTime = -1.0;
+bool plAGMasterMod::fBatchEval = true;
+
 // CTOR
 plAGMasterMod::plAGMasterMod()
 : fTarget(),
@@ -81,13 +90,18 @@ plAGMasterMod::plAGMasterMod()
   fNeedCompile(false),
   fIsGrouped(false),
   fIsGroupMaster(false),
-  fMsgForwarder()
+  fMsgForwarder(),
+  fBatchEvalTime(-1.0),
+  fInBatch(false),
+  fBatchJob(false),
+  fBatchPrepared(false)
 {
 }
 
 // DTOR
 plAGMasterMod::~plAGMasterMod()
 {
+    IRemoveFromBatch();
 }
 
 void plAGMasterMod::Write(hsStream *stream, hsResMgr *mgr)
@@ -206,6 +220,7 @@ void plAGMasterMod::RemoveTarget(plSceneObject* o)
     delete fAGMasterSDLMod;
     fAGMasterSDLMod = nullptr;
 
+    IRemoveFromBatch();
     fTarget = nullptr;
 }
 
@@ -219,9 +234,47 @@ plProfile_CreateTimer("  AffineCompose", "Animation", AffineCompose);
 plProfile_CreateTimer("  AffineApplicator", "Animation", MatrixApplicator);
 plProfile_CreateTimer("AnimatingPhysicals", "Animation", AnimatingPhysicals);
 plProfile_CreateTimer("StoppedAnimPhysicals", "Animation", StoppedAnimPhysicals);
+plProfile_CreateTimer("AnimBatch", "Animation", AnimBatch);
+plProfile_CreateTimer("  AnimBatchPrepare", "Animation", AnimBatchPrepare);
+plProfile_CreateTimer("  AnimBatchKeys", "Animation", AnimBatchKeys);
+plProfile_CreateTimer("  AnimBatchJobs", "Animation", AnimBatchJobs);
+plProfile_CreateTimer("  AnimBatchCommit", "Animation", AnimBatchCommit);
+plProfile_CreateCounter("AnimBatched", "Animation", AnimBatched);
+plProfile_CreateCounter("AnimBatchSerial", "Animation", AnimBatchSerial);
+plProfile_CreateCounter("AnimBatchConflicts", "Animation", AnimBatchConflicts);
+plProfile_CreateCounter("AnimBatchKeyRequests", "Animation", AnimBatchKeyRequests);
 
 // IEVAL
 bool plAGMasterMod::IEval(double secs, float del, uint32_t dirty)
+{
+    // If someone else's batch already took care of us this frame, there's nothing to do
+    if (fBatchEvalTime != secs)
+    {
+        if (fBatchEval && fLastBatchTime != secs)
+            IEvalBatch(secs, del);
+        else
+        {
+            IFirstEval();
+            ApplyAnimations(secs, del);
+        }
+    }
+
+    // We might get registered for just a single eval. If we don't need to eval anymore, unregister
+    if (!fNeedEval)
+    {
+        plgDispatch::Dispatch()->UnRegisterForExactType(plEvalMsg::Index(), GetKey());
+        IRemoveFromBatch();
+    }
+    else if (!fInBatch)
+    {
+        fBatchMods.push_back(this);
+        fInBatch = true;
+    }
+
+    return true;
+}
+
+void plAGMasterMod::IFirstEval()
 {
     if (fFirstEval)
     {
@@ -231,14 +284,6 @@ bool plAGMasterMod::IEval(double secs, float del, uint32_t dirty)
 
         fFirstEval = false;
     }
-    ApplyAnimations(secs, del);
-    
-    // We might get registered for just a single eval. If we don't need to eval anymore, unregister
-    if (!fNeedEval) 
-        plgDispatch::Dispatch()->UnRegisterForExactType(plEvalMsg::Index(), GetKey());
-
-
-    return true;
 }
 
 // APPLYANIMATIONS
@@ -246,15 +291,178 @@ void plAGMasterMod::ApplyAnimations(double time, float elapsed)
 {
     plProfile_BeginLap(ApplyAnimation, this->GetKey()->GetUoid().GetObjectName());
 
-    // update any fades
+    IProcessFades(elapsed);
+    AdvanceAnimsToTime(time);
+
+    plProfile_EndLap(ApplyAnimation,this->GetKey()->GetUoid().GetObjectName());
+}
+
+void plAGMasterMod::IProcessFades(float elapsed)
+{
     for (int i = 0; i < fAnimInstances.size(); i++)
     {
         fAnimInstances[i]->ProcessFade(elapsed);
     }
-    
-    AdvanceAnimsToTime(time);
+}
 
-    plProfile_EndLap(ApplyAnimation,this->GetKey()->GetUoid().GetObjectName());
+// BATCHED EVALUATION
+// Evaluating the graphs is the expensive part of animation and doesn't touch
+// anything outside of the graph, so for masters that don't share channels we
+// do that on the thread pool. Everything with side effects -- fades, advancing
+// the time converts (which fire callbacks), compiling and pushing transforms
+// into the coordinate interfaces -- stays on this thread, in registration order.
+void plAGMasterMod::IEvalBatch(double secs, float elapsed)
+{
+    plProfile_BeginTiming(AnimBatch);
+
+    fLastBatchTime = secs;
+
+    std::vector<plAGMasterMod*> mods = fBatchMods;
+    if (!fInBatch)
+        mods.push_back(this);
+
+    // Serial prepare: fades and time converts, and work out who can go wide.
+    // Anyone touching a channel mod or private anim already claimed by
+    // an earlier master this frame is evaluated serially instead.
+    plProfile_BeginTiming(AnimBatchPrepare);
+    std::vector<plAGMasterMod*> jobs;
+    jobs.reserve(mods.size());
+    std::unordered_set<const void*> claimed;
+    for (plAGMasterMod* mod : mods)
+    {
+        mod->fBatchEvalTime = secs;
+        mod->fBatchJob = false;
+        mod->fBatchPrepared = false;
+        mod->IFirstEval();
+
+        if (!mod->IIsBatchable())
+            continue;
+
+        bool shared = false;
+        for (const auto& it : mod->fChannelMods)
+            shared |= !claimed.insert(it.second).second;
+        for (plAGAnim* anim : mod->fPrivateAnims)
+            shared |= !claimed.insert(anim).second;
+        if (shared)
+            continue;
+
+        mod->IProcessFades(elapsed);
+        if (mod->fNeedCompile)
+            mod->Compile(secs);
+
+        // Advance the time converts here so the graph only has to read them.
+        // Anything we miss makes the job bail out to a serial evaluation.
+        for (plAGAnimInstance* inst : mod->fATCAnimInstances)
+        {
+            if (inst->GetBlend() > 0.f)
+                inst->GetTimeConvert()->WorldToAnimTime(secs);
+        }
+
+        mod->fBatchJob = true;
+        jobs.push_back(mod);
+    }
+    plProfile_EndTiming(AnimBatchPrepare);
+
+    // Interpolate the transform leaves of every job in one pass, so the
+    // graphs below mostly find their keys already done. Two instances of a
+    // private anim share its leaves; only the first gets them, the other
+    // one interpolates them itself like before.
+    plProfile_BeginTiming(AnimBatchKeys);
+    std::vector<plAffineKeyProgram::Request> keyRequests;
+    std::unordered_set<const void*> keyStates;
+    for (plAGMasterMod* mod : jobs)
+    {
+        for (plAGAnimInstance* inst : mod->fATCAnimInstances)
+        {
+            if (inst->GetBlend() > 0.f && inst->GetTimeConvert()->IsCachedAt(secs))
+                inst->GetKeyRequests(keyRequests);
+        }
+    }
+    keyRequests.erase(std::remove_if(keyRequests.begin(), keyRequests.end(),
+        [&keyStates](const plAffineKeyProgram::Request& request) {
+            return !keyStates.insert(request.fState).second;
+        }), keyRequests.end());
+    plProfile_IncCount(AnimBatchKeyRequests, keyRequests.size());
+    plAffineKeyProgram::Evaluate(keyRequests);
+    plProfile_EndTiming(AnimBatchKeys);
+
+    // The channel timers aren't thread safe, so they sit this part out
+    plProfile_BeginTiming(AnimBatchJobs);
+    plProfile_StopVar(AffineValue);
+    plProfile_StopVar(AffineInterp);
+    plProfile_StopVar(AffineBlend);
+    plProfile_StopVar(AffineCompose);
+    hsThreadPool::Instance().ParallelFor(jobs.size(), 1,
+        [&jobs, secs](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                jobs[i]->fBatchPrepared = jobs[i]->IPrepareAnims(secs);
+        });
+    plProfile_StartVar(AffineValue);
+    plProfile_StartVar(AffineInterp);
+    plProfile_StartVar(AffineBlend);
+    plProfile_StartVar(AffineCompose);
+    plProfile_EndTiming(AnimBatchJobs);
+
+    // Serial commit, in the same order we'd have evaluated in anyway
+    plProfile_BeginTiming(AnimBatchCommit);
+    for (plAGMasterMod* mod : mods)
+    {
+        if (mod->fBatchPrepared)
+        {
+            plProfile_Inc(AnimBatched);
+            mod->AdvanceAnimsToTime(secs);
+            continue;
+        }
+
+        if (mod->fBatchJob)
+        {
+            // Hit a time convert we didn't advance; redo it the old way
+            plProfile_Inc(AnimBatchConflicts);
+            mod->IDiscardPrepared();
+            mod->AdvanceAnimsToTime(secs);
+        }
+        else
+        {
+            plProfile_Inc(AnimBatchSerial);
+            mod->ApplyAnimations(secs, elapsed);
+        }
+    }
+    plProfile_EndTiming(AnimBatchCommit);
+
+    plProfile_EndTiming(AnimBatch);
+}
+
+// Evaluates our graph into the applicators. Runs on the thread pool.
+// Returns false if the graph needed a time convert that wasn't advanced yet.
+bool plAGMasterMod::IPrepareAnims(double time)
+{
+    plATCChannel::BeginBatch();
+    for (const auto& it : fChannelMods)
+        it.second->Prepare(time);
+    return plATCChannel::EndBatch();
+}
+
+void plAGMasterMod::IDiscardPrepared()
+{
+    for (const auto& it : fChannelMods)
+        it.second->DiscardPrepared();
+}
+
+bool plAGMasterMod::IIsBatchable() const
+{
+    // Grouped masters share their anims with the group
+    return !fIsGrouped && fSharedInstances.empty();
+}
+
+void plAGMasterMod::IRemoveFromBatch()
+{
+    if (!fInBatch)
+        return;
+
+    auto it = std::find(fBatchMods.begin(), fBatchMods.end(), this);
+    if (it != fBatchMods.end())
+        fBatchMods.erase(it);
+    fInBatch = false;
 }
 
 void plAGMasterMod::AdvanceAnimsToTime(double time)
@@ -388,6 +596,21 @@ plAGModifier * plAGMasterMod::IFindChannelMod(const plSceneObject *SO, const ST:
     return nullptr;
 }
 
+// Does every channel of this anim get a cache channel of its own when attached
+// with caching? Only controller channels do; anything else is shared.
+static bool AnimHasOwnChannels(const plAGAnim *anim)
+{
+    for (int i = 0; i < anim->GetApplicatorCount(); i++)
+    {
+        plAGChannel *channel = anim->GetApplicator(i)->GetChannel();
+        if (!plMatrixControllerChannel::ConvertNoRef(channel) &&
+            !plPointControllerChannel::ConvertNoRef(channel) &&
+            !plScalarControllerChannel::ConvertNoRef(channel))
+            return false;
+    }
+    return true;
+}
+
 // ATTACHANIMATIONBLENDED(anim, blend)
 plAGAnimInstance * plAGMasterMod::AttachAnimationBlended(plAGAnim *anim,
                                                          float blendFactor /* = 0 */,
@@ -412,6 +635,11 @@ plAGAnimInstance * plAGMasterMod::AttachAnimationBlended(plAGAnim *anim,
         instance = new plAGAnimInstance(anim, this, blendFactor, blendPriority, cache, false);
         fAnimInstances.push_back(instance);
 
+        // Public anims share their channels with everyone else using them,
+        // unless every channel gets its own cache channel.
+        if (i == fPrivateAnims.end() && !(cache && AnimHasOwnChannels(anim)))
+            fSharedInstances.push_back(instance);
+
         plATCAnim *atcAnim = plATCAnim::ConvertNoRef(anim);
         if (atcAnim)
         {
@@ -543,6 +771,7 @@ void plAGMasterMod::DetachAllAnimations()
     fAnimInstances.clear();
     fPrivateAnims.clear();
     fATCAnimInstances.clear();
+    fSharedInstances.clear();
 }
 
 // DETACHANIMATION(plAGAnimInstance *)
@@ -587,6 +816,9 @@ void plAGMasterMod::DetachAnimation(plAGAnimInstance *anim)
             break;
         }
     }
+    i = std::find(fSharedInstances.begin(), fSharedInstances.end(), anim);
+    if (i != fSharedInstances.end())
+        fSharedInstances.erase(i);
 }
 
 // DETACHANIMATION(name)
@@ -781,7 +1013,10 @@ void plAGMasterMod::IRegForEval(bool val)
     if (val)
         plgDispatch::Dispatch()->RegisterForExactType(plEvalMsg::Index(), GetKey());
     else
+    {
         plgDispatch::Dispatch()->UnRegisterForExactType(plEvalMsg::Index(), GetKey());
+        IRemoveFromBatch();
+    }
 }
 
 bool plAGMasterMod::HasRunningAnims()
@@ -49,6 +49,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #define PLAGMASTERMOD_INC
 
 #include <map>
+#include <vector>
 #include "pnModifier/plModifier.h"
 #include "plAGDefs.h"
 
@@ -190,6 +191,15 @@ public:
     void SetIsGrouped(bool grouped);
     void SetIsGroupMaster(bool master, plMsgForwarder* msgForwarder);
 
+    /** Turn batched evaluation on or off.
+        When on, the first master mod to get its eval each frame evaluates the
+        animation graphs of all the other masters that are registered for eval
+        on the thread pool, then hands the results to their scene objects
+        serially, in the same order they were registered. Masters sharing
+        channels with anyone else are still evaluated serially. */
+    static void SetBatchEval(bool on) { fBatchEval = on; }
+    static bool GetBatchEval() { return fBatchEval; }
+
     // PLASMA PROTOCOL
     size_t GetNumTargets() const override { return fTarget ? 1 : 0; }
     plSceneObject* GetTarget(size_t w) const override { /* hsAssert(w < GetNumTargets(), "Bad target"); */ return fTarget; }
@@ -213,6 +223,16 @@ protected:
     plAGModifier * IFindChannelMod(const plSceneObject *obj, const ST::string &name) const;
 
     bool IEval(double secs, float del, uint32_t dirty) override;
+
+    void IFirstEval();
+    void IProcessFades(float elapsed);
+
+    // batched evaluation
+    bool IIsBatchable() const;
+    bool IPrepareAnims(double time);
+    void IDiscardPrepared();
+    void IEvalBatch(double secs, float elapsed);
+    void IRemoveFromBatch();
     
     virtual void IApplyDynamic() {};    // dummy function required by base class
 
@@ -236,6 +256,9 @@ protected:
 
     // animations that require AnimTimeConvert state to be synched
     plInstanceVector fATCAnimInstances;
+
+    // instances whose channels may be shared with other masters
+    plInstanceVector fSharedInstances;
     
     bool fFirstEval;
     bool fNeedEval;
@@ -249,6 +272,15 @@ protected:
     bool fIsGrouped;
     bool fIsGroupMaster;
     plMsgForwarder* fMsgForwarder;
+
+    double fBatchEvalTime;      // the last time we were evaluated by a batch
+    bool fInBatch;              // are we in fBatchMods?
+    bool fBatchJob;             // we were handed to the thread pool this frame
+    bool fBatchPrepared;        // ...and our graph was evaluated there successfully
+
+    static std::vector<plAGMasterMod*> fBatchMods;
+    static double fLastBatchTime;
+    static bool fBatchEval;
     
     enum {
         kPrivateAnim,
@@ -124,6 +124,23 @@ void plAGModifier::Apply(double time) const
     }
 }
 
+// PREPARE
+void plAGModifier::Prepare(double time) const
+{
+    if (!fEnabled)
+        return;
+
+    for (plAGApplicator *app : fApps)
+        app->Prepare(time);
+}
+
+// DISCARDPREPARED
+void plAGModifier::DiscardPrepared() const
+{
+    for (plAGApplicator *app : fApps)
+        app->DiscardPrepared();
+}
+
 // IEVAL
 // Apply our channels to our scene object
 bool plAGModifier::IEval(double time, float delta, uint32_t dirty)
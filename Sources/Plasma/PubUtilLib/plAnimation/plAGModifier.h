@@ -119,6 +119,12 @@ public:
     /** Apply the animation for our scene object. */
     void Apply(double time) const;
 
+    /** Evaluate our applicators ahead of the next Apply() without touching
+        the scene object. \sa plAGApplicator::Prepare */
+    void Prepare(double time) const;
+    /** Drop anything Prepare() stored. */
+    void DiscardPrepared() const;
+
     /** Get the channel tied to our ith applicator */
     plAGChannel * GetChannel(int i) { return fApps[i]->GetChannel(); }
 
@@ -497,7 +497,7 @@ void plMatrixBlend::Dump(int indent, bool optimized, double time)
 // ctor ----------------------------------------------
 // -----
 plMatrixControllerChannel::plMatrixControllerChannel()
-: plMatrixChannel(), fController()
+: plMatrixChannel(), fController(), fKeyProgram(), fKeyProgramCompiled()
 {
 }
 
@@ -505,7 +505,7 @@ plMatrixControllerChannel::plMatrixControllerChannel()
 // -----
 plMatrixControllerChannel::plMatrixControllerChannel(plController *controller,
                                                      hsAffineParts *parts)
-: fController(controller)
+: fController(controller), fKeyProgram(), fKeyProgramCompiled()
 {
     fAP = *parts;
 }
@@ -514,6 +514,7 @@ plMatrixControllerChannel::plMatrixControllerChannel(plController *controller,
 // -----
 plMatrixControllerChannel::~plMatrixControllerChannel()
 {
+    delete fKeyProgram;
     if(fController) {
         delete fController;
         fController = nullptr;
@@ -532,9 +533,7 @@ const hsMatrix44 & plMatrixControllerChannel::Value(double time, bool peek)
 const hsMatrix44 & plMatrixControllerChannel::Value(double time, bool peek,
                                                     plControllerCacheInfo *cache)
 {
-    plProfile_BeginTiming(AffineInterp);
-    fController->Interp((float)time, &fAP, cache);
-    plProfile_EndTiming(AffineInterp);
+    AffineValue(time, peek, cache);
 
     plProfile_BeginTiming(AffineCompose);
     fAP.ComposeMatrix(&fResult);
@@ -554,9 +553,13 @@ const hsAffineParts & plMatrixControllerChannel::AffineValue(double time, bool p
 const hsAffineParts & plMatrixControllerChannel::AffineValue(double time, bool peek,
                                                              plControllerCacheInfo *cache)
 {
+    if (fKeyState.IsPreparedAt(time))
+        return fAP;
+
     plProfile_BeginTiming(AffineInterp);
     fController->Interp((float)time, &fAP, cache);
     plProfile_EndTiming(AffineInterp);
+    fKeyState.fPrepared = false;
     return fAP;
 }
 
@@ -569,6 +572,31 @@ plAGChannel *plMatrixControllerChannel::MakeCacheChannel(plAnimTimeConvert *atc)
     return new plMatrixControllerCacheChannel(this, cache);
 }
 
+// MakeKeyRequest ------------------------------------------------------------
+// ---------------
+bool plMatrixControllerChannel::MakeKeyRequest(float time, bool forwards,
+                                               plAffineKeyProgram::Request &request)
+{
+    const plAffineKeyProgram *program = IGetKeyProgram();
+    if (!program)
+        return false;
+
+    request = { program, &fKeyState, &fAP, time, forwards };
+    return true;
+}
+
+// IGetKeyProgram ------------------------------------------------------------
+// ---------------
+const plAffineKeyProgram *plMatrixControllerChannel::IGetKeyProgram()
+{
+    if (!fKeyProgramCompiled)
+    {
+        fKeyProgram = plAffineKeyProgram::Compile(fController);
+        fKeyProgramCompiled = true;
+    }
+    return fKeyProgram;
+}
+
 void plMatrixControllerChannel::Dump(int indent, bool optimized, double time)
 {
     ST::string_stream indentStr;
@@ -600,6 +628,11 @@ void plMatrixControllerChannel::Read(hsStream *stream, hsResMgr *mgr)
     fController = plController::ConvertNoRef(mgr->ReadCreatable(stream));
 
     fAP.Read(stream);
+
+    delete fKeyProgram;
+    fKeyProgram = nullptr;
+    fKeyProgramCompiled = false;
+    fKeyState.fPrepared = false;
 }
 
 /////////////////////////////////
@@ -616,6 +649,8 @@ plMatrixControllerCacheChannel::plMatrixControllerCacheChannel()
 plMatrixControllerCacheChannel::plMatrixControllerCacheChannel(plMatrixControllerChannel *controller, plControllerCacheInfo *cache)
 : fControllerChannel(controller), fCache(cache)
 {
+    // The controller may only animate some of the parts, the rest come from here
+    fAP = controller->fAP;
 }
 
 // ~DTOR()
@@ -628,12 +663,35 @@ plMatrixControllerCacheChannel::~plMatrixControllerCacheChannel()
 // VALUE(time)
 const hsMatrix44 & plMatrixControllerCacheChannel::Value(double time, bool peek)
 {
-    return fControllerChannel->Value(time, peek, fCache);
+    AffineValue(time, peek);
+
+    plProfile_BeginTiming(AffineCompose);
+    fAP.ComposeMatrix(&fResult);
+    plProfile_EndTiming(AffineCompose);
+    return fResult;
 }
 
 const hsAffineParts & plMatrixControllerCacheChannel::AffineValue(double time, bool peek)
 {
-    return fControllerChannel->AffineValue(time, peek, fCache);
+    if (fKeyState.IsPreparedAt(time))
+        return fAP;
+
+    plProfile_BeginTiming(AffineInterp);
+    fControllerChannel->fController->Interp((float)time, &fAP, fCache);
+    plProfile_EndTiming(AffineInterp);
+    fKeyState.fPrepared = false;
+    return fAP;
+}
+
+bool plMatrixControllerCacheChannel::MakeKeyRequest(float time, bool forwards,
+                                                    plAffineKeyProgram::Request &request)
+{
+    const plAffineKeyProgram *program = fControllerChannel->IGetKeyProgram();
+    if (!program)
+        return false;
+
+    request = { program, &fKeyState, &fAP, time, forwards };
+    return true;
 }
 
 // DETACH
@@ -735,34 +793,50 @@ plAGChannel * plQuatPointCombine::Detach(plAGChannel *channel)
 ///////////////////////////////////////////////////////////////////////////////////////////
 
 // IAPPLY
-void plMatrixChannelApplicator::IApply(const plAGModifier *mod, double time)
+// IEVALUATE
+// Pull our channel's transform, without touching the scene object
+bool plMatrixChannelApplicator::IEvaluate(double time, hsMatrix44 &l2p, hsMatrix44 &p2l)
 {
-    if(fChannel)
-    {
-        plMatrixChannel *matChan = plMatrixChannel::ConvertNoRef(fChannel);
+    plMatrixChannel *matChan = plMatrixChannel::ConvertNoRef(fChannel);
+    if (!matChan)
+        return false;
 
-        if(matChan)
-        {
-            hsMatrix44 inverse;
+    plProfile_BeginTiming(AffineValue);
+    const hsAffineParts &ap = matChan->AffineValue(time);
+    plProfile_EndTiming(AffineValue);
 
-            plProfile_BeginTiming(AffineValue);
-            const hsAffineParts &ap = matChan->AffineValue(time);
-            plProfile_EndTiming(AffineValue);
-            
-            hsMatrix44 result;
+    plProfile_BeginTiming(AffineCompose);
+    ap.ComposeMatrix(&l2p);
+    ap.ComposeInverseMatrix(&p2l);
+    //l2p.GetInverse(&p2l);
+    plProfile_EndTiming(AffineCompose);
 
-            plProfile_BeginTiming(AffineCompose);
-            ap.ComposeMatrix(&result);
-            ap.ComposeInverseMatrix(&inverse);
-            //result.GetInverse(&inverse);
-            plProfile_EndTiming(AffineCompose);
+    return true;
+}
 
-            plProfile_BeginTiming(MatrixApplicator);
-            plCoordinateInterface *CI = IGetCI(mod);
-            CI->SetLocalToParent(result, inverse);
-            plProfile_EndTiming(MatrixApplicator);  
-        }
+// IPREPARE
+bool plMatrixChannelApplicator::IPrepare(double time)
+{
+    fPrepared = IEvaluate(time, fPreparedL2P, fPreparedP2L);
+    return fPrepared;
+}
+
+// IAPPLY
+void plMatrixChannelApplicator::IApply(const plAGModifier *mod, double time)
+{
+    if (fPrepared)
+    {
+        fPrepared = false;
+    }
+    else if (!IEvaluate(time, fPreparedL2P, fPreparedP2L))
+    {
+        return;
     }
+
+    plProfile_BeginTiming(MatrixApplicator);
+    plCoordinateInterface *CI = IGetCI(mod);
+    CI->SetLocalToParent(fPreparedL2P, fPreparedP2L);
+    plProfile_EndTiming(MatrixApplicator);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////
@@ -49,6 +49,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "HeadSpin.h"        // you need types to include Matrix
 #include "hsMatrix44.h"
 #include "plTransform/hsAffineParts.h"
+#include "plInterp/plAffineKeyProgram.h"
 
 // local prototypes
 class plQuatChannel;
@@ -93,6 +94,11 @@ public:
 
     virtual plAGPinType GetPinType() { return kAGPinTransform; };
 
+    // Leaves that can hand their keys to plAffineKeyProgram fill in a request
+    // to evaluate them at the given time. Until something else evaluates the
+    // leaf, asking it for that time just returns the result.
+    virtual bool MakeKeyRequest(float time, bool forwards, plAffineKeyProgram::Request &request) { return false; }
+
     virtual void Dump(int indent, bool optimized, double time);
 
     // PLASMA PROTOCOL
@@ -211,9 +217,17 @@ public:
 // converts a plController-style animation into a plMatrixChannel
 class plMatrixControllerChannel : public plMatrixChannel
 {
+    friend class plMatrixControllerCacheChannel;
+
 protected:
     plController    *fController;
 
+    plAffineKeyProgram          *fKeyProgram;
+    bool                        fKeyProgramCompiled;
+    plAffineKeyProgram::State   fKeyState;
+
+    const plAffineKeyProgram *IGetKeyProgram();
+
 public:
     // xTORs
     plMatrixControllerChannel();
@@ -228,6 +242,8 @@ public:
     
     plAGChannel * MakeCacheChannel(plAnimTimeConvert *atc) override;
 
+    bool MakeKeyRequest(float time, bool forwards, plAffineKeyProgram::Request &request) override;
+
     void Dump(int indent, bool optimized, double time) override;
 
     // PLASMA PROTOCOL
@@ -243,12 +259,16 @@ public:
 /////////////////////////////////
 // PLMATRIXCONTROLLERCACHECHANNEL
 /////////////////////////////////
-// Same as plMatrixController, but with caching info
+// Same as plMatrixController, but with caching info.
+// Interpolates into its own result rather than the shared controller
+// channel's, so several instances of the same animation can be evaluated
+// at once.
 class plMatrixControllerCacheChannel : public plMatrixChannel
 {
 protected:
     plControllerCacheInfo *fCache;
     plMatrixControllerChannel *fControllerChannel;
+    plAffineKeyProgram::State fKeyState;
     
 public:
     plMatrixControllerCacheChannel();
@@ -257,6 +277,8 @@ public:
     
     const hsMatrix44 & Value(double time, bool peek = false) override;
     const hsAffineParts & AffineValue(double time, bool peek = false) override;
+
+    bool MakeKeyRequest(float time, bool forwards, plAffineKeyProgram::Request &request) override;
     
     plAGChannel * Detach(plAGChannel * channel) override;
     
@@ -310,9 +332,19 @@ public:
 class plMatrixChannelApplicator : public plAGApplicator
 {
 protected:
+    hsMatrix44 fPreparedL2P;
+    hsMatrix44 fPreparedP2L;
+    bool fPrepared;
+
+    bool IEvaluate(double time, hsMatrix44 &l2p, hsMatrix44 &p2l);
+    bool IPrepare(double time) override;
     void IApply(const plAGModifier *mod, double time) override;
 
 public:
+    plMatrixChannelApplicator() : fPrepared() { }
+
+    void DiscardPrepared() override { fPrepared = false; }
+
     CLASSNAME_REGISTER( plMatrixChannelApplicator );
     GETINTERFACE_ANY( plMatrixChannelApplicator, plAGApplicator );
 
@@ -333,6 +365,7 @@ protected:
     
     // apply our animation * our correction to the node
     void IApply(const plAGModifier *mod, double time) override;
+    bool IPrepare(double time) override { return false; }
 
 public:
     plMatrixDelayedCorrectionApplicator() : fDelayStart(-1000.f), fIgnoreNextCorrection(true) { fCorAP.Reset(); }
@@ -375,6 +408,7 @@ public:
 
 protected:
     void IApply(const plAGModifier *mod, double time) override;
+    bool IPrepare(double time) override { return false; }
     hsMatrix44 fLastL2A;        // local to animation space
     hsMatrix44 fLastA2L;        // animation space to local
     bool fNew;                  // true if we haven't cached anything yet
@@ -401,6 +401,7 @@ plPointControllerCacheChannel::plPointControllerCacheChannel(plPointControllerCh
 : fControllerChannel(controller),
   fCache(cache)
 {
+    fResult = controller->fResult;
 }
 
 // ~DTOR()
@@ -411,9 +412,11 @@ plPointControllerCacheChannel::~plPointControllerCacheChannel()
 }
 
 // VALUE(time)
+// Interpolates into our own result, see plMatrixControllerCacheChannel
 const hsPoint3 & plPointControllerCacheChannel::Value(double time, bool peek)
 {
-    return fControllerChannel->Value(time, fCache);
+    fControllerChannel->fController->Interp((float)time, &fResult, fCache);
+    return fResult;
 }
 
 // DETACH
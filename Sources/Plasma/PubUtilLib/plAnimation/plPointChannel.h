@@ -201,6 +201,8 @@ hsPoint3 BlendPoints(hsPoint3 &pointA, hsPoint3 &pointB, float blend);
 // converts a plController-style animation into a plPointChannel
 class plPointControllerChannel : public plPointChannel
 {
+    friend class plPointControllerCacheChannel;
+
 protected:
     plController *fController;
     
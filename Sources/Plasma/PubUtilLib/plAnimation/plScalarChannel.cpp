@@ -404,6 +404,7 @@ plScalarControllerCacheChannel::plScalarControllerCacheChannel(plScalarControlle
 : fControllerChannel(controller),
   fCache(cache)
 {
+    fResult = controller->fResult;
 }
 
 // dtor ---------------------------------------------------------
@@ -416,9 +417,11 @@ plScalarControllerCacheChannel::~plScalarControllerCacheChannel()
 
 // Value ---------------------------------------------------------------------
 // ------
+// Interpolates into our own result, see plMatrixControllerCacheChannel
 const float & plScalarControllerCacheChannel::Value(double time, bool peek)
 {
-    return fControllerChannel->Value(time, peek, fCache);
+    fControllerChannel->fController->Interp((float)time, &fResult, fCache);
+    return fResult;
 }
 
 // Detach -----------------------------------------------------------------
@@ -448,6 +451,10 @@ plAGChannel * plScalarControllerCacheChannel::Detach(plAGChannel * channel)
 //
 /////////////////////////////////////////////////////////////////////////////////////////
 
+// Per-thread batch state, see BeginBatch()
+static thread_local bool sInBatch = false;
+static thread_local bool sBatchConflict = false;
+
 // ctor --------------------
 plATCChannel::plATCChannel()
 : fConvert()
@@ -476,10 +483,38 @@ bool plATCChannel::IsStoppedAt(double time)
 // ------
 const float & plATCChannel::Value(double time, bool peek)
 {
+    if (sInBatch && !peek)
+    {
+        if (fConvert->IsCachedAt(time))
+            fResult = fConvert->CurrentAnimTime();
+        else
+        {
+            sBatchConflict = true;
+            fResult = fConvert->WorldToAnimTimeNoUpdate(time);
+        }
+        return fResult;
+    }
+
     fResult = (peek ? fConvert->WorldToAnimTimeNoUpdate(time) : fConvert->WorldToAnimTime(time));
     return fResult;
 }
 
+// BeginBatch ------------------
+// -----------
+void plATCChannel::BeginBatch()
+{
+    sInBatch = true;
+    sBatchConflict = false;
+}
+
+// EndBatch ------------------
+// ---------
+bool plATCChannel::EndBatch()
+{
+    sInBatch = false;
+    return !sBatchConflict;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////
 //
 // PLSCALARSDLCHANNEL
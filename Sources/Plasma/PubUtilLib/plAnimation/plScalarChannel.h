@@ -194,6 +194,8 @@ public:
 // converts a plController-style animation into a plScalarChannel
 class plScalarControllerChannel : public plScalarChannel
 {
+    friend class plScalarControllerCacheChannel;
+
 protected:
     plController *fController;
     
@@ -262,6 +264,16 @@ public:
     bool IsStoppedAt(double time) override;
     const float & Value(double time, bool peek = false) override;
 
+    /** While a thread is inside a batch, Value() won't advance the time
+        convert (which can fire callbacks and dirty SDL). If the convert
+        hasn't already been advanced to the requested time, it peeks
+        instead and the batch is flagged as conflicted, so the caller
+        can throw its results away and evaluate serially.
+        \sa plAGMasterMod */
+    static void BeginBatch();
+    /** Ends the batch on this thread. Returns false on a conflict. */
+    static bool EndBatch();
+
     // PLASMA PROTOCOL
     CLASSNAME_REGISTER( plATCChannel );
     GETINTERFACE_ANY( plATCChannel, plScalarChannel );
@@ -47,6 +47,9 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #ifdef EAX_SDK_AVAILABLE
 #   include <eax.h>
 #endif
+#include <algorithm>
+#include <cmath>
+#include <iterator>
 #include <memory>
 #include <array>
 
@@ -69,6 +72,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "pnMessage/plRefMsg.h"
 #include "pnMessage/plTimeMsg.h"
 
+#include "plAudioCore/plSoundBufferCache.h"
 #include "plMessage/plAgeLoadedMsg.h"
 #include "plMessage/plRenderMsg.h"
 #include "plStatusLog/plStatusLog.h"
@@ -86,6 +90,7 @@ ST::string kDefaultDeviceMagic = ST_LITERAL("(Default Device)");
 plProfile_CreateTimer("EAX Update", "Sound", SoundEAXUpdate);
 plProfile_CreateTimer("Soft Update", "Sound", SoundSoftUpdate);
 plProfile_CreateCounter("Max Sounds", "Sound", SoundMaxNum);
+plProfile_CreateCounter("Soft Sounds Checked", "Sound", SoundSoftChecked);
 plProfile_CreateTimer("AudioUpdate", "RenderSetup", AudioUpdate);
 
 //// Internal plSoftSound Methods Definition //////////////////////////////////////////////
@@ -97,6 +102,108 @@ void plSoftSound::BootSourceOff() const
         sound->ForceUnregisterFromAudioSys();
 }
 
+//// plSoftSoundGrid //////////////////////////////////////////////////////////////////////
+
+int32_t plSoftSoundGrid::ICell(float coord)
+{
+    return (int32_t)std::floor(coord / kCellSize);
+}
+
+uint64_t plSoftSoundGrid::IKey(int32_t x, int32_t y)
+{
+    return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+}
+
+// An empty range (max < min) means the sound can't be bounded
+void plSoftSoundGrid::ICells(const hsPoint3& center, float radius, int32_t& minX, int32_t& minY,
+                             int32_t& maxX, int32_t& maxY)
+{
+    if (radius >= 0.f) {
+        minX = ICell(center.fX - radius);
+        minY = ICell(center.fY - radius);
+        maxX = ICell(center.fX + radius);
+        maxY = ICell(center.fY + radius);
+        if ((int64_t)(maxX - minX + 1) * (maxY - minY + 1) <= kMaxCells)
+            return;
+    }
+
+    minX = minY = 0;
+    maxX = maxY = -1;
+}
+
+void plSoftSoundGrid::Insert(plSoftSoundList::iterator sound)
+{
+    ICells(sound->fCenter, sound->fRadius, sound->fCellMinX, sound->fCellMinY, sound->fCellMaxX, sound->fCellMaxY);
+    if (sound->fCellMaxX < sound->fCellMinX) {
+        fUnbounded.emplace_back(sound);
+        return;
+    }
+
+    for (int32_t x = sound->fCellMinX; x <= sound->fCellMaxX; ++x) {
+        for (int32_t y = sound->fCellMinY; y <= sound->fCellMaxY; ++y)
+            fCells[IKey(x, y)].emplace_back(sound);
+    }
+}
+
+void plSoftSoundGrid::Move(plSoftSoundList::iterator sound, const hsPoint3& center, float radius)
+{
+    int32_t minX, minY, maxX, maxY;
+    ICells(center, radius, minX, minY, maxX, maxY);
+
+    bool sameCells = minX == sound->fCellMinX && minY == sound->fCellMinY &&
+                     maxX == sound->fCellMaxX && maxY == sound->fCellMaxY;
+    if (!sameCells)
+        Remove(sound);
+
+    sound->fCenter = center;
+    sound->fRadius = radius;
+
+    if (!sameCells)
+        Insert(sound);
+}
+
+void plSoftSoundGrid::Remove(plSoftSoundList::iterator sound)
+{
+    auto removeFrom = [sound](std::vector<plSoftSoundList::iterator>& sounds) {
+        auto it = std::find(sounds.begin(), sounds.end(), sound);
+        if (it != sounds.end()) {
+            *it = sounds.back();
+            sounds.pop_back();
+        }
+    };
+
+    if (sound->fCellMaxX < sound->fCellMinX) {
+        removeFrom(fUnbounded);
+        return;
+    }
+
+    for (int32_t x = sound->fCellMinX; x <= sound->fCellMaxX; ++x) {
+        for (int32_t y = sound->fCellMinY; y <= sound->fCellMaxY; ++y) {
+            auto cell = fCells.find(IKey(x, y));
+            if (cell == fCells.end())
+                continue;
+            removeFrom(cell->second);
+            if (cell->second.empty())
+                fCells.erase(cell);
+        }
+    }
+}
+
+void plSoftSoundGrid::Clear()
+{
+    fCells.clear();
+    fUnbounded.clear();
+}
+
+void plSoftSoundGrid::Query(const hsPoint3& pos, std::vector<plSoftSoundList::iterator>& sounds) const
+{
+    sounds.insert(sounds.end(), fUnbounded.begin(), fUnbounded.end());
+
+    auto cell = fCells.find(IKey(ICell(pos.fX), ICell(pos.fY)));
+    if (cell != fCells.end())
+        sounds.insert(sounds.end(), cell->second.begin(), cell->second.end());
+}
+
 // plAudioSystem //////////////////////////////////////////////////////////////////////////
 
 int32_t   plAudioSystem::fMaxNumSounds = 16;
@@ -303,6 +410,7 @@ void plAudioSystem::Shutdown()
         i.BootSourceOff();
     fSoftRegionSounds.clear();
     fActiveSofts.clear();
+    fSoftGrid.Clear();
 
     for (auto rgn : fEAXRegions)
         GetKey()->Release(rgn->GetKey());
@@ -420,7 +528,9 @@ void    plAudioSystem::SetActive(bool b)
 //  need to be recalced, just resorted.
 void    plAudioSystem::RegisterSoftSound(plKey soundKey)
 {
+    // We don't know where it is yet, so it gets looked at until the next time we index
     fSoftRegionSounds.emplace_back(std::move(soundKey));
+    fSoftGrid.Insert(std::prev(fSoftRegionSounds.end()));
 
     fCurrDebugSound = nullptr;
     plSound::SetCurrDebugPlate(nullptr);
@@ -440,9 +550,10 @@ void    plAudioSystem::UnregisterSoftSound(const plKey& soundKey)
         return;
     }
 
-    soundIt = std::find_if(fSoftRegionSounds.begin(), fSoftRegionSounds.end(), findSoft);
-    if (soundIt != fSoftRegionSounds.end()) {
-        fSoftRegionSounds.erase(soundIt);
+    auto softIt = std::find_if(fSoftRegionSounds.begin(), fSoftRegionSounds.end(), findSoft);
+    if (softIt != fSoftRegionSounds.end()) {
+        fSoftGrid.Remove(softIt);
+        fSoftRegionSounds.erase(softIt);
         return;
     }
 
@@ -524,6 +635,7 @@ void    plAudioSystem::IUpdateSoftSounds(const hsPoint3 &newPosition)
             // yeah-they're-registered-but-not-active list
             fSoftRegionSounds.emplace_back(std::move(*soundIt));
             soundIt = fActiveSofts.erase(soundIt);
+            IIndexSoftSound(std::prev(fSoftRegionSounds.end()), sound, false);
 
             // We know this sound won't be enabled, so skip the Calc() call
             if (sound)
@@ -531,22 +643,35 @@ void    plAudioSystem::IUpdateSoftSounds(const hsPoint3 &newPosition)
         }
     }
 
-    // Now check remaining sounds to see if the listener moved into them
-    for (auto soundIt = fSoftRegionSounds.begin(); soundIt != fSoftRegionSounds.end(); /* do nothing */) {
-        if (!fListenerInit) {
-            soundIt++;
-            continue;
-        }
+    // Now check remaining sounds to see if the listener moved into them. Every sound still gets
+    // its Update(), since that is what finishes loading it and stops it once it's done, but that
+    // is cheap for a sound that isn't doing anything. We know roughly where each one can be heard
+    // from, so only the ones near the listener need ranking. Any sound that has moved since it
+    // was filed is refiled on the way.
+    if (fListenerInit) {
+        for (auto softIt = fSoftRegionSounds.begin(); softIt != fSoftRegionSounds.end(); ++softIt) {
+            plSound* sound = (plSound*)softIt->fSoundKey->ObjectIsLoaded();
+            if (!sound || sound->GetPriority() > plgAudioSys::GetPriorityCutoff())
+                continue;
 
-        plSound* sound = (plSound*)soundIt->fSoundKey->ObjectIsLoaded();
-        if (!sound || sound->GetPriority() > plgAudioSys::GetPriorityCutoff()) {
-            soundIt++;
-            continue;
+            sound->Update();
+            if (plgAudioSys::fMutedStateChange)
+                sound->SetMuted(plgAudioSys::fMuted);
+
+            // Out of range until the grid says otherwise. This ensures that dist attenuation is
+            // set to zero so we don't accidentally play.
+            sound->Disable();
+            IIndexSoftSound(softIt, sound, true);
         }
 
-        sound->Update();
-        if (plgAudioSys::fMutedStateChange)
-            sound->SetMuted(plgAudioSys::fMuted);
+        fSoftGrid.Query(newPosition, fSoftCandidates);
+        plProfile_IncCount(SoundSoftChecked, fActiveSofts.size() + fSoftCandidates.size());
+    }
+
+    for (plSoftSoundList::iterator softIt : fSoftCandidates) {
+        plSound* sound = (plSound*)softIt->fSoundKey->ObjectIsLoaded();
+        if (!sound || sound->GetPriority() > plgAudioSys::GetPriorityCutoff())
+            continue;
 
         if (sound->IsWithinRange(newPosition, &distSquared)) {
             // Our initial guess is that it's enabled...
@@ -555,27 +680,28 @@ void    plAudioSystem::IUpdateSoftSounds(const hsPoint3 &newPosition)
 
             if (rank > 0.f) {
                 // We just moved into its range, so move it to our active list and start the sucker
-                soundIt->fRank = (10.0f - sound->GetPriority()) * rank;
-                fActiveSofts.emplace_back(std::move(*soundIt));
-                soundIt = fSoftRegionSounds.erase(soundIt);
+                softIt->fRank = (10.0f - sound->GetPriority()) * rank;
+                fSoftGrid.Remove(softIt);
+                fActiveSofts.emplace_back(std::move(*softIt));
+                fSoftRegionSounds.erase(softIt);
             } else {
                 // Do NOT notify sound, since we were outside of its range and still are
                 // (but if we're playing, we shouldn't be, so better update)
                 if (sound->IsPlaying())
                     sound->UpdateSoftVolume(false);
-
-                soundIt++;
             }
-        } else {
-            // Do NOT notify sound, since we were outside of its range and still are
-            sound->Disable(); // ensure that dist attenuation is set to zero so we don't accidentally play
-
-            soundIt++;
         }
+        // else do NOT notify sound, since we were outside of its range and still are (and it's
+        // already been disabled above)
     }
-
-    std::sort(
-        fActiveSofts.begin(), fActiveSofts.end(),
+    fSoftCandidates.clear();
+
+    // Only the sounds that get to play, and the ones in the slop range after them, need to be
+    // in order. The rest are all told to stop regardless. Every rank was just recomputed, so
+    // there's no order worth keeping around between updates.
+    size_t numRanked = std::min(fActiveSofts.size(), (size_t)(fMaxNumSounds + fNumSoundsSlop));
+    std::partial_sort(
+        fActiveSofts.begin(), fActiveSofts.begin() + numRanked, fActiveSofts.end(),
         [](const plSoftSound& lhs, const plSoftSound& rhs) {
             // Larger values come first.
             return lhs.fRank > rhs.fRank;
@@ -675,6 +801,28 @@ void    plAudioSystem::IUpdateSoftSounds(const hsPoint3 &newPosition)
     plProfile_EndTiming(SoundSoftUpdate);
 }
 
+//// IIndexSoftSound ///////////////////////////////////////////////////////
+//  Files a sound nobody is hearing under where it can currently be heard from,
+//  or refiles it if it was already filed somewhere else.
+
+void plAudioSystem::IIndexSoftSound(plSoftSoundList::iterator soft, plSound* sound, bool filed)
+{
+    hsPoint3 center(0.f, 0.f, 0.f);
+    float radius = -1.f;
+    if (sound && sound->IsPropertySet(plSound::kPropIs3DSound)) {
+        center = sound->GetPosition();
+        radius = (float)sound->GetMax();
+    }
+
+    if (filed) {
+        fSoftGrid.Move(soft, center, radius);
+    } else {
+        soft->fCenter = center;
+        soft->fRadius = radius;
+        fSoftGrid.Insert(soft);
+    }
+}
+
 void plAudioSystem::NextDebugSound()
 {
     if (!fCurrDebugSound) {
@@ -702,17 +850,17 @@ void plAudioSystem::NextDebugSound()
             }
         }
 
-        soundIt = std::find_if(
+        auto activeIt = std::find_if(
             fActiveSofts.begin(), fActiveSofts.end(),
             [this](const plSoftSound& value) {
                 return fCurrDebugSound == value.fSoundKey;
             }
         );
-        if (soundIt != fActiveSofts.end()) {
+        if (activeIt != fActiveSofts.end()) {
             // Go to the next sound, if available.
-            soundIt++;
-            if (soundIt != fSoftRegionSounds.end())
-                fCurrDebugSound = soundIt->fSoundKey;
+            activeIt++;
+            if (activeIt != fActiveSofts.end())
+                fCurrDebugSound = activeIt->fSoundKey;
             else
                 fCurrDebugSound = nullptr;
         }
@@ -800,6 +948,7 @@ bool plAudioSystem::MsgReceive(plMessage* msg)
             fListenerInit = false;
         } else {
             fListenerInit = true;
+            plStatusLog::AddLineSF("audio.log", "ASYS: Decoded cache {}", plgAudioSys::GetDecodedCacheStats());
         }
     }
 
@@ -1072,6 +1221,20 @@ void plgAudioSys::UnregisterSoftSound(const plKey& soundKey)
         fSys->UnregisterSoftSound(soundKey);
 }
 
+void plgAudioSys::SetDecodedCacheBudget(size_t bytes)
+{
+    plSoundBufferCache::Instance().SetBudget(bytes);
+}
+
+ST::string plgAudioSys::GetDecodedCacheStats()
+{
+    const plSoundBufferCache& cache = plSoundBufferCache::Instance();
+    return ST::format("{} KiB of {} KiB ({} KiB unused), {} hits, {} misses, {} evictions",
+                      cache.GetResidentSize() / 1024, cache.GetBudget() / 1024,
+                      cache.GetUnusedSize() / 1024, cache.GetHits(), cache.GetMisses(),
+                      cache.GetEvictions());
+}
+
 void plgAudioSys::SetPriorityCutoff(uint8_t cut)
 {
     fPriorityCutoff = cut;
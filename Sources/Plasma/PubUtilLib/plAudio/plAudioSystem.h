@@ -115,6 +115,10 @@ public:
     static float    GetStreamFromRAMCutoff() { return fStreamFromRAMCutoff; }
     static void     SetStreamFromRAMCutoff(float c) { fStreamFromRAMCutoff = c; }
 
+    // How much decoded sound data to keep around for sounds that aren't playing
+    static void     SetDecodedCacheBudget(size_t bytes);
+    static ST::string GetDecodedCacheStats();
+
     static hsPoint3 GetCurrListenerPos();
     static void SetListenerPos(const hsPoint3& pos);
     static void SetListenerVelocity(const hsVector3& vel);
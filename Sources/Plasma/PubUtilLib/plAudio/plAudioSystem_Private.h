@@ -52,8 +52,10 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #ifdef EAX_SDK_AVAILABLE
 #   include <eax.h>
 #endif
+#include <list>
 #include <memory>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 #include "hsGeometry3.h"
@@ -62,6 +64,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 class plAudioEndpointVolume;
 class plEAXListenerMod;
 class plSoftSoundNode;
+class plSound;
 class plStatusLog;
 
 class plSoftSound
@@ -70,14 +73,55 @@ public:
     plKey fSoundKey;
     float fRank;
 
+    // Where the sound could be heard from when it was last indexed by plSoftSoundGrid.
+    // A negative radius means anywhere, as far as the grid is concerned.
+    hsPoint3 fCenter;
+    float fRadius;
+    int32_t fCellMinX, fCellMinY, fCellMaxX, fCellMaxY;
+
     plSoftSound(plKey s)
-        : fSoundKey(std::move(s))
+        : fSoundKey(std::move(s)), fRank(), fRadius(-1.f),
+          fCellMinX(), fCellMinY(), fCellMaxX(-1), fCellMaxY(-1)
     {
     }
 
     void BootSourceOff() const;
 };
 
+typedef std::list<plSoftSound> plSoftSoundList;
+
+// Buckets the soft sounds nobody is hearing by where they could be heard from, on a grid
+// in the horizontal plane, so that only the ones near the listener need to be looked at.
+class plSoftSoundGrid
+{
+public:
+    static constexpr float kCellSize = 64.f;
+
+    // Sounds that would cover more cells than this just always get looked at
+    static constexpr int32_t kMaxCells = 64;
+
+protected:
+    std::unordered_map<uint64_t, std::vector<plSoftSoundList::iterator>> fCells;
+    std::vector<plSoftSoundList::iterator> fUnbounded;
+
+    static int32_t  ICell(float coord);
+    static uint64_t IKey(int32_t x, int32_t y);
+    static void     ICells(const hsPoint3& center, float radius, int32_t& minX, int32_t& minY,
+                           int32_t& maxX, int32_t& maxY);
+
+public:
+    // Files the sound under its fCenter and fRadius
+    void Insert(plSoftSoundList::iterator sound);
+
+    // Refiles an already filed sound if it can now be heard from different cells
+    void Move(plSoftSoundList::iterator sound, const hsPoint3& center, float radius);
+    void Remove(plSoftSoundList::iterator sound);
+    void Clear();
+
+    // Adds every sound that might be heard at pos to the list
+    void Query(const hsPoint3& pos, std::vector<plSoftSoundList::iterator>& sounds) const;
+};
+
 class plAudioSystem : public hsKeyedObject
 {
 public:
@@ -125,8 +169,10 @@ protected:
     ALCdevice* fCaptureDevice;
     std::unique_ptr<plAudioEndpointVolume> fCaptureLevel;
 
-    std::vector<plSoftSound> fSoftRegionSounds;
+    plSoftSoundList fSoftRegionSounds;
     std::vector<plSoftSound> fActiveSofts;
+    plSoftSoundGrid fSoftGrid;
+    std::vector<plSoftSoundList::iterator> fSoftCandidates;
     plStatusLog* fDebugActiveSoundDisplay;
 
     static int32_t fMaxNumSounds, fNumSoundsSlop;
@@ -155,6 +201,7 @@ protected:
     void RegisterSoftSound(plKey soundKey);
     void UnregisterSoftSound(const plKey& soundKey);
     void IUpdateSoftSounds(const hsPoint3& newPosition);
+    void IIndexSoftSound(plSoftSoundList::iterator soft, plSound* sound, bool filed);
 };
 
 #endif
@@ -817,7 +817,8 @@ plSoundBuffer::ELoadReturnVal plSound::IPreLoadBuffer( bool playWhenLoaded, bool
     if (fDataBuffer && fDataBuffer->IsValid())
     {
         plProfile_BeginTiming( SoundLoadTime );
-        plSoundBuffer::ELoadReturnVal retVal = fDataBuffer->AsyncLoad(fDataBuffer->HasFlag(plSoundBuffer::kStreamCompressed) ? plAudioFileReader::kStreamNative : plAudioFileReader::kStreamWAV);
+        plSoundBuffer::ELoadReturnVal retVal = fDataBuffer->AsyncLoad(fDataBuffer->HasFlag(plSoundBuffer::kStreamCompressed) ? plAudioFileReader::kStreamNative : plAudioFileReader::kStreamWAV,
+                                                                      0, IGetDecodePriority());
         if(retVal == plSoundBuffer::kPending)
         {
             fPlayWhenLoaded = playWhenLoaded;
@@ -834,6 +835,24 @@ plSoundBuffer::ELoadReturnVal plSound::IPreLoadBuffer( bool playWhenLoaded, bool
     }
 }
 
+/////////////////////////////////////////////////////////////////////////
+//  Our priority decides first; within the same priority, sounds closer to
+//  the listener (relative to their range) are decoded sooner. 2D sounds are
+//  always treated as right on top of the listener.
+float plSound::IGetDecodePriority() const
+{
+    float distance = 0.f;
+    if (IsPropertySet(kPropIs3DSound) && GetMax() > 0)
+    {
+        hsPoint3 listenerPos = plgAudioSys::GetCurrListenerPos();
+        hsPoint3 soundPos = GetPosition();
+        hsVector3 toListener(&listenerPos, &soundPos);
+        distance = std::min(toListener.Magnitude() / GetMax(), 1.f);
+    }
+
+    return (float)fPriority + distance;
+}
+
 plFileName plSound::GetFileName() const
 {
     if (fDataBuffer)
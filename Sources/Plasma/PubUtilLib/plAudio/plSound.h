@@ -350,6 +350,9 @@ protected:
 
     //NOTE: if isIncidental is true the entire sound will be loaded. 
     virtual plSoundBuffer::ELoadReturnVal   IPreLoadBuffer( bool playWhenLoaded, bool isIncidental = false );   
+
+    // Orders our data buffer's load against the others waiting to be decoded. Lower is sooner.
+    float               IGetDecodePriority() const;
     virtual void        ISetActualTime( double t ) = 0;
     
     virtual bool        IActuallyLoaded() = 0;
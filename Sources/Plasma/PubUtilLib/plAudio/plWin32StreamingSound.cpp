@@ -153,7 +153,7 @@ plSoundBuffer::ELoadReturnVal plWin32StreamingSound::IPreLoadBuffer( bool playWh
 
         if(!fStartPos)
         {
-            if (fDataBuffer->AsyncLoad(type, isIncidental ? 0 : STREAMING_BUFFERS * STREAM_BUFFER_SIZE ) == plSoundBuffer::kPending)
+            if (fDataBuffer->AsyncLoad(type, isIncidental ? 0 : STREAMING_BUFFERS * STREAM_BUFFER_SIZE, IGetDecodePriority()) == plSoundBuffer::kPending)
             {
                 fPlayWhenLoaded = playWhenLoaded;
                 fLoading = true;
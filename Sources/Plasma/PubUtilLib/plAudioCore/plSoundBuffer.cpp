@@ -47,8 +47,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plSoundBuffer.h"
 #include "plSrtFileReader.h"
 
-#include <thread>
-#include <chrono>
+#include <algorithm>
 
 static plFileName GetFullPath(const plFileName &filename)
 {
@@ -81,89 +80,156 @@ static plAudioFileReader *CreateReader( bool fullpath, const plFileName &filenam
     return reader;
 }
 
-void plSoundPreloader::Run()
+//// plSoundDecoder //////////////////////////////////////////////////////////
+
+void plSoundDecoder::Init(size_t numWorkers)
 {
-    SetThisThreadName(ST_LITERAL("SoundPreloader"));
+    fRunning = true;
+    for (size_t i = 0; i < numWorkers; ++i)
+        fWorkers.emplace_back(hsThread::StartSimpleThread([this] { IWorkerProc(); }));
+}
 
-    std::vector<plSoundBuffer*> templist;
+void plSoundDecoder::Shutdown()
+{
+    {
+        hsLockGuard(fMutex);
+        fRunning = false;
+    }
+    fCondition.notify_all();
 
-    while (fRunning)
+    for (std::thread& worker : fWorkers)
+        worker.join();
+    fWorkers.clear();
+
+    // we need to be sure that all buffers are removed from our load list when shutting down or we will hang,
+    // since the sound buffer will wait to be destroyed until it is marked as loaded
+    for (Job& job : fQueue)
     {
-        {
-            hsLockGuard(fCritSect);
-            templist.insert(templist.end(), fBuffers.rbegin(), fBuffers.rend());
-            fBuffers.clear();
-        }
+        delete job.fReader;
+        job.fBuffer->SetLoaded(true);
+    }
+    fQueue.clear();
+}
 
-        if (templist.empty())
+void plSoundDecoder::AddBuffer(plSoundBuffer* buffer, float priority)
+{
+    {
+        hsLockGuard(fMutex);
+        Job job{ buffer, nullptr, 0, buffer->GetAsyncLoadLength(), priority, fNextSequence++ };
+        fQueue.emplace_back(job);
+        std::push_heap(fQueue.begin(), fQueue.end());
+    }
+    fCondition.notify_one();
+}
+
+void plSoundDecoder::Cancel(plSoundBuffer* buffer)
+{
+    std::unique_lock<std::mutex> lock(fMutex);
+    fChunkDone.wait(lock, [this, buffer] {
+        return std::find(fActive.begin(), fActive.end(), buffer) == fActive.end();
+    });
+
+    auto it = std::find_if(fQueue.begin(), fQueue.end(), [buffer](const Job& job) {
+        return job.fBuffer == buffer;
+    });
+    if (it != fQueue.end())
+    {
+        delete it->fReader;
+        fQueue.erase(it);
+        std::make_heap(fQueue.begin(), fQueue.end());
+        buffer->SetLoaded(true);
+    }
+}
+
+void plSoundDecoder::IWorkerProc()
+{
+    hsThread::SetThisThreadName(ST_LITERAL("SoundDecoder"));
+
+    std::unique_lock<std::mutex> lock(fMutex);
+    while (true)
+    {
+        fCondition.wait(lock, [this] { return !fRunning || !fQueue.empty(); });
+        if (!fRunning)
+            break;
+
+        std::pop_heap(fQueue.begin(), fQueue.end());
+        Job job = fQueue.back();
+        fQueue.pop_back();
+        fActive.emplace_back(job.fBuffer);
+        lock.unlock();
+
+        bool done = IDecodeChunk(job);
+
+        lock.lock();
+        fActive.erase(std::find(fActive.begin(), fActive.end(), job.fBuffer));
+        if (!done)
         {
-            fEvent.Wait();
+            // Back in line, behind anything more urgent that came in meanwhile
+            fQueue.emplace_back(job);
+            std::push_heap(fQueue.begin(), fQueue.end());
         }
-        else
-        {
-            plAudioFileReader *reader = nullptr;
-            plSrtFileReader* srtReader = nullptr;
 
-            while (!templist.empty())
-            {
-                plSoundBuffer* buf = templist.back();
-                templist.pop_back();
-
-                if (buf->GetData())
-                {
-                    plFileName srcFilename = buf->GetFileName();
-                    reader = CreateReader(true, srcFilename, buf->GetAudioReaderType(), buf->GetReaderSelect());
-                    
-                    if( reader )
-                    {
-                        unsigned readLen = buf->GetAsyncLoadLength() ? buf->GetAsyncLoadLength() : buf->GetDataLength();
-                        reader->Read( readLen, buf->GetData() );
-                        buf->SetAudioReader(reader);     // give sound buffer reader, since we may need it later
-
-                        plSrtFileReader* srtReader = buf->GetSrtReader();
-                        if (srtReader != nullptr && srtReader->GetCurrentAudioFileName() == srcFilename) {
-                            // same file we were playing before, so start the SRT feed over instead of deleting and reloading
-                            srtReader->StartOver();
-                        } else {
-                            auto newSrtFileReader = std::make_unique<plSrtFileReader>(srcFilename);
-                            if (newSrtFileReader->ReadFile())
-                                buf->SetSrtReader(newSrtFileReader.release());
-                        }
-                    }
-                    else
-                    {
-                        buf->SetError();
-                    }
-                }
-
-                buf->SetLoaded(true);
-            }
-        }
+        fChunkDone.notify_all();
     }
+}
 
-    // we need to be sure that all buffers are removed from our load list when shutting this thread down or we will hang,
-    // since the sound buffer will wait to be destroyed until it is marked as loaded
+// Returns true once the buffer is done with, one way or another.
+bool plSoundDecoder::IDecodeChunk(Job& job)
+{
+    plSoundBuffer* buf = job.fBuffer;
+    if (!buf->GetData())
     {
-        hsLockGuard(fCritSect);
-        while (!fBuffers.empty())
+        buf->SetLoaded(true);
+        return true;
+    }
+
+    plFileName srcFilename = buf->GetFileName();
+    if (!job.fReader)
+    {
+        job.fReader = CreateReader(true, srcFilename, buf->GetAudioReaderType(), buf->GetReaderSelect());
+        if (!job.fReader)
         {
-            plSoundBuffer* buf = fBuffers.back();
-            fBuffers.pop_back();
+            buf->SetError();
             buf->SetLoaded(true);
+            return true;
         }
     }
+
+    uint32_t chunk = std::min(kChunkSize, job.fLength - job.fDecoded);
+    bool readOK = job.fReader->Read(chunk, static_cast<uint8_t*>(buf->GetData()) + job.fDecoded);
+    job.fDecoded += chunk;
+    if (readOK && job.fDecoded < job.fLength)
+        return false;
+
+    buf->SetAudioReader(job.fReader);     // give sound buffer reader, since we may need it later
+    job.fReader = nullptr;
+
+    plSrtFileReader* srtReader = buf->GetSrtReader();
+    if (srtReader != nullptr && srtReader->GetCurrentAudioFileName() == srcFilename) {
+        // same file we were playing before, so start the SRT feed over instead of deleting and reloading
+        srtReader->StartOver();
+    } else {
+        auto newSrtFileReader = std::make_unique<plSrtFileReader>(srcFilename);
+        if (newSrtFileReader->ReadFile())
+            buf->SetSrtReader(newSrtFileReader.release());
+    }
+
+    buf->SetLoaded(true);
+    return true;
 }
 
-static plSoundPreloader gLoaderThread;
+static plSoundDecoder gDecoder;
 
 void plSoundBuffer::Init()
 {
-    gLoaderThread.Init();
+    // Decoding is mostly waiting on the disk and the OGG decoder, so a couple
+    // of workers are plenty to keep one long file from blocking the rest.
+    gDecoder.Init(std::clamp(std::thread::hardware_concurrency() / 2, 1U, 2U));
 }
 
 void plSoundBuffer::Shutdown()
 {
-    gLoaderThread.Shutdown();
+    gDecoder.Shutdown();
 }
 
 //// Constructor/Destructor //////////////////////////////////////////////////
@@ -172,31 +238,29 @@ plSoundBuffer::plSoundBuffer()
     : fAsyncLoadLength(), fStreamType(plAudioFileReader::StreamType::kStreamRAM),
       fError(), fValid(), fFileName(), fData(), fDataLength(),
       fFlags(), fDataRead(), fReader(), fSrtReader(), fLoaded(), fLoading(),
-      fHeader()
+      fHeader(), fCachedBytes(), fCacheUnused()
 { }
 
 plSoundBuffer::plSoundBuffer(const plFileName &fileName, uint32_t flags)
     : fAsyncLoadLength(), fStreamType(plAudioFileReader::StreamType::kStreamRAM),
       fError(), fValid(), fFileName(fileName), fData(), fDataLength(),
       fFlags(flags), fDataRead(), fReader(), fSrtReader(), fLoaded(), fLoading(),
-      fHeader()
+      fHeader(), fCachedBytes(), fCacheUnused()
 {
     fValid = IGrabHeaderInfo();
 }
 
 plSoundBuffer::~plSoundBuffer()
 { 
-    // if we are loading a sound we need to wait for the loading thread to be completely done processing this buffer.
+    // if we are loading a sound we need to make sure the decoder is completely done with this buffer.
     // otherwise it may try to access this buffer after it's been deleted
     if(fLoading)
     {
-        while(!fLoaded)
-        {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        }
+        gDecoder.Cancel(this);
+        fLoading = false;
     }
 
-    UnLoad();
+    IFreeData();
 
     delete fSrtReader;
 }
@@ -286,7 +350,7 @@ void    plSoundBuffer::SetFileName( const plFileName &name )
     fFileName = name;
 
     // Data is no longer valid
-    UnLoad();
+    IFreeData();
 }
 
 
@@ -326,12 +390,26 @@ plFileName plSoundBuffer::IGetFullPath()
 // When called subsequent times it will check to see if the data has been loaded.
 // Returns kPending while still loading the file. Returns kSuccess when the data has been loaded.
 // While a file is loading(fLoading == true, and fLoaded == false) a buffer, no paremeters of the buffer should be modified.
-plSoundBuffer::ELoadReturnVal plSoundBuffer::AsyncLoad(plAudioFileReader::StreamType type, unsigned length /* = 0 */ )
+// Buffers with a lower priority are decoded first. Decoding happens a chunk at a time, so a more urgent buffer
+// does not have to wait for a long one to finish.
+plSoundBuffer::ELoadReturnVal plSoundBuffer::AsyncLoad(plAudioFileReader::StreamType type, unsigned length /* = 0 */, float priority /* = 0.f */ )
 {
-    if(!gLoaderThread.IsRunning())
-        return kError;  // we cannot load the data since the load thread is no longer running
+    if(!gDecoder.IsRunning())
+        return kError;  // we cannot load the data since the decoder is no longer running
+    if(fCacheUnused)
+    {
+        // Still have the whole thing from last time?
+        if(length == 0 && type == fStreamType)
+        {
+            plSoundBufferCache::Instance().Reused(this);
+            return kSuccess;
+        }
+        IFreeData();
+    }
     if(!fLoading && !fLoaded)
     {
+        if(length == 0)
+            plSoundBufferCache::Instance().Missed();
         fAsyncLoadLength = length;
         fStreamType = type;
         if (fData == nullptr)
@@ -341,8 +419,8 @@ plSoundBuffer::ELoadReturnVal plSoundBuffer::AsyncLoad(plAudioFileReader::Stream
                 return kError;
         }
 
-        gLoaderThread.AddBuffer(this);
         fLoading = true;
+        gDecoder.AddBuffer(this, priority);
     }
     if(fLoaded) 
     {   
@@ -362,6 +440,9 @@ plSoundBuffer::ELoadReturnVal plSoundBuffer::AsyncLoad(plAudioFileReader::Stream
 
             fFlags &= ~kIsExternal;
             fLoading = false;
+
+            if(retVal == kSuccess && fAsyncLoadLength == 0 && fData)
+                plSoundBufferCache::Instance().Decoded(this, fDataLength);
             return retVal;
         }
         return kSuccess;
@@ -370,13 +451,37 @@ plSoundBuffer::ELoadReturnVal plSoundBuffer::AsyncLoad(plAudioFileReader::Stream
     return kPending;
 }
 
-//// ForceNonInternal ////////////////////////////////////////////////////////
-// destroys loaded, and frees data
+//// UnLoad ////////////////////////////////////////////////////////////////
+// releases the data, keeping fully decoded data in the cache for a while
 void    plSoundBuffer::UnLoad()
+{
+    if(fLoading || fCacheUnused)
+        return;
+
+    if(fCachedBytes)
+    {
+        // The sound has its own copy by now, so we won't need the file again until we're evicted
+        if(fReader)
+            fReader->Close();
+        delete fReader;
+        fReader = nullptr;
+
+        plSoundBufferCache::Instance().Released(this);
+        return;
+    }
+
+    IFreeData();
+}
+
+//// IFreeData ///////////////////////////////////////////////////////////////
+// destroys loaded, and frees data
+void    plSoundBuffer::IFreeData()
 {
     if(fLoading) 
         return;
 
+    plSoundBufferCache::Instance().Forget(this);
+
     if(fReader)
         fReader->Close();
 
@@ -401,12 +506,30 @@ void    plSoundBuffer::RoundDataPos( uint32_t &pos )
 // transfers ownership to caller
 plAudioFileReader *plSoundBuffer::GetAudioReader() 
 { 
+    // A cache hit has all of the data but not the reader, which was closed on UnLoad.
+    // Hand out one that's already at the end of the data, just like a fresh decode would,
+    // so the caller doesn't play everything again from the file.
+    if(!fReader && fCachedBytes)
+    {
+        fReader = CreateReader(true, fFileName, fStreamType, GetReaderSelect());
+        if(fReader && !fReader->SetPosition(fReader->GetDataSize()))
+        {
+            delete fReader;
+            fReader = nullptr;
+        }
+    }
+
     plAudioFileReader * reader = fReader;
     fReader = nullptr;
+
+    // Whoever takes the reader carries on from where the data left off, so the data
+    // can't be played again on its own.
+    if(reader)
+        plSoundBufferCache::Instance().Forget(this);
     return reader; 
 }       
     
-// WARNING:  called by the loader thread(only) 
+// WARNING:  called by the decoder (only) 
 // the reader will be handed off for later use. This is useful for streaming sound if we want to load the first chunk of data 
 //  and the continue streaming the file from disk.
 void plSoundBuffer::SetAudioReader(plAudioFileReader *reader)
@@ -55,10 +55,14 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "pnKeyedObject/hsKeyedObject.h"
 #include "plAudioCore.h"
 #include "plAudioFileReader.h"
+#include "plSoundBufferCache.h"
 #include "hsThread.h"
 #include "plFileSystem.h"
 
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 //// Class Definition ////////////////////////////////////////////////////////
@@ -68,6 +72,8 @@ class plAudioFileReader;
 class plSrtFileReader;
 class plSoundBuffer : public hsKeyedObject
 {
+    friend class plSoundBufferCache;
+
 public:
     plSoundBuffer();
     plSoundBuffer( const plFileName &fileName, uint32_t flags = 0 );
@@ -110,7 +116,9 @@ public:
     void                SetFlag( uint32_t flag, bool yes = true ) { if( yes ) fFlags |= flag; else fFlags &= ~flag; }
 
     // Must be called until return value is kSuccess. starts an asynchronous load first time called. returns kSuccess when finished.
-    ELoadReturnVal      AsyncLoad( plAudioFileReader::StreamType type, unsigned length = 0 );   
+    // Loads with a lower priority are decoded first.
+    ELoadReturnVal      AsyncLoad( plAudioFileReader::StreamType type, unsigned length = 0, float priority = 0.f );
+    // Lets go of the data. Fully decoded data is handed to plSoundBufferCache, which keeps it until it needs the room.
     void                UnLoad( );
 
     plAudioCore::ChannelSelect  GetReaderSelect() const;
@@ -141,13 +149,14 @@ protected:
     bool            IGrabHeaderInfo();
     void            IAddBuffers( void *base, void *toAdd, uint32_t lengthInBytes, uint8_t bitsPerSample );
     plFileName      IGetFullPath();
+    void            IFreeData();
 
     uint32_t        fFlags;
     bool            fValid;
     uint32_t        fDataRead;
     plFileName      fFileName;
 
-    bool            fLoaded;
+    std::atomic<bool> fLoaded;
     bool            fLoading;
     bool            fError;
     
@@ -159,46 +168,76 @@ protected:
     uint32_t            fAsyncLoadLength;
     plAudioFileReader::StreamType fStreamType;
 
+    // Owned by plSoundBufferCache
+    size_t                          fCachedBytes;
+    bool                            fCacheUnused;
+    plSoundBufferCache::BufferList::iterator fCacheIt;
+
     // for plugins only
     plAudioFileReader   *IGetReader( bool fullpath );
 };
 
 
-class plSoundPreloader : public hsThread
-{
-protected:
-    std::vector<plSoundBuffer*> fBuffers;
-    hsEvent fEvent;
-    bool fRunning;
-    std::mutex fCritSect;
+//// plSoundDecoder //////////////////////////////////////////////////////////
+//  Decodes sound buffers on a small pool of worker threads. Buffers are
+//  decoded a chunk at a time in priority order, so one long OGG no longer
+//  holds up every sound queued behind it, and a more urgent sound can jump
+//  in between two chunks of a less urgent one.
+//  A buffer only counts as loaded once its whole requested length is
+//  decoded. Streaming sounds just request their first few buffers and read
+//  the rest from disk while playing, but a static sound is uploaded to
+//  OpenAL in one piece and can't start playing before that.
 
+class plSoundDecoder
+{
 public:
-    void Run() override;
+    // Number of bytes decoded before checking for more urgent work
+    static constexpr uint32_t kChunkSize = 64 * 1024;
 
-    void Init()
+protected:
+    struct Job
     {
-        fRunning = true;
-        Start();
-    }
+        plSoundBuffer*      fBuffer;
+        plAudioFileReader*  fReader;
+        uint32_t            fDecoded;
+        uint32_t            fLength;
+        float               fPriority;
+        uint64_t            fSequence;
+
+        // Heap order: most urgent on top, first come first served among equals
+        bool operator<(const Job& other) const
+        {
+            if (fPriority != other.fPriority)
+                return fPriority > other.fPriority;
+            return fSequence > other.fSequence;
+        }
+    };
 
-    void Shutdown()
-    {
-        fRunning = false;
-        fEvent.Signal();
-        Stop();
-    }
+    std::vector<Job>            fQueue;
+    std::vector<plSoundBuffer*> fActive;
+    std::vector<std::thread>    fWorkers;
+    std::mutex                  fMutex;
+    std::condition_variable     fCondition;     // Workers wait on this for jobs
+    std::condition_variable     fChunkDone;     // Cancel() waits on this for workers to let go
+    uint64_t                    fNextSequence;
+    bool                        fRunning;
+
+    void IWorkerProc();
+    bool IDecodeChunk(Job& job);
+
+public:
+    plSoundDecoder() : fNextSequence(), fRunning() { }
+
+    void Init(size_t numWorkers);
+    void Shutdown();
 
     bool IsRunning() const { return fRunning; }
 
-    void AddBuffer(plSoundBuffer* buffer)
-    {
-        {
-            hsLockGuard(fCritSect);
-            fBuffers.emplace_back(buffer);
-        }
+    void AddBuffer(plSoundBuffer* buffer, float priority);
 
-        fEvent.Signal();
-    }
+    // Waits out the chunk being decoded for this buffer, if any, and drops
+    // the rest of its load.
+    void Cancel(plSoundBuffer* buffer);
 };
 
 #endif //_plSoundBuffer_h
@@ -0,0 +1,121 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "plSoundBufferCache.h"
+#include "plSoundBuffer.h"
+
+plSoundBufferCache& plSoundBufferCache::Instance()
+{
+    static plSoundBufferCache sInstance;
+    return sInstance;
+}
+
+void plSoundBufferCache::SetBudget(size_t bytes)
+{
+    fBudget = bytes;
+    ITrim();
+}
+
+void plSoundBufferCache::Clear()
+{
+    while (!fUnused.empty())
+    {
+        // Frees the data and calls back into Forget(), which removes it from the list
+        fUnused.front()->IFreeData();
+        ++fEvictions;
+    }
+}
+
+void plSoundBufferCache::ITrim()
+{
+    while (fResident > fBudget && !fUnused.empty())
+    {
+        fUnused.front()->IFreeData();
+        ++fEvictions;
+    }
+}
+
+void plSoundBufferCache::Decoded(plSoundBuffer* buffer, size_t bytes)
+{
+    hsAssert(!buffer->fCachedBytes, "Buffer decoded twice without being forgotten");
+
+    buffer->fCachedBytes = bytes;
+    fResident += bytes;
+
+    // Make room for the new data if we can
+    ITrim();
+}
+
+void plSoundBufferCache::Released(plSoundBuffer* buffer)
+{
+    if (!buffer->fCachedBytes || buffer->fCacheUnused)
+        return;
+
+    buffer->fCacheUnused = true;
+    buffer->fCacheIt = fUnused.insert(fUnused.end(), buffer);
+    fUnusedBytes += buffer->fCachedBytes;
+
+    ITrim();
+}
+
+void plSoundBufferCache::Reused(plSoundBuffer* buffer)
+{
+    hsAssert(buffer->fCacheUnused, "Reusing a buffer that's still in use");
+
+    fUnused.erase(buffer->fCacheIt);
+    fUnusedBytes -= buffer->fCachedBytes;
+    buffer->fCacheUnused = false;
+    ++fHits;
+}
+
+void plSoundBufferCache::Forget(plSoundBuffer* buffer)
+{
+    if (buffer->fCacheUnused)
+    {
+        fUnused.erase(buffer->fCacheIt);
+        fUnusedBytes -= buffer->fCachedBytes;
+        buffer->fCacheUnused = false;
+    }
+
+    fResident -= buffer->fCachedBytes;
+    buffer->fCachedBytes = 0;
+}
@@ -0,0 +1,110 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  plSoundBufferCache - Keeps decoded sound data resident after the sounds //
+//                       using it let go, up to a byte budget, so sounds    //
+//                       that play again soon don't have to be decoded      //
+//                       again. Unused data is evicted least recently used  //
+//                       first. Main thread only.                           //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef _plSoundBufferCache_h
+#define _plSoundBufferCache_h
+
+#include "HeadSpin.h"
+
+#include <list>
+
+class plSoundBuffer;
+
+class plSoundBufferCache
+{
+public:
+    typedef std::list<plSoundBuffer*> BufferList;
+
+    static constexpr size_t kDefaultBudget = 64 * 1024 * 1024;
+
+protected:
+    BufferList  fUnused;        // least recently used first
+    size_t      fBudget;
+    size_t      fResident;
+    size_t      fUnusedBytes;
+    uint32_t    fHits;
+    uint32_t    fMisses;
+    uint32_t    fEvictions;
+
+    void    ITrim();
+
+public:
+    plSoundBufferCache()
+        : fBudget(kDefaultBudget), fResident(), fUnusedBytes(),
+          fHits(), fMisses(), fEvictions()
+    { }
+
+    static plSoundBufferCache& Instance();
+
+    void    SetBudget(size_t bytes);
+    size_t  GetBudget() const { return fBudget; }
+
+    // All decoded data we know about, and the part of it no sound is using
+    size_t  GetResidentSize() const { return fResident; }
+    size_t  GetUnusedSize() const { return fUnusedBytes; }
+
+    uint32_t    GetHits() const { return fHits; }
+    uint32_t    GetMisses() const { return fMisses; }
+    uint32_t    GetEvictions() const { return fEvictions; }
+    void        ResetStats() { fHits = fMisses = fEvictions = 0; }
+
+    // Frees all of the data no sound is using
+    void    Clear();
+
+    // Called by plSoundBuffer as its data comes and goes
+    void    Decoded(plSoundBuffer* buffer, size_t bytes);
+    void    Missed() { ++fMisses; }
+    void    Released(plSoundBuffer* buffer);
+    void    Reused(plSoundBuffer* buffer);
+    void    Forget(plSoundBuffer* buffer);
+};
+
+#endif //_plSoundBufferCache_h
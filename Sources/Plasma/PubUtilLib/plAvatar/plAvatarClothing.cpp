@@ -49,6 +49,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plArmatureEffects.h"
 #include "plArmatureMod.h"
 #include "plAvatarMgr.h"
+#include "plClothingCompositor.h"
 #include "plClothingSDLModifier.h"
 
 #include "pnEncryption/plRandom.h"
@@ -396,7 +397,7 @@ bool plClothingBase::MsgReceive(plMessage* msg)
 
 plClothingOutfit::plClothingOutfit() : 
     fTargetLayer(nullptr), fBase(nullptr), fGroup(0), fAvatar(nullptr), fSynchClients(false), fMaterial(nullptr),
-    fVaultSaveEnabled(true), fMorphsInitDone(false)
+    fCompositor(nullptr), fVaultSaveEnabled(true), fMorphsInitDone(false)
 {
     fSkinTint.Set(1.f, 0.84f, 0.71f, 1.f);
     fItems.clear();
@@ -414,6 +415,12 @@ plClothingOutfit::~plClothingOutfit()
         delete fOptions.back();
         fOptions.pop_back();
     }
+    if (fCompositor)
+    {
+        if (fTargetLayer && fTargetLayer->GetTexture() == fCompositor->GetTexture())
+            fTargetLayer->SetTexture(nullptr);
+        delete fCompositor;
+    }
     plgDispatch::Dispatch()->UnRegisterForExactType(plPreResourceMsg::Index(), GetKey());
 }
 
@@ -942,6 +949,24 @@ void plClothingOutfit::DirtyTileset(int tileset)
     ForceUpdate(true);
 }
 
+void plClothingOutfit::CompositeTexture()
+{
+    if (fTargetLayer == nullptr)
+        return;
+
+    if (fCompositor == nullptr)
+        fCompositor = new plClothingCompositor;
+    else if (fDirtyItems.Empty() && fTargetLayer->GetTexture() == fCompositor->GetTexture())
+        return;
+
+    plMipmap *texture = fCompositor->Update(this, fDirtyItems);
+    if (texture)
+    {
+        fTargetLayer->SetTexture(texture);
+        fDirtyItems.Clear();
+    }
+}
+
 void plClothingOutfit::IUpdate()
 {
     //GenerateTexture();
@@ -61,6 +61,7 @@ class plGeometrySpan;
 class plClothingLayout;
 class plClothingElement;
 class plArmatureMod;
+class plClothingCompositor;
 class plSharedMesh;
 class plStateDataRecord;
 class plDXPipeline;
@@ -238,6 +239,11 @@ public:
     // XXX Don't use this. Temp function for a temp HACK console command.
     void DirtyTileset(int tileset);
 
+    /** Builds our texture on the CPU and puts it on the target layer, for
+     *  pipelines that don't composite clothing themselves.
+     */
+    void CompositeTexture();
+
     /** Instruct this plClothingOutfit to read clothing from the given file */
     void SetClothingFile(const plFileName &file) { fClothingFile = file; }
 
@@ -248,6 +254,7 @@ public:
 
 protected:
     hsBitVector fDirtyItems;
+    plClothingCompositor* fCompositor;
     bool fVaultSaveEnabled;
     bool fMorphsInitDone;
     plFileName fClothingFile;
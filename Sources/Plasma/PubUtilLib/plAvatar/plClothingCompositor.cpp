@@ -0,0 +1,459 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "HeadSpin.h"
+#include "plClothingCompositor.h"
+
+#include <algorithm>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+#include "hsBitVector.h"
+#include "hsColorRGBA.h"
+#include "hsGDeviceRef.h"
+#include "plProfile.h"
+
+#include "plAvatarClothing.h"
+
+#include "plGImage/hsCodecManager.h"
+#include "plGImage/plMipmap.h"
+
+plProfile_CreateTimer("ClothComposite", "Avatar", ClothComposite);
+plProfile_CreateCounter("ClothElemsBuilt", "Avatar", ClothElemsBuilt);
+plProfile_CreateCounter("ClothElemsShared", "Avatar", ClothElemsShared);
+plProfile_CreateMemCounter("ClothCache", "Avatar", ClothCache);
+
+//// Element Cache ///////////////////////////////////////////////////////////
+//  Least recently used elements go first once we're over budget. Only the
+//  main thread composites clothing, so there's no locking.
+
+struct plCachedClothingElement
+{
+    plClothingCompositor::Recipe fRecipe;
+    size_t fHash;
+    std::vector<uint32_t> fPixels;
+};
+
+typedef std::list<plCachedClothingElement> plClothingElementList;
+
+static plClothingElementList sCache;    // Most recently used first
+static std::unordered_multimap<size_t, plClothingElementList::iterator> sCacheIndex;
+static size_t sCacheBytes = 0;
+static size_t sCacheBudget = 16 * 1024 * 1024;
+
+static void IEraseCached(plClothingElementList::iterator it)
+{
+    auto range = sCacheIndex.equal_range(it->fHash);
+    for (auto idx = range.first; idx != range.second; ++idx)
+    {
+        if (idx->second == it)
+        {
+            sCacheIndex.erase(idx);
+            break;
+        }
+    }
+    sCacheBytes -= it->fPixels.size() * sizeof(uint32_t);
+    sCache.erase(it);
+}
+
+static void ITrimCache(size_t budget)
+{
+    while (sCacheBytes > budget && !sCache.empty())
+        IEraseCached(std::prev(sCache.end()));
+    plProfile_Set(ClothCache, sCacheBytes);
+}
+
+static const std::vector<uint32_t>* IFindCached(const plClothingCompositor::Recipe& recipe, size_t hash)
+{
+    auto range = sCacheIndex.equal_range(hash);
+    for (auto idx = range.first; idx != range.second; ++idx)
+    {
+        if (idx->second->fRecipe == recipe)
+        {
+            sCache.splice(sCache.begin(), sCache, idx->second);
+            return &idx->second->fPixels;
+        }
+    }
+    return nullptr;
+}
+
+static void IAddCached(const plClothingCompositor::Recipe& recipe, size_t hash, const std::vector<uint32_t>& pixels)
+{
+    size_t bytes = pixels.size() * sizeof(uint32_t);
+    if (bytes > sCacheBudget)
+        return;
+
+    ITrimCache(sCacheBudget - bytes);
+
+    sCache.push_front({ recipe, hash, pixels });
+    sCacheIndex.emplace(hash, sCache.begin());
+    sCacheBytes += bytes;
+    plProfile_Set(ClothCache, sCacheBytes);
+}
+
+void plClothingCompositor::SetCacheBudget(size_t bytes)
+{
+    sCacheBudget = bytes;
+    ITrimCache(sCacheBudget);
+}
+
+size_t plClothingCompositor::GetCacheBudget()
+{
+    return sCacheBudget;
+}
+
+void plClothingCompositor::FlushCache()
+{
+    ITrimCache(0);
+}
+
+size_t plClothingCompositor::Recipe::Hash() const
+{
+    size_t hash = 0;
+    auto combine = [&hash](size_t value)
+    {
+        hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    };
+
+    for (const plKey& key : fTextures)
+        combine(std::hash<const void*>()(key ? &*key : nullptr));
+    for (uint32_t word : fWords)
+        combine(word);
+    return hash;
+}
+
+//// plClothingCompositor ////////////////////////////////////////////////////
+
+plClothingCompositor::plClothingCompositor()
+    : fTexture(), fBaseImage(), fBase(), fLayout()
+{
+}
+
+plClothingCompositor::~plClothingCompositor()
+{
+    delete fTexture;
+    delete fBaseImage;
+}
+
+plMipmap* plClothingCompositor::Update(const plClothingOutfit* outfit, const hsBitVector& dirtyTilesets)
+{
+    const plClothingBase* base = outfit->fBase;
+    if (base == nullptr || base->fBaseTexture == nullptr || plClothingMgr::GetClothingMgr() == nullptr)
+        return nullptr;
+
+    const plClothingLayout* layout = plClothingMgr::GetClothingMgr()->GetLayout(base->fLayoutName);
+    if (layout == nullptr || layout->fOrigWidth == 0)
+        return nullptr;
+
+    plProfile_BeginTiming(ClothComposite);
+
+    // A new base means starting over, with every element up for a rebuild
+    bool rebuildAll = false;
+    if (fTexture == nullptr || base != fBase || layout != fLayout)
+    {
+        if (!IBuildBase(base, layout))
+        {
+            plProfile_EndTiming(ClothComposite);
+            return nullptr;
+        }
+        rebuildAll = true;
+    }
+
+    uint32_t dirtyMask = 0;
+    for (int i = 0; i < plClothingLayout::kMaxTileset; i++)
+    {
+        if (dirtyTilesets.IsBitSet(i))
+            dirtyMask |= 1 << i;
+    }
+
+    // The layout's own element list can't be trusted to resolve, so go by
+    // what the items point at, like the pipelines do. Elements stay on our
+    // list once drawn, so taking an item off puts the base back.
+    for (plClothingItem* item : outfit->fItems)
+    {
+        for (const plClothingElement* element : item->fElements)
+        {
+            auto sameElement = [element](const ElementState& state) { return state.fElement == element; };
+            if (element && std::none_of(fElements.cbegin(), fElements.cend(), sameElement))
+                fElements.emplace_back(element);
+        }
+    }
+
+    const uint32_t texWidth = fTexture->GetWidth();
+    std::vector<uint32_t> pixels;
+    for (ElementState& state : fElements)
+    {
+        const plClothingElement* element = state.fElement;
+
+        // Anything that drew here last time or wants to draw here now
+        // from a dirty tileset means another look.
+        uint32_t tilesets = state.fTilesets;
+        for (plClothingItem* item : outfit->fItems)
+        {
+            if (std::find(item->fElements.cbegin(), item->fElements.cend(), element) != item->fElements.cend())
+                tilesets |= 1 << item->fTileset;
+        }
+        if (!rebuildAll && !(tilesets & dirtyMask))
+            continue;
+
+        uint32_t x = element->fXPos * texWidth / layout->fOrigWidth;
+        uint32_t y = element->fYPos * texWidth / layout->fOrigWidth;
+        uint32_t width = element->fWidth * texWidth / layout->fOrigWidth;
+        uint32_t height = element->fHeight * texWidth / layout->fOrigWidth;
+        if (width == 0 || height == 0 || x + width > texWidth || y + height > fTexture->GetHeight())
+            continue;
+
+        Recipe recipe;
+        uint32_t drawn = IGatherRecipe(outfit, element, x, y, width, height, recipe);
+        if (!rebuildAll && recipe == state.fRecipe)
+        {
+            state.fTilesets = drawn;
+            continue;
+        }
+
+        size_t hash = recipe.Hash();
+        const std::vector<uint32_t>* cached = recipe.fCacheable ? IFindCached(recipe, hash) : nullptr;
+        if (cached)
+        {
+            IStoreElement(*cached, x, y, width, height);
+            plProfile_Inc(ClothElemsShared);
+        }
+        else
+        {
+            ICompositeElement(recipe, x, y, width, height, pixels);
+            IStoreElement(pixels, x, y, width, height);
+            if (recipe.fCacheable)
+                IAddCached(recipe, hash, pixels);
+            plProfile_Inc(ClothElemsBuilt);
+        }
+
+        state.fRecipe = std::move(recipe);
+        state.fTilesets = drawn;
+    }
+
+    plProfile_EndTiming(ClothComposite);
+    return fTexture;
+}
+
+//// IBuildBase //////////////////////////////////////////////////////////////
+//  Our texture is the base texture's size. Everything outside the layout
+//  elements is just the base, so that only has to be copied once.
+
+bool plClothingCompositor::IBuildBase(const plClothingBase* base, const plClothingLayout* layout)
+{
+    uint32_t width = base->fBaseTexture->GetWidth();
+
+    plMipmap* baseImage = IScaleTexture(base->fBaseTexture, width, width);
+    if (baseImage == nullptr)
+        return false;
+
+    delete fBaseImage;
+    fBaseImage = baseImage;
+
+    if (fTexture == nullptr || fTexture->GetWidth() != width)
+    {
+        delete fTexture;
+        fTexture = new plMipmap(width, width, plMipmap::kARGB32Config, 1);
+    }
+
+    plMipmap::CompositeOptions opts(plMipmap::kCopySrcAlpha);
+    fTexture->Composite(fBaseImage, 0, 0, &opts);
+
+    fBase = base;
+    fLayout = layout;
+    fElements.clear();
+    return true;
+}
+
+//// IGatherRecipe ///////////////////////////////////////////////////////////
+//  Lists everything the outfit draws into this element, in the same order
+//  and with the same tints the pipelines use. Returns the tilesets involved.
+//  The rect is part of it because every element starts out as its own piece
+//  of the base texture.
+
+uint32_t plClothingCompositor::IGatherRecipe(const plClothingOutfit* outfit, const plClothingElement* element,
+                                             uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                                             Recipe& recipe) const
+{
+    uint32_t tilesets = 0;
+
+    auto addTexture = [&recipe](plMipmap* texture)
+    {
+        plKey key = texture->GetKey();
+        if (!key)
+            recipe.fCacheable = false;
+        recipe.fTextures.emplace_back(std::move(key));
+        recipe.fMipmaps.emplace_back(texture);
+    };
+
+    addTexture(outfit->fBase->fBaseTexture);
+    recipe.fWords.emplace_back(x);
+    recipe.fWords.emplace_back(y);
+    recipe.fWords.emplace_back(width);
+    recipe.fWords.emplace_back(height);
+
+    for (plClothingItem* item : outfit->fItems)
+    {
+        for (size_t j = 0; j < item->fElements.size(); j++)
+        {
+            if (item->fElements[j] != element)
+                continue;
+
+            for (int k = 0; k < plClothingElement::kLayerMax; k++)
+            {
+                plMipmap* texture = item->fTextures[j][k];
+                if (texture == nullptr)
+                    continue;
+
+                hsColorRGBA tint = outfit->GetItemTint(item, k);
+                if (k >= plClothingElement::kLayerSkinBlend1 && k <= plClothingElement::kLayerSkinLast)
+                    tint.a = outfit->fSkinBlends[k - plClothingElement::kLayerSkinBlend1];
+
+                addTexture(texture);
+                recipe.fWords.emplace_back(tint.ToARGB32());
+                recipe.fWords.emplace_back(k == plClothingElement::kLayerBase);
+                tilesets |= 1 << item->fTileset;
+            }
+        }
+    }
+
+    return tilesets;
+}
+
+//// ICompositeElement ///////////////////////////////////////////////////////
+//  Base layers replace what's there, everything else is alpha blended over
+//  it, leaving the alpha alone. Both are modulated by the tint.
+
+void plClothingCompositor::ICompositeElement(const Recipe& recipe, uint32_t x, uint32_t y,
+                                             uint32_t width, uint32_t height,
+                                             std::vector<uint32_t>& pixels) const
+{
+    plMipmap element(width, height, plMipmap::kARGB32Config, 1);
+
+    plMipmap::CompositeOptions baseOpts(plMipmap::kCopySrcAlpha, 0, 1.f, 1.f, 1.f,
+                                        uint16_t(x), uint16_t(y), uint16_t(width), uint16_t(height));
+    element.Composite(fBaseImage, 0, 0, &baseOpts);
+
+    for (size_t i = 1; i < recipe.fMipmaps.size(); i++)
+    {
+        uint32_t tint = recipe.fWords[kRecipeRectWords + (i - 1) * 2];
+        bool replace = recipe.fWords[kRecipeRectWords + (i - 1) * 2 + 1] != 0;
+
+        std::unique_ptr<plMipmap> layer(IScaleTexture(recipe.fMipmaps[i], width, height));
+        if (!layer)
+            continue;
+
+        if (replace)
+        {
+            if (tint != 0xffffffff)
+            {
+                uint32_t* texel = (uint32_t*)layer->GetImage();
+                for (uint32_t p = 0; p < width * height; p++)
+                {
+                    uint32_t out = 0;
+                    for (int shift = 0; shift < 32; shift += 8)
+                        out |= ((((texel[p] >> shift) & 0xff) * ((tint >> shift) & 0xff) + 127) / 255) << shift;
+                    texel[p] = out;
+                }
+            }
+
+            plMipmap::CompositeOptions opts(plMipmap::kCopySrcAlpha);
+            element.Composite(layer.get(), 0, 0, &opts);
+        }
+        else
+        {
+            hsColorRGBA color;
+            color.FromARGB32(tint);
+
+            plMipmap::CompositeOptions opts(0, 0, color.r, color.g, color.b, 0, 0, 0, 0, uint8_t(tint >> 24));
+            element.Composite(layer.get(), 0, 0, &opts);
+        }
+    }
+
+    const uint32_t* src = (const uint32_t*)element.GetImage();
+    pixels.assign(src, src + width * height);
+}
+
+//// IStoreElement ///////////////////////////////////////////////////////////
+
+void plClothingCompositor::IStoreElement(const std::vector<uint32_t>& pixels, uint32_t x, uint32_t y,
+                                         uint32_t width, uint32_t height)
+{
+    fTexture->SetCurrLevel(0);
+    for (uint32_t row = 0; row < height; row++)
+        memcpy(fTexture->GetAddr32(x, y + row), pixels.data() + row * width, width * sizeof(uint32_t));
+
+    if (fTexture->GetDeviceRef() != nullptr)
+        fTexture->GetDeviceRef()->SetDirty(true);
+}
+
+//// IScaleTexture ///////////////////////////////////////////////////////////
+//  Returns a new single level 32-bit copy of the texture at the given size,
+//  or nullptr if we can't read it. Compressed textures go through the codec
+//  first.
+
+plMipmap* plClothingCompositor::IScaleTexture(plMipmap* texture, uint32_t width, uint32_t height)
+{
+    std::unique_ptr<plMipmap> uncompressed;
+    plMipmap* src = texture;
+    if (texture->IsCompressed())
+    {
+        uncompressed.reset(hsCodecManager::Instance().CreateUncompressedMipmap(texture, hsCodecManager::k32BitDepth));
+        src = uncompressed.get();
+    }
+    if (src == nullptr || src->GetPixelSize() != 32)
+        return nullptr;
+
+    plMipmap* scaled = new plMipmap(width, height, plMipmap::kARGB32Config, 1);
+
+    uint8_t level = uint8_t(src->GetCurrLevel());
+    src->SetCurrLevel(0);
+    if (src->GetWidth() == width && src->GetHeight() == height)
+        memcpy(scaled->GetImage(), src->GetImage(), width * height * sizeof(uint32_t));
+    else
+        src->ScaleNicely((uint32_t*)scaled->GetImage(), uint16_t(width), uint16_t(height), uint16_t(width), plMipmap::kDefaultFilter);
+    src->SetCurrLevel(level);
+
+    return scaled;
+}
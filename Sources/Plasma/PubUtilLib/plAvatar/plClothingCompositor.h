@@ -0,0 +1,132 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+#ifndef plClothingCompositor_inc
+#define plClothingCompositor_inc
+
+#include "HeadSpin.h"
+
+#include <vector>
+
+#include "pnKeyedObject/plKey.h"
+
+class hsBitVector;
+class plClothingBase;
+class plClothingElement;
+class plClothingLayout;
+class plClothingOutfit;
+class plMipmap;
+
+//
+// Builds an outfit's body texture on the CPU, so any pipeline (or none at
+// all) can dress an avatar. The texture is split along the elements the
+// outfit's items draw into, and only elements touched by dirty tilesets are
+// looked at again. A rebuilt element is first looked up in a cache shared by
+// every compositor, keyed on where it goes and the textures and tints that
+// went into it, so avatars wearing the same thing only pay for it once.
+//
+class plClothingCompositor
+{
+public:
+    plClothingCompositor();
+    ~plClothingCompositor();
+
+    // Brings our texture up to date with the outfit. Returns nullptr if the
+    // outfit has no base texture or layout to build on.
+    plMipmap* Update(const plClothingOutfit* outfit, const hsBitVector& dirtyTilesets);
+
+    plMipmap* GetTexture() const { return fTexture; }
+
+    // Bytes of composited elements kept around for reuse
+    static void SetCacheBudget(size_t bytes);
+    static size_t GetCacheBudget();
+    static void FlushCache();
+
+    // Everything that goes into one element. Texture keys are held on to so
+    // the same address can't come back as a different texture.
+    struct Recipe
+    {
+        std::vector<plKey> fTextures;   // Base texture, then every layer drawn
+        std::vector<plMipmap*> fMipmaps;// Same order as fTextures, not compared
+        std::vector<uint32_t> fWords;   // Element rect, then tint and mode per layer
+        bool fCacheable;                // False if a texture has no key
+
+        Recipe() : fCacheable(true) { }
+
+        bool operator==(const Recipe& other) const
+        {
+            return fCacheable && other.fCacheable && fWords == other.fWords && fTextures == other.fTextures;
+        }
+        size_t Hash() const;
+    };
+
+protected:
+    enum { kRecipeRectWords = 4 };      // x, y, width, height
+
+    struct ElementState
+    {
+        const plClothingElement* fElement;
+        Recipe fRecipe;                 // What the element was last built from
+        uint32_t fTilesets;             // Bit per tileset that drew into it
+
+        ElementState(const plClothingElement* element)
+            : fElement(element), fTilesets(~0U) { }
+    };
+
+    plMipmap* fTexture;
+    plMipmap* fBaseImage;               // Base texture at our resolution
+    const plClothingBase* fBase;
+    const plClothingLayout* fLayout;
+    std::vector<ElementState> fElements;// Every element drawn into since IBuildBase
+
+    bool IBuildBase(const plClothingBase* base, const plClothingLayout* layout);
+    uint32_t IGatherRecipe(const plClothingOutfit* outfit, const plClothingElement* element,
+                           uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                           Recipe& recipe) const;
+    void ICompositeElement(const Recipe& recipe, uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                           std::vector<uint32_t>& pixels) const;
+    void IStoreElement(const std::vector<uint32_t>& pixels, uint32_t x, uint32_t y,
+                       uint32_t width, uint32_t height);
+
+    static plMipmap* IScaleTexture(plMipmap* texture, uint32_t width, uint32_t height);
+};
+
+#endif // plClothingCompositor_inc
@@ -117,7 +117,7 @@ const uint32_t        plDrawableSpans::kSpanTypeParticleSpan  = 0xc0000000;
 //// Constructor & Destructor ////////////////////////////////////////////////
 
 plDrawableSpans::plDrawableSpans() :
-    fSpaceTree()
+    fSpaceTree(), fVisCacheSerial()
 {
     fReadyToRender = false;
     fProps = 0;
@@ -324,7 +324,8 @@ void plDrawableSpans::SetVisSet(plVisMgr* visMgr)
         myVis |= myNot;
 
         GetSpaceTree()->SetCache(&fVisCache);
-        if( !myVis.Empty() )
+        // A rebuilt tree renumbers its interior nodes, so the cached bits are junk.
+        if( !myVis.Empty() || fVisCacheSerial != GetSpaceTree()->GetRebuildSerial() )
         {
             fVisCache.Clear();
             
@@ -337,6 +338,7 @@ void plDrawableSpans::SetVisSet(plVisMgr* visMgr)
             }
             fLastVisSet = visSet;
             fLastVisNot = visNot;
+            fVisCacheSerial = GetSpaceTree()->GetRebuildSerial();
         }
     }
     else
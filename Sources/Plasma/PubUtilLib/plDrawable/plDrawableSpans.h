@@ -149,6 +149,7 @@ class plDrawableSpans : public plDrawable
         mutable hsBitVector     fLastVisSet; // Last vis set we were evaluated against.
         mutable hsBitVector     fLastVisNot; // Last exclusion set we were evaluated agains.
         hsBitVector             fVisCache; // the enabled section of the space tree
+        uint32_t                fVisCacheSerial; // space tree rebuild fVisCache was made against
 
         std::vector<plIcicle>       fIcicles;
         std::vector<plParticleSpan> fParticleSpans;
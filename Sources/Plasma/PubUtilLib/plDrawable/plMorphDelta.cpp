@@ -51,6 +51,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plGeometrySpan.h"
 
 #include "plTweak.h"
+#include "hsFastMath.h"
 
 static const float kMinWeight = 1.e-2f;
 
@@ -111,6 +112,35 @@ void plMorphDelta::Apply(std::vector<plAccessSpan>& dst, float weight /* = -1.f
     }
 }
 
+float plMorphDelta::EffectiveWeight(float w)
+{
+    return w > kMinWeight ? w : 0.f;
+}
+
+// MorphDelta - Accumulate
+// Add this delta's span, scaled by weight, into a running sum. The weight
+// here is the change in weight since the last time, and may be negative.
+void plMorphDelta::Accumulate(plMorphAccum& dst, size_t iSpan, float weight) const
+{
+    if (iSpan >= fSpans.size())
+        return;
+
+    const plMorphSpan& span = fSpans[iSpan];
+    const size_t stride = plMorphAccum::kNumFixed + 3 * span.fNumUVWChans;
+    hsAssert(stride <= dst.fStride, "Morph delta has more UVWs than its span");
+
+    const float* del = span.fPacked.data();
+    for (const plVertDelta& delta : span.fDeltas)
+    {
+        float* acc = dst.fVerts.data() + delta.fIdx * dst.fStride;
+        for (size_t k = 0; k < stride; k++)
+            acc[k] += del[k] * weight;
+        del += stride;
+
+        dst.Touch(delta.fIdx);
+    }
+}
+
 // MorphDelta - ComputeDeltas
 void plMorphDelta::ComputeDeltas(const std::vector<plAccessSpan>& base, const std::vector<plAccessSpan>& moved)
 {
@@ -256,6 +286,91 @@ void plMorphDelta::SetDeltas(size_t iSpan, const std::vector<plVertDelta>& delta
         if (numUVWChans)
             std::copy(uvws, uvws + (deltas.size() * numUVWChans), fSpans[iSpan].fUVWs);
     }
+    PackDeltas(iSpan);
+}
+
+void plMorphDelta::PackDeltas(size_t iSpan)
+{
+    plMorphSpan& span = fSpans[iSpan];
+    const size_t stride = plMorphAccum::kNumFixed + 3 * span.fNumUVWChans;
+
+    span.fPacked.resize(span.fDeltas.size() * stride);
+    float* dst = span.fPacked.data();
+    const hsPoint3* uvw = span.fUVWs;
+    for (const plVertDelta& delta : span.fDeltas)
+    {
+        *dst++ = delta.fPos.fX;
+        *dst++ = delta.fPos.fY;
+        *dst++ = delta.fPos.fZ;
+        *dst++ = delta.fNorm.fX;
+        *dst++ = delta.fNorm.fY;
+        *dst++ = delta.fNorm.fZ;
+        for (uint16_t i = 0; i < span.fNumUVWChans; i++, uvw++)
+        {
+            *dst++ = uvw->fX;
+            *dst++ = uvw->fY;
+            *dst++ = uvw->fZ;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+void plMorphAccum::Init(const plAccessVtxSpan& src)
+{
+    const uint32_t numVerts = src.VertCount();
+
+    fNumUVWChans = src.NumUVWs();
+    fStride = kNumFixed + 3 * fNumUVWChans;
+    fVerts.resize(numVerts * fStride);
+
+    float* dst = fVerts.data();
+    for (uint32_t i = 0; i < numVerts; i++)
+    {
+        const hsPoint3& pos = src.Position(i);
+        const hsVector3& norm = src.Normal(i);
+        *dst++ = pos.fX;
+        *dst++ = pos.fY;
+        *dst++ = pos.fZ;
+        *dst++ = norm.fX;
+        *dst++ = norm.fY;
+        *dst++ = norm.fZ;
+        const hsPoint3* uvw = src.UVWs(i);
+        for (uint16_t j = 0; j < fNumUVWChans; j++, uvw++)
+        {
+            *dst++ = uvw->fX;
+            *dst++ = uvw->fY;
+            *dst++ = uvw->fZ;
+        }
+    }
+
+    // Everything needs writing out the first time around
+    fTouched.assign(numVerts, 1);
+    fTouchedList.resize(numVerts);
+    for (uint32_t i = 0; i < numVerts; i++)
+        fTouchedList[i] = i;
+}
+
+void plMorphAccum::Flush(plAccessVtxSpan& dst)
+{
+    for (uint32_t iVtx : fTouchedList)
+    {
+        const float* src = fVerts.data() + iVtx * fStride;
+
+        dst.Position(iVtx).Set(src[0], src[1], src[2]);
+
+        hsVector3& norm = dst.Normal(iVtx);
+        norm.Set(src[3], src[4], src[5]);
+        hsFastMath::Normalize(norm);
+
+        hsPoint3* uvw = dst.UVWs(iVtx);
+        src += kNumFixed;
+        for (uint16_t j = 0; j < fNumUVWChans; j++, uvw++, src += 3)
+            uvw->Set(src[0], src[1], src[2]);
+
+        fTouched[iVtx] = 0;
+    }
+    fTouchedList.clear();
 }
 
 void plMorphDelta::Read(hsStream* s, hsResMgr* mgr)
@@ -275,6 +390,7 @@ void plMorphDelta::Read(hsStream* s, hsResMgr* mgr)
             if( nUVW )
                 s->Read(nDel * nUVW * sizeof(hsPoint3), fSpans[iSpan].fUVWs);
         }
+        PackDeltas(iSpan);
     }
 
 }
@@ -71,6 +71,34 @@ struct plMorphSpan
 
     uint16_t                  fNumUVWChans;
     hsPoint3*               fUVWs; // Length is fUVWChans*fDeltas.GetCount() (*sizeof(hsPoint3) in bytes).
+
+    // The same deltas packed for plMorphAccum: position, normal and
+    // fNumUVWChans UVWs as consecutive floats, one after another.
+    std::vector<float>      fPacked;
+};
+
+// Running sum of a span's base vertices and every weighted delta applied
+// to it, with the normals left unnormalized, so a change in weight can be
+// applied on its own instead of rebuilding the whole span.
+// Each vertex is fStride floats laid out like plMorphSpan::fPacked.
+struct plMorphAccum
+{
+    enum { kNumFixed = 6 }; // position and normal
+
+    uint16_t                fNumUVWChans;
+    size_t                  fStride;
+    std::vector<float>      fVerts;
+    std::vector<uint8_t>    fTouched;
+    std::vector<uint32_t>   fTouchedList; // vertices changed since the last Flush()
+
+    plMorphAccum() : fNumUVWChans(), fStride() { }
+
+    void Init(const plAccessVtxSpan& src);
+    void Touch(uint32_t iVtx) { if (!fTouched[iVtx]) { fTouched[iVtx] = 1; fTouchedList.emplace_back(iVtx); } }
+    bool IsTouched() const { return !fTouchedList.empty(); }
+
+    // Write the changed vertices out, renormalizing their normals.
+    void Flush(plAccessVtxSpan& dst);
 };
 
 class plMorphDelta : public plCreatable
@@ -92,6 +120,10 @@ public:
     float    GetWeight() const { return fWeight; }
 
     void        Apply(std::vector<plAccessSpan>& dst, float weight = -1.f) const;
+    void        Accumulate(plMorphAccum& dst, size_t iSpan, float weight) const;
+
+    // Weights too small to bother with are treated as zero
+    static float EffectiveWeight(float w);
 
     void        ComputeDeltas(const std::vector<plAccessSpan>& base, const std::vector<plAccessSpan>& moved);
     void        ComputeDeltas(const std::vector<plGeometrySpan*>& base, const std::vector<plGeometrySpan*>& moved, const hsMatrix44& d2b, const hsMatrix44& d2bTInv);
@@ -101,6 +133,7 @@ public:
     void        SetDeltas(size_t iSpan, const std::vector<plVertDelta>& deltas, size_t numUVWChans, const hsPoint3* uvws); // len uvws is deltas.size() * numUVWChans
 
     void        AllocDeltas(size_t iSpan, size_t nDel, size_t nUVW);
+    void        PackDeltas(size_t iSpan);
 
     void Read(hsStream* s, hsResMgr* mgr) override;
     void Write(hsStream* s, hsResMgr* mgr) override;
@@ -64,6 +64,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plTweak.h"
 #include "hsTimer.h"
 #include "hsFastMath.h"
+#include "hsThreadPool.h"
 
 ///////////////////////////////////////////////////////////////////////////
 
@@ -99,6 +100,10 @@ const uint32_t kChanMask = plAccessVtxSpan::kPositionMask
 
 plConst(float)   kMorphTime(0.5);
 
+// Incremental updates between rebuilding the sums from scratch, to keep
+// rounding error from adding up.
+plConst(uint32_t) kMaxIncrementalUpdates(256);
+
 struct plMorphTarget
 {
     plMorphTarget(uint16_t layer, uint16_t delta, float weight)
@@ -111,6 +116,8 @@ struct plMorphTarget
 
 std::vector<plMorphTarget> fTgtWgts;
 
+bool plMorphSequence::fIncremental = true;
+
 plMorphSequence::plMorphSequence()
 :   fMorphFlags(),
     fMorphSDLMod(),
@@ -171,11 +178,17 @@ bool plMorphSequence::MsgReceive(plMessage* msg)
 
         if( fMorphFlags & kHaveShared )
         {
-            IApplyShared();
+            if (fIncremental)
+                IApplySharedIncremental();
+            else
+                IApplyShared();
         }
         else
         {
-            Apply();
+            if (fIncremental)
+                IApplyIncremental();
+            else
+                Apply();
         }
         return true;
     }
@@ -333,6 +346,7 @@ void plMorphSequence::Init()
             plAccessGeometry::Instance()->TakeSnapShot(di, kChanMask);
 
             ISetHaveSnap(true);
+            fState.Invalidate();
         }
     }
 }
@@ -370,6 +384,7 @@ void plMorphSequence::DeInit()
                 plAccessGeometry::Instance()->ReleaseSnapShot(di);
 
             ISetHaveSnap(false);
+            fState.Invalidate();
         }
     }
 }
@@ -425,6 +440,119 @@ void plMorphSequence::Reset(const plDrawInterface* di) const
     // Use access span RestoreSnapshot
     if( di )
         plAccessGeometry::Instance()->RestoreSnapShot(di, kChanMask);
+
+    // Whatever we had summed up is gone now
+    fState.Invalidate();
+}
+
+// MorphSequence - IApplyIncremental
+// Same as Apply(), but only applies whatever weights changed since last time.
+void plMorphSequence::IApplyIncremental()
+{
+    const plDrawInterface* di = IGetDrawInterface();
+    if( !di )
+        return;
+
+    std::vector<plAccessSpan> dst;
+    if (INeedsRebuild(fState))
+    {
+        // Start over from the snapshot
+        Reset(di);
+        plAccessGeometry::Instance()->OpenRW(di, dst);
+
+        fState.fSpans.resize(dst.size());
+        for (size_t i = 0; i < dst.size(); i++)
+            fState.fSpans[i].Init(dst[i].AccessVtx());
+        fState.fValid = true;
+    }
+    else
+    {
+        plAccessGeometry::Instance()->OpenRW(di, dst);
+    }
+
+    IGatherChanges(fState, fMorphs, nullptr);
+    IAccumulate({ &fState });
+
+    std::vector<plMorphAccum*> accs;
+    for (plMorphAccum& acc : fState.fSpans)
+        accs.emplace_back(&acc);
+    IFlush(accs, dst);
+
+    plAccessGeometry::Instance()->Close(dst);
+}
+
+// Whether the sums have to be built from scratch before applying changes
+bool plMorphSequence::INeedsRebuild(const plMorphMeshState& state)
+{
+    return !state.IsValid() || state.fNumUpdates >= kMaxIncrementalUpdates;
+}
+
+// Work out which weights changed since we last applied them to this mesh
+void plMorphSequence::IGatherChanges(plMorphMeshState& state, const std::vector<plMorphArray>& morphs,
+                                     const std::vector<plMorphArrayWeights>* weights)
+{
+    state.fChanges.clear();
+    state.fApplied.resize(morphs.size());
+    for (size_t iLay = 0; iLay < morphs.size(); iLay++)
+    {
+        const plMorphArray& morph = morphs[iLay];
+        std::vector<float>& applied = state.fApplied[iLay].fDeltaWeights;
+        applied.resize(morph.GetNumDeltas(), 0.f);
+
+        for (size_t iDel = 0; iDel < morph.GetNumDeltas(); iDel++)
+        {
+            float w = weights ? (*weights)[iLay].fDeltaWeights[iDel] : morph.GetWeight(iDel);
+            w = plMorphDelta::EffectiveWeight(w);
+            if (w != applied[iDel])
+            {
+                state.fChanges.emplace_back(&morph.GetDelta(iDel), w - applied[iDel]);
+                applied[iDel] = w;
+            }
+        }
+    }
+
+    if (!state.fChanges.empty())
+        state.fNumUpdates++;
+}
+
+// Sum the pending changes in, one job per span, since spans don't share vertices
+void plMorphSequence::IAccumulate(const std::vector<plMorphMeshState*>& states)
+{
+    std::vector<std::pair<plMorphMeshState*, size_t>> jobs;
+    for (plMorphMeshState* state : states)
+    {
+        if (state->fChanges.empty())
+            continue;
+        for (size_t i = 0; i < state->fSpans.size(); i++)
+            jobs.emplace_back(state, i);
+    }
+
+    hsThreadPool::Instance().ParallelFor(jobs.size(), 1, [&jobs](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            plMorphMeshState* state = jobs[i].first;
+            size_t iSpan = jobs[i].second;
+            for (const auto& change : state->fChanges)
+                change.first->Accumulate(state->fSpans[iSpan], iSpan, change.second);
+        }
+    });
+
+    for (plMorphMeshState* state : states)
+        state->fChanges.clear();
+}
+
+// Write the touched vertices of each sum into the matching open span
+void plMorphSequence::IFlush(const std::vector<plMorphAccum*>& accs, std::vector<plAccessSpan>& dst)
+{
+    hsAssert(accs.size() == dst.size(), "Mismatch between morph sums and spans");
+
+    hsThreadPool::Instance().ParallelFor(accs.size(), 1, [&accs, &dst](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            if (accs[i]->IsTouched() && dst[i].HasAccessVtx())
+                accs[i]->Flush(dst[i].AccessVtx());
+        }
+    });
 }
 
 const plDrawInterface* plMorphSequence::IGetDrawInterface() const
@@ -539,6 +667,69 @@ void plMorphSequence::IReleaseIndices()
         IReleaseIndices(i);
 }
 
+// Incremental version of IApplyShared(). The sums for all meshes are updated
+// together, so the per span jobs can be spread across the thread pool.
+void plMorphSequence::IApplySharedIncremental()
+{
+    std::vector<plMorphMeshState*> states;
+    for (size_t i = 0; i < fSharedMeshes.size(); i++)
+    {
+        plSharedMeshInfo& mInfo = fSharedMeshes[i];
+        if (!mInfo.fCurrDraw)
+            continue;
+
+        if (INeedsRebuild(mInfo.fState))
+            IInitSharedState(i);
+
+        IGatherChanges(mInfo.fState, mInfo.fMesh->fMorphSet->fMorphs, &mInfo.fArrayWeights);
+        states.emplace_back(&mInfo.fState);
+        mInfo.fFlags &= ~plSharedMeshInfo::kInfoDirtyMesh;
+    }
+
+    IAccumulate(states);
+
+    // Only open the spans that actually changed
+    std::vector<plMorphAccum*> accs;
+    std::vector<plAccessSpan> dst;
+    for (plSharedMeshInfo& mInfo : fSharedMeshes)
+    {
+        if (!mInfo.fCurrDraw)
+            continue;
+
+        for (size_t i = 0; i < mInfo.fState.fSpans.size(); i++)
+        {
+            if (!mInfo.fState.fSpans[i].IsTouched())
+                continue;
+
+            plAccessSpan dstAcc;
+            plAccessGeometry::Instance()->OpenRW(mInfo.fCurrDraw, mInfo.fCurrIdx[i], dstAcc);
+            dst.emplace_back(dstAcc);
+            accs.emplace_back(&mInfo.fState.fSpans[i]);
+        }
+    }
+
+    IFlush(accs, dst);
+
+    plAccessGeometry::Instance()->Close(dst);
+}
+
+// Build the sums for a shared mesh from its pristine geometry
+void plMorphSequence::IInitSharedState(size_t iShare)
+{
+    plSharedMeshInfo& mInfo = fSharedMeshes[iShare];
+    plMorphMeshState& state = mInfo.fState;
+
+    state.Invalidate();
+    state.fSpans.resize(mInfo.fMesh->fSpans.size());
+    for (size_t i = 0; i < mInfo.fMesh->fSpans.size(); i++)
+    {
+        plAccessSpan srcAcc;
+        plAccessGeometry::Instance()->AccessSpanFromGeometrySpan(srcAcc, mInfo.fMesh->fSpans[i]);
+        state.fSpans[i].Init(srcAcc.AccessVtx());
+    }
+    state.fValid = true;
+}
+
 void plMorphSequence::IApplyShared(size_t iShare)
 {
     if (iShare >= fSharedMeshes.size() || fSharedMeshes[iShare].fCurrDraw == nullptr)
@@ -577,6 +768,7 @@ bool plMorphSequence::IResetShared(size_t iShare)
         return false;
 
     plSharedMeshInfo& mInfo = fSharedMeshes[iShare];
+    mInfo.fState.Invalidate();
 
     // Now copy each shared mesh geometryspan into the drawable
     // to get it back to it's pristine condition.
@@ -609,6 +801,7 @@ bool plMorphSequence::IFindIndices(size_t iShare)
 {
     plSharedMeshInfo& mInfo = fSharedMeshes[iShare];
     mInfo.fCurrDraw = nullptr; // In case we fail.
+    mInfo.fState.Invalidate(); // The drawable will need everything written out again
 
     const plInstanceDrawInterface* di = plInstanceDrawInterface::ConvertNoRef(IGetDrawInterface());
     if( !di )
@@ -640,6 +833,7 @@ void plMorphSequence::IReleaseIndices(size_t iShare)
 {
     plSharedMeshInfo& mInfo = fSharedMeshes[iShare];
     mInfo.fCurrDraw = nullptr;
+    mInfo.fState.Invalidate();
 }
 
 hsSsize_t plMorphSequence::IFindSharedMeshIndex(const plKey& meshKey) const
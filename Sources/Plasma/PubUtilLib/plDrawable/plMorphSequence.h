@@ -43,6 +43,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #ifndef plMorphSequence_inc
 #define plMorphSequence_inc
 
+#include <utility>
 #include <vector>
 
 #include "pnModifier/plSingleModifier.h"
@@ -58,6 +59,22 @@ struct plMorphArrayWeights
     std::vector<float> fDeltaWeights;
 };
 
+// What's currently applied to one mesh, so that only weight changes
+// need to be applied from one frame to the next.
+struct plMorphMeshState
+{
+    std::vector<plMorphAccum>           fSpans;     // running sums, one per span
+    std::vector<plMorphArrayWeights>    fApplied;   // effective weights summed into fSpans
+    std::vector<std::pair<const plMorphDelta*, float>> fChanges; // weight changes still to be summed in
+    uint32_t                            fNumUpdates; // since fSpans was last built from scratch
+    bool                                fValid;     // fSpans has been built, even if there aren't any
+
+    plMorphMeshState() : fNumUpdates(), fValid() { }
+
+    bool IsValid() const { return fValid; }
+    void Invalidate() { fSpans.clear(); fApplied.clear(); fChanges.clear(); fNumUpdates = 0; fValid = false; }
+};
+
 class plSharedMeshInfo
 {
 public:
@@ -71,6 +88,7 @@ public:
     plDrawable*         fCurrDraw;
     std::vector<plMorphArrayWeights> fArrayWeights;
     uint8_t               fFlags;
+    plMorphMeshState    fState;
 
     plSharedMeshInfo() : fMesh(), fCurrDraw(), fFlags() { }
 };
@@ -116,6 +134,9 @@ protected:
     std::vector<plMorphState>   fPendingStates;
     plMorphSequenceSDLMod*      fMorphSDLMod;
     int8_t                        fGlobalLayerRef;
+    mutable plMorphMeshState    fState;         // for our own drawable, when not using shared meshes
+
+    static bool                 fIncremental;
 
     const plDrawInterface*      IGetDrawInterface() const;
 
@@ -136,6 +157,16 @@ protected:
     void        IFindIndices(); // Refresh Indicies
     void        IApplyShared(); // Apply whatever morphs are active
 
+    // Incremental application
+    void        IApplyIncremental();
+    void        IApplySharedIncremental();
+    void        IInitSharedState(size_t iShare);
+    static bool INeedsRebuild(const plMorphMeshState& state);
+    static void IGatherChanges(plMorphMeshState& state, const std::vector<plMorphArray>& morphs,
+                               const std::vector<plMorphArrayWeights>* weights);
+    static void IAccumulate(const std::vector<plMorphMeshState*>& states);
+    static void IFlush(const std::vector<plMorphAccum*>& accs, std::vector<plAccessSpan>& dst);
+
     hsSsize_t   IFindPendingStateIndex(const plKey& meshKey) const; // Do we have pending state for this mesh?
     hsSsize_t   IFindSharedMeshIndex(const plKey& meshKey) const; // What's this mesh's index in our array?
     bool        IIsUsingDrawable(plDrawable *draw); // Are we actively looking at spans in this drawable?
@@ -166,6 +197,11 @@ public:
     void Apply() const;
     void Reset(const plDrawInterface* di=nullptr) const;
 
+    /** When on (the default), only the change in each weight is applied each
+        time, rather than resetting the mesh and applying every delta again. */
+    static void SetIncremental(bool on) { fIncremental = on; }
+    static bool GetIncremental() { return fIncremental; }
+
     size_t GetNumLayers(const plKey& meshKey = {}) const;
     void AddLayer(const plMorphArray& ma) { fMorphs.emplace_back(ma); }
 
@@ -45,6 +45,11 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "hsStream.h"
 #include "hsBitVector.h"
 #include "plProfile.h"
+#include "plSpaceTreeMaker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
 
 #include "plIntersect/plVolumeIsect.h"
 #include "plMath/hsRadixSort.h"
@@ -53,6 +58,28 @@ static hsBitVector scratchTotVec;
 static hsBitVector scratchBitVec;
 
 plProfile_CreateCounter("Harvest Leaves", "Draw", HarvestLeaves);
+plProfile_CreateCounter("Space Refit", "Draw", SpaceTreeRefit);
+plProfile_CreateCounter("Space Rebuild", "Draw", SpaceTreeRebuild);
+
+float plSpaceTree::fRebuildThreshold = 2.f;
+bool plSpaceTree::fHotCulling = true;
+
+// Rebuilding tiny trees buys nothing.
+static const int32_t kMinRebuildLeaves = 8;
+
+static inline double BoundsSurfaceArea(const hsBounds3Ext& bnd)
+{
+    if( bnd.GetType() != kBoundsNormal )
+        return 0;
+
+    const hsPoint3& mins = bnd.GetMins();
+    const hsPoint3& maxs = bnd.GetMaxs();
+    double dx = maxs.fX - mins.fX;
+    double dy = maxs.fY - mins.fY;
+    double dz = maxs.fZ - mins.fZ;
+
+    return 2. * (dx * dy + dy * dz + dz * dx);
+}
 
 void plSpaceTreeNode::Read(hsStream* s)
 {
@@ -82,7 +109,15 @@ void plSpaceTreeNode::Write(hsStream* s)
 plSpaceTree::plSpaceTree()
 :   fCullFunc(),
     fNumLeaves(),
-    fCache()
+    fCache(),
+    fLeafArea(),
+    fInteriorArea(),
+    fBaseQuality(),
+    fRebuildSerial(),
+    fRefitReady(),
+    fChildrenFirst(),
+    fHotCull(),
+    fHotCullValid()
 {
 }
 
@@ -112,13 +147,286 @@ void plSpaceTree::IRefreshRecur(int16_t which)
             sub.fWorldBounds.Union(&fTree[sub.fChildren[1]].fWorldBounds);
 
         sub.fFlags &= ~plSpaceTreeNode::kDirty;
+
+        IUpdateHot(which);
+    }
+}
+
+void plSpaceTree::IMarkDirty(int16_t idx)
+{
+    if( !(fTree[idx].fFlags & plSpaceTreeNode::kDirty) )
+    {
+        fTree[idx].fFlags |= plSpaceTreeNode::kDirty;
+        fDirtyNodes.emplace_back(idx);
+    }
+}
+
+// Run once per tree (and after each rebuild). Settles whatever was dirty, checks
+// whether every parent follows its children in fTree (the plSpaceTreeMaker layout),
+// and records the surface area ratio we'll measure refit degradation against.
+void plSpaceTree::IInitRefit()
+{
+    IRefreshRecur(fRoot);
+    fDirtyNodes.clear();
+
+    fChildrenFirst = true;
+    fLeafArea = 0;
+    fInteriorArea = 0;
+    for (size_t i = 0; i < fTree.size(); i++)
+    {
+        plSpaceTreeNode& node = fTree[i];
+        node.fFlags &= ~plSpaceTreeNode::kDirty;
+
+        if( node.fParent != kRootParent && node.fParent <= int16_t(i) )
+            fChildrenFirst = false;
+
+        if( node.IsLeaf() )
+            fLeafArea += BoundsSurfaceArea(node.fWorldBounds);
+        else
+            fInteriorArea += BoundsSurfaceArea(node.fWorldBounds);
+    }
+    fBaseQuality = fLeafArea > 0 ? fInteriorArea / fLeafArea : 0;
+
+    fRefitReady = true;
+}
+
+// Bottom up refit of just the nodes MoveLeaf dirtied. Parents always sit after
+// their children, so walking the dirty list in index order finishes every child
+// before its parent is recomputed.
+void plSpaceTree::IRefit()
+{
+    std::sort(fDirtyNodes.begin(), fDirtyNodes.end());
+
+    for (int16_t idx : fDirtyNodes)
+    {
+        plSpaceTreeNode& sub = fTree[idx];
+        sub.fFlags &= ~plSpaceTreeNode::kDirty;
+
+        if( sub.fFlags & plSpaceTreeNode::kIsLeaf )
+            continue;
+
+        fInteriorArea -= BoundsSurfaceArea(sub.fWorldBounds);
+
+        sub.fWorldBounds.MakeEmpty();
+        if( !(fTree[sub.fChildren[0]].fFlags & plSpaceTreeNode::kDisabled) )
+            sub.fWorldBounds.Union(&fTree[sub.fChildren[0]].fWorldBounds);
+        if( !(fTree[sub.fChildren[1]].fFlags & plSpaceTreeNode::kDisabled) )
+            sub.fWorldBounds.Union(&fTree[sub.fChildren[1]].fWorldBounds);
+
+        fInteriorArea += BoundsSurfaceArea(sub.fWorldBounds);
+
+        IUpdateHot(idx);
     }
+    plProfile_IncCount(SpaceTreeRefit, fDirtyNodes.size());
+
+    fDirtyNodes.clear();
+}
+
+// Hand the current leaf bounds back to the maker. Leaf i stays node i, so only
+// interior indices change.
+void plSpaceTree::IRebuild()
+{
+    plSpaceTreeMaker maker;
+    maker.Reset();
+    for (int32_t i = 0; i < fNumLeaves; i++)
+        maker.AddLeaf(fTree[i].fWorldBounds, 0 != (fTree[i].fFlags & plSpaceTreeNode::kDisabled));
+
+    std::unique_ptr<plSpaceTree> fresh(maker.MakeTree());
+
+    // The maker parks leaves without normal bounds at the origin, and its interior
+    // bounds take in disabled leaves. Put the real leaf bounds back and refit
+    // everything above them.
+    for (int32_t i = 0; i < fNumLeaves; i++)
+        fresh->fTree[i].fWorldBounds = fTree[i].fWorldBounds;
+    for (size_t i = fNumLeaves; i < fresh->fTree.size(); i++)
+        fresh->fTree[i].fFlags |= plSpaceTreeNode::kDirty;
+
+    fTree.swap(fresh->fTree);
+    fRoot = fresh->fRoot;
+    fHot.clear();
+    IRefreshRecur(fRoot);
+    IBuildHot();
+
+    ++fRebuildSerial;
+    plProfile_Inc(SpaceTreeRebuild);
+
+    IInitRefit();
+}
+
+// The hot grid spans everything currently in the tree plus some slack, so leaves
+// can wander a while before a node falls off the grid and forces a re-encode.
+void plSpaceTree::IBuildHot()
+{
+    fHot.resize(fTree.size());
+    fHotCullValid = false;
+
+    hsBounds3Ext all;
+    all.MakeEmpty();
+    for (const plSpaceTreeNode& node : fTree)
+    {
+        if( node.fWorldBounds.GetType() == kBoundsNormal )
+            all.Union(&node.fWorldBounds);
+    }
+    hsPoint3 mins, maxs;
+    if( all.GetType() == kBoundsNormal )
+    {
+        mins = all.GetMins();
+        maxs = all.GetMaxs();
+    }
+    else
+    {
+        mins.Set(0, 0, 0);
+        maxs.Set(0, 0, 0);
+    }
+
+    for( int i = 0; i < 3; i++ )
+    {
+        float slack = (maxs[i] - mins[i]) * 0.25f + 1.f;
+        float size = maxs[i] - mins[i] + 2.f * slack;
+        fHotOrigin[i] = mins[i] - slack;
+        fHotScale[i] = 65535.f / size;
+        fHotStep[i] = size / 65535.f;
+    }
+
+    // Only non-finite bounds can miss a grid built around everything. IEncodeHot
+    // leaves those empty, which sends the culls to the node's real bounds.
+    size_t offGrid = 0;
+    for (size_t i = 0; i < fTree.size(); i++)
+    {
+        if( !IEncodeHot(int16_t(i)) )
+            offGrid++;
+    }
+    hsAssert(offGrid == 0, "Non-finite bounds in the space tree");
+}
+
+// Returns false if the node's bounds have left the grid, in which case the
+// grid has to be rebuilt. The node is left with an empty hot box until then.
+bool plSpaceTree::IEncodeHot(int16_t idx)
+{
+    const plSpaceTreeNode& node = fTree[idx];
+    plSpaceTreeHotNode& hot = fHot[idx];
+
+    if( node.IsLeaf() )
+    {
+        hot.fChildren[0] = -1;
+        hot.fChildren[1] = -1;
+    }
+    else
+    {
+        hot.fChildren[0] = node.fChildren[0];
+        hot.fChildren[1] = node.fChildren[1];
+    }
+
+    if( (node.fFlags & plSpaceTreeNode::kDisabled) || (node.fWorldBounds.GetType() != kBoundsNormal) )
+    {
+        hot.fMins[0] = hot.fMins[1] = hot.fMins[2] = 0xffff;
+        hot.fMaxs[0] = hot.fMaxs[1] = hot.fMaxs[2] = 0;
+        return true;
+    }
+
+    const hsPoint3& mins = node.fWorldBounds.GetMins();
+    const hsPoint3& maxs = node.fWorldBounds.GetMaxs();
+    for( int i = 0; i < 3; i++ )
+    {
+        float lo = (mins[i] - fHotOrigin[i]) * fHotScale[i];
+        float hi = (maxs[i] - fHotOrigin[i]) * fHotScale[i];
+        if( !(lo >= 0) || !(hi <= 65535.f) )
+        {
+            hot.fMins[0] = hot.fMins[1] = hot.fMins[2] = 0xffff;
+            hot.fMaxs[0] = hot.fMaxs[1] = hot.fMaxs[2] = 0;
+            return false;
+        }
+
+        // An extra step each way soaks up the float error in the grid mapping.
+        hot.fMins[i] = uint16_t(std::max(std::floor(lo) - 1.f, 0.f));
+        hot.fMaxs[i] = uint16_t(std::min(std::ceil(hi) + 1.f, 65535.f));
+    }
+    return true;
+}
+
+void plSpaceTree::IUpdateHot(int16_t idx)
+{
+    if( fHot.size() != fTree.size() )
+        return;
+
+    if( !IEncodeHot(idx) )
+        IBuildHot();
+}
+
+void plSpaceTree::IUpdateHotChain(int16_t idx)
+{
+    while( idx != kRootParent )
+    {
+        IUpdateHot(idx);
+        idx = fTree[idx].fParent;
+    }
+}
+
+void plSpaceTree::ISetHotCull(const plVolumeIsect* cullFunc) const
+{
+    hsPoint3 mins, maxs;
+    fHotCullValid = fHotCulling && cullFunc && (fHot.size() == fTree.size()) && cullFunc->GetWorldBounds(mins, maxs);
+    if( !fHotCullValid )
+        return;
+
+    // Clamping onto the grid only grows the box, and everything in the tree is
+    // on the grid, so this can't reject anything the exact test would keep.
+    for( int i = 0; i < 3; i++ )
+    {
+        float lo = (mins[i] - fHotOrigin[i]) * fHotScale[i];
+        float hi = (maxs[i] - fHotOrigin[i]) * fHotScale[i];
+        fHotCull.fMins[i] = uint16_t(std::min(std::max(std::floor(lo) - 1.f, 0.f), 65535.f));
+        fHotCull.fMaxs[i] = uint16_t(std::min(std::max(std::ceil(hi) + 1.f, 0.f), 65535.f));
+    }
+}
+
+void plSpaceTree::GetHotBounds(int16_t w, hsPoint3& mins, hsPoint3& maxs) const
+{
+    const plSpaceTreeHotNode& hot = fHot[w];
+    mins.Set(fHotOrigin.fX + hot.fMins[0] * fHotStep.fX,
+             fHotOrigin.fY + hot.fMins[1] * fHotStep.fY,
+             fHotOrigin.fZ + hot.fMins[2] * fHotStep.fZ);
+    maxs.Set(fHotOrigin.fX + hot.fMaxs[0] * fHotStep.fX,
+             fHotOrigin.fY + hot.fMaxs[1] * fHotStep.fY,
+             fHotOrigin.fZ + hot.fMaxs[2] * fHotStep.fZ);
+}
+
+float plSpaceTree::GetQuality() const
+{
+    if( fBaseQuality <= 0 || fLeafArea <= 0 )
+        return 1.f;
+
+    return float(fInteriorArea / fLeafArea / fBaseQuality);
 }
 
 void plSpaceTree::Refresh()
 {
-    if( !IsEmpty() )
+    if( IsEmpty() )
+        return;
+
+    if( !fRefitReady )
+    {
+        IInitRefit();
+        return;
+    }
+
+    if( fDirtyNodes.empty() )
+        return;
+
+    if( !fChildrenFirst )
+    {
+        // Not laid out by plSpaceTreeMaker, fall back on the top down walk.
         IRefreshRecur(fRoot);
+        for (int16_t idx : fDirtyNodes)
+            fTree[idx].fFlags &= ~plSpaceTreeNode::kDirty;
+        fDirtyNodes.clear();
+        return;
+    }
+
+    IRefit();
+
+    if( fRebuildThreshold > 0 && fNumLeaves >= kMinRebuildLeaves && GetQuality() > fRebuildThreshold )
+        IRebuild();
 }
 
 void plSpaceTree::SetTreeFlag(uint16_t f, bool on)
@@ -134,6 +442,9 @@ void plSpaceTree::SetTreeFlag(uint16_t f, bool on)
 
     for (plSpaceTreeNode& node : fTree)
         node.fFlags |= f;
+
+    if( f & plSpaceTreeNode::kDisabled )
+        IBuildHot();
 }
 
 void plSpaceTree::ClearTreeFlag(uint16_t f)
@@ -143,6 +454,9 @@ void plSpaceTree::ClearTreeFlag(uint16_t f)
 
     for (plSpaceTreeNode& node : fTree)
         node.fFlags &= ~f;
+
+    if( f & plSpaceTreeNode::kDisabled )
+        IBuildHot();
 }
 
 void plSpaceTree::SetLeafFlag(int16_t idx, uint16_t f, bool on)
@@ -160,6 +474,7 @@ void plSpaceTree::SetLeafFlag(int16_t idx, uint16_t f, bool on)
 
     fTree[idx].fFlags |= f;
 
+    const int16_t leaf = idx;
     idx = fTree[idx].fParent;
 
     while( idx != kRootParent )
@@ -175,17 +490,21 @@ void plSpaceTree::SetLeafFlag(int16_t idx, uint16_t f, bool on)
             idx = fTree[idx].fParent;
         }
     }
+
+    if( f & plSpaceTreeNode::kDisabled )
+        IUpdateHotChain(leaf);
 }
 
 void plSpaceTree::ClearLeafFlag(int16_t idx, uint16_t f)
 {
     hsAssert(idx == fTree[idx].fLeafIndex, "Some scrambling of indices");
 
+    const int16_t leaf = idx;
     while( idx != kRootParent )
     {
         if( !(fTree[idx].fFlags & f) )
         {
-            return;
+            break;
         }
         else
         {
@@ -194,6 +513,8 @@ void plSpaceTree::ClearLeafFlag(int16_t idx, uint16_t f)
         }
     }
 
+    if( f & plSpaceTreeNode::kDisabled )
+        IUpdateHotChain(leaf);
 }
 
 inline void plSpaceTree::IEnableLeaf(int16_t idx, hsBitVector& cache) const
@@ -237,6 +558,9 @@ void plSpaceTree::IHarvestAndCullEnabledLeaves(int16_t subIdx, const hsBitVector
     if( !cache.IsBitSet(subIdx) )
         return;
 
+    if( fHotCullValid && !fHot[subIdx].IsEmpty() && !fHot[subIdx].Overlaps(fHotCull) )
+        return;
+
     const plSpaceTreeNode& subRoot = fTree[subIdx];
 
     plVolumeCullResult res = fCullFunc->Test(subRoot.fWorldBounds);
@@ -271,7 +595,6 @@ void plSpaceTree::IHarvestEnabledLeaves(int16_t subIdx, const hsBitVector& cache
 
     if( subRoot.fFlags & plSpaceTreeNode::kIsLeaf )
     {
-        plProfile_Inc(HarvestLeaves);
         list.emplace_back(subIdx);
     }
     else
@@ -287,6 +610,7 @@ void plSpaceTree::HarvestEnabledLeaves(plVolumeIsect* cull, const hsBitVector& c
         return;
 
     fCullFunc = cull;
+    ISetHotCull(fCullFunc);
     if (fCullFunc)
         IHarvestAndCullEnabledLeaves(fRoot, cache, list);
     else
@@ -320,7 +644,9 @@ void plSpaceTree::MoveLeaf(int16_t idx, const hsBounds3Ext& bnd)
 {
     hsAssert(idx == fTree[idx].fLeafIndex, "Some scrambling of indices");
 
+    fLeafArea += BoundsSurfaceArea(bnd) - BoundsSurfaceArea(fTree[idx].fWorldBounds);
     fTree[idx].fWorldBounds = bnd;
+    IUpdateHot(idx);
 
     while( idx != kRootParent )
     {
@@ -330,7 +656,7 @@ void plSpaceTree::MoveLeaf(int16_t idx, const hsBounds3Ext& bnd)
         }
         else
         {
-            fTree[idx].fFlags |= plSpaceTreeNode::kDirty;
+            IMarkDirty(idx);
             idx = fTree[idx].fParent;
         }
     }
@@ -369,6 +695,7 @@ void plSpaceTree::HarvestLeaves(plVolumeIsect* cull, hsBitVector& list) const
     if( !IsEmpty() )
     {
         fCullFunc = cull;
+        ISetHotCull(fCullFunc);
         if (fCullFunc)
             IHarvestAndCullLeaves(fTree[fRoot], scratchTotVec, list);
         else
@@ -426,6 +753,9 @@ void plSpaceTree::IHarvestAndCullLeaves(const plSpaceTreeNode& subRoot, hsBitVec
     if( totList.IsBitSet(idx) )
         return;
 
+    if( fHotCullValid && !fHot[idx].IsEmpty() && !fHot[idx].Overlaps(fHotCull) )
+        return;
+
     hsAssert(fCullFunc, "Oops");
     plVolumeCullResult res = fCullFunc->Test(subRoot.fWorldBounds);
     if( res == kVolumeCulled )
@@ -460,6 +790,10 @@ void plSpaceTree::IHarvestAndCullLeaves(const plSpaceTreeNode& subRoot, std::vec
     if( subRoot.fFlags & plSpaceTreeNode::kDisabled )
         return;
 
+    auto idx = (uint32_t)(&subRoot - &fTree[0]);
+    if( fHotCullValid && !fHot[idx].IsEmpty() && !fHot[idx].Overlaps(fHotCull) )
+        return;
+
     hsAssert(fCullFunc, "Oops");
     plVolumeCullResult res = fCullFunc->Test(subRoot.fWorldBounds);
     if( res == kVolumeCulled )
@@ -536,6 +870,11 @@ void plSpaceTree::Read(hsStream* s, hsResMgr* mgr)
     fTree.resize(n);
     for (uint32_t i = 0; i < n; i++)
         fTree[i].Read(s);
+
+    fDirtyNodes.clear();
+    fRefitReady = false;
+
+    IBuildHot();
 }
 
 void plSpaceTree::Write(hsStream* s, hsResMgr* mgr)
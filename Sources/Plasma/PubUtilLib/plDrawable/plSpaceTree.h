@@ -87,6 +87,30 @@ public:
 };
 
 
+// Query time copy of a plSpaceTreeNode, indexed the same as the full node array.
+// The bounds are quantized onto a grid covering the whole tree, rounded outward so
+// they always contain the real bounds. Disabled nodes and nodes without normal bounds
+// get an empty box. Four of these fit in a cache line, where a full node with its
+// hsBounds3Ext is bigger than two, so traversals only touch the full nodes when they
+// need an exact answer.
+class plSpaceTreeHotNode
+{
+public:
+    uint16_t              fMins[3];
+    uint16_t              fMaxs[3];
+    int16_t               fChildren[2]; // fChildren[0] < 0 for leaves
+
+    int16_t               GetChild(int w) const { hsAssert(!IsLeaf(), "Getting Child of leaf node"); return fChildren[w]; }
+    bool                IsLeaf() const { return fChildren[0] < 0; }
+    bool                IsEmpty() const { return fMins[0] > fMaxs[0]; }
+    bool                Overlaps(const plSpaceTreeHotNode& o) const
+    {
+        return (fMins[0] <= o.fMaxs[0]) && (fMaxs[0] >= o.fMins[0])
+            && (fMins[1] <= o.fMaxs[1]) && (fMaxs[1] >= o.fMins[1])
+            && (fMins[2] <= o.fMaxs[2]) && (fMaxs[2] >= o.fMins[2]);
+    }
+};
+
 class plSpaceTree : public plCreatable
 {
 public:
@@ -111,7 +135,40 @@ private:
 
     hsPoint3                        fViewPos;
 
+    // Nodes (leaves included) marked dirty by MoveLeaf since the last Refresh.
+    std::vector<int16_t>              fDirtyNodes;
+
+    // Surface area sums used to judge how far refitting has degraded the tree.
+    double                          fLeafArea;
+    double                          fInteriorArea;
+    double                          fBaseQuality;
+    uint32_t                          fRebuildSerial;
+    bool                            fRefitReady;
+    bool                            fChildrenFirst;
+
+    static float                    fRebuildThreshold;
+    static bool                     fHotCulling;
+
+    std::vector<plSpaceTreeHotNode> fHot;
+    hsPoint3                        fHotOrigin;
+    hsVector3                       fHotScale; // world to grid
+    hsVector3                       fHotStep; // grid to world
+
+    // The current cull volume's box on the hot grid, when it has one.
+    mutable plSpaceTreeHotNode      fHotCull;
+    mutable bool                    fHotCullValid;
+
     void        IRefreshRecur(int16_t which);
+    void        IMarkDirty(int16_t idx);
+    void        IInitRefit();
+    void        IRefit();
+    void        IRebuild();
+
+    void        IBuildHot();
+    bool        IEncodeHot(int16_t idx);
+    void        IUpdateHot(int16_t idx);
+    void        IUpdateHotChain(int16_t idx);
+    void        ISetHotCull(const plVolumeIsect* cullFunc) const;
     
     void        IHarvestAndCullLeaves(const plSpaceTreeNode& subRoot, std::vector<int16_t>& list) const;
     void        IHarvestLeaves(const plSpaceTreeNode& subRoot, std::vector<int16_t>& list) const;
@@ -154,6 +211,8 @@ public:
 
     void EnableLeaf(int16_t idx, hsBitVector& cache) const;
     void EnableLeaves(const std::vector<int16_t>& list, hsBitVector& cache) const;
+    // Safe to run on different trees at once, so it leaves the Harvest Leaves
+    // counter to the caller.
     void HarvestEnabledLeaves(plVolumeIsect* cullFunc, const hsBitVector& cache, std::vector<int16_t>& list) const;
     void SetCache(const hsBitVector* cache) { fCache = cache; }
 
@@ -167,6 +226,10 @@ public:
     void SetTreeFlag(uint16_t f, bool on=true);
 
     bool IsDisabled(uint16_t w) const { return (GetNode(w).fFlags & plSpaceTreeNode::kDisabled) || (fCache && !fCache->IsBitSet(w)); }
+    bool IsCacheDisabled(uint16_t w) const { return fCache && !fCache->IsBitSet(w); }
+
+    const plSpaceTreeHotNode& GetHotNode(int16_t w) const { return fHot[w]; }
+    void GetHotBounds(int16_t w, hsPoint3& mins, hsPoint3& maxs) const;
 
     // Should GetWorldBounds check and refresh if needed?
     const hsBounds3Ext& GetWorldBounds() const { return GetNode(GetRoot()).fWorldBounds; }
@@ -175,7 +238,23 @@ public:
     void Refresh();
     bool IsEmpty() const { return 0 != (GetNode(GetRoot()).fFlags & plSpaceTreeNode::kEmpty); }
     bool IsDirty() const { return 0 != (GetNode(GetRoot()).fFlags & plSpaceTreeNode::kDirty); }
-    void MakeDirty() { fTree[GetRoot()].fFlags |= plSpaceTreeNode::kDirty; }
+    void MakeDirty() { IMarkDirty(GetRoot()); }
+
+    // Ratio of the current interior/leaf surface area to what it was when the tree was built.
+    // Refitting around moving leaves pushes this up; past the rebuild threshold, Refresh
+    // rebuilds the tree. Leaf indices survive a rebuild, interior node indices don't, so
+    // anything caching node bits (see SetCache) should watch GetRebuildSerial().
+    float GetQuality() const;
+    uint32_t GetRebuildSerial() const { return fRebuildSerial; }
+
+    // Zero or less disables rebuilding.
+    static void SetRebuildThreshold(float t) { fRebuildThreshold = t; }
+    static float GetRebuildThreshold() { return fRebuildThreshold; }
+
+    // Culling against the hot nodes gives the same leaves as culling against the
+    // full bounds, just faster. Turning it off is for checking and timing that.
+    static void SetHotCulling(bool on) { fHotCulling = on; }
+    static bool GetHotCulling() { return fHotCulling; }
 
     int32_t GetNumLeaves() const { return fNumLeaves; }
 
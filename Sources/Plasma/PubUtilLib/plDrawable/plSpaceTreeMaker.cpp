@@ -550,6 +550,7 @@ plSpaceTree* plSpaceTreeMaker::IMakeEmptyTree()
     tree->fTree[0].fFlags = plSpaceTreeNode::kEmpty;
     tree->fRoot = 0;
     tree->fNumLeaves = 0;
+    tree->IBuildHot();
 
     Cleanup();
 
@@ -572,6 +573,8 @@ plSpaceTree* plSpaceTreeMaker::IMakeDegenerateTree()
     if( fDisabled.IsBitSet(0) )
         tree->SetLeafFlag(0, plSpaceTreeNode::kDisabled, true);
 
+    tree->IBuildHot();
+
     Cleanup();
 
     return tree;
@@ -616,6 +619,8 @@ plSpaceTree* plSpaceTreeMaker::IMakeSpaceTree()
             tree->SetLeafFlag(i, plSpaceTreeNode::kDisabled, true);
     }
 
+    tree->IBuildHot();
+
     StopTimer(kMakeSpaceTree);
 
     return tree;
@@ -1206,25 +1206,6 @@ void plWaveSet7::RemoveBuoy(const plKey& soKey)
 /////////////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////////////
 
-// This is very evil. I can't believe I'm doing this. Stop me, please.
-class plFilterMask
-{
-    protected:
-        int             fExt;
-        float        **fMask;
-
-    public:
-
-        plFilterMask( float sig );
-        virtual ~plFilterMask();
-
-        int     Begin() const { return -fExt; }
-        int     End() const { return fExt; }
-
-        float    Mask( int i, int j ) const { return fMask[ i ][ j ]; }
-};
-// End evil.
-
 void plWaveSet7::IInitState()
 {
     plConst(float) kWaterTable(-10.f);
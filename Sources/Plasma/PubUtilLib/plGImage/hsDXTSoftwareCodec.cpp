@@ -44,9 +44,14 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "hsColorRGBA.h"
 #include "hsDXTSoftwareCodec.h"
 #include "hsEndian.h"
+#include "hsThreadPool.h"
 #include "plMipmap.h"
 #include "hsCodecManager.h"
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 #define SWAPVARS( x, y, t ) { t = x; x = y; y = t; }
 
 // This is the color depth that we decompress to by default if we're not told otherwise
@@ -66,6 +71,23 @@ hsDXTSoftwareCodec::hsDXTSoftwareCodec()
 {
 }
 
+// CPU-optimized functions requiring dispatch
+hsCpuFunctionDispatcher<hsDXTSoftwareCodec::uncompress_level_ptr> hsDXTSoftwareCodec::uncompress_dxt1_to_32 {
+    &hsDXTSoftwareCodec::IUncompressMipmapDXT1To32FPU,
+    nullptr,                                                // SSE1
+    nullptr,                                                // SSE2
+    nullptr,                                                // SSE3
+    &hsDXTSoftwareCodec::IUncompressMipmapDXT1To32SSSE3
+};
+
+hsCpuFunctionDispatcher<hsDXTSoftwareCodec::uncompress_level_ptr> hsDXTSoftwareCodec::uncompress_dxt5_to_32 {
+    &hsDXTSoftwareCodec::IUncompressMipmapDXT5To32FPU,
+    nullptr,                                                // SSE1
+    nullptr,                                                // SSE2
+    nullptr,                                                // SSE3
+    &hsDXTSoftwareCodec::IUncompressMipmapDXT5To32SSSE3
+};
+
 hsDXTSoftwareCodec::~hsDXTSoftwareCodec()
 {
 }
@@ -76,6 +98,11 @@ hsDXTSoftwareCodec::~hsDXTSoftwareCodec()
 //  read it :)
 
 plMipmap *hsDXTSoftwareCodec::CreateCompressedMipmap( plMipmap *uncompressed )
+{
+    return CreateCompressedMipmap( uncompressed, kQualityFast );
+}
+
+plMipmap *hsDXTSoftwareCodec::CreateCompressedMipmap( plMipmap *uncompressed, Quality quality )
 {
     uint8_t           format;
     plMipmap        *compressed = nullptr;
@@ -100,17 +127,43 @@ plMipmap *hsDXTSoftwareCodec::CreateCompressedMipmap( plMipmap *uncompressed )
                                 uncompressed->GetNumLevels(), plMipmap::kDirectXCompression, format );
 
     {
-        /// Now loop through and compress each one (that is a valid size!)
+        /// Gather up the block rows of each level (that is a valid size!).
+        /// Blocks don't depend on one another, so we can hand all the rows of
+        /// all the levels to the thread pool at once.
+        struct BlockRow
+        {
+            const uint8_t   *fSrc;
+            uint8_t         *fDest;
+            uint32_t        fSrcRowBytes;
+            uint32_t        fNumBlocks;
+        };
+        std::vector<BlockRow>   rows;
+
+        const uint8_t compressionType = compressed->fDirectXInfo.fCompressionType;
+        const uint8_t blockSize = compressed->fDirectXInfo.fBlockSize;
         for( i = 0; i < compressed->GetNumLevels(); i++ )
         {
-            uncompressed->SetCurrLevel( i );
-            compressed->SetCurrLevel( i );
-            if( ( compressed->GetCurrWidth() | compressed->GetCurrHeight() ) & 0x03 )
+            uint32_t    width, height, srcRowBytes;
+            uint8_t     *src = uncompressed->GetLevelPtr( i, &width, &height, &srcRowBytes );
+            uint8_t     *dest = compressed->GetLevelPtr( i );
+            if( ( width | height ) & 0x03 )
                 break;
 
-            CompressMipmapLevel( uncompressed, compressed );
+            for( uint32_t y = 0; y < height; y += 4 )
+            {
+                uint32_t numBlocks = width >> 2;
+                rows.push_back( { src + y * srcRowBytes, dest + ( y >> 2 ) * numBlocks * blockSize, srcRowBytes, numBlocks } );
+            }
         }
 
+        hsThreadPool::Instance().ParallelFor( rows.size(), 1,
+            [this, &rows, compressionType, blockSize, quality]( size_t begin, size_t end )
+            {
+                for( size_t row = begin; row < end; row++ )
+                    ICompressBlockRow( rows[ row ].fSrc, rows[ row ].fSrcRowBytes, rows[ row ].fDest,
+                                       rows[ row ].fNumBlocks, compressionType, blockSize, quality );
+            } );
+
         /// Now copy the rest straight over
         for( ; i < compressed->GetNumLevels(); i++ )
             memcpy( compressed->GetLevelPtr( i ), uncompressed->GetLevelPtr( i ), uncompressed->GetLevelSize( i ) );
@@ -522,9 +575,9 @@ void    hsDXTSoftwareCodec::UncompressMipmap( plMipmap *destBMap, plMipmap *srcB
     {
         /// 32-bit ARGB - Can be either DXT5 or DXT1
         if( srcBMap->fDirectXInfo.fCompressionType == plMipmap::DirectXInfo::kDXT5 )
-            IUncompressMipmapDXT5To32( destBMap, srcBMap );
+            uncompress_dxt5_to_32.call( destBMap, srcBMap );
         else if( srcBMap->fDirectXInfo.fCompressionType == plMipmap::DirectXInfo::kDXT1 )
-            IUncompressMipmapDXT1To32( destBMap, srcBMap );
+            uncompress_dxt1_to_32.call( destBMap, srcBMap );
     }
     else if( destBMap->fUncompressedInfo.fType == plMipmap::UncompressedInfo::kRGB1555 )
     {
@@ -1926,294 +1979,518 @@ uint8_t   hsDXTSoftwareCodec::IMixEqualInten( uint8_t color1, uint8_t color2 )
 
 
 
-void hsDXTSoftwareCodec::CompressMipmapLevel( plMipmap *uncompressed, plMipmap *compressed )
+//// ICompressBlockRow ////////////////////////////////////////////////////////
+//  Compresses one row of 4x4 blocks. Only touches the pixels and blocks it is
+//  given, so separate rows (and levels) can be compressed concurrently.
+
+static inline const hsRGBAColor32 *IGetBlockPixel( const uint8_t *srcRow, uint32_t srcRowBytes, int32_t x, int32_t y )
 {
-    uint32_t *compressedImage = (uint32_t *)compressed->GetCurrLevelPtr();
-    int32_t x, y;
-    int32_t xMax = uncompressed->GetCurrWidth() >> 2;
-    int32_t yMax = uncompressed->GetCurrHeight() >> 2;
-    for (x = 0; x < xMax; ++x)
+    return (const hsRGBAColor32 *)( srcRow + y * srcRowBytes + ( x << 2 ) );
+}
+
+void hsDXTSoftwareCodec::ICompressBlockRow( const uint8_t *srcRow, uint32_t srcRowBytes, uint8_t *destRow,
+                                            uint32_t numBlocks, uint8_t compressionType, uint8_t blockSize,
+                                            Quality quality )
+{
+    int32_t x;
+    for (x = 0; x < (int32_t)numBlocks; ++x)
     {
-        for (y = 0; y < yMax; ++y)
+        uint8_t maxAlpha = 0;
+        uint8_t minAlpha = 255;
+        uint8_t oldMaxAlpha = 0;
+        uint8_t oldMinAlpha = 255;
+        uint8_t alpha[8];
+        int32_t maxDistance = 0;
+        hsRGBAColor32 color[4];
+        bool hasTransparency = false;
+
+        int32_t xx, yy;
+        for (xx = 0; xx < 4; ++xx)
         {
-            uint8_t maxAlpha = 0;
-            uint8_t minAlpha = 255;
-            uint8_t oldMaxAlpha = 0;
-            uint8_t oldMinAlpha = 255;
-            uint8_t alpha[8];
-            int32_t maxDistance = 0;
-            hsRGBAColor32 color[4];
-            bool hasTransparency = false;
-
-            int32_t xx, yy;
-            for (xx = 0; xx < 4; ++xx)
+            for (yy = 0; yy < 4; ++yy)
             {
-                for (yy = 0; yy < 4; ++yy)
+                const hsRGBAColor32* pixel = IGetBlockPixel(srcRow, srcRowBytes, 4 * x + xx, yy);
+                uint8_t pixelAlpha = pixel->a;
+                if (pixelAlpha != 255)
                 {
-                    hsRGBAColor32* pixel = (hsRGBAColor32*)uncompressed->GetAddr32(4 * x + xx, 4 * y + yy);
-                    uint8_t pixelAlpha = pixel->a;
-                    if (pixelAlpha != 255)
+                    hasTransparency = true;
+                }
+
+                if (compressionType == plMipmap::DirectXInfo::kDXT5)
+                {
+                    if (pixelAlpha > maxAlpha)
                     {
-                        hasTransparency = true;
+                        maxAlpha = pixelAlpha;
+                    }
+                    
+                    if ((pixelAlpha > oldMaxAlpha) && (pixelAlpha < 255))
+                    {
+                        oldMaxAlpha = pixelAlpha;
                     }
 
-                    if (compressed->fDirectXInfo.fCompressionType == plMipmap::DirectXInfo::kDXT5)
+                    if (pixelAlpha < minAlpha)
                     {
-                        if (pixelAlpha > maxAlpha)
-                        {
-                            maxAlpha = pixelAlpha;
-                        }
+                        minAlpha = pixelAlpha;
+                    }
+
+                    if ((pixelAlpha < oldMinAlpha) && (pixelAlpha > 0))
+                    {
+                        oldMinAlpha = minAlpha;
+                    }
+                }
+                
+                if (quality != kQualityFast)
+                    continue;
+
+                int32_t xx2, yy2;
+                for (xx2 = 0; xx2 < 4; ++xx2)
+                {
+                    for (yy2 = 0; yy2 < 4; ++yy2)
+                    {
+                        const hsRGBAColor32* pixel1 = IGetBlockPixel(srcRow, srcRowBytes, 4 * x + xx, yy);
+                        const hsRGBAColor32* pixel2 = IGetBlockPixel(srcRow, srcRowBytes, 4 * x + xx2, yy2);
                         
-                        if ((pixelAlpha > oldMaxAlpha) && (pixelAlpha < 255))
+                        int32_t distance = ColorDistanceARGBSquared(*pixel1, *pixel2);
+                        if (distance >= maxDistance)
                         {
-                            oldMaxAlpha = pixelAlpha;
+                            maxDistance = distance;
+                            color[0] = *pixel1;
+                            color[1] = *pixel2;
                         }
+                    } // for yy2
+                } // for xx2
+            } // for yy
+        } // for xx
+        
+        if (quality == kQualityHigh)
+        {
+            IFitColorEndpoints(srcRow, srcRowBytes, x,
+                               (compressionType == plMipmap::DirectXInfo::kDXT1) && hasTransparency,
+                               color);
+        }
 
-                        if (pixelAlpha < minAlpha)
-                        {
-                            minAlpha = pixelAlpha;
-                        }
+        if (oldMinAlpha == 255)
+        {
+            hsAssert(oldMaxAlpha == 0, "Weirdness in oldMaxAlpha hsDXTSoftwareCodec::CompressBitmap.");
+            oldMinAlpha = 0;
+            oldMaxAlpha = 255;
+        }
 
-                        if ((pixelAlpha < oldMinAlpha) && (pixelAlpha > 0))
-                        {
-                            oldMinAlpha = minAlpha;
-                        }
-                    }
-                    
-                    int32_t xx2, yy2;
-                    for (xx2 = 0; xx2 < 4; ++xx2)
-                    {
-                        for (yy2 = 0; yy2 < 4; ++yy2)
-                        {
-                            hsRGBAColor32* pixel1 = (hsRGBAColor32*)uncompressed->GetAddr32(4 * x + xx, 4 * y + yy);
-                            hsRGBAColor32* pixel2 = (hsRGBAColor32*)uncompressed->GetAddr32(4 * x + xx2, 4 * y + yy2);
-                            
-                            int32_t distance = ColorDistanceARGBSquared(*pixel1, *pixel2);
-                            if (distance >= maxDistance)
-                            {
-                                maxDistance = distance;
-                                color[0] = *pixel1;
-                                color[1] = *pixel2;
-                            }
-                        } // for yy2
-                    } // for xx2
-                } // for yy
-            } // for xx
-            
-            if (oldMinAlpha == 255)
+        if (compressionType == plMipmap::DirectXInfo::kDXT5)
+        {
+            if ((maxAlpha == 255) && (minAlpha == 0))
             {
-                hsAssert(oldMaxAlpha == 0, "Weirdness in oldMaxAlpha hsDXTSoftwareCodec::CompressBitmap.");
-                oldMinAlpha = 0;
-                oldMaxAlpha = 255;
+                hsAssert(oldMinAlpha <= oldMaxAlpha, "Min > Max in hsDXTSoftwareCodec::CompressBitmap 1.");
+                alpha[0] = oldMinAlpha;
+                alpha[1] = oldMaxAlpha;
+                alpha[2] = (4 * alpha[0] + alpha[1]) / 5;      // Bit code 010
+                alpha[3] = (3 * alpha[0] + 2 * alpha[1]) / 5;  // Bit code 011    
+                alpha[4] = (2 * alpha[0] + 3 * alpha[1]) / 5;  // Bit code 100    
+                alpha[5] = (alpha[0] + 4 * alpha[1]) / 5;      // Bit code 101
+                alpha[6] = 0;                                // Bit code 110
+                alpha[7] = 255;                              // Bit code 111
             }
-
-            if (compressed->fDirectXInfo.fCompressionType == plMipmap::DirectXInfo::kDXT5)
+            else if (maxAlpha == minAlpha)
             {
-                if ((maxAlpha == 255) && (minAlpha == 0))
-                {
-                    hsAssert(oldMinAlpha <= oldMaxAlpha, "Min > Max in hsDXTSoftwareCodec::CompressBitmap 1.");
-                    alpha[0] = oldMinAlpha;
-                    alpha[1] = oldMaxAlpha;
-                    alpha[2] = (4 * alpha[0] + alpha[1]) / 5;      // Bit code 010
-                    alpha[3] = (3 * alpha[0] + 2 * alpha[1]) / 5;  // Bit code 011    
-                    alpha[4] = (2 * alpha[0] + 3 * alpha[1]) / 5;  // Bit code 100    
-                    alpha[5] = (alpha[0] + 4 * alpha[1]) / 5;      // Bit code 101
-                    alpha[6] = 0;                                // Bit code 110
-                    alpha[7] = 255;                              // Bit code 111
-                }
-                else if (maxAlpha == minAlpha)
-                {
-                    alpha[0] = minAlpha;
-                    alpha[1] = maxAlpha;
-                    alpha[2] = (4 * alpha[0] + alpha[1]) / 5;      // Bit code 010
-                    alpha[3] = (3 * alpha[0] + 2 * alpha[1]) / 5;  // Bit code 011    
-                    alpha[4] = (2 * alpha[0] + 3 * alpha[1]) / 5;  // Bit code 100    
-                    alpha[5] = (alpha[0] + 4 * alpha[1]) / 5;      // Bit code 101
-                    alpha[6] = 0;                                // Bit code 110
-                    alpha[7] = 255;                              // Bit code 111
-                }
-                else
-                {
-                    hsAssert(minAlpha < maxAlpha, "Min => Max in hsDXTSoftwareCodec::CompressBitmap 3.");
-                    alpha[0] = maxAlpha;
-                    alpha[1] = minAlpha;
-                    alpha[2] = (6 * alpha[0] + alpha[1]) / 7;      // bit code 010
-                    alpha[3] = (5 * alpha[0] + 2 * alpha[1]) / 7;  // Bit code 011    
-                    alpha[4] = (4 * alpha[0] + 3 * alpha[1]) / 7;  // Bit code 100    
-                    alpha[5] = (3 * alpha[0] + 4 * alpha[1]) / 7;  // Bit code 101
-                    alpha[6] = (2 * alpha[0] + 5 * alpha[1]) / 7;  // Bit code 110    
-                    alpha[7] = (alpha[0] + 6 * alpha[1]) / 7;      // Bit code 111
-                }
+                alpha[0] = minAlpha;
+                alpha[1] = maxAlpha;
+                alpha[2] = (4 * alpha[0] + alpha[1]) / 5;      // Bit code 010
+                alpha[3] = (3 * alpha[0] + 2 * alpha[1]) / 5;  // Bit code 011    
+                alpha[4] = (2 * alpha[0] + 3 * alpha[1]) / 5;  // Bit code 100    
+                alpha[5] = (alpha[0] + 4 * alpha[1]) / 5;      // Bit code 101
+                alpha[6] = 0;                                // Bit code 110
+                alpha[7] = 255;                              // Bit code 111
             }
-            
-            uint32_t encoding;
-            uint16_t shortColor[2];
-            shortColor[0] = Color32To16(color[0]);
-            shortColor[1] = Color32To16(color[1]);
-            if ((shortColor[0] == shortColor[1]) ||
-                ((compressed->fDirectXInfo.fCompressionType == plMipmap::DirectXInfo::kDXT1) &&
-                hasTransparency))
+            else
             {
-                encoding = kThreeColorEncoding;
-
-                if (shortColor[0] > shortColor[1])
-                {
-                    uint16_t temp = shortColor[1];
-                    shortColor[1] = shortColor[0];
-                    shortColor[0] = temp;
-                    
-                    hsRGBAColor32 temp32 = color[1];
-                    color[1] = color[0];
-                    color[0] = temp32;
-                }
+                hsAssert(minAlpha < maxAlpha, "Min => Max in hsDXTSoftwareCodec::CompressBitmap 3.");
+                alpha[0] = maxAlpha;
+                alpha[1] = minAlpha;
+                alpha[2] = (6 * alpha[0] + alpha[1]) / 7;      // bit code 010
+                alpha[3] = (5 * alpha[0] + 2 * alpha[1]) / 7;  // Bit code 011    
+                alpha[4] = (4 * alpha[0] + 3 * alpha[1]) / 7;  // Bit code 100    
+                alpha[5] = (3 * alpha[0] + 4 * alpha[1]) / 7;  // Bit code 101
+                alpha[6] = (2 * alpha[0] + 5 * alpha[1]) / 7;  // Bit code 110    
+                alpha[7] = (alpha[0] + 6 * alpha[1]) / 7;      // Bit code 111
+            }
+        }
+        
+        uint32_t encoding;
+        uint16_t shortColor[2];
+        shortColor[0] = Color32To16(color[0]);
+        shortColor[1] = Color32To16(color[1]);
+        if ((shortColor[0] == shortColor[1]) ||
+            ((compressionType == plMipmap::DirectXInfo::kDXT1) &&
+            hasTransparency))
+        {
+            encoding = kThreeColorEncoding;
 
-                color[2] = BlendColors32(1, color[0], 1, color[1]);
+            if (shortColor[0] > shortColor[1])
+            {
+                uint16_t temp = shortColor[1];
+                shortColor[1] = shortColor[0];
+                shortColor[0] = temp;
+                
+                hsRGBAColor32 temp32 = color[1];
+                color[1] = color[0];
+                color[0] = temp32;
+            }
 
-                hsRGBAColor32 black;
-                black.Set(0, 0, 0, 0);
+            color[2] = BlendColors32(1, color[0], 1, color[1]);
 
-                color[3] = black;
-            }
-            else
-            {
-                encoding = kFourColorEncoding;
+            hsRGBAColor32 black;
+            black.Set(0, 0, 0, 0);
 
-                if (shortColor[0] < shortColor[1])
-                {
-                    uint16_t temp = shortColor[1];
-                    shortColor[1] = shortColor[0];
-                    shortColor[0] = temp;
-                    
-                    hsRGBAColor32 temp32 = color[1];
-                    color[1] = color[0];
-                    color[0] = temp32;
-                }
+            color[3] = black;
+        }
+        else
+        {
+            encoding = kFourColorEncoding;
 
-                color[2] = BlendColors32(2, color[0], 1, color[1]);
-                color[3] = BlendColors32(1, color[0], 2, color[1]);
-            }
-            
-            // Process each pixel in block
-            uint32_t blockSize = compressed->fDirectXInfo.fBlockSize;
-            uint32_t *block = &compressedImage[(x + xMax * y) * (blockSize >> 2)];
-            uint8_t *byteBlock = (uint8_t *)block;
-            uint8_t *alphaBlock = nullptr;
-            uint16_t *colorBlock = nullptr;
-            if (compressed->fDirectXInfo.fCompressionType == plMipmap::DirectXInfo::kDXT5)
-            {
-                alphaBlock = byteBlock;
-                colorBlock = (uint16_t *)(byteBlock + 8);
-                alphaBlock[0] = 0;
-                alphaBlock[1] = 0;
-                alphaBlock[2] = 0;
-                alphaBlock[3] = 0;
-                alphaBlock[4] = 0;
-                alphaBlock[5] = 0;
-                alphaBlock[6] = 0;
-                alphaBlock[7] = 0;
-            }
-            else if (compressed->fDirectXInfo.fCompressionType == plMipmap::DirectXInfo::kDXT1)
-            {
-                alphaBlock = nullptr;
-                colorBlock = (uint16_t *)(byteBlock);
-            }
-            else
+            if (shortColor[0] < shortColor[1])
             {
-                hsAssert(false, "Unrecognized compression scheme.");
+                uint16_t temp = shortColor[1];
+                shortColor[1] = shortColor[0];
+                shortColor[0] = temp;
+                
+                hsRGBAColor32 temp32 = color[1];
+                color[1] = color[0];
+                color[0] = temp32;
             }
-            
-            colorBlock[0] = 0;
-            colorBlock[1] = 0;
-            colorBlock[2] = 0;
-            colorBlock[3] = 0;
-            for (xx = 0; xx < 4; ++xx)
+
+            color[2] = BlendColors32(2, color[0], 1, color[1]);
+            color[3] = BlendColors32(1, color[0], 2, color[1]);
+        }
+        
+        // Process each pixel in block
+        uint8_t *byteBlock = &destRow[x * blockSize];
+        uint8_t *alphaBlock = nullptr;
+        uint16_t *colorBlock = nullptr;
+        if (compressionType == plMipmap::DirectXInfo::kDXT5)
+        {
+            alphaBlock = byteBlock;
+            colorBlock = (uint16_t *)(byteBlock + 8);
+            alphaBlock[0] = 0;
+            alphaBlock[1] = 0;
+            alphaBlock[2] = 0;
+            alphaBlock[3] = 0;
+            alphaBlock[4] = 0;
+            alphaBlock[5] = 0;
+            alphaBlock[6] = 0;
+            alphaBlock[7] = 0;
+        }
+        else if (compressionType == plMipmap::DirectXInfo::kDXT1)
+        {
+            alphaBlock = nullptr;
+            colorBlock = (uint16_t *)(byteBlock);
+        }
+        else
+        {
+            hsAssert(false, "Unrecognized compression scheme.");
+        }
+        
+        colorBlock[0] = 0;
+        colorBlock[1] = 0;
+        colorBlock[2] = 0;
+        colorBlock[3] = 0;
+        for (xx = 0; xx < 4; ++xx)
+        {
+            for (yy = 0; yy < 4; ++yy)
             {
-                for (yy = 0; yy < 4; ++yy)
+                const hsRGBAColor32* pixel = IGetBlockPixel(srcRow, srcRowBytes, 4 * x + xx, yy);
+                uint8_t pixelAlpha = pixel->a;
+                if (alphaBlock)
                 {
-                    hsRGBAColor32* pixel = (hsRGBAColor32*)uncompressed->GetAddr32(4 * x + xx, 4 * y + yy);
-                    uint8_t pixelAlpha = pixel->a;
-                    if (alphaBlock)
+                    uint32_t alphaIndex = 0;
+                    uint32_t alphaDistance = abs(pixelAlpha - alpha[0]);
+                    
+                    int32_t i;
+                    for (i = 1; i < 8; i++)
                     {
-                        uint32_t alphaIndex = 0;
-                        uint32_t alphaDistance = abs(pixelAlpha - alpha[0]);
-                        
-                        int32_t i;
-                        for (i = 1; i < 8; i++)
+                        uint32_t distance = abs(pixelAlpha - alpha[i]);
+                        if (distance < alphaDistance)
                         {
-                            uint32_t distance = abs(pixelAlpha - alpha[i]);
-                            if (distance < alphaDistance)
-                            {
-                                alphaIndex = i;
-                                alphaDistance = distance;
-                            }
-                        }
-                        
-                        if (yy < 2)
-                        {
-                            uint32_t alphaShift = 3 * (4 * yy + xx);
-                            uint32_t threeAlphaBytes = alphaIndex << alphaShift;
-                            alphaBlock[2] |= (threeAlphaBytes & 0xff);
-                            alphaBlock[3] |= ((threeAlphaBytes >> 8) & 0xff);
-                            alphaBlock[4] |= ((threeAlphaBytes >> 16) & 0xff);
-                        }
-                        else
-                        {
-                            uint32_t alphaShift = 3 * (4 * (yy - 2) + xx);
-                            uint32_t threeAlphaBytes = alphaIndex << alphaShift;
-                            alphaBlock[5] |= (threeAlphaBytes & 0xff);
-                            alphaBlock[6] |= ((threeAlphaBytes >> 8) & 0xff);
-                            alphaBlock[7] |= ((threeAlphaBytes >> 16) & 0xff);
+                            alphaIndex = i;
+                            alphaDistance = distance;
                         }
                     }
                     
-                    uint32_t colorIndex = 0;
-                    uint32_t colorDistance = ColorDistanceARGBSquared(*pixel, color[0]);
-                    
-                    if ((encoding == kThreeColorEncoding) &&
-                        (pixelAlpha == 0))
+                    if (yy < 2)
                     {
-                        colorIndex = 3;
+                        uint32_t alphaShift = 3 * (4 * yy + xx);
+                        uint32_t threeAlphaBytes = alphaIndex << alphaShift;
+                        alphaBlock[2] |= (threeAlphaBytes & 0xff);
+                        alphaBlock[3] |= ((threeAlphaBytes >> 8) & 0xff);
+                        alphaBlock[4] |= ((threeAlphaBytes >> 16) & 0xff);
                     }
                     else
                     {
-                        int32_t i;
-                        int32_t colorMax = (encoding == kThreeColorEncoding) ? 3 : 4;
-                        for (i = 1; i < colorMax; i++)
+                        uint32_t alphaShift = 3 * (4 * (yy - 2) + xx);
+                        uint32_t threeAlphaBytes = alphaIndex << alphaShift;
+                        alphaBlock[5] |= (threeAlphaBytes & 0xff);
+                        alphaBlock[6] |= ((threeAlphaBytes >> 8) & 0xff);
+                        alphaBlock[7] |= ((threeAlphaBytes >> 16) & 0xff);
+                    }
+                }
+                
+                uint32_t colorIndex = 0;
+                uint32_t colorDistance = ColorDistanceARGBSquared(*pixel, color[0]);
+                
+                if ((encoding == kThreeColorEncoding) &&
+                    (pixelAlpha == 0))
+                {
+                    colorIndex = 3;
+                }
+                else
+                {
+                    int32_t i;
+                    int32_t colorMax = (encoding == kThreeColorEncoding) ? 3 : 4;
+                    for (i = 1; i < colorMax; i++)
+                    {
+                        uint32_t distance = ColorDistanceARGBSquared(*pixel, color[i]);
+                        if (distance < colorDistance)
                         {
-                            uint32_t distance = ColorDistanceARGBSquared(*pixel, color[i]);
-                            if (distance < colorDistance)
-                            {
-                                colorIndex = i;
-                                colorDistance = distance;
-                            }
+                            colorIndex = i;
+                            colorDistance = distance;
                         }
                     }
+                }
 
-                    if (yy < 2)
-                    {
-                        uint32_t colorShift = 2 * (4 * yy + xx);
-                        uint16_t colorWord = (uint16_t)(colorIndex << colorShift);
-                        colorBlock[2] |= colorWord;
-                    }
-                    else
-                    {
-                        uint32_t colorShift = 2 * (4 * (yy - 2) + xx);
-                        uint16_t colorWord = (uint16_t)(colorIndex << colorShift);
-                        colorBlock[3] |= colorWord;
-                    }
-                } // for yy
-            } // for xx
-            
-            if (alphaBlock)
+                if (yy < 2)
+                {
+                    uint32_t colorShift = 2 * (4 * yy + xx);
+                    uint16_t colorWord = (uint16_t)(colorIndex << colorShift);
+                    colorBlock[2] |= colorWord;
+                }
+                else
+                {
+                    uint32_t colorShift = 2 * (4 * (yy - 2) + xx);
+                    uint16_t colorWord = (uint16_t)(colorIndex << colorShift);
+                    colorBlock[3] |= colorWord;
+                }
+            } // for yy
+        } // for xx
+        
+        if (alphaBlock)
+        {
+            alphaBlock[0] = alpha[0];
+            alphaBlock[1] = alpha[1];
+        }
+        
+        colorBlock[0] = shortColor[0];
+        colorBlock[1] = shortColor[1];
+    } // for x
+}
+
+//// IFitColorEndpoints ///////////////////////////////////////////////////////
+//  Fits the two color endpoints of a block for kQualityHigh. The initial
+//  endpoints are the extremes of the block's colors along their principal
+//  axis; they are then refined by least squares against the palette indices
+//  they produce, keeping a refinement only if it lowers the block's error once
+//  quantized to 565. The returned endpoints are already quantized, so the
+//  palette the compressor builds from them matches what the decoder sees.
+
+static inline uint8_t IQuantizeChannel( float value, uint32_t step )
+{
+    int32_t q = int32_t( value / step + 0.5f ) * int32_t( step );
+    return uint8_t( std::clamp( q, 0, int32_t( 256 - step ) ) );
+}
+
+static inline hsRGBAColor32 IQuantizeColor565( const float color[3] )
+{
+    hsRGBAColor32 result;
+    result.SetARGB( 255, IQuantizeChannel( color[0], 8 ), IQuantizeChannel( color[1], 4 ),
+                    IQuantizeChannel( color[2], 8 ) );
+    return result;
+}
+
+void hsDXTSoftwareCodec::IFitColorEndpoints( const uint8_t *srcRow, uint32_t srcRowBytes, int32_t blockX,
+                                             bool threeColor, hsRGBAColor32 endpoints[2] )
+{
+    // Fully transparent pixels of a three-color block always get index 3,
+    // so their colors don't take part in the fit
+    float pixels[16][3];
+    int32_t numPixels = 0;
+    for (int32_t yy = 0; yy < 4; ++yy)
+    {
+        for (int32_t xx = 0; xx < 4; ++xx)
+        {
+            const hsRGBAColor32* pixel = IGetBlockPixel(srcRow, srcRowBytes, 4 * blockX + xx, yy);
+            if (threeColor && pixel->a == 0)
+                continue;
+
+            pixels[numPixels][0] = pixel->r;
+            pixels[numPixels][1] = pixel->g;
+            pixels[numPixels][2] = pixel->b;
+            ++numPixels;
+        }
+    }
+
+    if (numPixels == 0)
+    {
+        endpoints[0].SetARGB(255, 0, 0, 0);
+        endpoints[1] = endpoints[0];
+        return;
+    }
+
+    float mean[3] = { 0.f, 0.f, 0.f };
+    for (int32_t i = 0; i < numPixels; ++i)
+    {
+        for (int32_t c = 0; c < 3; ++c)
+            mean[c] += pixels[i][c];
+    }
+    for (int32_t c = 0; c < 3; ++c)
+        mean[c] /= numPixels;
+
+    float cov[3][3] = {};
+    for (int32_t i = 0; i < numPixels; ++i)
+    {
+        float d[3] = { pixels[i][0] - mean[0], pixels[i][1] - mean[1], pixels[i][2] - mean[2] };
+        for (int32_t r = 0; r < 3; ++r)
+        {
+            for (int32_t c = 0; c < 3; ++c)
+                cov[r][c] += d[r] * d[c];
+        }
+    }
+
+    // Power iteration for the principal axis, starting from the covariance
+    // row of the channel with the widest spread
+    int32_t widest = 0;
+    if (cov[1][1] > cov[widest][widest])
+        widest = 1;
+    if (cov[2][2] > cov[widest][widest])
+        widest = 2;
+
+    float axis[3] = { cov[widest][0], cov[widest][1], cov[widest][2] };
+    for (int32_t iter = 0; iter < 8; ++iter)
+    {
+        float next[3];
+        for (int32_t r = 0; r < 3; ++r)
+            next[r] = cov[r][0] * axis[0] + cov[r][1] * axis[1] + cov[r][2] * axis[2];
+
+        float scale = std::max({ std::fabs(next[0]), std::fabs(next[1]), std::fabs(next[2]) });
+        if (scale == 0.f)
+            break;
+        for (int32_t c = 0; c < 3; ++c)
+            axis[c] = next[c] / scale;
+    }
+
+    float length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    float minT = 0.f, maxT = 0.f;
+    if (length > 0.f)
+    {
+        for (int32_t c = 0; c < 3; ++c)
+            axis[c] /= length;
+
+        minT = maxT = (pixels[0][0] - mean[0]) * axis[0] + (pixels[0][1] - mean[1]) * axis[1] +
+                      (pixels[0][2] - mean[2]) * axis[2];
+        for (int32_t i = 1; i < numPixels; ++i)
+        {
+            float t = (pixels[i][0] - mean[0]) * axis[0] + (pixels[i][1] - mean[1]) * axis[1] +
+                      (pixels[i][2] - mean[2]) * axis[2];
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+    }
+
+    float start[2][3];
+    for (int32_t c = 0; c < 3; ++c)
+    {
+        start[0][c] = mean[c] + axis[c] * maxT;
+        start[1][c] = mean[c] + axis[c] * minT;
+    }
+
+    // Share of endpoint 0 in each palette entry
+    static const float kFourColorWeights[4] = { 1.f, 0.f, 2.f / 3.f, 1.f / 3.f };
+    static const float kThreeColorWeights[3] = { 1.f, 0.f, 1.f / 2.f };
+    const float *weights = threeColor ? kThreeColorWeights : kFourColorWeights;
+    const int32_t numColors = threeColor ? 3 : 4;
+
+    // Picks each pixel's palette entry, returning the block's total error
+    uint8_t indices[16];
+    auto blockError = [&](const hsRGBAColor32 ends[2], uint8_t *outIndices) -> uint32_t
+    {
+        hsRGBAColor32 palette[4] = { ends[0], ends[1] };
+        if (threeColor)
+        {
+            palette[2] = BlendColors32(1, ends[0], 1, ends[1]);
+        }
+        else
+        {
+            palette[2] = BlendColors32(2, ends[0], 1, ends[1]);
+            palette[3] = BlendColors32(1, ends[0], 2, ends[1]);
+        }
+
+        uint32_t error = 0;
+        for (int32_t i = 0; i < numPixels; ++i)
+        {
+            hsRGBAColor32 pixel;
+            pixel.SetARGB(255, uint8_t(pixels[i][0]), uint8_t(pixels[i][1]), uint8_t(pixels[i][2]));
+
+            uint8_t bestIndex = 0;
+            uint32_t bestDistance = ColorDistanceARGBSquared(pixel, palette[0]);
+            for (int32_t j = 1; j < numColors; ++j)
             {
-                alphaBlock[0] = alpha[0];
-                alphaBlock[1] = alpha[1];
+                uint32_t distance = ColorDistanceARGBSquared(pixel, palette[j]);
+                if (distance < bestDistance)
+                {
+                    bestIndex = uint8_t(j);
+                    bestDistance = distance;
+                }
             }
-            
-            colorBlock[0] = shortColor[0];
-            colorBlock[1] = shortColor[1];
-        } // for y
-    } // for x
+            outIndices[i] = bestIndex;
+            error += bestDistance;
+        }
+        return error;
+    };
+
+    endpoints[0] = IQuantizeColor565(start[0]);
+    endpoints[1] = IQuantizeColor565(start[1]);
+    uint32_t bestError = blockError(endpoints, indices);
+
+    for (int32_t iter = 0; iter < 2 && bestError > 0; ++iter)
+    {
+        // Solve for the endpoints that best reproduce the pixels given the
+        // current palette indices
+        float aa = 0.f, ab = 0.f, bb = 0.f;
+        float ax[3] = { 0.f, 0.f, 0.f };
+        float bx[3] = { 0.f, 0.f, 0.f };
+        for (int32_t i = 0; i < numPixels; ++i)
+        {
+            float wa = weights[indices[i]];
+            float wb = 1.f - wa;
+            aa += wa * wa;
+            ab += wa * wb;
+            bb += wb * wb;
+            for (int32_t c = 0; c < 3; ++c)
+            {
+                ax[c] += wa * pixels[i][c];
+                bx[c] += wb * pixels[i][c];
+            }
+        }
+
+        float det = aa * bb - ab * ab;
+        if (std::fabs(det) < 1e-4f)
+            break;  // Every pixel uses the same entry, nothing to solve for
+
+        float refined[2][3];
+        for (int32_t c = 0; c < 3; ++c)
+        {
+            refined[0][c] = (ax[c] * bb - bx[c] * ab) / det;
+            refined[1][c] = (bx[c] * aa - ax[c] * ab) / det;
+        }
+
+        hsRGBAColor32 candidate[2] = { IQuantizeColor565(refined[0]), IQuantizeColor565(refined[1]) };
+        uint8_t candidateIndices[16];
+        uint32_t error = blockError(candidate, candidateIndices);
+        if (error >= bestError)
+            break;
+
+        endpoints[0] = candidate[0];
+        endpoints[1] = candidate[1];
+        bestError = error;
+        memcpy(indices, candidateIndices, sizeof(indices));
+    }
 }
 
 uint16_t hsDXTSoftwareCodec::BlendColors16(uint16_t weight1, uint16_t color1, uint16_t weight2, uint16_t color2)
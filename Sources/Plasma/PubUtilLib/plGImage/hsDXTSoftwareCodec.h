@@ -44,6 +44,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "HeadSpin.h"
 #include "hsCodec.h"
+#include "hsCpuID.h"
 
 class plMipmap;
 typedef struct hsColor32 hsRGBAColor32;
@@ -58,7 +59,18 @@ public:
 
     static void Init()  { fRegistered = Register(); }
 
+    // How hard the compressor works to fit each block's two color endpoints.
+    // kQualityFast picks the two most distant pixels of the block; kQualityHigh
+    // fits a line through the block's colors and refines the endpoints against
+    // the quantized 565 palette. Alpha endpoints are fitted the same way by both.
+    enum Quality
+    {
+        kQualityFast,
+        kQualityHigh
+    };
+
     plMipmap *CreateCompressedMipmap(plMipmap *uncompressed) override;
+    plMipmap *CreateCompressedMipmap(plMipmap *uncompressed, Quality quality);
 
     // Uncompresses the given source into a new destination mipmap
     plMipmap *CreateUncompressedMipmap(plMipmap *compressed, uint8_t flags = 0) override;
@@ -72,7 +84,13 @@ private:
         kThreeColorEncoding
     };
 
-    void    CompressMipmapLevel( plMipmap *uncompressed, plMipmap *compressed );
+    // Compresses one row of 4x4 blocks from an RGB8888 source level
+    void    ICompressBlockRow( const uint8_t *srcRow, uint32_t srcRowBytes, uint8_t *destRow,
+                               uint32_t numBlocks, uint8_t compressionType, uint8_t blockSize,
+                               Quality quality );
+    // Least-squares fit of a block's color endpoints, for kQualityHigh
+    void    IFitColorEndpoints( const uint8_t *srcRow, uint32_t srcRowBytes, int32_t blockX,
+                                bool threeColor, hsRGBAColor32 endpoints[2] );
 
     uint16_t BlendColors16(uint16_t weight1, uint16_t color1, uint16_t weight2, uint16_t color2);
     hsRGBAColor32 BlendColors32(uint32_t weight1, hsRGBAColor32 color1, uint32_t weight2, hsRGBAColor32 color2);
@@ -149,6 +167,23 @@ private:
 
     static bool Register();
     static bool fRegistered;
+
+protected:
+    //  CPU-optimized functions
+    typedef void(*uncompress_level_ptr)(plMipmap*, plMipmap*);
+    static hsCpuFunctionDispatcher<uncompress_level_ptr> uncompress_dxt1_to_32;
+    static hsCpuFunctionDispatcher<uncompress_level_ptr> uncompress_dxt5_to_32;
+
+    static void IUncompressMipmapDXT1To32FPU(plMipmap* destBMap, plMipmap* srcBMap)
+    {
+        Instance().IUncompressMipmapDXT1To32(destBMap, srcBMap);
+    }
+    static void IUncompressMipmapDXT5To32FPU(plMipmap* destBMap, plMipmap* srcBMap)
+    {
+        Instance().IUncompressMipmapDXT5To32(destBMap, srcBMap);
+    }
+    static void IUncompressMipmapDXT1To32SSSE3(plMipmap* destBMap, plMipmap* srcBMap);
+    static void IUncompressMipmapDXT5To32SSSE3(plMipmap* destBMap, plMipmap* srcBMap);
 };
 
 #endif // __HSDXTSOFTWARECODEC_H
@@ -0,0 +1,274 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "HeadSpin.h"
+#include "hsDXTSoftwareCodec.h"
+#include "hsSIMD.h"
+#include "plMipmap.h"
+
+#include <cstring>
+
+//// SSSE3 Block Decoders /////////////////////////////////////////////////////
+//  Each 4-pixel row of a DXT block is expanded with one pshufb against the
+//  block's palette, instead of looking up and storing each pixel by hand.
+//  Output is bit-identical to the FPU versions in hsDXTSoftwareCodec.cpp.
+//
+//  Note: these are only ever dispatched on x86, so we can skip the endian
+//  swapping the FPU versions do.
+
+#ifdef HAVE_SSSE3
+namespace
+{
+    // Shuffle masks that expand one byte of 2-bit color indices (one row of
+    // a block) into 4 ARGB pixels picked out of a 4-entry palette.
+    struct ColorRowMasks
+    {
+        alignas(16) uint8_t fMasks[256][16];
+
+        constexpr ColorRowMasks() : fMasks()
+        {
+            for (size_t row = 0; row < 256; ++row) {
+                for (size_t pix = 0; pix < 4; ++pix) {
+                    uint8_t idx = uint8_t((row >> (pix * 2)) & 0x03);
+                    for (size_t byte = 0; byte < 4; ++byte)
+                        fMasks[row][pix * 4 + byte] = uint8_t(idx * 4 + byte);
+                }
+            }
+        }
+    };
+    constexpr ColorRowMasks kColorRowMasks;
+
+    // Shuffle masks that move the 4 alpha indices of one row into the alpha
+    // byte of each pixel. The color bytes come out zeroed and must be set to
+    // 0x80 (see alphaHoles below) before shuffling against the alpha palette.
+    struct AlphaRowMasks
+    {
+        alignas(16) uint8_t fMasks[4][16];
+
+        constexpr AlphaRowMasks() : fMasks()
+        {
+            for (size_t row = 0; row < 4; ++row) {
+                for (size_t pix = 0; pix < 4; ++pix) {
+                    fMasks[row][pix * 4 + 0] = 0x80;
+                    fMasks[row][pix * 4 + 1] = 0x80;
+                    fMasks[row][pix * 4 + 2] = 0x80;
+                    fMasks[row][pix * 4 + 3] = uint8_t(row * 4 + pix);
+                }
+            }
+        }
+    };
+    constexpr AlphaRowMasks kAlphaRowMasks;
+
+    // Unpacks the 16 3-bit alpha indices of a DXT5 block into 16-bit lanes:
+    // each lane gets the two bytes holding its index, and is multiplied so the
+    // index ends up in the top 3 bits.
+    struct AlphaIndexUnpack
+    {
+        alignas(16) uint8_t  fShuffle[2][16];
+        alignas(16) uint16_t fScale[2][8];
+
+        constexpr AlphaIndexUnpack() : fShuffle(), fScale()
+        {
+            for (size_t pix = 0; pix < 16; ++pix) {
+                size_t bit = 16 + pix * 3;
+                size_t byte = bit >> 3;
+                fShuffle[pix >> 3][(pix & 7) * 2 + 0] = uint8_t(byte);
+                fShuffle[pix >> 3][(pix & 7) * 2 + 1] = (byte < 7) ? uint8_t(byte + 1) : 0x80;
+                fScale[pix >> 3][pix & 7] = uint16_t(1 << (13 - (bit & 7)));
+            }
+        }
+    };
+    constexpr AlphaIndexUnpack kAlphaIndexUnpack;
+
+    inline uint32_t IRGB565To888(uint16_t color)
+    {
+        return ((color & 0xf800) << 8) | ((color & 0x07e0) << 5) | ((color & 0x001f) << 3);
+    }
+
+    inline uint32_t IMixTwoThirds888(uint32_t twoThirds, uint32_t oneThird)
+    {
+        uint32_t r = ((twoThirds & 0x00ff0000) * 2 + (oneThird & 0x00ff0000)) / 3;
+        uint32_t g = ((twoThirds & 0x0000ff00) * 2 + (oneThird & 0x0000ff00)) / 3;
+        uint32_t b = ((twoThirds & 0x000000ff) * 2 + (oneThird & 0x000000ff)) / 3;
+        return (r & 0x00ff0000) + (g & 0x0000ff00) + (b & 0x000000ff);
+    }
+
+    inline uint32_t IMixEqual888(uint32_t color1, uint32_t color2)
+    {
+        uint32_t r = ((color1 & 0x00ff0000) + (color2 & 0x00ff0000)) >> 1;
+        uint32_t g = ((color1 & 0x0000ff00) + (color2 & 0x0000ff00)) >> 1;
+        uint32_t b = ((color1 & 0x000000ff) + (color2 & 0x000000ff)) >> 1;
+        return (r & 0x00ff0000) + (g & 0x0000ff00) + (b & 0x000000ff);
+    }
+
+    // Builds the 4-entry color palette of a DXT color block. DXT1 blocks may
+    // use three-color encoding and get opaque alpha, DXT5 alpha is zeroed.
+    inline __m128i IColorPalette(const uint8_t* colorBlock, bool isDXT1, uint32_t* bits)
+    {
+        uint16_t    c0, c1;
+        memcpy(&c0, colorBlock, sizeof(c0));
+        memcpy(&c1, colorBlock + 2, sizeof(c1));
+        memcpy(bits, colorBlock + 4, sizeof(*bits));
+
+        alignas(16) uint32_t colors[4];
+        colors[0] = IRGB565To888(c0);
+        colors[1] = IRGB565To888(c1);
+        if (!isDXT1 || c0 > c1) {
+            colors[2] = IMixTwoThirds888(colors[0], colors[1]);
+            colors[3] = IMixTwoThirds888(colors[1], colors[0]);
+        } else {
+            colors[2] = IMixEqual888(colors[0], colors[1]);
+            colors[3] = 0;
+        }
+
+        if (isDXT1) {
+            colors[0] |= 0xff000000;
+            colors[1] |= 0xff000000;
+            colors[2] |= 0xff000000;
+            if (c0 > c1)
+                colors[3] |= 0xff000000;
+        }
+        return _mm_load_si128(reinterpret_cast<const __m128i*>(colors));
+    }
+}
+#endif // HAVE_SSSE3
+
+void hsDXTSoftwareCodec::IUncompressMipmapDXT1To32SSSE3(plMipmap* destBMap, plMipmap* srcBMap)
+{
+#ifdef HAVE_SSSE3
+    hsAssert((srcBMap->GetCurrWidth() & 3) == 0, "Bitmap width must be multiple of 4");
+    hsAssert((srcBMap->GetCurrHeight() & 3) == 0, "Bitmap height must be multiple of 4");
+
+    const uint8_t* srcData = static_cast<const uint8_t*>(srcBMap->GetCurrLevelPtr());
+    const uint32_t blockSize = srcBMap->fDirectXInfo.fBlockSize;
+    const size_t bMapStride = destBMap->GetAddr32(0, 1) - destBMap->GetAddr32(0, 0);
+
+    for (uint32_t y = 0; y < srcBMap->GetCurrHeight(); y += 4) {
+        for (uint32_t x = 0; x < srcBMap->GetCurrWidth(); x += 4) {
+            uint32_t bits;
+            const __m128i palette = IColorPalette(srcData, true, &bits);
+
+            uint32_t* destData = destBMap->GetAddr32(x, y);
+            for (size_t row = 0; row < 4; ++row) {
+                __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i*>(kColorRowMasks.fMasks[bits & 0xff]));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(destData), _mm_shuffle_epi8(palette, mask));
+                bits >>= 8;
+                destData += bMapStride;
+            }
+
+            srcData += blockSize;
+        }
+    }
+#endif
+}
+
+void hsDXTSoftwareCodec::IUncompressMipmapDXT5To32SSSE3(plMipmap* destBMap, plMipmap* srcBMap)
+{
+#ifdef HAVE_SSSE3
+    hsAssert((srcBMap->GetCurrWidth() & 3) == 0, "Bitmap width must be multiple of 4");
+    hsAssert((srcBMap->GetCurrHeight() & 3) == 0, "Bitmap height must be multiple of 4");
+
+    const uint8_t* srcData = static_cast<const uint8_t*>(srcBMap->GetCurrLevelPtr());
+    const uint32_t blockSize = srcBMap->fDirectXInfo.fBlockSize;
+    const size_t bMapStride = destBMap->GetAddr32(0, 1) - destBMap->GetAddr32(0, 0);
+
+    for (uint32_t y = 0; y < srcBMap->GetCurrHeight(); y += 4) {
+        for (uint32_t x = 0; x < srcBMap->GetCurrWidth(); x += 4) {
+            /// Alpha palette--same fixed point trickery as the FPU version,
+            /// so we round identically.
+            uint32_t alphas[8];
+            alphas[0] = uint32_t(srcData[0]) << 24;
+            alphas[1] = uint32_t(srcData[1]) << 24;
+            if (alphas[0] > alphas[1]) {
+                uint32_t aTemp = alphas[0];
+                uint32_t a0 = (alphas[0] / 7) & 0xff000000;
+                uint32_t a1 = (alphas[1] / 7) & 0xff000000;
+                for (size_t j = 2; j < 8; ++j) {
+                    aTemp += a1 - a0;
+                    alphas[j] = aTemp;
+                }
+            } else {
+                uint32_t aTemp = alphas[0];
+                uint32_t a0 = (alphas[1] - aTemp) / 5;
+                for (size_t j = 2; j < 6; ++j) {
+                    aTemp += a0;
+                    alphas[j] = aTemp & 0xff000000;
+                }
+                alphas[6] = 0;
+                alphas[7] = 0xff000000;
+            }
+
+            alignas(16) uint8_t alphaPal[16] = {};
+            for (size_t j = 0; j < 8; ++j)
+                alphaPal[j] = uint8_t(alphas[j] >> 24);
+
+            /// Unpack the 16 3-bit alpha indices, one per byte
+            const __m128i alphaBlock = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(srcData));
+            __m128i lo = _mm_shuffle_epi8(alphaBlock, _mm_load_si128(reinterpret_cast<const __m128i*>(kAlphaIndexUnpack.fShuffle[0])));
+            __m128i hi = _mm_shuffle_epi8(alphaBlock, _mm_load_si128(reinterpret_cast<const __m128i*>(kAlphaIndexUnpack.fShuffle[1])));
+            lo = _mm_srli_epi16(_mm_mullo_epi16(lo, _mm_load_si128(reinterpret_cast<const __m128i*>(kAlphaIndexUnpack.fScale[0]))), 13);
+            hi = _mm_srli_epi16(_mm_mullo_epi16(hi, _mm_load_si128(reinterpret_cast<const __m128i*>(kAlphaIndexUnpack.fScale[1]))), 13);
+
+            const __m128i alphaHoles = _mm_set1_epi32(0x00808080);
+            const __m128i alphaPalette = _mm_load_si128(reinterpret_cast<const __m128i*>(alphaPal));
+            const __m128i alphaIndices = _mm_packus_epi16(lo, hi);
+
+            uint32_t bits;
+            const __m128i palette = IColorPalette(srcData + 8, false, &bits);
+
+            uint32_t* destData = destBMap->GetAddr32(x, y);
+            for (size_t row = 0; row < 4; ++row) {
+                __m128i cMask = _mm_load_si128(reinterpret_cast<const __m128i*>(kColorRowMasks.fMasks[bits & 0xff]));
+                __m128i aMask = _mm_load_si128(reinterpret_cast<const __m128i*>(kAlphaRowMasks.fMasks[row]));
+                aMask = _mm_or_si128(_mm_shuffle_epi8(alphaIndices, aMask), alphaHoles);
+                __m128i pixels = _mm_or_si128(_mm_shuffle_epi8(palette, cMask),
+                                              _mm_shuffle_epi8(alphaPalette, aMask));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(destData), pixels);
+                bits >>= 8;
+                destData += bMapStride;
+            }
+
+            srcData += blockSize;
+        }
+    }
+#endif
+}
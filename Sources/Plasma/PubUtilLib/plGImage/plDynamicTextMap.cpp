@@ -54,6 +54,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "HeadSpin.h"
 #include "plDynamicTextMap.h"
 
+#include <algorithm>
 #include <string_theory/format>
 
 #include "hsStream.h"
@@ -79,7 +80,8 @@ plProfile_Extern(MemMipmaps);
 plDynamicTextMap::plDynamicTextMap()
     : fVisWidth(0), fVisHeight(0), fHasAlpha(false), fPremultipliedAlpha(false), fJustify(kLeftJustify),
       fInitBuffer(), fFontSize(), fFontFlags(), fShadowed(), fLineSpacing(),
-      fCurrFont(), fFontAntiAliasRGB(), fFontBlockRGB(), fHasCreateBeenCalled()
+      fCurrFont(), fFontAntiAliasRGB(), fFontBlockRGB(), fHasCreateBeenCalled(),
+      fDirtyLeft(), fDirtyTop(), fDirtyRight(), fDirtyBottom()
 {
     fFontColor.Set(0, 0, 0, 1);
 }
@@ -90,7 +92,7 @@ plDynamicTextMap::~plDynamicTextMap()
 }
 
 plDynamicTextMap::plDynamicTextMap( uint32_t width, uint32_t height, bool hasAlpha, uint32_t extraWidth, uint32_t extraHeight, bool premultipliedAlpha )
-    : fInitBuffer(nullptr)
+    : fInitBuffer(nullptr), fDirtyLeft(), fDirtyTop(), fDirtyRight(), fDirtyBottom()
 {
     Create( width, height, hasAlpha, extraWidth, extraHeight, premultipliedAlpha );
 }
@@ -377,6 +379,8 @@ void    plDynamicTextMap::IClearFromBuffer( uint32_t *clearBuffer )
         data += fWidth;
         srcData += fVisWidth;
     }
+
+    AddDirtyRect( 0, 0, fWidth, fHeight );
 }
 
 //// IPropagateFlags //////////////////////////////////////////////////////////
@@ -403,6 +407,8 @@ void    plDynamicTextMap::ClearToColor( hsColorRGBA &color )
     // Buffer is of size fVisWidth x fVisHeight, so we need a bit of work to do this right
     for( i = 0; i < fHeight * fWidth; i++ )
         data[ i ] = hex;
+
+    AddDirtyRect( 0, 0, fWidth, fHeight );
 }
 
 //// SetJustify ///////////////////////////////////////////////////////////////
@@ -498,6 +504,7 @@ void    plDynamicTextMap::DrawString( uint16_t x, uint16_t y, const wchar_t *tex
     fCurrFont->SetRenderFlag( plFont::kRenderWrap | plFont::kRenderClip, false );
 	fCurrFont->SetRenderClipRect( 0, 0, fVisWidth, fVisHeight );
     fCurrFont->RenderString( this, x, y, text );
+    IAddFontDirtyRect();
 }
 
 //// DrawClippedString ////////////////////////////////////////////////////////
@@ -516,6 +523,7 @@ void    plDynamicTextMap::DrawClippedString( int16_t x, int16_t y, const wchar_t
     IPropagateFlags();
     fCurrFont->SetRenderClipping( x, y, width, height );
     fCurrFont->RenderString( this, x, y, text );
+    IAddFontDirtyRect();
 }
 
 //// DrawClippedString ////////////////////////////////////////////////////////
@@ -534,6 +542,7 @@ void    plDynamicTextMap::DrawClippedString( int16_t x, int16_t y, const wchar_t
     IPropagateFlags();
     fCurrFont->SetRenderClipping( clipX, clipY, width, height );
     fCurrFont->RenderString( this, x, y, text );
+    IAddFontDirtyRect();
 }
 
 //// DrawWrappedString ////////////////////////////////////////////////////////
@@ -552,6 +561,7 @@ void    plDynamicTextMap::DrawWrappedString( uint16_t x, uint16_t y, const wchar
     IPropagateFlags();
     fCurrFont->SetRenderWrapping( x, y, width, height );
     fCurrFont->RenderString( this, x, y, text, lastX, lastY );
+    IAddFontDirtyRect();
 }
 
 //// CalcStringWidth //////////////////////////////////////////////////////////
@@ -641,6 +651,7 @@ void    plDynamicTextMap::FillRect( uint16_t x, uint16_t y, uint16_t width, uint
 
     // Gee, how hard can it REALLY be?
     uint32_t i, hex = fPremultipliedAlpha ? color.ToARGB32Premultiplied() : color.ToARGB32();
+    uint16_t fillTop = y;
     height += y;
     if( height > fHeight )
         height = (uint16_t)fHeight;
@@ -650,6 +661,8 @@ void    plDynamicTextMap::FillRect( uint16_t x, uint16_t y, uint16_t width, uint
         for( i = 0; i < width; i++ )
             destPtr[ i ] = hex;
     }
+
+    AddDirtyRect( x, fillTop, width, height - fillTop );
 }
 
 //// FrameRect ////////////////////////////////////////////////////////////////
@@ -678,6 +691,8 @@ void    plDynamicTextMap::FrameRect( uint16_t x, uint16_t y, uint16_t width, uin
         dest1[ 0 ] = dest1[ width - 1 ] = hex;
         dest1 += fWidth;
     }
+
+    AddDirtyRect( x, y, width, height );
 }
 
 //// DrawImage ////////////////////////////////////////////////////////////////
@@ -704,6 +719,7 @@ void    plDynamicTextMap::DrawImage( uint16_t x, uint16_t y, plMipmap *image, Dr
         opts.fFlags |= plMipmap::kDestPremultiplied;
 
     Composite( image, x, y, &opts );
+    AddDirtyRect( x, y, image->GetWidth(), image->GetHeight() );
 
     /// HACK for now, since the alpha in the mipmap gets copied straight into the
     /// 32-bit color buffer, but our separate hacked alpha buffer hasn't been updated
@@ -749,6 +765,8 @@ void    plDynamicTextMap::DrawClippedImage( uint16_t x, uint16_t y, plMipmap *im
     opts.fSrcClipWidth = srcClipWidth;
     opts.fSrcClipHeight = srcClipHeight;
     Composite( image, x, y, &opts );
+    AddDirtyRect( x, y, srcClipWidth > 0 ? srcClipWidth : image->GetWidth(),
+                        srcClipHeight > 0 ? srcClipHeight : image->GetHeight() );
 
     /// HACK for now, since the alpha in the mipmap gets copied straight into the
     /// 32-bit color buffer, but our separate hacked alpha buffer hasn't been updated
@@ -771,9 +789,55 @@ void    plDynamicTextMap::FlushToHost()
     if( !IIsValid() )
         return;
 
-    // Dirty the mipmap's deviceRef, if there is one
+    // Dirty the mipmap's deviceRef, if there is one. If we know what we drew
+    // into, only that part needs to go back up to the card
     if (GetDeviceRef() != nullptr)
-        GetDeviceRef()->SetDirty( true );
+    {
+        bool partial = fDirtyLeft < fDirtyRight && fDirtyTop < fDirtyBottom &&
+                       ( fDirtyRight - fDirtyLeft < fWidth || fDirtyBottom - fDirtyTop < fHeight );
+        if( partial )
+            GetDeviceRef()->AddDirtyRegion( fDirtyLeft, fDirtyTop, fDirtyRight, fDirtyBottom );
+        else
+            GetDeviceRef()->SetDirty( true );
+    }
+
+    fDirtyLeft = fDirtyTop = fDirtyRight = fDirtyBottom = 0;
+}
+
+//// AddDirtyRect /////////////////////////////////////////////////////////////
+
+void    plDynamicTextMap::AddDirtyRect( int32_t x, int32_t y, int32_t width, int32_t height )
+{
+    int32_t left = std::max( x, 0 );
+    int32_t top = std::max( y, 0 );
+    int32_t right = std::min( x + width, (int32_t)fWidth );
+    int32_t bottom = std::min( y + height, (int32_t)fHeight );
+    if( left >= right || top >= bottom )
+        return;
+
+    if( fDirtyLeft >= fDirtyRight || fDirtyTop >= fDirtyBottom )
+    {
+        fDirtyLeft = (uint16_t)left;
+        fDirtyTop = (uint16_t)top;
+        fDirtyRight = (uint16_t)right;
+        fDirtyBottom = (uint16_t)bottom;
+    }
+    else
+    {
+        fDirtyLeft = (uint16_t)std::min( left, (int32_t)fDirtyLeft );
+        fDirtyTop = (uint16_t)std::min( top, (int32_t)fDirtyTop );
+        fDirtyRight = (uint16_t)std::max( right, (int32_t)fDirtyRight );
+        fDirtyBottom = (uint16_t)std::max( bottom, (int32_t)fDirtyBottom );
+    }
+}
+
+//// IAddFontDirtyRect ////////////////////////////////////////////////////////
+//  Dirties whatever the font just rendered into us
+
+void    plDynamicTextMap::IAddFontDirtyRect()
+{
+    pcSmallRect rect = fCurrFont->GetLastRenderRect();
+    AddDirtyRect( rect.fX, rect.fY, rect.fWidth, rect.fHeight );
 }
 
 //// GetLayerTransform ////////////////////////////////////////////////////////
@@ -904,5 +968,9 @@ void    plDynamicTextMap::Swap( plDynamicTextMap *other )
     SWAP_ME( bool, fFontBlockRGB, other->fFontBlockRGB );
 
     SWAP_ME( plFont *, fCurrFont, other->fCurrFont );
+
+    // Both device refs got fully dirtied above, so drop what we'd tracked
+    fDirtyLeft = fDirtyTop = fDirtyRight = fDirtyBottom = 0;
+    other->fDirtyLeft = other->fDirtyTop = other->fDirtyRight = other->fDirtyBottom = 0;
     SWAP_ME( uint32_t *, fInitBuffer, other->fInitBuffer );
 }
@@ -184,6 +184,11 @@ class plDynamicTextMap : public plMipmap
 
         void    FlushToHost();
 
+        // Marks part of the surface as changed for the next FlushToHost(). The
+        // drawing functions above do this themselves; only needed if you write
+        // into the image directly (e.g. with Composite()).
+        void    AddDirtyRect( int32_t x, int32_t y, int32_t width, int32_t height );
+
         bool    MsgReceive(plMessage *msg) override;
 
         uint32_t  GetVisibleWidth() const { return fVisWidth; }
@@ -238,6 +243,11 @@ class plDynamicTextMap : public plMipmap
         uint32_t      *fInitBuffer;
         
         bool        fHasCreateBeenCalled;
+
+        // Area drawn into since the last FlushToHost(), [left, right) x [top, bottom)
+        uint16_t    fDirtyLeft, fDirtyTop, fDirtyRight, fDirtyBottom;
+
+        void        IAddFontDirtyRect();
 };
 
 
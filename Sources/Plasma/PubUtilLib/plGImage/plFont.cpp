@@ -63,6 +63,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "HeadSpin.h"
+#include <algorithm>
+#include <cstring>
 #include <string>
 
 #include "plFont.h"
@@ -138,8 +140,20 @@ void    plFont::IClear( bool onConstruct )
     fRenderInfo.fMipmap = nullptr;
     fRenderInfo.fRenderFunc = nullptr;
     fRenderInfo.fVolatileStringPtr = nullptr;
+    fRenderInfo.fTouchedLeft = fRenderInfo.fTouchedTop = 0;
+    fRenderInfo.fTouchedRight = fRenderInfo.fTouchedBottom = 0;
     fRenderInfo.fFirstLineIndent = 0;
     fRenderInfo.fLineSpacing = 0;
+
+    fBlendTableColor = 0;
+    fBlendTableMode = kBlendTableNone;
+    IClearExtentsCache();
+}
+
+void    plFont::IClearExtentsCache()
+{
+    fExtentsCache.clear();
+    fExtentsLRU.clear();
 }
 
 void    plFont::Read( hsStream *s, hsResMgr *mgr )
@@ -200,6 +214,9 @@ void    plFont::ICalcFontAscent()
         if( fMaxCharHeight < fCharacters[ i ].fHeight )
             fMaxCharHeight = fCharacters[ i ].fHeight;
     }
+
+    // New glyph metrics, so anything we measured before is stale
+    IClearExtentsCache();
 }
 
 //// IIsWordBreaker //////////////////////////////////////////////////////////
@@ -238,6 +255,9 @@ void    plFont::RenderString( plMipmap *mip, uint16_t x, uint16_t y, const wchar
         return;
     }
 
+    fRenderInfo.fTouchedLeft = fRenderInfo.fTouchedTop = 0;
+    fRenderInfo.fTouchedRight = fRenderInfo.fTouchedBottom = 0;
+
     IRenderString( mip, x, y, string, false );
     if (lastX != nullptr)
         *lastX = fRenderInfo.fLastX;
@@ -245,6 +265,13 @@ void    plFont::RenderString( plMipmap *mip, uint16_t x, uint16_t y, const wchar
         *lastY = fRenderInfo.fLastY;
 }
 
+pcSmallRect plFont::GetLastRenderRect() const
+{
+    return pcSmallRect( fRenderInfo.fTouchedLeft, fRenderInfo.fTouchedTop,
+                        fRenderInfo.fTouchedRight - fRenderInfo.fTouchedLeft,
+                        fRenderInfo.fTouchedBottom - fRenderInfo.fTouchedTop );
+}
+
 const plFont::plCharacter& plFont::IGetCharacter(wchar_t c) const
 {
     if (c - fFirstChar < fCharacters.size()) {
@@ -345,17 +372,13 @@ void    plFont::IRenderString( plMipmap *mip, uint16_t x, uint16_t y, const wcha
         {
             if( fRenderInfo.fFlags & kRenderIntoAlpha )
             {
-                if( fRenderInfo.fFlags & kRenderAlphaPremultiplied )
+                if( ( fRenderInfo.fFlags & kRenderAlphaPremultiplied ) && ( fRenderInfo.fFlags & kRenderShadow ) )
+                    fRenderInfo.fRenderFunc = &plFont::IRenderChar8To32AlphaPremShadow;
+                else
                 {
-                    if (fRenderInfo.fFlags & kRenderShadow)
-                        fRenderInfo.fRenderFunc = &plFont::IRenderChar8To32AlphaPremShadow;
-                    else
-                        fRenderInfo.fRenderFunc = &plFont::IRenderChar8To32AlphaPremultiplied;
+                    IBuildBlendTable();
+                    fRenderInfo.fRenderFunc = &plFont::IRenderChar8To32Blended;
                 }
-                else if( ( fRenderInfo.fColor & 0xff000000 ) != 0xff000000 )
-                    fRenderInfo.fRenderFunc = &plFont::IRenderChar8To32Alpha;
-                else
-                    fRenderInfo.fRenderFunc = &plFont::IRenderChar8To32FullAlpha;
             }
             else
                 fRenderInfo.fRenderFunc = &plFont::IRenderChar8To32;
@@ -722,6 +745,8 @@ void    plFont::IRenderLoop( const wchar_t *string, int32_t maxCount )
                     thisWidth >>= 1;
 
                 (this->*(fRenderInfo.fRenderFunc))( fCharacters[ c ] );
+                if( fRenderInfo.fRenderFunc != &plFont::IRenderCharNull )
+                    IAddTouchedChar( fCharacters[ c ] );
 
                 fRenderInfo.fX += thisWidth;
                 fRenderInfo.fMaxWidth -= thisWidth;
@@ -747,6 +772,33 @@ void    plFont::IRenderLoop( const wchar_t *string, int32_t maxCount )
     }
 }
 
+//// IAddTouchedChar //////////////////////////////////////////////////////////
+//  Grows the touched bounds by the cell of a character rendered at the
+//  current position. Shadows reach 2 pixels past the glyph bitmap and faux
+//  italics shift rows right by up to half the glyph height.
+
+void    plFont::IAddTouchedChar( const plCharacter &c )
+{
+    int16_t left = fRenderInfo.fX - 2;
+    int16_t top = (int16_t)( fRenderInfo.fY - c.fBaseline - 2 );
+    int16_t right = (int16_t)( fRenderInfo.fX + fWidth + ( c.fHeight >> 1 ) + 2 );
+    int16_t bottom = (int16_t)( fRenderInfo.fY - c.fBaseline + c.fHeight + 2 );
+
+    if( fRenderInfo.fTouchedLeft >= fRenderInfo.fTouchedRight )
+    {
+        fRenderInfo.fTouchedLeft = left;
+        fRenderInfo.fTouchedTop = top;
+        fRenderInfo.fTouchedRight = right;
+        fRenderInfo.fTouchedBottom = bottom;
+        return;
+    }
+
+    fRenderInfo.fTouchedLeft = std::min( fRenderInfo.fTouchedLeft, left );
+    fRenderInfo.fTouchedTop = std::min( fRenderInfo.fTouchedTop, top );
+    fRenderInfo.fTouchedRight = std::max( fRenderInfo.fTouchedRight, right );
+    fRenderInfo.fTouchedBottom = std::max( fRenderInfo.fTouchedBottom, bottom );
+}
+
 //// The Rendering Functions //////////////////////////////////////////////////
 
 void    plFont::IRenderChar1To32( const plFont::plCharacter &c )
@@ -922,123 +974,42 @@ void    plFont::IRenderChar8To32( const plFont::plCharacter &c )
     }
 }
 
-void    plFont::IRenderChar8To32FullAlpha( const plFont::plCharacter &c )
-{
-    uint8_t   *src = fBMapData + c.fBitmapOff;
-    uint32_t  *destPtr, *destBasePtr = (uint32_t *)(fRenderInfo.fDestPtr - c.fBaseline * int32_t(fRenderInfo.fDestStride));
-    int16_t   x, y, thisHeight, xstart, thisWidth;
-    uint32_t  destColorOnly;
-
-
-    // Unfortunately for some fonts, their right kern value actually is
-    // farther left than the right edge of the bitmap (think of overlapping
-    // script fonts). Ideally, we should store the actual width of each char's
-    // bitmap and use that here. However, it really shouldn't make too big of a
-    // difference, especially since the dest pixels that we end up overlapping
-    // should already be in the cache. If it does, time to upgrade the font
-    // format (again)
-    thisWidth = fWidth;// + (int32_t)c.fRightKern;
-    if( thisWidth >= fRenderInfo.fMaxWidth )
-        thisWidth = fRenderInfo.fMaxWidth;
-
-    xstart = fRenderInfo.fClipRect.fX - fRenderInfo.fX;
-    if( xstart < 0 )
-        xstart = 0;
-
-    destColorOnly = fRenderInfo.fColor & 0x00ffffff;
-
-    y = fRenderInfo.fClipRect.fY - fRenderInfo.fY + (int16_t)c.fBaseline;
-    if( y < 0 )
-        y = 0;
-    else
-    {
-        destBasePtr = (uint32_t *)( (uint8_t *)destBasePtr + y*fRenderInfo.fDestStride );
-        src += y*fRenderInfo.fNumCols;
-    }
-
-    thisHeight = fRenderInfo.fMaxHeight + (int16_t)c.fBaseline;
-    if( thisHeight > (int16_t)c.fHeight )
-        thisHeight = (int16_t)c.fHeight;
+//// IBlendSpan ///////////////////////////////////////////////////////////////
+//  Writes one glyph row through a pre-blended table. Most of a glyph's cell
+//  is empty, so uncovered pixels are skipped eight at a time.
 
-    for( ; y < thisHeight; y++ )
-    {
-        destPtr = destBasePtr;
-        for( x = xstart; x < thisWidth; x++ )
-        {
-            if( src[ x ] != 0 )
-                destPtr[ x ] = ( src[ x ] << 24 ) | destColorOnly;
-        }
-        destBasePtr = (uint32_t *)( (uint8_t *)destBasePtr + fRenderInfo.fDestStride );
-        src += fWidth;
-    }
-}
-
-void    plFont::IRenderChar8To32Alpha( const plFont::plCharacter &c )
+static inline void  IBlendSpan( uint32_t *destPtr, const uint8_t *src, int16_t x, int16_t end, const uint32_t *table )
 {
-    uint8_t   val, *src = fBMapData + c.fBitmapOff;
-    uint32_t  *destPtr, *destBasePtr = (uint32_t *)(fRenderInfo.fDestPtr - c.fBaseline * int32_t(fRenderInfo.fDestStride));
-    int16_t   x, y, thisHeight, xstart, thisWidth;
-    uint32_t  destColorOnly, alphaMult, fullAlpha;
-
-
-    // Unfortunately for some fonts, their right kern value actually is
-    // farther left than the right edge of the bitmap (think of overlapping
-    // script fonts). Ideally, we should store the actual width of each char's
-    // bitmap and use that here. However, it really shouldn't make too big of a
-    // difference, especially since the dest pixels that we end up overlapping
-    // should already be in the cache. If it does, time to upgrade the font
-    // format (again)
-    thisWidth = fWidth;// + (int32_t)c.fRightKern;
-    if( thisWidth >= fRenderInfo.fMaxWidth )
-        thisWidth = fRenderInfo.fMaxWidth;
-
-    xstart = fRenderInfo.fClipRect.fX - fRenderInfo.fX;
-    if( xstart < 0 )
-        xstart = 0;
-
-    destColorOnly = fRenderInfo.fColor & 0x00ffffff;
-    // alphaMult should come out to be a value to satisfy (fontAlpha * alphaMult >> 8) as the right alpha,
-    // but then we want it so (fontAlpha * alphaMult) will be in the upper 8 bits
-    fullAlpha = fRenderInfo.fColor & 0xff000000;
-    alphaMult = fullAlpha / 255;
-
-    y = fRenderInfo.fClipRect.fY - fRenderInfo.fY + (int16_t)c.fBaseline;
-    if( y < 0 )
-        y = 0;
-    else
-    {
-        destBasePtr = (uint32_t *)( (uint8_t *)destBasePtr + y*fRenderInfo.fDestStride );
-        src += y*fRenderInfo.fNumCols;
-    }
-
-    thisHeight = fRenderInfo.fMaxHeight + (int16_t)c.fBaseline;
-    if( thisHeight > (int16_t)c.fHeight )
-        thisHeight = (int16_t)c.fHeight;
-
-    for( ; y < thisHeight; y++ )
+    while( x < end )
     {
-        destPtr = destBasePtr;
-        for( x = xstart; x < thisWidth; x++ )
+        if( end - x >= 8 )
         {
-            val = src[ x ];
-            if( val == 0xff )
-                destPtr[ x ] = fullAlpha | destColorOnly;
-            else if( val != 0 )
+            uint64_t coverage;
+            memcpy( &coverage, src + x, sizeof( coverage ) );
+            if( coverage != 0 )
             {
-                destPtr[ x ] = ( ( alphaMult * val ) & 0xff000000 ) | destColorOnly;
+                for( int16_t i = x; i < x + 8; i++ )
+                {
+                    if( src[ i ] != 0 )
+                        destPtr[ i ] = table[ src[ i ] ];
+                }
             }
+            x += 8;
+        }
+        else
+        {
+            if( src[ x ] != 0 )
+                destPtr[ x ] = table[ src[ x ] ];
+            x++;
         }
-        destBasePtr = (uint32_t *)( (uint8_t *)destBasePtr + fRenderInfo.fDestStride );
-        src += fWidth;
     }
 }
 
-void    plFont::IRenderChar8To32AlphaPremultiplied( const plFont::plCharacter &c )
+void    plFont::IRenderChar8To32Blended( const plFont::plCharacter &c )
 {
     uint8_t   *src = fBMapData + c.fBitmapOff;
-    uint32_t  *destPtr, *destBasePtr = (uint32_t *)(fRenderInfo.fDestPtr - c.fBaseline * int32_t(fRenderInfo.fDestStride));
-    int16_t   x, y, thisHeight, xstart, thisWidth;
-    uint8_t   srcA, srcR, srcG, srcB;
+    uint32_t  *destBasePtr = (uint32_t *)(fRenderInfo.fDestPtr - c.fBaseline * int32_t(fRenderInfo.fDestStride));
+    int16_t   y, thisHeight, xstart, thisWidth;
 
 
     // Unfortunately for some fonts, their right kern value actually is
@@ -1056,11 +1027,6 @@ void    plFont::IRenderChar8To32AlphaPremultiplied( const plFont::plCharacter &c
     if( xstart < 0 )
         xstart = 0;
 
-    srcA = (uint8_t)(( fRenderInfo.fColor >> 24 ) & 0x000000ff);
-    srcR = (uint8_t)(( fRenderInfo.fColor >> 16 ) & 0x000000ff);
-    srcG = (uint8_t)(( fRenderInfo.fColor >> 8  ) & 0x000000ff);
-    srcB = (uint8_t)(( fRenderInfo.fColor       ) & 0x000000ff);
-
     y = fRenderInfo.fClipRect.fY - fRenderInfo.fY + (int16_t)c.fBaseline;
     if( y < 0 )
         y = 0;
@@ -1076,17 +1042,7 @@ void    plFont::IRenderChar8To32AlphaPremultiplied( const plFont::plCharacter &c
 
     for( ; y < thisHeight; y++ )
     {
-        destPtr = destBasePtr;
-        for( x = xstart; x < thisWidth; x++ )
-        {
-            uint32_t a = src[ x ];
-            if (a != 0)
-            {
-                if (srcA != 0xff)
-                    a = (srcA*a + 127)/255;
-                destPtr[ x ] = ( a << 24 ) | (((srcR*a + 127)/255) << 16) | (((srcG*a + 127)/255) << 8) | ((srcB*a + 127)/255);
-            }
-        }
+        IBlendSpan( destBasePtr, src, xstart, thisWidth, fBlendTable );
         destBasePtr = (uint32_t *)( (uint8_t *)destBasePtr + fRenderInfo.fDestStride );
         src += fWidth;
     }
@@ -1177,6 +1133,66 @@ void    plFont::IRenderCharNull( const plCharacter &c )
 {
 }
 
+//// IBuildBlendTable /////////////////////////////////////////////////////////
+//  Fills fBlendTable for IRenderChar8To32Blended() with the exact pixel the
+//  old per-pixel alpha, full alpha and premultiplied paths would have written
+//  for each coverage value.
+
+void    plFont::IBuildBlendTable()
+{
+    uint32_t mode;
+    if( fRenderInfo.fFlags & kRenderAlphaPremultiplied )
+        mode = kBlendTablePremultiplied;
+    else if( ( fRenderInfo.fColor & 0xff000000 ) != 0xff000000 )
+        mode = kBlendTableAlpha;
+    else
+        mode = kBlendTableFullAlpha;
+
+    if( mode == fBlendTableMode && fRenderInfo.fColor == fBlendTableColor )
+        return;
+
+    fBlendTableMode = mode;
+    fBlendTableColor = fRenderInfo.fColor;
+    fBlendTable[ 0 ] = 0;   // Never written, coverage 0 is skipped
+
+    uint32_t destColorOnly = fRenderInfo.fColor & 0x00ffffff;
+    uint32_t srcA = ( fRenderInfo.fColor >> 24 ) & 0x000000ff;
+    uint32_t srcR = ( fRenderInfo.fColor >> 16 ) & 0x000000ff;
+    uint32_t srcG = ( fRenderInfo.fColor >> 8  ) & 0x000000ff;
+    uint32_t srcB = ( fRenderInfo.fColor       ) & 0x000000ff;
+
+    // alphaMult should come out to be a value to satisfy (fontAlpha * alphaMult >> 8) as the right alpha,
+    // but then we want it so (fontAlpha * alphaMult) will be in the upper 8 bits
+    uint32_t fullAlpha = fRenderInfo.fColor & 0xff000000;
+    uint32_t alphaMult = fullAlpha / 255;
+
+    for( uint32_t val = 1; val < 256; val++ )
+    {
+        switch( mode )
+        {
+            case kBlendTableAlpha:
+                if( val == 0xff )
+                    fBlendTable[ val ] = fullAlpha | destColorOnly;
+                else
+                    fBlendTable[ val ] = ( ( alphaMult * val ) & 0xff000000 ) | destColorOnly;
+                break;
+
+            case kBlendTableFullAlpha:
+                fBlendTable[ val ] = ( val << 24 ) | destColorOnly;
+                break;
+
+            case kBlendTablePremultiplied:
+                {
+                    uint32_t a = val;
+                    if( srcA != 0xff )
+                        a = ( srcA * a + 127 ) / 255;
+                    fBlendTable[ val ] = ( a << 24 ) | ( ( ( srcR * a + 127 ) / 255 ) << 16 ) | ( ( ( srcG * a + 127 ) / 255 ) << 8 ) | ( ( srcB * a + 127 ) / 255 );
+                }
+                break;
+        }
+    }
+}
+
 //// CalcString Variations ////////////////////////////////////////////////////
 
 uint16_t  plFont::CalcStringWidth( const ST::string &string )
@@ -1204,18 +1220,80 @@ void    plFont::CalcStringExtents( const ST::string &string, uint16_t &width, ui
     CalcStringExtents(string.to_wchar().data(), width, height, ascent, firstClippedChar, lastX, lastY);
 }
 
+// Upper bound on fExtentsCache before we start evicting
+static constexpr size_t kMaxCachedExtents = 256;
+
+size_t plFont::plExtentsKeyHash::operator()(const plExtentsKey &key) const
+{
+    size_t hash = std::hash<std::wstring_view>()(key.fString);
+    auto combine = [&hash](size_t value)
+    {
+        hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    };
+
+    const plExtentsLayout &layout = key.fLayout;
+    combine(layout.fFlags);
+    combine((uint16_t(layout.fClipX) << 16) | uint16_t(layout.fClipY));
+    combine((uint16_t(layout.fClipWidth) << 16) | uint16_t(layout.fClipHeight));
+    combine((uint16_t(layout.fFirstLineIndent) << 16) | uint16_t(layout.fLineSpacing));
+    return hash;
+}
+
 void    plFont::CalcStringExtents( const wchar_t *string, uint16_t &width, uint16_t &height, uint16_t &ascent, uint32_t &firstClippedChar, uint16_t &lastX, uint16_t &lastY )
 {
-    IRenderString(nullptr, 0, 0, string, true);
-    width = fRenderInfo.fFarthestX;
-    height = (uint16_t)(fRenderInfo.fY + fFontDescent);//fRenderInfo.fMaxDescent;
-    ascent = fRenderInfo.fMaxAscent;
-    lastX = fRenderInfo.fLastX;
-    lastY = fRenderInfo.fLastY;
-
-    // firstClippedChar is an index into the given string that points to the start of the part of the string
-    // that got clipped (i.e. not rendered).
-    firstClippedChar = fRenderInfo.fVolatileStringPtr - string;
+    // Text boxes and chat re-measure the same strings on every redraw, so
+    // remember what we found for each string and layout
+    plExtentsKey key;
+    key.fString = string;
+    key.fLayout.fFlags = fRenderInfo.fFlags;
+    key.fLayout.fClipX = fRenderInfo.fClipRect.fX;
+    key.fLayout.fClipY = fRenderInfo.fClipRect.fY;
+    key.fLayout.fClipWidth = fRenderInfo.fClipRect.fWidth;
+    key.fLayout.fClipHeight = fRenderInfo.fClipRect.fHeight;
+    key.fLayout.fFirstLineIndent = fRenderInfo.fFirstLineIndent;
+    key.fLayout.fLineSpacing = fRenderInfo.fLineSpacing;
+
+    auto cached = fExtentsCache.find(key);
+    if (cached != fExtentsCache.end())
+    {
+        // Move to the front of the line
+        fExtentsLRU.splice(fExtentsLRU.begin(), fExtentsLRU, cached->second);
+    }
+    else
+    {
+        IRenderString(nullptr, 0, 0, string, true);
+
+        plStringExtents extents;
+        extents.fWidth = fRenderInfo.fFarthestX;
+        extents.fHeight = (uint16_t)(fRenderInfo.fY + fFontDescent);//fRenderInfo.fMaxDescent;
+        extents.fAscent = fRenderInfo.fMaxAscent;
+        extents.fLastX = fRenderInfo.fLastX;
+        extents.fLastY = fRenderInfo.fLastY;
+
+        // firstClippedChar is an index into the given string that points to the start of the part of the string
+        // that got clipped (i.e. not rendered).
+        extents.fFirstClippedChar = fRenderInfo.fVolatileStringPtr - string;
+
+        if (fExtentsCache.size() >= kMaxCachedExtents)
+        {
+            const plExtentsEntry &oldest = fExtentsLRU.back();
+            fExtentsCache.erase(plExtentsKey{ oldest.fString, oldest.fLayout });
+            fExtentsLRU.pop_back();
+        }
+
+        // Only now do we need our own copy of the string for the key to view
+        fExtentsLRU.push_front(plExtentsEntry{ std::wstring(key.fString), key.fLayout, extents });
+        key.fString = fExtentsLRU.front().fString;
+        cached = fExtentsCache.emplace(key, fExtentsLRU.begin()).first;
+    }
+
+    const plStringExtents &extents = cached->second->fExtents;
+    width = extents.fWidth;
+    height = extents.fHeight;
+    ascent = extents.fAscent;
+    lastX = extents.fLastX;
+    lastY = extents.fLastY;
+    firstClippedChar = extents.fFirstClippedChar;
 }
 
 //// IGetFreeCharData /////////////////////////////////////////////////////////
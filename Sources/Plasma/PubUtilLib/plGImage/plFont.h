@@ -66,6 +66,10 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "hsColorRGBA.h"
 #include "pcSmallRect.h"
 
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "pnKeyedObject/hsKeyedObject.h"
@@ -202,12 +206,83 @@ class plFont : public hsKeyedObject
 
                 const wchar_t   *fVolatileStringPtr;    // Just so we know where we clipped
 
+                // Bounds of every character cell touched by the last RenderString(),
+                // padded for shadows and italics
+                int16_t       fTouchedLeft, fTouchedTop, fTouchedRight, fTouchedBottom;
+
                 CharRenderFunc  fRenderFunc;
         };
 
         plRenderInfo    fRenderInfo;
 
+        // Pre-blended output pixels for every 8-bit glyph coverage value, for
+        // the render functions that overwrite the destination instead of
+        // blending with it. Rebuilt only when the render color or mode changes
+        enum BlendTableMode
+        {
+            kBlendTableNone,
+            kBlendTableAlpha,
+            kBlendTableFullAlpha,
+            kBlendTablePremultiplied
+        };
+        uint32_t        fBlendTable[ 256 ];
+        uint32_t        fBlendTableColor;
+        uint32_t        fBlendTableMode;
+
+        // Cached CalcStringExtents() results, keyed on the string and the
+        // render state that affects its layout, so UI that flips between
+        // settings keeps its entries. The least recently used entry goes
+        // first when the cache is full; everything goes when the font changes
+        class plStringExtents
+        {
+            public:
+                uint16_t  fWidth, fHeight, fAscent, fLastX, fLastY;
+                uint32_t  fFirstClippedChar;
+        };
+        class plExtentsLayout
+        {
+            public:
+                uint32_t  fFlags;
+                int16_t   fClipX, fClipY, fClipWidth, fClipHeight;
+                int16_t   fFirstLineIndent, fLineSpacing;
+
+                bool operator==(const plExtentsLayout &other) const
+                {
+                    return fFlags == other.fFlags &&
+                           fClipX == other.fClipX && fClipY == other.fClipY &&
+                           fClipWidth == other.fClipWidth && fClipHeight == other.fClipHeight &&
+                           fFirstLineIndent == other.fFirstLineIndent && fLineSpacing == other.fLineSpacing;
+                }
+        };
+        class plExtentsEntry
+        {
+            public:
+                std::wstring        fString;
+                plExtentsLayout     fLayout;
+                plStringExtents     fExtents;
+        };
+        // Views either the string in an entry, or the caller's for a lookup
+        class plExtentsKey
+        {
+            public:
+                std::wstring_view   fString;
+                plExtentsLayout     fLayout;
+
+                bool operator==(const plExtentsKey &other) const
+                {
+                    return fString == other.fString && fLayout == other.fLayout;
+                }
+        };
+        struct plExtentsKeyHash
+        {
+            size_t operator()(const plExtentsKey &key) const;
+        };
+        typedef std::list<plExtentsEntry> plExtentsList;
+        plExtentsList   fExtentsLRU;    // Most recently used first
+        std::unordered_map<plExtentsKey, plExtentsList::iterator, plExtentsKeyHash> fExtentsCache;
+
         void    IClear( bool onConstruct = false );
+        void    IClearExtentsCache();
         void    ICalcFontAscent();
 
         uint8_t   *IGetFreeCharData( uint32_t &newOffset );
@@ -220,11 +295,12 @@ class plFont : public hsKeyedObject
         void    IRenderChar1To32( const plCharacter &c );
         void    IRenderChar1To32AA( const plCharacter &c );
         void    IRenderChar8To32( const plCharacter &c );
-        void    IRenderChar8To32Alpha( const plCharacter &c );
-        void    IRenderChar8To32FullAlpha( const plCharacter &c );
-        void    IRenderChar8To32AlphaPremultiplied( const plCharacter &c );
+        void    IRenderChar8To32Blended( const plCharacter &c );
         void    IRenderChar8To32AlphaPremShadow( const plCharacter &c );
         void    IRenderCharNull( const plCharacter &c );
+        void    IAddTouchedChar( const plCharacter &c );
+
+        void    IBuildBlendTable();
 
         uint32_t IGetCharPixel( const plCharacter &c, int32_t x, int32_t y )
         {
@@ -278,6 +354,11 @@ class plFont : public hsKeyedObject
         void    RenderString(plMipmap *mip, uint16_t x, uint16_t y, const ST::string &string, uint16_t *lastX = nullptr, uint16_t *lastY = nullptr);
         void    RenderString(plMipmap *mip, uint16_t x, uint16_t y, const wchar_t *string, uint16_t *lastX = nullptr, uint16_t *lastY = nullptr);
 
+        // Conservative rect of the pixels the last RenderString() may have written,
+        // so callers can dirty just that part of the destination. Not clipped to
+        // the destination mipmap.
+        pcSmallRect GetLastRenderRect() const;
+
         uint16_t  CalcStringWidth( const ST::string &string );
         uint16_t  CalcStringWidth( const wchar_t *string );
         void    CalcStringExtents( const ST::string &string, uint16_t &width, uint16_t &height, uint16_t &ascent, uint16_t &lastX, uint16_t &lastY );
@@ -62,8 +62,11 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plProfile.h"
 #include "plJPEG.h"
 #include "plPNG.h"
+#include "hsThreadPool.h"
 #include <cmath>
 #include <algorithm>
+#include <functional>
+#include <vector>
 #include <string_theory/format>
 
 plProfile_CreateMemCounter("Mipmaps", "Memory", MemMipmaps);
@@ -871,18 +874,20 @@ namespace {
 class plFilterMask
 {
     protected:
-        int             fExt;
-        float        **fMask;
+        int                 fExt;
+        std::vector<float>  fMask;
 
     public:
 
         plFilterMask( float sig );
-        virtual ~plFilterMask();
 
         int     Begin() const { return -fExt; }
         int     End() const { return fExt; }
 
-        float    Mask( int i, int j ) const { return fMask[ i ][ j ]; }
+        float    Mask( int i, int j ) const { return fMask[ ( i + fExt ) * ( ( fExt << 1 ) + 1 ) + j + fExt ]; }
+
+        // Row-major, ( 2 * End() + 1 ) squared taps, for the row filters
+        const float *Data() const { return fMask.data(); }
 };
 
 plFilterMask::plFilterMask( float sig )
@@ -891,28 +896,138 @@ plFilterMask::plFilterMask( float sig )
     if( fExt < 1 )
         fExt = 1;
 
-    float **m = new float *[ ( fExt << 1 ) + 1 ];
-    m += fExt;
     int i, j;
     float ooSigSq = 1.f / ( sig * sig );
 
+    fMask.reserve( ( ( fExt << 1 ) + 1 ) * ( ( fExt << 1 ) + 1 ) );
     for( i = -fExt; i <= fExt; i++ )
     {
-        m[ i ] = ( new float[ ( fExt << 1 ) + 1] ) + fExt;
         for( j = -fExt; j <= fExt; j++ )
         {
-            m[ i ][ j ] = expf( -( i*i + j*j ) * ooSigSq );
+            fMask.push_back( expf( -( i*i + j*j ) * ooSigSq ) );
         }
     }
-    fMask = m;
 }
 
-plFilterMask::~plFilterMask()
+//// IFilterRowFPU ////////////////////////////////////////////////////////////
+//  Runs the filter mask over one row of destination pixels. Destination pixel
+//  j is centered on source pixel ( j << srcShift, srcY ). Taps that fall off
+//  the source are skipped (and don't count towards the weight).
+
+void plMipmap::IFilterRowFPU( const float *mask, int32_t ext, const uint8_t *src, int32_t srcRowBytes,
+                              int32_t srcWidth, int32_t srcHeight, int32_t srcY, int32_t srcShift,
+                              uint8_t *dst, int32_t dstWidth )
 {
-    int i;
-    for( i = -fExt; i <= fExt; i++ )
-        delete [] ( fMask[ i ] - fExt );
-    delete [] ( fMask - fExt );
+    const int32_t maskWidth = ( ext << 1 ) + 1;
+    const int32_t iiBegin = std::max( -ext, -srcY );
+    const int32_t iiEnd = std::min( ext, srcHeight - 1 - srcY );
+
+    int32_t j, ii, jj;
+    for( j = 0; j < dstWidth; j++ )
+    {
+        const int32_t srcX = j << srcShift;
+        const int32_t jjBegin = std::max( -ext, -srcX );
+        const int32_t jjEnd = std::min( ext, srcWidth - 1 - srcX );
+        const uint8_t *center = src + srcY * srcRowBytes + ( srcX << 2 );
+
+        int32_t chan;
+        for( chan = 0; chan < 4; chan++ )
+        {
+            float w = 0;
+            float a = 0;
+
+            for( ii = iiBegin; ii <= iiEnd; ii++ )
+            {
+                const float *maskRow = mask + ( ii + ext ) * maskWidth + ext;
+                for( jj = jjBegin; jj <= jjEnd; jj++ )
+                {
+                    w += maskRow[ jj ];
+                    a += ( float( center[ ii * srcRowBytes + ( jj << 2 ) + chan ] ) + 0.5f ) * maskRow[ jj ];
+                }
+            }
+            a /= w;
+
+            dst[ ( j << 2 ) + chan ] = (uint8_t)a;
+        }
+    }
+}
+
+// CPU-optimized functions requiring dispatch
+hsCpuFunctionDispatcher<plMipmap::filter_row_ptr> plMipmap::filter_row {
+    &plMipmap::IFilterRowFPU,
+    nullptr,                        // SSE1
+    &plMipmap::IFilterRowSSE2
+};
+
+//// IBlendRowFPU /////////////////////////////////////////////////////////////
+//  Blends a row of source pixels onto the dest with the source alpha scaled
+//  by the opacity and the source color by the tint. The dest alpha is kept,
+//  unless writeAlpha is set.
+
+void plMipmap::IBlendRowFPU( uint32_t *dst, const uint32_t *src, uint32_t width, uint32_t opacity,
+                             const float *tint, bool writeAlpha )
+{
+    uint32_t  r, g, b, dR, dG, dB, srcAlpha, oneMinusAlpha, destAlpha;
+
+    for( uint32_t pX = 0; pX < width; pX++ )
+    {
+        // Wacko trick here. Alphas are 0-255, which means scaling by alpha would
+        // be a v' = v * alpha / 255 operation sequence. However, since we hate
+        // dividing by 255 all the time, we actually scale the alpha just ever so
+        // slightly so it's 0-256, which makes the divide a simple shift. Note
+        // that this will result in some tiny bit of aliasing, but it shouldn't be
+        // enough to notice
+
+        if (!(src[pX] >> 24)) // Zero alpha. Skip this pixel
+            continue;
+
+        srcAlpha = opacity * ( ( src[ pX ] >> 16 ) & 0x0000ff00 ) / 255 / 256;
+        oneMinusAlpha = 256 - srcAlpha;
+        destAlpha = dst[ pX ] & 0xff000000;
+
+        r = (uint32_t)((( src[ pX ] >> 16 ) & 0x000000ff) * tint[ 0 ]);
+        g = (uint32_t)((( src[ pX ] >> 8  ) & 0x000000ff) * tint[ 1 ]);
+        b = (uint32_t)((( src[ pX ]       ) & 0x000000ff) * tint[ 2 ]);
+        dR = ( dst[ pX ] >> 16 ) & 0x000000ff;
+        dG = ( dst[ pX ] >> 8  ) & 0x000000ff;
+        dB = ( dst[ pX ]       ) & 0x000000ff;
+        r = ( r * srcAlpha ) >> 8;
+        g = ( g * srcAlpha ) >> 8;
+        b = ( b * srcAlpha ) >> 8;
+        dR = ( dR * oneMinusAlpha ) >> 8;
+        dG = ( dG * oneMinusAlpha ) >> 8;
+        dB = ( dB * oneMinusAlpha ) >> 8;
+
+        // Dest alpha for now is just our original dest alpha
+        dst[ pX ] = ( ( r + dR ) << 16 ) | ( ( g + dG ) << 8 ) | ( b + dB ) | destAlpha;
+
+        // Unless our blend option is set of course
+        if( writeAlpha )
+            dst[ pX ] = ( dst[ pX ] & 0x00ffffff ) | ( srcAlpha << 24 );
+    }
+}
+
+hsCpuFunctionDispatcher<plMipmap::blend_row_ptr> plMipmap::blend_row {
+    &plMipmap::IBlendRowFPU,
+    nullptr,                        // SSE1
+    &plMipmap::IBlendRowSSE2
+};
+
+//// IForEachFilterRow ////////////////////////////////////////////////////////
+//  Filtered rows don't depend on each other, so big images get their rows
+//  spread across the thread pool. Small ones just run here.
+
+static void IForEachFilterRow( uint32_t height, uint32_t width, const std::function<void(uint32_t)> &filterRow )
+{
+    constexpr size_t kMinPixelsPerJob = 16384;
+
+    const size_t grainSize = std::max<size_t>( 1, kMinPixelsPerJob / std::max<uint32_t>( width, 1 ) );
+    hsThreadPool::Instance().ParallelFor( height, grainSize,
+        [&filterRow]( size_t begin, size_t end )
+        {
+            for( size_t row = begin; row < end; row++ )
+                filterRow( uint32_t( row ) );
+        } );
 }
 
 
@@ -1088,49 +1203,25 @@ void    plMipmap::ICreateLevelNoDetail( uint8_t iDst, const plFilterMask& mask )
     hsAssert(fPixelSize == 32, "Only 32 bit implemented");
     ASSERT_UNCOMPRESSED();
 
-    int32_t i, j, ii, jj;
-
     if( 32 == fPixelSize )
     {
         SetCurrLevel(iDst);
 
-        uint8_t *src = (uint8_t *)GetLevelPtr( iDst-1 );
+        const uint8_t *src = (uint8_t *)GetLevelPtr( iDst-1 );
         uint8_t *dst = (uint8_t *)GetLevelPtr(iDst);
 
-        int32_t srcRowBytes = fCurrLevelRowBytes << 1;
-        int32_t srcHeight = fCurrLevelHeight << 1;
-        int32_t srcWidth = fCurrLevelWidth << 1;
+        const int32_t srcRowBytes = fCurrLevelRowBytes << 1;
+        const int32_t srcHeight = fCurrLevelHeight << 1;
+        const int32_t srcWidth = fCurrLevelWidth << 1;
+        const int32_t dstRowBytes = fCurrLevelRowBytes;
+        const int32_t dstWidth = fCurrLevelWidth;
 
-        for( i = 0; i < fCurrLevelHeight; i++ )
-        {
-            for( j = 0; j < fCurrLevelWidth; j++ )
+        IForEachFilterRow( fCurrLevelHeight, fCurrLevelWidth,
+            [&]( uint32_t i )
             {
-                uint8_t *center = src + (i << 1) * srcRowBytes + (j << 3);
-
-                int32_t chan;
-                for( chan = 0; chan < 4; chan++ )
-                {
-                    float w = 0;
-                    float a = 0;
-
-                    for( ii = mask.Begin(); ii <= mask.End(); ii++ )
-                    {
-                        for( jj = mask.Begin(); jj <= mask.End(); jj++ )
-                        {
-                            if( (ii + (i << 1) >= 0)&&(ii + (i << 1) < srcHeight)
-                              &&(jj + (j << 1) >= 0)&&(jj + (j << 1) < srcWidth) )
-                            {
-                                w += mask.Mask(ii, jj);
-                                a += (float(center[ii*srcRowBytes + (jj<<2) + chan]) + 0.5f) * mask.Mask(ii, jj);
-                            }
-                        }
-                    }
-                    a /= w;
-
-                    dst[i * fCurrLevelRowBytes + (j << 2) + chan] = (uint8_t)a;
-                }
-            }
-        }
+                filter_row.call( mask.Data(), mask.End(), src, srcRowBytes, srcWidth, srcHeight,
+                                 int32_t( i << 1 ), 1, dst + i * dstRowBytes, dstWidth );
+            } );
     }
 }
 
@@ -1445,8 +1536,6 @@ void plMipmap::Filter(float sig)
     hsAssert(fPixelSize == 32, "Only 32 bit implemented");
     ASSERT_UNCOMPRESSED();
 
-    int i, j, ii, jj;
-
     if( 32 == fPixelSize )
     {
         uint8_t *dst = (uint8_t *)(fImage);
@@ -1459,40 +1548,16 @@ void plMipmap::Filter(float sig)
 
         plFilterMask mask(sig);
 
-        int32_t srcRowBytes = fRowBytes;
-        int32_t srcHeight = fHeight;
-        int32_t srcWidth = fWidth;
+        const int32_t rowBytes = fRowBytes;
+        const int32_t height = fHeight;
+        const int32_t width = fWidth;
 
-        for( i = 0; i < fHeight; i++ )
-        {
-            for( j = 0; j < fWidth; j++ )
+        IForEachFilterRow( fHeight, fWidth,
+            [&]( uint32_t i )
             {
-                uint8_t *center = &src[i * srcRowBytes + (j << 2)];
-
-                int32_t chan;
-                for( chan = 0; chan < 4; chan++ )
-                {
-                    float w = 0;
-                    float a = 0;
-
-                    for( ii = mask.Begin(); ii <= mask.End(); ii++ )
-                    {
-                        for( jj = mask.Begin(); jj <= mask.End(); jj++ )
-                        {
-                            if( (ii + i >= 0)&&(ii + i < srcHeight)
-                              &&(jj + j >= 0)&&(jj + j < srcWidth) )
-                            {
-                                w += mask.Mask(ii, jj);
-                                a += (float(center[ii*srcRowBytes + (jj<<2) + chan]) + 0.5f) * mask.Mask(ii, jj);
-                            }
-                        }
-                    }
-                    a /= w;
-
-                    dst[i * fRowBytes + (j << 2) + chan] = (uint8_t)(a);
-                }
-            }
-        }
+                filter_row.call( mask.Data(), mask.End(), src.data(), rowBytes, width, height,
+                                 int32_t( i ), 0, dst + i * rowBytes, width );
+            } );
     }
 }
 
@@ -1644,8 +1709,8 @@ void    plMipmap::Composite( plMipmap *source, uint16_t x, uint16_t y, plMipmap:
     uint8_t   level, numLevels, srcNumLevels, srcLevelOffset, levelsToSkip;
     uint16_t  pX, pY;
     uint32_t  *srcLevelPtr, *dstLevelPtr, *srcPtr, *dstPtr;
-    uint32_t  srcRowBytes, dstRowBytes, srcRowBytesToCopy, r, g, b, dR, dG, dB, srcWidth, srcHeight;
-    uint32_t  srcAlpha, oneMinusAlpha, destAlpha;
+    uint32_t  srcRowBytes, dstRowBytes, srcRowBytesToCopy, srcWidth, srcHeight;
+    uint32_t  srcAlpha;
     uint16_t  srcClipX, srcClipY;
 
 
@@ -1838,6 +1903,8 @@ void    plMipmap::Composite( plMipmap *source, uint16_t x, uint16_t y, plMipmap:
     }
     else
     {
+        const float tint[ 3 ] = { options->fRedTint, options->fGreenTint, options->fBlueTint };
+
         for( level = 0; level < numLevels; level++, y >>= 1, x >>= 1 )
         {
             srcPtr = srcLevelPtr;
@@ -1846,51 +1913,10 @@ void    plMipmap::Composite( plMipmap *source, uint16_t x, uint16_t y, plMipmap:
             // Clipping
             srcPtr += srcClipY * ( srcRowBytes >> 2 ) + srcClipX;
 
-            for( pY = (uint16_t)srcHeight; pY > 0; pY-- )         
+            for( pY = (uint16_t)srcHeight; pY > 0; pY-- )
             {
-                // Reverse the loop so we can count downwards--slightly faster
-                pX = (uint16_t)srcWidth;
-                do
-                {
-                    pX--;
-
-                    // Wacko trick here. Alphas are 0-255, which means scaling by alpha would
-                    // be a v' = v * alpha / 255 operation sequence. However, since we hate
-                    // dividing by 255 all the time, we actually scale the alpha just ever so
-                    // slightly so it's 0-256, which makes the divide a simple shift. Note
-                    // that this will result in some tiny bit of aliasing, but it shouldn't be
-                    // enough to notice
-                    
-                    if (!(srcPtr[pX] >> 24)) // Zero alpha. Skip this pixel
-                        continue;
-
-                    srcAlpha = options->fOpacity * ( ( srcPtr[ pX ] >> 16 ) & 0x0000ff00 ) / 255 / 256;
-                    oneMinusAlpha = 256 - srcAlpha;
-                    destAlpha = dstPtr[ pX ] & 0xff000000;
-
-                    r = (uint32_t)((( srcPtr[ pX ] >> 16 ) & 0x000000ff) * options->fRedTint);
-                    g = (uint32_t)((( srcPtr[ pX ] >> 8  ) & 0x000000ff) * options->fGreenTint);
-                    b = (uint32_t)((( srcPtr[ pX ]       ) & 0x000000ff) * options->fBlueTint);
-                    dR = ( dstPtr[ pX ] >> 16 ) & 0x000000ff;
-                    dG = ( dstPtr[ pX ] >> 8  ) & 0x000000ff;
-                    dB = ( dstPtr[ pX ]       ) & 0x000000ff;
-                    r = ( r * srcAlpha ) >> 8;
-                    g = ( g * srcAlpha ) >> 8;
-                    b = ( b * srcAlpha ) >> 8;
-                    dR = ( dR * oneMinusAlpha ) >> 8;
-                    dG = ( dG * oneMinusAlpha ) >> 8;
-                    dB = ( dB * oneMinusAlpha ) >> 8;
-
-                    // Dest alpha for now is just our original dest alpha
-                    dstPtr[ pX ] = ( ( r + dR ) << 16 ) | ( ( g + dG ) << 8 ) | ( b + dB ) | destAlpha;
-
-                    if( !( options->fFlags & kBlendWriteAlpha ) )
-                        continue;
-
-                    // Unless our blend option is set of course
-                    dstPtr[ pX ] = ( dstPtr[ pX ] & 0x00ffffff ) | ( srcAlpha << 24 );
-
-                } while( pX > 0 );
+                blend_row.call( dstPtr, srcPtr, srcWidth, options->fOpacity, tint,
+                                ( options->fFlags & kBlendWriteAlpha ) != 0 );
 
                 dstPtr += dstRowBytes >> 2;
                 srcPtr += srcRowBytes >> 2;
@@ -2019,13 +2045,7 @@ void    plMipmap::IColorLevel( uint8_t level, const uint8_t *colorMask )
 void    plMipmap::ScaleNicely( uint32_t *destPtr, uint16_t destWidth, uint16_t destHeight,
                                 uint16_t destStride, plMipmap::ScaleFilter filter ) const
 {
-    uint16_t      destX, destY, srcX, srcY;
-    int16_t       srcStartX, srcEndX, srcStartY, srcEndY;
-    float       srcPosX, srcPosY, destToSrcXScale, destToSrcYScale, filterWidth, filterHeight, weight;
-    float       totalWeight;
-    hsColorRGBA color, accumColor;
-    float       whyWaits[ 16 ], whyWait, xWeights[ 16 ];
-    uint32_t      *srcPtr;
+    float       destToSrcXScale, destToSrcYScale, filterWidth, filterHeight;
 
 
     // Init
@@ -2046,9 +2066,20 @@ void    plMipmap::ScaleNicely( uint32_t *destPtr, uint16_t destWidth, uint16_t d
     if( filterHeight < 1.f )
         filterHeight = 1.f;
 
-    // Process
-    for( destY = 0; destY < destHeight; destY++ )
+    // Process (each destination row on its own, so big images go wide)
+    IForEachFilterRow( destHeight, destWidth, [=]( uint32_t row )
     {
+        uint16_t    destX, destY, srcX, srcY;
+        int16_t     srcStartX, srcEndX, srcStartY, srcEndY;
+        float       srcPosX, srcPosY, weight;
+        float       totalWeight;
+        hsColorRGBA color, accumColor;
+        float       whyWaits[ 16 ], whyWait, xWeights[ 16 ];
+        uint32_t    *srcPtr;
+
+        destY = uint16_t( row );
+        uint32_t *destRow = destPtr + destY * destStride;
+
         // Calculate the span across this row
         srcPosY = destY * destToSrcYScale;
 
@@ -2116,11 +2147,9 @@ void    plMipmap::ScaleNicely( uint32_t *destPtr, uint16_t destWidth, uint16_t d
             accumColor *= 1.f / totalWeight;
 
             // Set the final value
-            *destPtr = accumColor.ToARGB32();
-            destPtr++;
+            destRow[ destX ] = accumColor.ToARGB32();
         }
-        destPtr += destStride - destWidth;
-    }
+    } );
 }
 
 //// ResizeNicely /////////////////////////////////////////////////////////////
@@ -54,6 +54,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #ifndef _plMipmap_h
 #define _plMipmap_h
 
+#include "hsCpuID.h"
 #include "plBitmap.h"
 
 #ifdef HS_DEBUGGING
@@ -320,6 +321,27 @@ class plMipmap : public plBitmap
 
         float    IGetDetailLevelAlpha( uint8_t level, float dropStart, float dropStop, float min, float max );
 
+        //  CPU-optimized functions
+        typedef void(*filter_row_ptr)(const float*, int32_t, const uint8_t*, int32_t, int32_t, int32_t,
+                                      int32_t, int32_t, uint8_t*, int32_t);
+        static hsCpuFunctionDispatcher<filter_row_ptr> filter_row;
+
+        static void IFilterRowFPU(const float *mask, int32_t ext, const uint8_t *src, int32_t srcRowBytes,
+                                  int32_t srcWidth, int32_t srcHeight, int32_t srcY, int32_t srcShift,
+                                  uint8_t *dst, int32_t dstWidth);
+        static void IFilterRowSSE2(const float *mask, int32_t ext, const uint8_t *src, int32_t srcRowBytes,
+                                   int32_t srcWidth, int32_t srcHeight, int32_t srcY, int32_t srcShift,
+                                   uint8_t *dst, int32_t dstWidth);
+
+        // Blends one row of Composite()'s default mode. tint is { red, green, blue }
+        typedef void(*blend_row_ptr)(uint32_t*, const uint32_t*, uint32_t, uint32_t, const float*, bool);
+        static hsCpuFunctionDispatcher<blend_row_ptr> blend_row;
+
+        static void IBlendRowFPU(uint32_t *dst, const uint32_t *src, uint32_t width, uint32_t opacity,
+                                 const float *tint, bool writeAlpha);
+        static void IBlendRowSSE2(uint32_t *dst, const uint32_t *src, uint32_t width, uint32_t opacity,
+                                  const float *tint, bool writeAlpha);
+
         void        ICarryZeroAlpha(uint8_t iDst);
         void        ICarryColor(uint8_t iDst, uint32_t col);
 
@@ -0,0 +1,165 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "HeadSpin.h"
+#include "plMipmap.h"
+#include "hsSIMD.h"
+
+#include <algorithm>
+#include <cstring>
+
+//// IFilterRowSSE2 ///////////////////////////////////////////////////////////
+//  Same as IFilterRowFPU, but runs all four channels of a pixel at once. Each
+//  channel still sees exactly the same sequence of float operations, so the
+//  output is identical.
+
+void plMipmap::IFilterRowSSE2( const float *mask, int32_t ext, const uint8_t *src, int32_t srcRowBytes,
+                               int32_t srcWidth, int32_t srcHeight, int32_t srcY, int32_t srcShift,
+                               uint8_t *dst, int32_t dstWidth )
+{
+#ifdef HAVE_SSE2
+    const int32_t maskWidth = ( ext << 1 ) + 1;
+    const int32_t iiBegin = std::max( -ext, -srcY );
+    const int32_t iiEnd = std::min( ext, srcHeight - 1 - srcY );
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 half = _mm_set1_ps( 0.5f );
+
+    int32_t j, ii, jj;
+    for( j = 0; j < dstWidth; j++ )
+    {
+        const int32_t srcX = j << srcShift;
+        const int32_t jjBegin = std::max( -ext, -srcX );
+        const int32_t jjEnd = std::min( ext, srcWidth - 1 - srcX );
+        const uint8_t *center = src + srcY * srcRowBytes + ( srcX << 2 );
+
+        float w = 0;
+        __m128 a = _mm_setzero_ps();
+
+        for( ii = iiBegin; ii <= iiEnd; ii++ )
+        {
+            const float *maskRow = mask + ( ii + ext ) * maskWidth + ext;
+            const uint8_t *srcRow = center + ii * srcRowBytes;
+            for( jj = jjBegin; jj <= jjEnd; jj++ )
+            {
+                int32_t pixel;
+                memcpy( &pixel, srcRow + ( jj << 2 ), sizeof( pixel ) );
+
+                __m128i chans = _mm_unpacklo_epi8( _mm_cvtsi32_si128( pixel ), zero );
+                chans = _mm_unpacklo_epi16( chans, zero );
+
+                w += maskRow[ jj ];
+                a = _mm_add_ps( a, _mm_mul_ps( _mm_add_ps( _mm_cvtepi32_ps( chans ), half ), _mm_set1_ps( maskRow[ jj ] ) ) );
+            }
+        }
+        a = _mm_div_ps( a, _mm_set1_ps( w ) );
+
+        __m128i result = _mm_cvttps_epi32( a );
+        result = _mm_packs_epi32( result, result );
+        result = _mm_packus_epi16( result, result );
+
+        int32_t pixel = _mm_cvtsi128_si32( result );
+        memcpy( dst + ( j << 2 ), &pixel, sizeof( pixel ) );
+    }
+#endif
+}
+
+//// IBlendRowSSE2 ////////////////////////////////////////////////////////////
+//  Two pixels at a time version of IBlendRowFPU. The tint is still applied
+//  in float and truncated, and the opacity scale uses an exact divide by 255,
+//  so the output matches. Tints above one can push a channel past 8 bits,
+//  which doesn't fit the 16-bit lanes, so those rows go the slow way.
+
+void plMipmap::IBlendRowSSE2( uint32_t *dst, const uint32_t *src, uint32_t width, uint32_t opacity,
+                              const float *tint, bool writeAlpha )
+{
+#ifdef HAVE_SSE2
+    for( int i = 0; i < 3; i++ )
+    {
+        if( !( tint[ i ] >= 0.f && tint[ i ] <= 1.f ) )
+        {
+            IBlendRowFPU( dst, src, width, opacity, tint, writeAlpha );
+            return;
+        }
+    }
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16( 1 );
+    const __m128i full = _mm_set1_epi16( 256 );
+    const __m128i opac = _mm_set1_epi16( int16_t( opacity ) );
+    const __m128i colorLanes = _mm_set_epi16( 0, -1, -1, -1, 0, -1, -1, -1 );
+    const __m128 tints = _mm_set_ps( 1.f, tint[ 0 ], tint[ 1 ], tint[ 2 ] );
+
+    uint32_t pX = 0;
+    for( ; pX + 2 <= width; pX += 2 )
+    {
+        __m128i s = _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i *)( src + pX ) ), zero );
+        __m128i d = _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i *)( dst + pX ) ), zero );
+
+        __m128 lo = _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( s, zero ) ), tints );
+        __m128 hi = _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( s, zero ) ), tints );
+        __m128i color = _mm_packs_epi32( _mm_cvttps_epi32( lo ), _mm_cvttps_epi32( hi ) );
+
+        // opacity * alpha / 255, with (v + 1 + (v >> 8)) >> 8 standing in for the divide
+        __m128i srcA = _mm_shufflehi_epi16( _mm_shufflelo_epi16( s, _MM_SHUFFLE( 3, 3, 3, 3 ) ), _MM_SHUFFLE( 3, 3, 3, 3 ) );
+        __m128i v = _mm_mullo_epi16( srcA, opac );
+        __m128i alpha = _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16( v, one ), _mm_srli_epi16( v, 8 ) ), 8 );
+
+        // Zero alpha works out to the dest color on its own
+        __m128i blended = _mm_add_epi16( _mm_srli_epi16( _mm_mullo_epi16( color, alpha ), 8 ),
+                                         _mm_srli_epi16( _mm_mullo_epi16( d, _mm_sub_epi16( full, alpha ) ), 8 ) );
+
+        __m128i outAlpha = d;
+        if( writeAlpha )
+        {
+            __m128i skipped = _mm_cmpeq_epi16( srcA, zero );
+            outAlpha = _mm_or_si128( _mm_and_si128( skipped, d ), _mm_andnot_si128( skipped, alpha ) );
+        }
+        blended = _mm_or_si128( _mm_and_si128( colorLanes, blended ), _mm_andnot_si128( colorLanes, outAlpha ) );
+
+        _mm_storel_epi64( (__m128i *)( dst + pX ), _mm_packus_epi16( blended, blended ) );
+    }
+
+    if( pX < width )
+        IBlendRowFPU( dst + pX, src + pX, width - pX, opacity, tint, writeAlpha );
+#endif
+}
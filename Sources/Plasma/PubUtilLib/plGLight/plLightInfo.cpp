@@ -223,7 +223,8 @@ const std::vector<int16_t>& plLightInfo::GetAffected(plSpaceTree* space, const s
         {
             if( IGetIsect() )
             {
-                static hsBitVector cache;
+                // Drawables may be lit on several threads at once.
+                static thread_local hsBitVector cache;
                 cache.Clear();
                 space->EnableLeaves(visList, cache);
 
@@ -655,6 +656,20 @@ void plLimitedDirLightInfo::GetStrengthAndScale(const hsBounds3Ext& bnd, float&
     plLightInfo::GetStrengthAndScale(bnd, strength, scale);
 }
 
+bool plLimitedDirLightInfo::GetAffectedBounds(hsBounds3Ext& bnd) const
+{
+    if( !fParPlanes )
+        return false;
+
+    hsPoint3 corner(-fWidth * 0.5f, -fHeight * 0.5f, -fDepth);
+    bnd.Reset(&corner);
+    corner.Set(fWidth * 0.5f, fHeight * 0.5f, 0);
+    bnd.Union(&corner);
+    bnd.Transform(&fLightToWorld);
+
+    return true;
+}
+
 void plLimitedDirLightInfo::Read(hsStream* s, hsResMgr* mgr)
 {
     plDirectionalLightInfo::Read(s, mgr);
@@ -786,6 +801,21 @@ void plOmniLightInfo::GetStrengthAndScale(const hsBounds3Ext& bnd, float& streng
     }
 }
 
+bool plOmniLightInfo::GetAffectedBounds(hsBounds3Ext& bnd) const
+{
+    if( !fSphere )
+        return false;
+
+    hsPoint3 wpos = GetWorldPosition();
+    hsVector3 rad(fSphere->GetRadius(), fSphere->GetRadius(), fSphere->GetRadius());
+    hsPoint3 corner = wpos - rad;
+    bnd.Reset(&corner);
+    corner = wpos + rad;
+    bnd.Union(&corner);
+
+    return true;
+}
+
 float plOmniLightInfo::GetRadius() const
 {
     float radius = 0;
@@ -927,6 +957,34 @@ plVolumeIsect* plSpotLightInfo::IGetIsect() const
     return fCone;
 }
 
+bool plSpotLightInfo::GetAffectedBounds(hsBounds3Ext& bnd) const
+{
+    // The cone test is really a pyramid out to the far cap, so box the tip
+    // and the cap's corners. Uncapped or near flat ones go everywhere.
+    if( !fCone || fCone->GetLength() <= 0 )
+        return false;
+
+    float sinAng, cosAng;
+    hsFastMath::SinCosInRangeAppr(fCone->GetAngle(), sinAng, cosAng);
+    if( cosAng < 1.e-2f )
+        return false;
+
+    float len = fCone->GetLength();
+    // A little slack, since the cone's own planes come from approximate trig.
+    float halfWidth = len * sinAng / cosAng * 1.01f;
+
+    hsPoint3 pts[5];
+    pts[0].Set(0, 0, 0);
+    pts[1].Set(-halfWidth, -halfWidth, -len);
+    pts[2].Set( halfWidth, -halfWidth, -len);
+    pts[3].Set(-halfWidth,  halfWidth, -len);
+    pts[4].Set( halfWidth,  halfWidth, -len);
+    bnd.Reset(5, pts);
+    bnd.Transform(&fLightToWorld);
+
+    return true;
+}
+
 void plSpotLightInfo::IRefresh()
 {
     plLightInfo::IRefresh();
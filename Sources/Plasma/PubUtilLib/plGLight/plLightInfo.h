@@ -190,6 +190,9 @@ public:
     virtual void GetStrengthAndScale(const hsBounds3Ext& bnd, float& strength, float& scale) const;
 
     bool AffectsBound(const hsBounds3Ext& bnd);
+    // World space box around everything AffectsBound() might accept, based on
+    // the volume as of the last Refresh(). False if the light has no limit.
+    virtual bool GetAffectedBounds(hsBounds3Ext& bnd) const { return false; }
     void GetAffectedForced(const plSpaceTree* space, hsBitVector& list, bool charac);
     void GetAffected(const plSpaceTree* space, hsBitVector& list, bool charac);
     const std::vector<int16_t>& GetAffected(plSpaceTree* space, const std::vector<int16_t>& visList, std::vector<int16_t>& litList, bool charac);
@@ -295,6 +298,7 @@ public:
     GETINTERFACE_ANY( plLimitedDirLightInfo, plDirectionalLightInfo );
 
     void GetStrengthAndScale(const hsBounds3Ext& bnd, float& strength, float& scale) const override;
+    bool GetAffectedBounds(hsBounds3Ext& bnd) const override;
 
     float GetWidth() const { return fWidth; }
     float GetHeight() const { return fHeight; }
@@ -336,6 +340,7 @@ public:
     GETINTERFACE_ANY( plOmniLightInfo, plLightInfo );
 
     void GetStrengthAndScale(const hsBounds3Ext& bnd, float& strength, float& scale) const override;
+    bool GetAffectedBounds(hsBounds3Ext& bnd) const override;
 
     hsVector3 GetNegativeWorldDirection(const hsPoint3& pos) const override;
 
@@ -393,6 +398,7 @@ public:
     GETINTERFACE_ANY( plSpotLightInfo, plOmniLightInfo );
 
     void GetStrengthAndScale(const hsBounds3Ext& bnd, float& strength, float& scale) const override;
+    bool GetAffectedBounds(hsBounds3Ext& bnd) const override;
 
     hsVector3 GetWorldDirection() const;
     hsVector3 GetNegativeWorldDirection(const hsPoint3& pos) const override { return -GetWorldDirection(); }
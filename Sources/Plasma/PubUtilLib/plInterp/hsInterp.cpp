@@ -393,112 +393,108 @@ static inline hsKeyFrame* GetKey(int32_t i, void *keys, int32_t size)
 }
 
 //
-// STATIC
-// Given a list of keys, and a time, fills in the 2 boundary keys and 
-// a fraction (p=0-1) indicating where the time falls between them.
-// Returns the index of the first key which can be passed in as a hint (lastKeyIdx)
-// for the next search.
+// Shared by both flavors of GetBoundaryKeyFrames. frameOf(i) returns the
+// frame of key i. Fills in the index of the first boundary key (the second is
+// either the same key or the next one) and the fraction between them.
 //
-void hsInterp::GetBoundaryKeyFrames(float time, uint32_t numKeys, void *keys, uint32_t size,
-                                    hsKeyFrame **kF1, hsKeyFrame **kF2, uint32_t *lastKeyIdx, float *p, bool forwards)
+// During normal playback the time only moves a little each frame, so we try
+// the hinted pair and its neighbor in the direction of play first. Anything
+// else (seeks, loops, big time steps) falls back to a binary search, so the
+// cost never grows linearly with the length of the animation.
+//
+template<typename FrameOf>
+static inline void IFindBoundaryKeys(float time, uint32_t numKeys, FrameOf frameOf,
+                                     uint32_t *k1Idx, uint32_t *k2Idx, uint32_t *lastKeyIdx, float *p, bool forwards)
 {
     hsAssert(numKeys>1, "Must have more than 1 keyframe");
-    int k1 = 0, k2 = 0;
     float frame = time * MAX_FRAMES_PER_SEC;
 
     // boundary case, past end
-    if (frame > GetKey(numKeys-1, keys, size)->fFrame)
+    if (frame > frameOf(numKeys-1))
     {
-        k1=k2=numKeys-1;
-        (*kF2) = GetKey(k1, keys, size);
-        (*kF1) = (*kF2);
+        *k1Idx = *k2Idx = numKeys-1;
         *p = 0.0;
-        goto ret;
+        *lastKeyIdx = numKeys-1;
+        return;
     }
 
-    hsKeyFrame *key1, *key2;
     // boundary case, before start
-    if (frame < (key1=GetKey(0, keys, size))->fFrame)
+    if (frame < frameOf(0))
     {
-        k1=k2=0;
-        (*kF1) = GetKey(k1, keys, size);
-        (*kF2) = (*kF1);
+        *k1Idx = *k2Idx = 0;
         *p = 0.0;
-        goto ret;
+        *lastKeyIdx = 0;
+        return;
     }
 
-    // prime loop
-    int i;
-    i = 1;
-    if (*lastKeyIdx > 0 && *lastKeyIdx < numKeys - 1)
+    auto spans = [=](uint32_t i)
     {
-        // new starting point for search
-        if (forwards)
-            key1 = GetKey(*lastKeyIdx, keys, size);
-        else
-            key2 = GetKey(*lastKeyIdx + 1, keys, size);
+        return frameOf(i) <= frame && frame <= frameOf(i + 1);
+    };
 
-        i = *lastKeyIdx + 1;
-    }
-    else if (!forwards)
+    uint32_t k1 = numKeys;
+    uint32_t hint = *lastKeyIdx;
+    if (hint < numKeys - 1)
     {
-        key2 = GetKey(1, keys, size);
+        if (spans(hint))
+            k1 = hint;
+        else if (forwards && hint + 2 < numKeys && spans(hint + 1))
+            k1 = hint + 1;
+        else if (!forwards && hint > 0 && spans(hint - 1))
+            k1 = hint - 1;
     }
 
-    // search pairs of keys
-    int count;
-    if (forwards)
+    if (k1 == numKeys)
     {
-        for (count = 1; count <= numKeys; count++, i++)
+        // Find the first key at or after our frame. The checks above
+        // guarantee it's somewhere in [1, numKeys-1].
+        uint32_t lo = 1, hi = numKeys - 1;
+        while (lo < hi)
         {
-            if (i >= numKeys)
-            {
-                key1 = GetKey(0, keys, size);
-                i = 1;
-                count++;
-            }
-                
-            key2 = GetKey(i, keys, size);
-            if (frame <= key2->fFrame && frame >= key1->fFrame)
-            {
-                k2=i;
-                k1=i-1;
-                (*kF2) = key2;
-                (*kF1) = key1;
-                *p = (time - (*kF1)->fFrame / MAX_FRAMES_PER_SEC) / (((*kF2)->fFrame - (*kF1)->fFrame) / MAX_FRAMES_PER_SEC);
-                goto ret;
-            }
-            key1=key2;
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (frameOf(mid) < frame)
+                lo = mid + 1;
+            else
+                hi = mid;
         }
+        k1 = lo - 1;
     }
-    else
-    {
-        for (count = 1; count <= numKeys; count++, i--)
-        {
-            if (i < 1)
-            {
-                i = numKeys - 1;
-                key2 = GetKey(i, keys, size);
-                count++;
-            }
-            
-            key1 = GetKey(i - 1, keys, size);
-            if (frame <= key2->fFrame && frame >= key1->fFrame)
-            {
-                k2 = i;
-                k1 = i - 1;
-                (*kF2) = key2;
-                (*kF1) = key1;
-                *p = (time - (*kF1)->fFrame / MAX_FRAMES_PER_SEC) / (((*kF2)->fFrame - (*kF1)->fFrame) / MAX_FRAMES_PER_SEC);
-                goto ret;
-            }
-            key2=key1;
-        }
-    }       
 
-ret:
-;
+    *k1Idx = k1;
+    *k2Idx = k1 + 1;
+    if (frameOf(k1 + 1) == frameOf(k1))
+        *p = 0.0;
+    else
+        *p = (frame - frameOf(k1)) / (frameOf(k1 + 1) - frameOf(k1)); // frame is in the span, so this stays in [0, 1]
     *lastKeyIdx = k1;
 }
 
+//
+// STATIC
+// Given a list of keys, and a time, fills in the 2 boundary keys and 
+// a fraction (p=0-1) indicating where the time falls between them.
+// Returns the index of the first key which can be passed in as a hint (lastKeyIdx)
+// for the next search.
+//
+void hsInterp::GetBoundaryKeyFrames(float time, uint32_t numKeys, void *keys, uint32_t size,
+                                    hsKeyFrame **kF1, hsKeyFrame **kF2, uint32_t *lastKeyIdx, float *p, bool forwards)
+{
+    // Promote to int before the subtraction, like the old search did
+    auto frameOf = [=](uint32_t i) { return int32_t(GetKey(i, keys, size)->fFrame); };
+
+    uint32_t k1, k2;
+    IFindBoundaryKeys(time, numKeys, frameOf, &k1, &k2, lastKeyIdx, p, forwards);
+    (*kF1) = GetKey(k1, keys, size);
+    (*kF2) = GetKey(k2, keys, size);
+}
 
+//
+// STATIC
+// Same as above, for keys whose frames are kept in their own array.
+//
+void hsInterp::GetBoundaryKeyFrames(float time, uint32_t numKeys, const float *frames,
+                                    uint32_t *k1, uint32_t *k2, uint32_t *lastKeyIdx, float *p, bool forwards)
+{
+    auto frameOf = [=](uint32_t i) { return frames[i]; };
+    IFindBoundaryKeys(time, numKeys, frameOf, k1, k2, lastKeyIdx, p, forwards);
+}
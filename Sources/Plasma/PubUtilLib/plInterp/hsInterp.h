@@ -88,6 +88,9 @@ public:
     // Given a time value, find the enclosing keyframes and normalize time (0-1)
     static void GetBoundaryKeyFrames(float time, uint32_t numKeys, void *keys, 
         uint32_t keySize, hsKeyFrame **kF1, hsKeyFrame **kF2, uint32_t *lastKeyIdx, float *p, bool forwards);
+    // Same, for key frames kept in their own array. Fills in key indices instead.
+    static void GetBoundaryKeyFrames(float time, uint32_t numKeys, const float *frames,
+        uint32_t *k1, uint32_t *k2, uint32_t *lastKeyIdx, float *p, bool forwards);
 
 };
 
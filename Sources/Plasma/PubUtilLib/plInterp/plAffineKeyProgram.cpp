@@ -0,0 +1,377 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "plAffineKeyProgram.h"
+
+#include "HeadSpin.h"
+#include "hsQuat.h"
+#include "hsThreadPool.h"
+
+#include "hsInterp.h"
+#include "hsKeys.h"
+#include "plController.h"
+
+#include "plTransform/hsAffineParts.h"
+
+#include <algorithm>
+
+//// Compile //////////////////////////////////////////////////////////////////
+
+plAffineKeyProgram *plAffineKeyProgram::Compile(const plController *controller)
+{
+    const plCompoundController *compound = plCompoundController::ConvertNoRef(controller);
+    if (!compound)
+        return nullptr;
+
+    plAffineKeyProgram *program = new plAffineKeyProgram;
+    for (uint8_t i = 0; i < kNumStreams; i++)
+    {
+        const plController *sub = compound->GetController(i);
+        if (!sub)
+            continue;
+
+        if (!ICompileStream(plLeafController::ConvertNoRef(sub), i, program->fStreams[i]))
+        {
+            delete program;
+            return nullptr;
+        }
+    }
+
+    return program;
+}
+
+bool plAffineKeyProgram::ICompileStream(const plLeafController *leaf, uint8_t stream, Stream &out)
+{
+    if (!leaf || leaf->GetNumKeys() == 0)
+        return false;
+
+    const uint32_t numKeys = leaf->GetNumKeys();
+    const uint8_t type = leaf->GetType();
+
+    bool posKeys = (type == hsKeyFrame::kPoint3KeyFrame || type == hsKeyFrame::kBezPoint3KeyFrame);
+    bool rotKeys = (type == hsKeyFrame::kQuatKeyFrame ||
+                    type == hsKeyFrame::kCompressedQuatKeyFrame32 ||
+                    type == hsKeyFrame::kCompressedQuatKeyFrame64);
+    bool scaleKeys = (type == hsKeyFrame::kScaleKeyFrame || type == hsKeyFrame::kBezScaleKeyFrame);
+    if ((stream == kPosStream && !posKeys) ||
+        (stream == kRotStream && !rotKeys) ||
+        (stream == kScaleStream && !scaleKeys))
+        return false;
+
+    out.fType = (type == hsKeyFrame::kBezPoint3KeyFrame || type == hsKeyFrame::kBezScaleKeyFrame) ? kBezier : kLinear;
+    out.fHasValue = !rotKeys;
+    out.fHasQuat = !posKeys;
+
+    out.fFrames.resize(numKeys);
+    for (int c = 0; c < 3; c++)
+    {
+        if (out.fHasValue)
+            out.fValue[c].resize(numKeys);
+        if (out.fType == kBezier)
+        {
+            out.fInTan[c].resize(numKeys);
+            out.fOutTan[c].resize(numKeys);
+        }
+    }
+    if (out.fHasQuat)
+    {
+        for (int c = 0; c < 4; c++)
+            out.fQuat[c].resize(numKeys);
+    }
+
+    auto setValue = [&out](uint32_t i, const hsScalarTriple &value)
+    {
+        out.fValue[0][i] = value.fX;
+        out.fValue[1][i] = value.fY;
+        out.fValue[2][i] = value.fZ;
+    };
+    auto setTangents = [&out](uint32_t i, const hsScalarTriple &inTan, const hsScalarTriple &outTan)
+    {
+        out.fInTan[0][i] = inTan.fX;
+        out.fInTan[1][i] = inTan.fY;
+        out.fInTan[2][i] = inTan.fZ;
+        out.fOutTan[0][i] = outTan.fX;
+        out.fOutTan[1][i] = outTan.fY;
+        out.fOutTan[2][i] = outTan.fZ;
+    };
+    auto setQuat = [&out](uint32_t i, const hsQuat &quat)
+    {
+        out.fQuat[0][i] = quat.fX;
+        out.fQuat[1][i] = quat.fY;
+        out.fQuat[2][i] = quat.fZ;
+        out.fQuat[3][i] = quat.fW;
+    };
+
+    for (uint32_t i = 0; i < numKeys; i++)
+    {
+        switch (type)
+        {
+        case hsKeyFrame::kPoint3KeyFrame:
+            {
+                const hsPoint3Key *key = leaf->GetPoint3Key(i);
+                out.fFrames[i] = key->fFrame;
+                setValue(i, key->fValue);
+            }
+            break;
+        case hsKeyFrame::kBezPoint3KeyFrame:
+            {
+                const hsBezPoint3Key *key = leaf->GetBezPoint3Key(i);
+                out.fFrames[i] = key->fFrame;
+                setValue(i, key->fValue);
+                setTangents(i, key->fInTan, key->fOutTan);
+            }
+            break;
+        case hsKeyFrame::kQuatKeyFrame:
+            {
+                const hsQuatKey *key = leaf->GetQuatKey(i);
+                out.fFrames[i] = key->fFrame;
+                setQuat(i, key->fValue);
+            }
+            break;
+        case hsKeyFrame::kCompressedQuatKeyFrame32:
+            {
+                hsCompressedQuatKey32 *key = leaf->GetCompressedQuatKey32(i);
+                hsQuat quat;
+                key->GetQuat(quat);
+                out.fFrames[i] = key->fFrame;
+                setQuat(i, quat);
+            }
+            break;
+        case hsKeyFrame::kCompressedQuatKeyFrame64:
+            {
+                hsCompressedQuatKey64 *key = leaf->GetCompressedQuatKey64(i);
+                hsQuat quat;
+                key->GetQuat(quat);
+                out.fFrames[i] = key->fFrame;
+                setQuat(i, quat);
+            }
+            break;
+        case hsKeyFrame::kScaleKeyFrame:
+            {
+                const hsScaleKey *key = leaf->GetScaleKey(i);
+                out.fFrames[i] = key->fFrame;
+                setValue(i, key->fValue.fS);
+                setQuat(i, key->fValue.fQ);
+            }
+            break;
+        case hsKeyFrame::kBezScaleKeyFrame:
+            {
+                const hsBezScaleKey *key = leaf->GetBezScaleKey(i);
+                out.fFrames[i] = key->fFrame;
+                setValue(i, key->fValue.fS);
+                setTangents(i, key->fInTan, key->fOutTan);
+                setQuat(i, key->fValue.fQ);
+            }
+            break;
+        }
+    }
+
+    return true;
+}
+
+//// Evaluate /////////////////////////////////////////////////////////////////
+// Each job gets enough requests to fill its slerp lanes, two rotations
+// (essential and stretch) per request at most.
+
+void plAffineKeyProgram::Evaluate(const Request *requests, size_t count)
+{
+    constexpr size_t kRequestsPerJob = SlerpLanes::kMaxLanes / 2;
+
+    auto evalRange = [requests](size_t begin, size_t end)
+    {
+        SlerpLanes lanes;
+        for (size_t i = begin; i < end; i++)
+        {
+            if (lanes.IsFull())
+                lanes.Flush();
+
+            const Request &request = requests[i];
+            request.fProgram->IEvaluate(request, lanes);
+            request.fState->fTime = request.fTime;
+            request.fState->fPrepared = true;
+        }
+        lanes.Flush();
+    };
+
+    if (count <= kRequestsPerJob)
+        evalRange(0, count);
+    else
+        hsThreadPool::Instance().ParallelFor(count, kRequestsPerJob, evalRange);
+}
+
+// Same math as plLeafController::Interp, one stream at a time
+void plAffineKeyProgram::IEvaluate(const Request &request, SlerpLanes &lanes) const
+{
+    hsAffineParts *parts = request.fResult;
+    hsScalarTriple *values[kNumStreams] = { &parts->fT, nullptr, &parts->fK };
+    hsQuat *quats[kNumStreams] = { nullptr, &parts->fQ, &parts->fU };
+
+    for (uint8_t s = 0; s < kNumStreams; s++)
+    {
+        const Stream &stream = fStreams[s];
+        if (stream.fType == kNone)
+            continue;
+
+        uint32_t k1 = 0, k2 = 0;
+        float t = 0.f;
+        if (stream.NumKeys() > 1)
+        {
+            hsInterp::GetBoundaryKeyFrames(request.fTime, stream.NumKeys(), stream.fFrames.data(),
+                                           &k1, &k2, &request.fState->fHints[s], &t, request.fForwards);
+        }
+
+        if (stream.fHasValue)
+        {
+            float result[3];
+            if (stream.fType == kBezier)
+            {
+                float scale = (stream.fFrames[k2] - stream.fFrames[k1]) * MAX_TICKS_PER_FRAME / 3.f;
+                for (int c = 0; c < 3; c++)
+                {
+                    hsInterp::BezScalarEval(stream.fValue[c][k1], stream.fOutTan[c][k1],
+                                            stream.fValue[c][k2], stream.fInTan[c][k2],
+                                            t, scale, &result[c]);
+                }
+            }
+            else
+            {
+                uint32_t k = (t == 1.f) ? k2 : k1;
+                for (int c = 0; c < 3; c++)
+                {
+                    if (t == 0.f || t == 1.f)
+                        result[c] = stream.fValue[c][k];
+                    else
+                        hsInterp::LinInterp(stream.fValue[c][k1], stream.fValue[c][k2], t, &result[c]);
+                }
+            }
+            values[s]->Set(result[0], result[1], result[2]);
+        }
+
+        if (stream.fHasQuat)
+        {
+            if (t == 0.f || t == 1.f)
+            {
+                uint32_t k = (t == 1.f) ? k2 : k1;
+                quats[s]->Set(stream.fQuat[0][k], stream.fQuat[1][k], stream.fQuat[2][k], stream.fQuat[3][k]);
+            }
+            else
+                lanes.Add(stream, k1, k2, t, quats[s]);
+        }
+    }
+}
+
+//// SlerpLanes ///////////////////////////////////////////////////////////////
+
+void plAffineKeyProgram::SlerpLanes::Add(const Stream &stream, uint32_t k1, uint32_t k2, float t, hsQuat *dest)
+{
+    hsAssert(fCount < kMaxLanes, "Too many slerps queued up");
+
+    for (int c = 0; c < 4; c++)
+    {
+        fFrom[c][fCount] = stream.fQuat[c][k1];
+        fTo[c][fCount] = stream.fQuat[c][k2];
+    }
+    fT[fCount] = t;
+    fDest[fCount] = dest;
+    fCount++;
+}
+
+void plAffineKeyProgram::SlerpLanes::Flush()
+{
+    if (!fCount)
+        return;
+
+    // Pad out the last group of four with something harmless
+    for (uint32_t i = fCount; i & 3; i++)
+    {
+        for (int c = 0; c < 4; c++)
+            fFrom[c][i] = fTo[c][i] = (c == 3) ? 1.f : 0.f;
+        fT[i] = 0.5f;
+    }
+
+    slerp_lanes.call(*this);
+
+    for (uint32_t i = 0; i < fCount; i++)
+        fDest[i]->Set(fOut[0][i], fOut[1][i], fOut[2][i], fOut[3][i]);
+    fCount = 0;
+}
+
+//// ISlerpLanesFPU ///////////////////////////////////////////////////////////
+// Slerp without the transcendentals, after D. Eberly, "A Fast and Accurate
+// Algorithm for Computing SLERP". The weights sin((1-t)a)/sin(a) and
+// sin(ta)/sin(a) are written as polynomials in cos(a) - 1, whose coefficients
+// only depend on t. Like hsQuat::SetFromSlerp, we flip the second quat when
+// the two are more than 90 degrees apart.
+
+void plAffineKeyProgram::ISlerpLanesFPU(SlerpLanes &lanes)
+{
+    for (uint32_t i = 0; i < lanes.fCount; i++)
+    {
+        float cosA = lanes.fFrom[0][i] * lanes.fTo[0][i] + lanes.fFrom[1][i] * lanes.fTo[1][i] +
+                     lanes.fFrom[2][i] * lanes.fTo[2][i] + lanes.fFrom[3][i] * lanes.fTo[3][i];
+        float sign = (cosA < 0.f) ? -1.f : 1.f;
+        float xm1 = std::min(cosA * sign, 1.f) - 1.f;
+
+        float t = lanes.fT[i];
+        float d = 1.f - t;
+        float tSq = t * t;
+        float dSq = d * d;
+
+        float wTo = 1.f, wFrom = 1.f;
+        for (int j = kSlerpTerms - 1; j >= 0; j--)
+        {
+            wTo = 1.f + (kSlerpU[j] * tSq - kSlerpV[j]) * xm1 * wTo;
+            wFrom = 1.f + (kSlerpU[j] * dSq - kSlerpV[j]) * xm1 * wFrom;
+        }
+        wTo *= t * sign;
+        wFrom *= d;
+
+        for (int c = 0; c < 4; c++)
+            lanes.fOut[c][i] = lanes.fFrom[c][i] * wFrom + lanes.fTo[c][i] * wTo;
+    }
+}
+
+hsCpuFunctionDispatcher<plAffineKeyProgram::slerp_lanes_ptr> plAffineKeyProgram::slerp_lanes {
+    &plAffineKeyProgram::ISlerpLanesFPU,
+    nullptr,                                // SSE1
+    &plAffineKeyProgram::ISlerpLanesSSE2
+};
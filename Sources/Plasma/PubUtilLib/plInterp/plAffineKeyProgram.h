@@ -0,0 +1,185 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+#ifndef plAffineKeyProgram_inc
+#define plAffineKeyProgram_inc
+
+#include "HeadSpin.h"
+#include "hsCpuID.h"
+
+#include <vector>
+
+class hsAffineParts;
+class hsQuat;
+class plController;
+class plLeafController;
+
+//
+// A position/rotation/scale controller flattened into plain arrays, so that
+// the leaves of many animation graphs can be interpolated in one pass.
+//
+// Each of the three sub-controllers becomes a stream: one array of key frames
+// plus one array per value component (and per tangent component for Bezier
+// keys). Compressed rotation keys are expanded up front. Evaluate() looks up
+// the keys of every request with the hinted binary search from hsInterp, does
+// the linear and Bezier parts right away, and collects all of the rotations
+// that need a slerp so they can be done four at a time.
+//
+// Only compound controllers whose children are plain leaf controllers can be
+// compiled. Compile() returns nullptr for anything else, and those channels
+// keep going through plController::Interp.
+//
+class plAffineKeyProgram
+{
+public:
+    // Per-user state, kept by whoever owns the result being written to
+    struct State
+    {
+        uint32_t    fHints[3];      // Last key index of each stream
+        float       fTime;          // Time of the last batched evaluation
+        bool        fPrepared;      // fTime is valid
+
+        State() : fHints(), fTime(), fPrepared() { }
+
+        bool IsPreparedAt(double time) const { return fPrepared && fTime == float(time); }
+    };
+
+    struct Request
+    {
+        const plAffineKeyProgram    *fProgram;
+        State                       *fState;
+        hsAffineParts               *fResult;   // Only the animated parts are written
+        float                       fTime;
+        bool                        fForwards;
+    };
+
+    // Returns nullptr if the controller can't be flattened
+    static plAffineKeyProgram *Compile(const plController *controller);
+
+    // Evaluates all of the requests, spreading them over the thread pool.
+    // Requests must not share states or results. Marks each state prepared.
+    static void Evaluate(const Request *requests, size_t count);
+    static void Evaluate(const std::vector<Request> &requests) { Evaluate(requests.data(), requests.size()); }
+
+private:
+    enum StreamType
+    {
+        kNone,
+        kLinear,
+        kBezier
+    };
+
+    // Keys of one sub-controller. Rotations and the scale axis are held in
+    // fQuat, translations and scale factors in fValue.
+    struct Stream
+    {
+        uint8_t             fType;
+        bool                fHasQuat;
+        bool                fHasValue;
+        std::vector<float>  fFrames;
+        std::vector<float>  fValue[3];
+        std::vector<float>  fInTan[3];
+        std::vector<float>  fOutTan[3];
+        std::vector<float>  fQuat[4];
+
+        Stream() : fType(kNone), fHasQuat(), fHasValue() { }
+
+        uint32_t NumKeys() const { return uint32_t(fFrames.size()); }
+    };
+
+    enum
+    {
+        kPosStream,
+        kRotStream,
+        kScaleStream,
+        kNumStreams
+    };
+
+    Stream fStreams[kNumStreams];
+
+    // Rotations waiting for a slerp, in structure-of-arrays form
+    struct SlerpLanes
+    {
+        enum { kMaxLanes = 128 };
+
+        alignas(16) float   fFrom[4][kMaxLanes];
+        alignas(16) float   fTo[4][kMaxLanes];
+        alignas(16) float   fT[kMaxLanes];
+        alignas(16) float   fOut[4][kMaxLanes];
+        hsQuat              *fDest[kMaxLanes];
+        uint32_t            fCount;
+
+        SlerpLanes() : fCount() { }
+
+        bool IsFull() const { return fCount + 2 > kMaxLanes; }
+        void Add(const Stream &stream, uint32_t k1, uint32_t k2, float t, hsQuat *dest);
+
+        // Runs the slerps and writes the results out to their destinations
+        void Flush();
+    };
+
+    // Slerps the lanes (padded to a multiple of four) into fOut. Uses a
+    // polynomial fit of the slerp coefficients instead of acos and sin, so
+    // it vectorizes. Matches hsQuat::SetFromSlerp to about 1e-6.
+    enum { kSlerpTerms = 12 };
+    static constexpr float kSlerpMu = 1.89372f;
+    static constexpr float kSlerpU[kSlerpTerms] = {
+        1.f / (1 * 3), 1.f / (2 * 5), 1.f / (3 * 7), 1.f / (4 * 9),
+        1.f / (5 * 11), 1.f / (6 * 13), 1.f / (7 * 15), 1.f / (8 * 17),
+        1.f / (9 * 19), 1.f / (10 * 21), 1.f / (11 * 23), kSlerpMu / (12 * 25)
+    };
+    static constexpr float kSlerpV[kSlerpTerms] = {
+        1.f / 3, 2.f / 5, 3.f / 7, 4.f / 9,
+        5.f / 11, 6.f / 13, 7.f / 15, 8.f / 17,
+        9.f / 19, 10.f / 21, 11.f / 23, kSlerpMu * 12 / 25
+    };
+
+    typedef void(*slerp_lanes_ptr)(SlerpLanes&);
+    static hsCpuFunctionDispatcher<slerp_lanes_ptr> slerp_lanes;
+
+    static void ISlerpLanesFPU(SlerpLanes &lanes);
+    static void ISlerpLanesSSE2(SlerpLanes &lanes);
+
+    static bool ICompileStream(const plLeafController *leaf, uint8_t stream, Stream &out);
+    void IEvaluate(const Request &request, SlerpLanes &lanes) const;
+};
+
+#endif // plAffineKeyProgram_inc
@@ -0,0 +1,90 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "plAffineKeyProgram.h"
+
+#include "hsSIMD.h"
+
+//// ISlerpLanesSSE2 //////////////////////////////////////////////////////////
+// Same as ISlerpLanesFPU, four lanes per register.
+
+void plAffineKeyProgram::ISlerpLanesSSE2(SlerpLanes &lanes)
+{
+#ifdef HAVE_SSE2
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 signBit = _mm_set1_ps(-0.f);
+
+    for (uint32_t i = 0; i < lanes.fCount; i += 4)
+    {
+        __m128 from[4], to[4];
+        for (int c = 0; c < 4; c++)
+        {
+            from[c] = _mm_load_ps(&lanes.fFrom[c][i]);
+            to[c] = _mm_load_ps(&lanes.fTo[c][i]);
+        }
+
+        __m128 cosA = _mm_add_ps(_mm_add_ps(_mm_mul_ps(from[0], to[0]), _mm_mul_ps(from[1], to[1])),
+                                 _mm_add_ps(_mm_mul_ps(from[2], to[2]), _mm_mul_ps(from[3], to[3])));
+        __m128 sign = _mm_and_ps(cosA, signBit);
+        __m128 xm1 = _mm_sub_ps(_mm_min_ps(_mm_xor_ps(cosA, sign), one), one);
+
+        __m128 t = _mm_load_ps(&lanes.fT[i]);
+        __m128 d = _mm_sub_ps(one, t);
+        __m128 tSq = _mm_mul_ps(t, t);
+        __m128 dSq = _mm_mul_ps(d, d);
+
+        __m128 wTo = one, wFrom = one;
+        for (int j = kSlerpTerms - 1; j >= 0; j--)
+        {
+            __m128 u = _mm_set1_ps(kSlerpU[j]);
+            __m128 v = _mm_set1_ps(kSlerpV[j]);
+            wTo = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(u, tSq), v), xm1), wTo));
+            wFrom = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(u, dSq), v), xm1), wFrom));
+        }
+        wTo = _mm_xor_ps(_mm_mul_ps(wTo, t), sign);
+        wFrom = _mm_mul_ps(wFrom, d);
+
+        for (int c = 0; c < 4; c++)
+            _mm_store_ps(&lanes.fOut[c][i], _mm_add_ps(_mm_mul_ps(from[c], wFrom), _mm_mul_ps(to[c], wTo)));
+    }
+#endif // HAVE_SSE2
+}
@@ -394,6 +394,15 @@ bool plAnimTimeConvert::IsStoppedAt(double wSecs) const
     return IIsStoppedAt(wSecs, state->fFlags, state->fEaseCurve);
 }
 
+bool plAnimTimeConvert::IsCachedAt(double wSecs) const
+{
+    // Mirrors the early out in WorldToAnimTime: we've already been evaluated
+    // at this time, there's no state change to cross and no forced move
+    // callbacks to fire.
+    return wSecs == fLastEvalWorldTime && wSecs >= fLastStateChange &&
+           fLastEvalWorldTime > fLastStateChange && !(fFlags & kForcedMove);
+}
+
 float plAnimTimeConvert::WorldToAnimTime(double wSecs)
 {
     //hsAssert(wSecs >= fLastEvalWorldTime, "Tried to eval a time that's earlier than the last eval time.");
@@ -132,6 +132,7 @@ public:
     bool        IsStoppedAt(double wSecs) const;
     float    WorldToAnimTime(double wSecs);
     float    WorldToAnimTimeNoUpdate(double wSecs) const; // convert time but don't fire triggers or set state
+    bool        IsCachedAt(double wSecs) const; // true if WorldToAnimTime(wSecs) would just return the current time
     
 protected:
     static float IWorldToAnimTimeNoUpdate(double wSecs, plATCState *state);
@@ -48,6 +48,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "hsResMgr.h"
 #include "plIntersect/plClosest.h"
 
+#include <algorithm>
+
 static const float kDefLength = 5.f;
 
 plSphereIsect::plSphereIsect()
@@ -96,6 +98,13 @@ void plSphereIsect::SetTransform(const hsMatrix44& l2w, const hsMatrix44& w2l)
     }
 }
 
+bool plSphereIsect::GetWorldBounds(hsPoint3& mins, hsPoint3& maxs) const
+{
+    mins = fMins;
+    maxs = fMaxs;
+    return true;
+}
+
 // Could use ClosestPoint to find the closest point on the bounds
 // to our center, and do a distance test on that. Would be more
 // accurate than this box test approx, but whatever.
@@ -783,6 +792,12 @@ void plBoundsIsect::SetTransform(const hsMatrix44& l2w, const hsMatrix44& w2l)
 
 plVolumeCullResult plBoundsIsect::Test(const hsBounds3Ext& bnd) const
 {
+    // Two oriented boxes can miss each other without either one's axes showing
+    // it, so check the boxes around them too (see GetWorldBounds).
+    if( (fWorldBounds.GetType() == kBoundsNormal) && (bnd.GetType() == kBoundsNormal)
+        && (fWorldBounds.hsBounds3::TestBound(bnd) < 0) )
+        return kVolumeCulled;
+
     int retVal = fWorldBounds.TestBound(bnd);
     if( retVal < 0 )
         return kVolumeCulled;
@@ -794,6 +809,16 @@ plVolumeCullResult plBoundsIsect::Test(const hsBounds3Ext& bnd) const
     return retVal < 0 ? kVolumeCulled : kVolumeSplit;   
 }
 
+bool plBoundsIsect::GetWorldBounds(hsPoint3& mins, hsPoint3& maxs) const
+{
+    if( fWorldBounds.GetType() != kBoundsNormal )
+        return false;
+
+    mins = fWorldBounds.GetMins();
+    maxs = fWorldBounds.GetMaxs();
+    return true;
+}
+
 float plBoundsIsect::Test(const hsPoint3& pos) const
 {
     hsAssert(false, "Unimplemented");
@@ -877,6 +902,26 @@ plVolumeCullResult plUnionIsect::Test(const hsBounds3Ext& bnd) const
     return retVal;
 }
 
+bool plUnionIsect::GetWorldBounds(hsPoint3& mins, hsPoint3& maxs) const
+{
+    if (fVolumes.empty())
+        return false;
+
+    for (size_t i = 0; i < fVolumes.size(); i++)
+    {
+        hsPoint3 vMins, vMaxs;
+        if (!fVolumes[i]->GetWorldBounds(vMins, vMaxs))
+            return false;
+
+        for (int j = 0; j < 3; j++)
+        {
+            mins[j] = i ? std::min(mins[j], vMins[j]) : vMins[j];
+            maxs[j] = i ? std::max(maxs[j], vMaxs[j]) : vMaxs[j];
+        }
+    }
+    return true;
+}
+
 float plUnionIsect::Test(const hsPoint3& pos) const
 {
     float retVal = 1.e33f;
@@ -915,6 +960,29 @@ plVolumeCullResult plIntersectionIsect::Test(const hsBounds3Ext& bnd) const
     return retVal;
 }
 
+// Any bounded member bounds the whole thing, so clip down to all of them.
+// Bounds only overlap the clipped box if they overlap every member's box, so
+// anything missing it misses a member, and that member culls it. That holds
+// when the result comes out inside out too.
+bool plIntersectionIsect::GetWorldBounds(hsPoint3& mins, hsPoint3& maxs) const
+{
+    bool bounded = false;
+    for (plVolumeIsect* volume : fVolumes)
+    {
+        hsPoint3 vMins, vMaxs;
+        if (!volume->GetWorldBounds(vMins, vMaxs))
+            continue;
+
+        for (int j = 0; j < 3; j++)
+        {
+            mins[j] = bounded ? std::max(mins[j], vMins[j]) : vMins[j];
+            maxs[j] = bounded ? std::min(maxs[j], vMaxs[j]) : vMaxs[j];
+        }
+        bounded = true;
+    }
+    return bounded;
+}
+
 float plIntersectionIsect::Test(const hsPoint3& pos) const
 {
     float retVal = -1.f;
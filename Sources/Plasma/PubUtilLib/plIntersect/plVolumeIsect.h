@@ -70,6 +70,12 @@ public:
     virtual plVolumeCullResult  Test(const hsBounds3Ext& bnd) const = 0;    
     virtual float            Test(const hsPoint3& pos) const = 0;
 
+    // World space box around the volume, for cheap rejection ahead of Test().
+    // Returns false if the volume isn't bounded (or nobody's bothered to say).
+    // Test() must cull any bounds whose box misses this one, so that skipping
+    // Test() on a miss never changes the answer.
+    virtual bool GetWorldBounds(hsPoint3& mins, hsPoint3& maxs) const { return false; }
+
     void Read(hsStream* s, hsResMgr* mgr) override = 0;
     void Write(hsStream* s, hsResMgr* mgr) override = 0;
 };
@@ -97,6 +103,7 @@ public:
 
     plVolumeCullResult  Test(const hsBounds3Ext& bnd) const override;
     float            Test(const hsPoint3& pos) const override; // return 0 if point inside, else "distance" from pos to volume
+    bool GetWorldBounds(hsPoint3& mins, hsPoint3& maxs) const override;
 
     void Read(hsStream* s, hsResMgr* mgr) override;
     void Write(hsStream* s, hsResMgr* mgr) override;
@@ -260,6 +267,7 @@ public:
 
     plVolumeCullResult  Test(const hsBounds3Ext& bnd) const override;
     float            Test(const hsPoint3& pos) const override;
+    bool GetWorldBounds(hsPoint3& mins, hsPoint3& maxs) const override;
 
     void Read(hsStream* s, hsResMgr* mgr) override;
     void Write(hsStream* s, hsResMgr* mgr) override;
@@ -294,6 +302,7 @@ public:
 
     plVolumeCullResult  Test(const hsBounds3Ext& bnd) const override;
     float            Test(const hsPoint3& pos) const override;
+    bool GetWorldBounds(hsPoint3& mins, hsPoint3& maxs) const override;
 };
 
 class plIntersectionIsect : public plComplexIsect
@@ -305,6 +314,7 @@ public:
 
     plVolumeCullResult  Test(const hsBounds3Ext& bnd) const override;
     float            Test(const hsPoint3& pos) const override;
+    bool GetWorldBounds(hsPoint3& mins, hsPoint3& maxs) const override;
 };
 
 #endif // plVolumeIsect_inc
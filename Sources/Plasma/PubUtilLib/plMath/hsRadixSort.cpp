@@ -42,6 +42,11 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "HeadSpin.h"
 #include "hsRadixSort.h"
+#include "hsThreadPool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
 
 hsRadixSort::hsRadixSort() : fList()
 {
@@ -180,3 +185,150 @@ hsRadixSort::Elem* hsRadixSort::Sort(Elem* inList, uint32_t flags)
 
     return fList;
 }
+
+//////////////////////////////////////////////////////////////////////////////
+// hsRadixSortArray
+
+// Turns a key into an unsigned int that sorts the same way, so every
+// flavor can share the one set of byte passes.
+template <typename K>
+static inline K IRadixKey(K bits, uint32_t flags)
+{
+    constexpr K kSignBit = K(1) << (sizeof(K) * 8 - 1);
+
+    if (flags & hsRadixSort::kSignedInt)
+        bits ^= kSignBit;
+    else if (!(flags & hsRadixSort::kUnsigned))
+        bits = (bits & kSignBit) ? ~bits : (bits | kSignBit);
+
+    return bits;
+}
+
+template <typename E, typename K>
+void hsRadixSortArray::ICount(const E* elems, size_t count, uint32_t flags)
+{
+    constexpr size_t kNumPasses = sizeof(K);
+
+    // Not worth waking anyone for less than this each.
+    constexpr size_t kMinChunk = 4096;
+
+    size_t numChunks = 1;
+    if (fParallelThreshold && count >= fParallelThreshold)
+        numChunks = std::clamp<size_t>(count / kMinChunk, 1, hsThreadPool::Instance().GetNumWorkers() + 1);
+
+    // One table per chunk, which get summed into the first.
+    fCounts.assign(numChunks * kNumPasses * 256, 0);
+
+    auto countRange = [this, elems, flags](size_t chunk, size_t begin, size_t end)
+    {
+        uint32_t* counts = fCounts.data() + chunk * kNumPasses * 256;
+        for (size_t i = begin; i < end; i++)
+        {
+            K key = IRadixKey<K>(elems[i].fKey.fUInt, flags);
+            for (size_t pass = 0; pass < kNumPasses; pass++)
+                counts[pass * 256 + ((key >> (pass * 8)) & 0xff)]++;
+        }
+    };
+
+    if (numChunks == 1)
+    {
+        countRange(0, 0, count);
+        return;
+    }
+
+    const size_t chunkSize = (count + numChunks - 1) / numChunks;
+    hsThreadPool::Instance().ParallelFor(numChunks, 1,
+        [&countRange, chunkSize, count](size_t begin, size_t end)
+        {
+            for (size_t chunk = begin; chunk < end; chunk++)
+                countRange(chunk, chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize));
+        });
+
+    uint32_t* total = fCounts.data();
+    for (size_t chunk = 1; chunk < numChunks; chunk++)
+    {
+        const uint32_t* counts = fCounts.data() + chunk * kNumPasses * 256;
+        for (size_t i = 0; i < kNumPasses * 256; i++)
+            total[i] += counts[i];
+    }
+}
+
+template <typename E, typename K>
+void hsRadixSortArray::ISort(E* elems, size_t count, uint32_t flags, std::vector<E>& scratch)
+{
+    static_assert(std::is_trivially_copyable_v<E>, "Radix sort elements get memcpy'd");
+    constexpr size_t kNumPasses = sizeof(K);
+
+    if (count < 2)
+        return;
+
+    hsAssert(count <= 0xffffffff, "Too many elements for the counts");
+
+    ICount<E, K>(elems, count, flags);
+
+    scratch.resize(count);
+    E* src = elems;
+    E* dst = scratch.data();
+
+    const K firstKey = IRadixKey<K>(elems[0].fKey.fUInt, flags);
+    for (size_t pass = 0; pass < kNumPasses; pass++)
+    {
+        uint32_t* counts = fCounts.data() + pass * 256;
+        const size_t shift = pass * 8;
+
+        // Everybody has the same digit here, so this pass wouldn't move anything.
+        if (counts[(firstKey >> shift) & 0xff] == count)
+            continue;
+
+        uint32_t offset = 0;
+        for (size_t i = 0; i < 256; i++)
+        {
+            uint32_t num = counts[i];
+            counts[i] = offset;
+            offset += num;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            K key = IRadixKey<K>(src[i].fKey.fUInt, flags);
+            dst[counts[(key >> shift) & 0xff]++] = src[i];
+        }
+
+        std::swap(src, dst);
+    }
+
+    if (src != elems)
+        memcpy(elems, src, count * sizeof(E));
+
+    // The list sort gets its negative floats in order by reversing them,
+    // and does kReverse by reversing everything, so ties come out of those
+    // backwards. Things like coplanar decals depend on that order.
+    if (!(flags & (hsRadixSort::kSignedInt | hsRadixSort::kUnsigned)))
+    {
+        constexpr K kSignBit = K(1) << (sizeof(K) * 8 - 1);
+
+        // Negatives are all up front now
+        size_t i = 0;
+        while (i < count && (elems[i].fKey.fUInt & kSignBit))
+        {
+            size_t end = i + 1;
+            while (end < count && elems[end].fKey.fUInt == elems[i].fKey.fUInt)
+                end++;
+            std::reverse(elems + i, elems + end);
+            i = end;
+        }
+    }
+
+    if (flags & hsRadixSort::kReverse)
+        std::reverse(elems, elems + count);
+}
+
+void hsRadixSortArray::Sort(Elem32* elems, size_t count, uint32_t flags)
+{
+    ISort<Elem32, uint32_t>(elems, count, flags, fScratch32);
+}
+
+void hsRadixSortArray::Sort(Elem64* elems, size_t count, uint32_t flags)
+{
+    ISort<Elem64, uint64_t>(elems, count, flags, fScratch64);
+}
@@ -43,6 +43,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #ifndef hsRadixSort_inc
 #define hsRadixSort_inc
 
+#include <vector>
+
 class hsRadixSortElem 
 {
 public:
@@ -88,4 +90,70 @@ public:
 
 };
 
+//////////////////////////////////////////////////////////////////////////////
+// LSD radix sort over an array instead of a linked list.
+//
+// Takes the same flags as hsRadixSort, on 32 or 64 bit keys, and leaves
+// equal keys in the same order it does: as they came in, except that ties
+// between negative floats come out backwards, and kReverse flips the lot,
+// ties included. Byte passes where every key has the same digit are
+// skipped, so keys that only use their low bytes are cheap. The scratch buffers are kept between calls,
+// so hang on to one of these for sorts done every frame.
+//
+// Counting the digits is the only pass that can be split up, and for big
+// enough inputs (see SetParallelThreshold) it's done on the thread pool.
+
+class hsRadixSortArray
+{
+public:
+    struct Elem32
+    {
+        union {
+            float       fFloat;
+            int32_t     fInt;
+            uint32_t    fUInt;
+        }                           fKey;
+
+        intptr_t                    fBody;
+    };
+
+    struct Elem64
+    {
+        union {
+            double      fDouble;
+            int64_t     fInt;
+            uint64_t    fUInt;
+        }                           fKey;
+
+        intptr_t                    fBody;
+    };
+
+    enum { kDefaultParallelThreshold = 32768 };
+
+protected:
+    std::vector<Elem32>     fScratch32;
+    std::vector<Elem64>     fScratch64;
+    std::vector<uint32_t>   fCounts;
+    size_t                  fParallelThreshold;
+
+    template <typename E, typename K>
+    void ISort(E* elems, size_t count, uint32_t flags, std::vector<E>& scratch);
+
+    template <typename E, typename K>
+    void ICount(const E* elems, size_t count, uint32_t flags);
+
+public:
+    hsRadixSortArray() : fParallelThreshold(kDefaultParallelThreshold) { }
+
+    void    Sort(Elem32* elems, size_t count, uint32_t flags = 0);
+    void    Sort(Elem64* elems, size_t count, uint32_t flags = 0);
+    void    Sort(std::vector<Elem32>& elems, uint32_t flags = 0) { Sort(elems.data(), elems.size(), flags); }
+    void    Sort(std::vector<Elem64>& elems, uint32_t flags = 0) { Sort(elems.data(), elems.size(), flags); }
+
+    // Inputs with at least this many elements count their digits in
+    // parallel. Zero turns that off.
+    void    SetParallelThreshold(size_t n) { fParallelThreshold = n; }
+    size_t  GetParallelThreshold() const { return fParallelThreshold; }
+};
+
 #endif // hsRadixSort_inc
@@ -40,6 +40,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 *==LICENSE==*/
 #include "plPXPhysical.h"
+#include "plPXSimulation.h"
 #include "plPXSubWorld.h"
 #include "plSimulationMgr.h"
 
@@ -105,7 +106,7 @@ PhysRecipe::~PhysRecipe()
 }
 
 plPXPhysical::plPXPhysical()
-    : fActor(), fGroup(plSimDefs::kGroupMax), fReportsOn(), fLOSDBs(plSimDefs::kLOSDBNone),
+    : fActor(), fInitPending(), fGroup(plSimDefs::kGroupMax), fReportsOn(), fLOSDBs(plSimDefs::kLOSDBNone),
       fLastSyncTime(), fSDLMod(), fSndGroup()
 {
 }
@@ -128,6 +129,8 @@ bool plPXPhysical::MsgReceive( plMessage* msg )
     if (plGenRefMsg *refM = plGenRefMsg::ConvertNoRef(msg)) {
         return HandleRefMsg(refM);
     } else if (plSimulationMsg *simM = plSimulationMsg::ConvertNoRef(msg)) {
+        FinishCooking();
+
         plLinearVelocityMsg* velMsg = plLinearVelocityMsg::ConvertNoRef(msg);
         if (velMsg) {
             SetLinearVelocitySim(velMsg->Velocity());
@@ -237,6 +240,7 @@ bool plPXPhysical::HandleRefMsg(plGenRefMsg* refMsg)
 
 void plPXPhysical::GetTransform(hsMatrix44& l2w, hsMatrix44& w2l)
 {
+    FinishCooking();
     IGetTransformGlobal(l2w);
     l2w.GetInverse(&w2l);
 }
@@ -374,15 +378,20 @@ void plPXPhysical::Read(hsStream* stream, hsResMgr* mgr)
         fRecipe.bDimensions.Read(stream);
         fRecipe.bOffset.Read(stream);
     } else if (fBounds == plSimDefs::kHullBounds) {
-        fRecipe.convexMesh = ICookHull(stream);
+        IStartCooking(stream, true);
     } else {
-        fRecipe.triMesh = ICookTriMesh(stream);
+        IStartCooking(stream, false);
     }
 
     // If we do not have a world specified, we go ahead and init into the main world...
-    // This will been done in MsgReceive otherwise
-    if (!fRecipe.worldKey)
-        InitActor();
+    // This will been done in MsgReceive otherwise. Meshes are cooked in the background
+    // while the rest of the page loads, so those actors wait until someone needs them.
+    if (!fRecipe.worldKey) {
+        if (fCookJob)
+            fInitPending = true;
+        else
+            InitActor();
+    }
     InitProxy();
 }
 
@@ -438,6 +447,7 @@ bool plPXPhysical::DirtySynchState(const ST::string& SDLStateName, uint32_t sync
 
 void plPXPhysical::GetSyncState(hsPoint3& pos, hsQuat& rot, hsVector3& linV, hsVector3& angV)
 {
+    FinishCooking();
     IGetPoseSim(pos, rot);
     GetLinearVelocitySim(linV);
     GetAngularVelocitySim(angV);
@@ -445,6 +455,7 @@ void plPXPhysical::GetSyncState(hsPoint3& pos, hsQuat& rot, hsVector3& linV, hsV
 
 void plPXPhysical::SetSyncState(hsPoint3* pos, hsQuat* rot, hsVector3* linV, hsVector3* angV)
 {
+    FinishCooking();
     bool isLoading = plNetClientApp::GetInstance()->IsLoadingInitialAgeState();
     bool isFirstIn = plNetClientApp::GetInstance()->GetJoinOrder() == 0;
     bool initialSync = isLoading && isFirstIn;
@@ -470,6 +481,7 @@ void plPXPhysical::SetSyncState(hsPoint3* pos, hsQuat* rot, hsVector3* linV, hsV
 
 void plPXPhysical::ResetSyncState()
 {
+    FinishCooking();
     if (fSDLMod) {
         hsVector3 zero;
         bool wakeup = GetProperty(plSimulationInterface::kStartInactive);
@@ -488,6 +500,7 @@ void plPXPhysical::ResetSyncState()
 
 void plPXPhysical::SendNewLocation(bool synchTransform, bool isSynchUpdate)
 {
+    FinishCooking();
     // Called after the simulation has run....sends new positions to the various scene objects
     // *** want to do this in response to an update message....
     if (CanSynchPosition(isSynchUpdate)) {
@@ -528,6 +541,7 @@ void plPXPhysical::SetTransform(const hsMatrix44& l2w, const hsMatrix44& w2l, bo
     //  make sure there is some difference between the matrices...
     // ... but not when a subworld... because the subworld may be animating and if the object is still then it is actually moving within the subworld
     if (force || (!IsStatic() && (fWorldKey || !l2w.Compare(fCachedLocal2World, .0001f)))) {
+        FinishCooking();
         ISetTransformGlobal(l2w);
         plProfile_Inc(SetTransforms);
     }
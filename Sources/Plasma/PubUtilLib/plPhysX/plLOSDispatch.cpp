@@ -42,6 +42,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "plLOSDispatch.h"
 
+#include <algorithm>
+
 #include "plgDispatch.h"
 #include "plProfile.h"
 
@@ -58,6 +60,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plStatusLog/plStatusLog.h"
 
 plProfile_CreateTimer("LineOfSight", "Simulation", LineOfSight);
+plProfile_CreateCounter("  LOS Requests", "Simulation", LOSRequests);
+plProfile_CreateCounter("  LOS Batches", "Simulation", LOSBatches);
 
 plLOSDispatch::plLOSDispatch()
     : fDebugDisplay()
@@ -69,6 +73,9 @@ plLOSDispatch::plLOSDispatch()
 
 plLOSDispatch::~plLOSDispatch()
 {
+    for (const PendingRequest& request : fPending)
+        hsRefCnt_SafeUnRef(request.fMsg);
+
     plgDispatch::Dispatch()->UnRegisterForExactType(plLOSRequestMsg::Index(), GetKey());
     plgDispatch::Dispatch()->UnRegisterForExactType(plRenderMsg::Index(), GetKey());
 }
@@ -77,8 +84,7 @@ bool plLOSDispatch::MsgReceive(plMessage* msg)
 {
     plLOSRequestMsg* requestMsg = plLOSRequestMsg::ConvertNoRef(msg);
     if (requestMsg) {
-        plProfile_BeginTiming(LineOfSight);
-
+        // The subworld is decided now, while the local avatar is where the sender expects.
         plKey worldKey = requestMsg->fWorldKey;
         if (!worldKey) {
             plArmatureMod* av = plAvatarMgr::GetInstance()->GetLocalAvatar();
@@ -86,34 +92,14 @@ bool plLOSDispatch::MsgReceive(plMessage* msg)
                 worldKey = av->GetController()->GetSubworld();
         }
 
-        auto result = IRaycast(requestMsg->fFrom, requestMsg->fTo, worldKey, requestMsg->fRequestType,
-                               requestMsg->GetTestType() == plLOSRequestMsg::kTestClosest,
-                               requestMsg->GetCullDB());
-        if (result.fResult == LOSResult::kHit &&
-            (requestMsg->GetReportType() == plLOSRequestMsg::kReportHit ||
-             requestMsg->GetReportType() == plLOSRequestMsg::kReportHitOrMiss)) {
-            plLOSHitMsg* hitMsg = new plLOSHitMsg(GetKey(), requestMsg->GetSender(), requestMsg->fRequestID);
-            hitMsg->fObj = result.fHitObj;
-            hitMsg->fHitPoint = result.fPoint;
-            hitMsg->fNormal = result.fNormal;
-            hitMsg->fDistance = result.fDistance;
-            hitMsg->Send();
-        } else if (result.fResult != LOSResult::kHit &&
-                   (requestMsg->GetReportType() == plLOSRequestMsg::kReportMiss ||
-                    requestMsg->GetReportType() == plLOSRequestMsg::kReportHitOrMiss)) {
-            plLOSHitMsg* missMsg = new plLOSHitMsg(GetKey(), requestMsg->GetSender(), requestMsg->fRequestID);
-            missMsg->fNoHit = true;
-            // Don't leak out any internal state, just report a miss.
-            missMsg->Send();
-        }
-
-        fRequests.emplace_back(requestMsg->GetRequestName(), requestMsg->GetRequestID(), result.fResult);
-
-        plProfile_EndTiming(LineOfSight);
+        hsRefCnt_SafeRef(requestMsg);
+        fPending.emplace_back(requestMsg, std::move(worldKey));
         return true;
     }
 
     if (plRenderMsg::ConvertNoRef(msg)) {
+        ProcessRequests();
+
         if (!fDebugDisplay) {
             fDebugDisplay = plStatusLogMgr::GetInstance().CreateStatusLog(32, "Line of Sight",
                                                                           plStatusLog::kDontWriteFile |
@@ -160,6 +146,74 @@ bool plLOSDispatch::MsgReceive(plMessage* msg)
     return hsKeyedObject::MsgReceive(msg);
 }
 
+void plLOSDispatch::ProcessRequests()
+{
+    if (fPending.empty())
+        return;
+
+    plProfile_BeginTiming(LineOfSight);
+
+    // Sending the replies may well cause more requests to come in, so take ownership of
+    // everything we have so far.
+    std::vector<PendingRequest> pending;
+    pending.swap(fPending);
+
+    std::vector<RaycastQuery> queries;
+    queries.reserve(pending.size());
+    for (const PendingRequest& request : pending) {
+        plLOSRequestMsg* msg = request.fMsg;
+        queries.emplace_back(msg->fFrom, msg->fTo, msg->fRequestType, msg->GetCullDB(),
+                             msg->GetTestType() == plLOSRequestMsg::kTestClosest);
+    }
+
+    // There are only ever a handful of subworlds in play, so a linear search is fine.
+    std::vector<plKey> worlds;
+    std::vector<std::vector<RaycastQuery*>> batches;
+    for (size_t i = 0; i < pending.size(); ++i) {
+        auto it = std::find(worlds.begin(), worlds.end(), pending[i].fWorld);
+        if (it == worlds.end()) {
+            worlds.push_back(pending[i].fWorld);
+            batches.emplace_back();
+            it = worlds.end() - 1;
+        }
+        batches[it - worlds.begin()].push_back(&queries[i]);
+    }
+
+    for (size_t i = 0; i < worlds.size(); ++i)
+        IRaycastBatch(worlds[i], batches[i]);
+
+    // Reply in the order the requests arrived.
+    for (size_t i = 0; i < pending.size(); ++i) {
+        plLOSRequestMsg* requestMsg = pending[i].fMsg;
+        const RaycastResult& result = queries[i].fResult;
+
+        if (result.fResult == LOSResult::kHit &&
+            (requestMsg->GetReportType() == plLOSRequestMsg::kReportHit ||
+             requestMsg->GetReportType() == plLOSRequestMsg::kReportHitOrMiss)) {
+            plLOSHitMsg* hitMsg = new plLOSHitMsg(GetKey(), requestMsg->GetSender(), requestMsg->fRequestID);
+            hitMsg->fObj = result.fHitObj;
+            hitMsg->fHitPoint = result.fPoint;
+            hitMsg->fNormal = result.fNormal;
+            hitMsg->fDistance = result.fDistance;
+            hitMsg->Send();
+        } else if (result.fResult != LOSResult::kHit &&
+                   (requestMsg->GetReportType() == plLOSRequestMsg::kReportMiss ||
+                    requestMsg->GetReportType() == plLOSRequestMsg::kReportHitOrMiss)) {
+            plLOSHitMsg* missMsg = new plLOSHitMsg(GetKey(), requestMsg->GetSender(), requestMsg->fRequestID);
+            missMsg->fNoHit = true;
+            // Don't leak out any internal state, just report a miss.
+            missMsg->Send();
+        }
+
+        fRequests.emplace_back(requestMsg->GetRequestName(), requestMsg->GetRequestID(), result.fResult);
+        hsRefCnt_SafeUnRef(requestMsg);
+    }
+
+    plProfile_IncCount(LOSRequests, pending.size());
+    plProfile_IncCount(LOSBatches, worlds.size());
+    plProfile_EndTiming(LineOfSight);
+}
+
 bool plLOSDispatch::ITestHit(const plSceneObject* so) const
 {
     for (size_t i = 0; i < so->GetNumModifiers(); ++i) {
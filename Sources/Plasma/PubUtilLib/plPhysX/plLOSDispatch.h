@@ -42,6 +42,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #ifndef plLOSDispatch_H
 #define plLOSDispatch_H
 
+#include <cfloat>
 #include <vector>
 #include <string_theory/string>
 
@@ -88,8 +89,19 @@ private:
         { }
     };
 
+    struct PendingRequest
+    {
+        plLOSRequestMsg* fMsg;
+        plKey fWorld;
+
+        PendingRequest(plLOSRequestMsg* msg, plKey world)
+            : fMsg(msg), fWorld(std::move(world))
+        { }
+    };
+
     plStatusLog* fDebugDisplay;
     std::vector<LOSRequest> fRequests;
+    std::vector<PendingRequest> fPending;
 
 public:
     plLOSDispatch();
@@ -100,6 +112,13 @@ public:
 
     bool MsgReceive(plMessage* msg) override;
 
+    /**
+     * Runs every request received since the last call and sends out the replies.
+     * Requests are queued up as they arrive so that they can be grouped by subworld and
+     * executed together. This is called before each simulation step and before rendering.
+     */
+    void ProcessRequests();
+
 protected:
     bool ITestHit(const plSceneObject* obj) const;
 
@@ -118,8 +137,27 @@ protected:
         { }
     };
 
-    RaycastResult IRaycast(hsPoint3 origin, hsPoint3 destination, const plKey& world, plSimDefs::plLOSDB db,
-                           bool closest, plSimDefs::plLOSDB cullDB = plSimDefs::kLOSDBNone);
+    struct RaycastQuery
+    {
+        hsPoint3 fFrom;
+        hsPoint3 fTo;
+        plSimDefs::plLOSDB fDB;
+        plSimDefs::plLOSDB fCullDB;
+        bool fClosest;
+        RaycastResult fResult;
+
+        RaycastQuery(const hsPoint3& from, const hsPoint3& to, plSimDefs::plLOSDB db,
+                     plSimDefs::plLOSDB cullDB, bool closest)
+            : fFrom(from), fTo(to), fDB(db), fCullDB(cullDB), fClosest(closest),
+              fResult(LOSResult::kMiss, nullptr, { 0.f, 0.f, 0.f }, { 0.f, 0.f, 0.f }, FLT_MAX)
+        { }
+    };
+
+    /**
+     * Runs a batch of raycasts against a single subworld.
+     * The queries are given in worldspace, as are the results.
+     */
+    void IRaycastBatch(const plKey& world, const std::vector<RaycastQuery*>& queries);
 };
 
 #endif
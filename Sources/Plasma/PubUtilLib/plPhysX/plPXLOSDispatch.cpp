@@ -56,90 +56,77 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 // ==========================================================================
 
-plLOSDispatch::RaycastResult plLOSDispatch::IRaycast(hsPoint3 origin, hsPoint3 destination,
-                                                     const plKey& world, plSimDefs::plLOSDB db,
-                                                     bool closest, plSimDefs::plLOSDB cullDB)
+class plPXRaycastQueryFilter : public physx::PxQueryFilterCallback
 {
-    RaycastResult result(LOSResult::kMiss, nullptr, { 0.f, 0.f, 0.f }, { 0.f, 0.f, 0.f }, FLT_MAX);
+    plLOSDispatch* fDispatch;
+    plSimDefs::plLOSDB fCullDB;
 
-    plPXSimulation* sim = plSimulationMgr::GetInstance()->GetPhysX();
-    physx::PxScene* scene = sim->FindScene(world);
-    if (!scene)
-        return result;
+public:
+    plPXRaycastQueryFilter(plLOSDispatch* self)
+        : fDispatch(self), fCullDB(plSimDefs::kLOSDBNone)
+    { }
 
-    // The raycast comes in as worldspace, but if the player is in a subworld, we'll need
-    // to convert it to subworld space.
-    hsMatrix44 l2w;
-    l2w.Reset();
-    if (world) {
-        if (plSceneObject* so = plSceneObject::ConvertNoRef(world->ObjectIsLoaded())) {
-            l2w = so->GetLocalToWorld();
-            origin = so->GetWorldToLocal() * origin;
-            destination = so->GetWorldToLocal() * destination;
+    void SetCullDB(plSimDefs::plLOSDB cullDB) { fCullDB = cullDB; }
+
+    physx::PxQueryHitType::Enum preFilter(const physx::PxFilterData& filterData,
+                                          const physx::PxShape* shape,
+                                          const physx::PxRigidActor* actor,
+                                          physx::PxHitFlags& queryFlags) override
+    {
+        auto data = static_cast<plPXActorData*>(actor->userData);
+        if (!data)
+            return physx::PxQueryHitType::eNONE;
+
+        // Disabled physicals aren't hit.
+        if (data->GetPhysical() && data->GetPhysical()->GetProperty(plSimulationInterface::kDisable))
+            return physx::PxQueryHitType::eNONE;
+        if (data->GetController() && !data->GetController()->IsEnabled())
+            return physx::PxQueryHitType::eNONE;
+
+        if (plSceneObject* so = plSceneObject::ConvertNoRef(data->GetKey()->ObjectIsLoaded())){
+            if (!fDispatch->ITestHit(so))
+                return physx::PxQueryHitType::eNONE;
         }
+
+        // Ensures all hits are returned.
+        return physx::PxQueryHitType::eTOUCH;
     }
 
-    hsVector3 direction = hsVector3(destination - origin);
-    float magnitude = direction.Magnitude();
-    if (magnitude <= 0.f)
-        return result;
-    direction.Normalize();
-
-    plPXFilterData data;
-    data.SetLOSDBs((plSimDefs::plLOSDB)((physx::PxU32)db | (physx::PxU32)cullDB));
-    physx::PxQueryFilterData filter(data, physx::PxQueryFlag::eSTATIC |
-                                          physx::PxQueryFlag::eDYNAMIC |
-                                          physx::PxQueryFlag::ePREFILTER |
-                                          physx::PxQueryFlag::ePOSTFILTER);
-    if (!closest)
-        filter.flags |= physx::PxQueryFlag::eANY_HIT;
-
-    class plPXRaycastQueryFilter : public physx::PxQueryFilterCallback
+    physx::PxQueryHitType::Enum postFilter(const physx::PxFilterData& filterData,
+                                           const physx::PxQueryHit& hit) override
     {
-        plLOSDispatch* fDispatch;
-        plSimDefs::plLOSDB fCullDB;
-
-    public:
-        plPXRaycastQueryFilter(plLOSDispatch* self, plSimDefs::plLOSDB cullDB)
-            : fDispatch(self), fCullDB(cullDB)
-        { }
+        // If we are culling the LOS hits, any cull hit should prevent touches beyond that hit.
+        if (fCullDB != plSimDefs::kLOSDBNone) {
+            if (static_cast<const plPXFilterData&>(filterData).TestLOSDBs(fCullDB))
+                return physx::PxQueryHitType::eBLOCK;
+        }
 
-        physx::PxQueryHitType::Enum preFilter(const physx::PxFilterData& filterData,
-                                              const physx::PxShape* shape,
-                                              const physx::PxRigidActor* actor,
-                                              physx::PxHitFlags& queryFlags) override
-        {
-            auto data = static_cast<plPXActorData*>(actor->userData);
-            if (!data)
-                return physx::PxQueryHitType::eNONE;
+        return physx::PxQueryHitType::eTOUCH;
+    }
+};
 
-            // Disabled physicals aren't hit.
-            if (data->GetPhysical() && data->GetPhysical()->GetProperty(plSimulationInterface::kDisable))
-                return physx::PxQueryHitType::eNONE;
-            if (data->GetController() && !data->GetController()->IsEnabled())
-                return physx::PxQueryHitType::eNONE;
+// ==========================================================================
 
-            if (plSceneObject* so = plSceneObject::ConvertNoRef(data->GetKey()->ObjectIsLoaded())){
-                if (!fDispatch->ITestHit(so))
-                    return physx::PxQueryHitType::eNONE;
-            }
+void plLOSDispatch::IRaycastBatch(const plKey& world, const std::vector<RaycastQuery*>& queries)
+{
+    plPXSimulation* sim = plSimulationMgr::GetInstance()->GetPhysX();
+    physx::PxScene* scene = sim->FindScene(world);
+    if (!scene)
+        return;
 
-            // Ensures all hits are returned.
-            return physx::PxQueryHitType::eTOUCH;
+    // The raycasts come in as worldspace, but if the player is in a subworld, we'll need
+    // to convert them to subworld space.
+    hsMatrix44 l2w, w2l;
+    l2w.Reset();
+    w2l.Reset();
+    if (world) {
+        if (plSceneObject* so = plSceneObject::ConvertNoRef(world->ObjectIsLoaded())) {
+            l2w = so->GetLocalToWorld();
+            w2l = so->GetWorldToLocal();
         }
+    }
 
-        physx::PxQueryHitType::Enum postFilter(const physx::PxFilterData& filterData,
-                                               const physx::PxQueryHit& hit) override
-        {
-            // If we are culling the LOS hits, any cull hit should prevent touches beyond that hit.
-            if (fCullDB != plSimDefs::kLOSDBNone) {
-                if (static_cast<const plPXFilterData&>(filterData).TestLOSDBs(fCullDB))
-                    return physx::PxQueryHitType::eBLOCK;
-            }
-
-            return physx::PxQueryHitType::eTOUCH;
-        }
-    } filterCallback(this, cullDB);
+    plPXRaycastQueryFilter filterCallback(this);
 
     class plPXRaycastCallback : public physx::PxRaycastCallback
     {
@@ -195,18 +182,41 @@ plLOSDispatch::RaycastResult plLOSDispatch::IRaycast(hsPoint3 origin, hsPoint3 d
                 fResult.fDistance = block.distance;
             }
         }
-    } raycast(result, cullDB);
-
-    bool hit = scene->raycast(plPXConvert::Point(origin),
-                              plPXConvert::Vector(direction),
-                              magnitude, raycast,
-                              (physx::PxHitFlag::ePOSITION | physx::PxHitFlag::eNORMAL),
-                              filter, &filterCallback);
-
-    // Convert back to worldspace
-    if (hit) {
-        result.fPoint = l2w * result.fPoint;
-        result.fNormal = l2w * result.fNormal;
+    };
+
+    for (RaycastQuery* query : queries) {
+        RaycastResult& result = query->fResult;
+        hsPoint3 origin = w2l * query->fFrom;
+        hsPoint3 destination = w2l * query->fTo;
+
+        hsVector3 direction = hsVector3(destination - origin);
+        float magnitude = direction.Magnitude();
+        if (magnitude <= 0.f)
+            continue;
+        direction.Normalize();
+
+        plPXFilterData data;
+        data.SetLOSDBs((plSimDefs::plLOSDB)((physx::PxU32)query->fDB | (physx::PxU32)query->fCullDB));
+        physx::PxQueryFilterData filter(data, physx::PxQueryFlag::eSTATIC |
+                                              physx::PxQueryFlag::eDYNAMIC |
+                                              physx::PxQueryFlag::ePREFILTER |
+                                              physx::PxQueryFlag::ePOSTFILTER);
+        if (!query->fClosest)
+            filter.flags |= physx::PxQueryFlag::eANY_HIT;
+
+        filterCallback.SetCullDB(query->fCullDB);
+        plPXRaycastCallback raycast(result, query->fCullDB);
+
+        bool hit = scene->raycast(plPXConvert::Point(origin),
+                                  plPXConvert::Vector(direction),
+                                  magnitude, raycast,
+                                  (physx::PxHitFlag::ePOSITION | physx::PxHitFlag::eNORMAL),
+                                  filter, &filterCallback);
+
+        // Convert back to worldspace
+        if (hit) {
+            result.fPoint = l2w * result.fPoint;
+            result.fNormal = l2w * result.fNormal;
+        }
     }
-    return result;
 }
@@ -0,0 +1,309 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "plPXMeshCache.h"
+
+#include "hsGeometry3.h"
+#include "hsLockGuard.h"
+#include "hsStream.h"
+
+#include "pnEncryption/plChecksum.h"
+
+#include "plStatusLog/plStatusLog.h"
+
+#include <algorithm>
+#include <ctime>
+#include <string_theory/format>
+
+#if HS_BUILD_FOR_WIN32
+#   include <process.h>
+#else
+#   include <unistd.h>
+#endif
+
+// ==========================================================================
+
+/** Bump this whenever the layout of a cache entry or its key changes. */
+constexpr uint32_t kMeshCacheFormat = 1;
+
+/** Once over budget, the cache is trimmed down to this fraction of it to avoid thrashing. */
+constexpr uint64_t kMeshCacheTrimNum = 3;
+constexpr uint64_t kMeshCacheTrimDen = 4;
+
+/** Temporaries older than this (in seconds) belong to a store that will never finish. */
+constexpr uint64_t kMeshCacheStaleTmpAge = 60 * 60;
+
+static const char kMeshCacheMagic[] = { 'P', 'X', 'M', 'C' };
+constexpr uint32_t kMeshCacheHeaderSize = sizeof(kMeshCacheMagic) + sizeof(uint32_t) * 3;
+
+// ==========================================================================
+
+plPXMeshCache::plPXMeshCache(plFileName dir, uint32_t sdkVersion, uint64_t budget)
+    : fDir(std::move(dir)), fSdkVersion(sdkVersion), fBudget(budget), fSize(),
+      fHits(), fMisses()
+{
+    plFileSystem::CreateDir(fDir, true);
+    IScan();
+    if (fSize > fBudget)
+        ITrim();
+}
+
+plFileName plPXMeshCache::IGetPath(const ST::string& key) const
+{
+    return plFileName::Join(fDir, ST::format("{}.pxm", key));
+}
+
+void plPXMeshCache::IScan()
+{
+    // Anything left over from a store that was interrupted is garbage, but a recent temporary
+    // may still be being written by another client sharing the user data directory.
+    uint64_t now = uint64_t(time(nullptr));
+    for (const plFileName& tmp : plFileSystem::ListDir(fDir, "*.tmp")) {
+        if (plFileInfo(tmp).ModifyTime() + kMeshCacheStaleTmpAge < now)
+            plFileSystem::Unlink(tmp);
+    }
+
+    fSize = 0;
+    for (const plFileName& entry : plFileSystem::ListDir(fDir, "*.pxm"))
+        fSize += plFileInfo(entry).FileSize();
+}
+
+// ==========================================================================
+
+ST::string plPXMeshCache::MakeKey(Kind kind, const std::vector<uint32_t>& tris,
+                                  const std::vector<hsPoint3>& verts,
+                                  const void* params, size_t paramsSize) const
+{
+    uint32_t header[] = {
+        kMeshCacheFormat,
+        fSdkVersion,
+        uint32_t(kind),
+        uint32_t(tris.size()),
+        uint32_t(verts.size()),
+    };
+
+    plChecksum sum(plChecksum::Type::kSHA1);
+    sum.Start();
+    sum.AddTo(sizeof(header), reinterpret_cast<const uint8_t*>(header));
+    sum.AddTo(paramsSize, reinterpret_cast<const uint8_t*>(params));
+    if (!tris.empty())
+        sum.AddTo(tris.size() * sizeof(uint32_t), reinterpret_cast<const uint8_t*>(tris.data()));
+    if (!verts.empty())
+        sum.AddTo(verts.size() * sizeof(hsPoint3), reinterpret_cast<const uint8_t*>(verts.data()));
+    sum.Finish();
+    return sum.GetAsHexString();
+}
+
+bool plPXMeshCache::Contains(const ST::string& key) const
+{
+    return plFileInfo(IGetPath(key)).Exists();
+}
+
+bool plPXMeshCache::Find(const ST::string& key, std::vector<uint8_t>& data)
+{
+    plFileName path = IGetPath(key);
+
+    bool valid = false;
+    bool exists;
+    {
+        hsUNIXStream s;
+        exists = s.Open(path, "rb");
+
+        // Don't let a truncated entry throw out of the header reads.
+        if (exists && s.GetEOF() >= kMeshCacheHeaderSize) {
+            char magic[sizeof(kMeshCacheMagic)];
+            s.Read(sizeof(magic), magic);
+            uint32_t format = s.ReadLE32();
+            uint32_t sdkVersion = s.ReadLE32();
+            uint32_t size = s.ReadLE32();
+
+            if (memcmp(magic, kMeshCacheMagic, sizeof(magic)) == 0 &&
+                format == kMeshCacheFormat && sdkVersion == fSdkVersion &&
+                size == s.GetEOF() - kMeshCacheHeaderSize) {
+                data.resize(size);
+                valid = s.Read(size, data.data()) == size;
+            }
+        }
+    }
+
+    hsLockGuard(fLock);
+    if (valid) {
+        fHits++;
+        return true;
+    }
+
+    if (exists) {
+        plStatusLog::AddLineSF("Simulation.log", plStatusLog::kYellow,
+                               "Discarding stale cooked mesh '{}'", key);
+        IRemove(key);
+    }
+    data.clear();
+    fMisses++;
+    return false;
+}
+
+void plPXMeshCache::Store(const ST::string& key, const uint8_t* data, size_t size)
+{
+#if HS_BUILD_FOR_WIN32
+    int pid = _getpid();
+#else
+    int pid = getpid();
+#endif
+
+    plFileName path = IGetPath(key);
+    plFileName tmp = ST::format("{}.{}.tmp", path, pid);
+
+    // Identical meshes may be cooked by several workers at once, so only one gets to write.
+    hsLockGuard(fLock);
+
+    // Write to a temporary and rename it into place so that a crash (or another client sharing
+    // the same user data directory) never sees a partial entry. The temporary is named for this
+    // process so that two clients storing the same mesh don't write into one file.
+    {
+        hsUNIXStream s;
+        if (!s.Open(tmp, "wb")) {
+            plStatusLog::AddLineSF("Simulation.log", plStatusLog::kRed,
+                                   "Failed to create cooked mesh cache entry '{}'", tmp);
+            return;
+        }
+
+        s.Write(sizeof(kMeshCacheMagic), kMeshCacheMagic);
+        s.WriteLE32(kMeshCacheFormat);
+        s.WriteLE32(fSdkVersion);
+        s.WriteLE32(uint32_t(size));
+        s.Write(size, data);
+    }
+
+    plFileInfo existing(path);
+    bool unlinked = existing.Exists() && plFileSystem::Unlink(path);
+    if (unlinked)
+        fSize -= std::min<uint64_t>(fSize, existing.FileSize());
+    if (!plFileSystem::Move(tmp, path)) {
+        plFileSystem::Unlink(tmp);
+        return;
+    }
+
+    // If the old entry couldn't be removed up front, the move has replaced it.
+    if (existing.Exists() && !unlinked)
+        fSize -= std::min<uint64_t>(fSize, existing.FileSize());
+
+    fSize += kMeshCacheHeaderSize + size;
+    if (fSize > fBudget)
+        ITrim();
+}
+
+void plPXMeshCache::Remove(const ST::string& key)
+{
+    hsLockGuard(fLock);
+    IRemove(key);
+}
+
+void plPXMeshCache::IRemove(const ST::string& key)
+{
+    plFileName path = IGetPath(key);
+    plFileInfo info(path);
+    if (info.Exists() && plFileSystem::Unlink(path))
+        fSize -= std::min<uint64_t>(fSize, info.FileSize());
+}
+
+void plPXMeshCache::Trim()
+{
+    hsLockGuard(fLock);
+    ITrim();
+}
+
+void plPXMeshCache::SetBudget(uint64_t budget)
+{
+    hsLockGuard(fLock);
+    fBudget = budget;
+    ITrim();
+}
+
+void plPXMeshCache::ITrim()
+{
+    struct Entry
+    {
+        plFileName fPath;
+        uint64_t fTime;
+        uint64_t fSize;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    for (plFileName& path : plFileSystem::ListDir(fDir, "*.pxm")) {
+        plFileInfo info(path);
+        entries.push_back({ std::move(path), info.ModifyTime(), uint64_t(info.FileSize()) });
+        total += info.FileSize();
+    }
+
+    uint64_t target = fBudget / kMeshCacheTrimDen * kMeshCacheTrimNum;
+    if (total > fBudget) {
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.fTime < b.fTime;
+        });
+
+        size_t evicted = 0;
+        for (const Entry& entry : entries) {
+            if (total <= target)
+                break;
+            if (plFileSystem::Unlink(entry.fPath)) {
+                total -= entry.fSize;
+                evicted++;
+            }
+        }
+
+        plStatusLog::AddLineSF("Simulation.log", "Evicted {} cooked meshes from the cache, {} remain",
+                               evicted, plFileSystem::ConvertFileSize(total));
+    }
+
+    fSize = total;
+}
+
+void plPXMeshCache::Clear()
+{
+    hsLockGuard(fLock);
+    fSize = 0;
+    for (const plFileName& entry : plFileSystem::ListDir(fDir, "*.pxm")) {
+        if (!plFileSystem::Unlink(entry))
+            fSize += plFileInfo(entry).FileSize();
+    }
+}
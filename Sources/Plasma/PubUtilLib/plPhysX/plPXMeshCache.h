@@ -0,0 +1,139 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+#ifndef plPXMeshCache_h_inc
+#define plPXMeshCache_h_inc
+
+#include "plFileSystem.h"
+
+#include <mutex>
+#include <string_theory/string>
+#include <vector>
+
+struct hsPoint3;
+
+/**
+ * On-disk cache of cooked PhysX meshes.
+ * Cooking a mesh is by far the most expensive part of loading a physical, and the result only
+ * depends on the source geometry, the cooking parameters, and the SDK version. Cooked meshes are
+ * stored in the user data directory under a hash of all of those inputs so that subsequent loads
+ * can skip straight to inserting the mesh into the simulation.
+ * All methods may be called from any thread.
+ */
+class plPXMeshCache
+{
+public:
+    enum class Kind : uint8_t
+    {
+        kConvexHull,
+        kTriangleMesh,
+    };
+
+    /** Default maximum size of the cache on disk. */
+    static constexpr uint64_t kDefaultBudget = 256 * 1024 * 1024;
+
+protected:
+    plFileName fDir;
+    uint32_t fSdkVersion;
+    uint64_t fBudget;
+    uint64_t fSize;
+    uint32_t fHits;
+    uint32_t fMisses;
+    std::mutex fLock;
+
+    plFileName IGetPath(const ST::string& key) const;
+    void IScan();
+    void IRemove(const ST::string& key);
+    void ITrim();
+
+public:
+    /**
+     * Opens the cache in the given directory.
+     * \param sdkVersion The version of the PhysX SDK that produced the cooked data. Entries
+     *                   cooked by any other version are discarded as they are encountered.
+     */
+    plPXMeshCache(plFileName dir, uint32_t sdkVersion, uint64_t budget=kDefaultBudget);
+
+    /**
+     * Computes the cache key for a mesh.
+     * \param params Raw bytes of whatever cooking state affects the output.
+     */
+    [[nodiscard]]
+    ST::string MakeKey(Kind kind, const std::vector<uint32_t>& tris, const std::vector<hsPoint3>& verts,
+                       const void* params, size_t paramsSize) const;
+
+    /** Tests whether a cooked mesh is present without loading it. */
+    [[nodiscard]]
+    bool Contains(const ST::string& key) const;
+
+    /** Loads a cooked mesh from the cache. */
+    bool Find(const ST::string& key, std::vector<uint8_t>& data);
+
+    /** Saves a cooked mesh into the cache, evicting old entries if the cache is over budget. */
+    void Store(const ST::string& key, const uint8_t* data, size_t size);
+
+    /** Removes a single entry, eg because PhysX rejected its contents. */
+    void Remove(const ST::string& key);
+
+    /** Evicts the least recently written entries until the cache fits in its budget. */
+    void Trim();
+
+    /** Removes every entry from the cache. */
+    void Clear();
+
+    [[nodiscard]]
+    const plFileName& GetDirectory() const { return fDir; }
+
+    [[nodiscard]]
+    uint64_t GetSize() const { return fSize; }
+
+    [[nodiscard]]
+    uint64_t GetBudget() const { return fBudget; }
+    void SetBudget(uint64_t budget);
+
+    [[nodiscard]]
+    uint32_t GetHits() const { return fHits; }
+
+    [[nodiscard]]
+    uint32_t GetMisses() const { return fMisses; }
+};
+
+#endif
@@ -53,6 +53,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "hsStream.h"
 #include "hsQuat.h"
 
+#include "pnKeyedObject/plUoid.h"
+#include "pnMessage/plMessage.h"
 #include "pnMessage/plNodeRefMsg.h"
 #include "pnMessage/plSDLModifierMsg.h"
 #include "pnSceneObject/plSimulationInterface.h"
@@ -225,6 +227,10 @@ void plPXPhysical::DirtyRecipe()
 
 bool plPXPhysical::InitActor()
 {
+    // We may get here before the mesh is done cooking, eg when our subworld is loaded.
+    fInitPending = false;
+    FinishCooking();
+
     plPXSimulation* sim = plSimulationMgr::GetInstance()->GetPhysX();
 
     plPXActorType actorType = plPXActorType::kUnset;
@@ -320,6 +326,12 @@ void plPXPhysical::IUpdateSubworld()
 
 void plPXPhysical::DestroyActor()
 {
+    if (fCookJob) {
+        plSimulationMgr::GetInstance()->GetPhysX()->RemovePendingPhysical(this);
+        fCookJob.reset();
+        fInitPending = false;
+    }
+
     if (fActor) {
         // When the actor is removed from the world, it eventually receives eNOTIFY_TOUCH_LOST
         // after the keyed objects are destroyed but before the PhysX SDK destroys the actor.
@@ -353,6 +365,8 @@ void plPXPhysical::IEnable(bool enable)
 
 plPhysical& plPXPhysical::SetProperty(int prop, bool status)
 {
+    FinishCooking();
+
     if (GetProperty(prop) == status)
     {
         const char* propName = "(unknown)";
@@ -500,6 +514,7 @@ void plPXPhysical::SetLinearVelocitySim(const hsVector3& vel, bool wakeup)
 
 void plPXPhysical::ClearLinearVelocity()
 {
+    FinishCooking();
     SetLinearVelocitySim({});
 }
 
@@ -541,18 +556,15 @@ void plPXPhysical::SetDampingSim(float factor)
 
 // ==========================================================================
 
-physx::PxConvexMesh* plPXPhysical::ICookHull(hsStream* s)
+bool plPXPhysical::IReadMesh(hsStream* s, bool hull, std::vector<uint32_t>& tris, std::vector<hsPoint3>& verts) const
 {
-    std::vector<uint32_t> tris;
-    std::vector<hsPoint3> verts;
-
     switch (fRecipe.bounds) {
     case plSimDefs::kHullBounds:
         try {
             plPXCooking::ReadConvexHull26(s, tris, verts);
         } catch (const plPXCookingException& ex) {
             SimLog("Failed to uncook convex hull '{}': {}", GetKeyName(), ex.what());
-            return nullptr;
+            return false;
         }
         break;
 
@@ -561,17 +573,32 @@ physx::PxConvexMesh* plPXPhysical::ICookHull(hsStream* s)
         try {
             plPXCooking::ReadTriMesh26(s, tris, verts);
         } catch (const plPXCookingException& ex) {
-            SimLog("Failed to uncook triangle mesh (for hull bounds) '{}': {}", GetKeyName(), ex.what());
-            return nullptr;
+            if (hull)
+                SimLog("Failed to uncook triangle mesh (for hull bounds) '{}': {}", GetKeyName(), ex.what());
+            else
+                SimLog("Failed to uncook triangle mesh '{}': {}", GetKeyName(), ex.what());
+            return false;
         }
 
         // Forces PhysX to compute a hull
-        tris.clear();
+        if (hull)
+            tris.clear();
         break;
 
     DEFAULT_FATAL(fRecipe.bounds);
     }
 
+    hsAssert(hull || fRecipe.bounds != plSimDefs::kHullBounds, "Convex hull read as a triangle mesh");
+    return true;
+}
+
+physx::PxConvexMesh* plPXPhysical::ICookHull(hsStream* s)
+{
+    std::vector<uint32_t> tris;
+    std::vector<hsPoint3> verts;
+    if (!IReadMesh(s, true, tris, verts))
+        return nullptr;
+
     return plSimulationMgr::GetInstance()->GetPhysX()->InsertConvexHull(tris, verts);
 }
 
@@ -579,22 +606,121 @@ physx::PxTriangleMesh* plPXPhysical::ICookTriMesh(hsStream* s)
 {
     std::vector<uint32_t> tris;
     std::vector<hsPoint3> verts;
+    if (!IReadMesh(s, false, tris, verts))
+        return nullptr;
 
-    switch (fRecipe.bounds) {
-    case plSimDefs::kExplicitBounds:
-    case plSimDefs::kProxyBounds:
-        try {
-             plPXCooking::ReadTriMesh26(s, tris, verts);
-        } catch (const plPXCookingException& ex) {
-            SimLog("Failed to uncook triangle mesh '{}': {}", GetKeyName(), ex.what());
-            return nullptr;
-        }
-        break;
+    return plSimulationMgr::GetInstance()->GetPhysX()->InsertTriangleMesh(tris, verts);
+}
 
-    DEFAULT_FATAL(fRecipe.bounds);
+void plPXPhysical::IStartCooking(hsStream* s, bool hull)
+{
+    std::vector<uint32_t> tris;
+    std::vector<hsPoint3> verts;
+    if (!IReadMesh(s, hull, tris, verts))
+        return;
+
+    plPXSimulation* sim = plSimulationMgr::GetInstance()->GetPhysX();
+    fCookJob = sim->CookMeshAsync(hull ? plPXMeshCache::Kind::kConvexHull : plPXMeshCache::Kind::kTriangleMesh,
+                                  GetKey()->GetUoid().GetLocation(), std::move(tris), std::move(verts));
+    sim->AddPendingPhysical(this);
+}
+
+void plPXPhysical::FinishCooking()
+{
+    if (!fCookJob)
+        return;
+
+    plPXSimulation* sim = plSimulationMgr::GetInstance()->GetPhysX();
+    sim->RemovePendingPhysical(this);
+    if (fCookJob->GetKind() == plPXMeshCache::Kind::kConvexHull)
+        fRecipe.convexMesh = sim->FinishConvexHull(*fCookJob);
+    else
+        fRecipe.triMesh = sim->FinishTriangleMesh(*fCookJob);
+    fCookJob.reset();
+
+    if (fInitPending) {
+        fInitPending = false;
+        InitActor();
     }
+}
 
-    return plSimulationMgr::GetInstance()->GetPhysX()->InsertTriangleMesh(tris, verts);
+static void SkipPrewarmKey(hsStream* s)
+{
+    if (s->ReadBool()) {
+        plUoid uoid;
+        uoid.Read(s);
+    }
+}
+
+static void SkipPrewarmStrings(hsStream* s)
+{
+    uint16_t num = s->ReadLE16();
+    for (uint16_t i = 0; i < num; i++) {
+        ST::string str;
+        plMsgStdStringHelper::Peek(str, s);
+    }
+}
+
+bool plPXPhysical::PrewarmMeshCache(hsStream* s)
+{
+    // This mirrors plSynchedObject::Read and plPXPhysical::Read up to the mesh data.
+    SkipPrewarmKey(s);
+    uint32_t synchFlags = s->ReadLE32();
+    if (synchFlags & kExcludePersistentState)
+        SkipPrewarmStrings(s);
+    if (synchFlags & kHasVolatileState)
+        SkipPrewarmStrings(s);
+
+    float mass = s->ReadLEFloat();
+    s->ReadLEFloat(); // friction
+    s->ReadLEFloat(); // restitution
+    auto bounds = (plSimDefs::Bounds)s->ReadByte();
+    auto group = (plSimDefs::Group)s->ReadByte();
+    s->ReadLE32(); // reportsOn
+    if (s->ReadLE16() == plSimDefs::kLOSDBSwimRegion)
+        group = plSimDefs::kGroupMax;
+
+    for (int i = 0; i < 4; ++i)
+        SkipPrewarmKey(s);
+
+    hsPoint3 l2sP;
+    l2sP.Read(s);
+    hsQuat l2sQ;
+    l2sQ.Read(s);
+
+    hsBitVector props;
+    props.Read(s);
+
+    if (bounds == plSimDefs::kSphereBounds || bounds == plSimDefs::kBoxBounds)
+        return false;
+
+    // Same as DirtyRecipe, which runs before the properties are read.
+    bool hull = bounds == plSimDefs::kHullBounds;
+    if (!hull) {
+        bool dynamic = mass != 0.f && group == plSimDefs::kGroupDynamic;
+        bool trigger = group == plSimDefs::kGroupDetector;
+        hull = dynamic || trigger;
+    }
+
+    std::vector<uint32_t> tris;
+    std::vector<hsPoint3> verts;
+    try {
+        if (bounds == plSimDefs::kHullBounds)
+            plPXCooking::ReadConvexHull26(s, tris, verts);
+        else
+            plPXCooking::ReadTriMesh26(s, tris, verts);
+    } catch (const plPXCookingException&) {
+        return false;
+    }
+
+    plPXSimulation* sim = plSimulationMgr::GetInstance()->GetPhysX();
+    if (hull) {
+        // Forces PhysX to compute a hull, as in ICookHull
+        if (bounds != plSimDefs::kHullBounds)
+            tris.clear();
+        return sim->CacheConvexHull(tris, verts);
+    }
+    return sim->CacheTriangleMesh(tris, verts);
 }
 
 // ==========================================================================
@@ -699,6 +825,8 @@ static plDrawableSpans* IGenerateProxy(plDrawableSpans* drawable,
 
 plDrawableSpans* plPXPhysical::CreateProxy(hsGMaterial* mat, std::vector<uint32_t>& idx, plDrawableSpans* addTo)
 {
+    FinishCooking();
+
     plDrawableSpans* myDraw = addTo;
     hsMatrix44 l2w, unused;
     GetTransform(l2w, unused);
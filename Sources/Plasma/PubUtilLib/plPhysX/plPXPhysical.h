@@ -60,6 +60,7 @@ class hsGMaterial;
 class plLOSHit;
 class plMessage;
 class plPhysicalProxy;
+class plPXCookJob;
 struct hsPlane3;
 struct hsPoint3;
 class hsQuat;
@@ -179,9 +180,30 @@ public:
 
     // Export time and internal use only
     bool InitActor();
+    bool IReadMesh(hsStream* s, bool hull, std::vector<uint32_t>& tris, std::vector<hsPoint3>& verts) const;
     physx::PxConvexMesh* ICookHull(hsStream* s);
     physx::PxTriangleMesh* ICookTriMesh(hsStream* s);
 
+    /**
+     * Reads the mesh for this physical and starts cooking it on the thread pool.
+     * \sa FinishCooking()
+     */
+    void IStartCooking(hsStream* s, bool hull);
+
+    /**
+     * Waits for the mesh started by IStartCooking() and inserts it into the simulation,
+     * along with the actor if it was waiting on the mesh.
+     */
+    void FinishCooking();
+
+    /**
+     * Cooks the mesh of a serialized physical into the simulation's mesh cache.
+     * The stream must be positioned at the start of the object's data, just past its
+     * class index. No keys are resolved and no object is created.
+     * \returns true if the physical has a mesh and it is now in the cache.
+     */
+    static bool PrewarmMeshCache(hsStream* s);
+
     void Read(hsStream* s, hsResMgr* mgr) override;
     void Write(hsStream* s, hsResMgr* mgr) override;
 
@@ -296,6 +318,9 @@ protected:
     physx::PxRigidActor* fActor;
     plKey fWorldKey;    // either a subworld or nil
 
+    std::unique_ptr<plPXCookJob> fCookJob;  // mesh still cooking after Read()
+    bool fInitPending;                      // create the actor once fCookJob is done
+
     PhysRecipe fRecipe;
     plSimDefs::Bounds fBounds;
     plSimDefs::Group fGroup;
@@ -41,6 +41,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 *==LICENSE==*/
 #include "plPXSimulation.h"
 #include "plPXConvert.h"
+#include "plPXCpuDispatcher.h"
 #include "plPhysXAPI.h"
 #include "plPXPhysical.h"
 #include "plPXPhysicalControllerCore.h"
@@ -48,6 +49,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plPXSubWorld.h"
 #include "plSimulationMgr.h"
 
+#include "hsThreadPool.h"
+#include "hsTimer.h"
 #include "plProfile.h"
 
 #include "pnNetCommon/plNetApp.h"
@@ -55,6 +58,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "plStatusLog/plStatusLog.h"
 
+#include <algorithm>
+
 // ==========================================================================
 
 /** if the step is greater than .15 seconds, clamp to that */
@@ -63,6 +68,12 @@ constexpr float kDefaultMaxDelta = 0.15f;
 /** default simulation freqency is 120hz */
 constexpr float kDefaultStepSize = 1.f / 120.f;
 
+/**
+ * by default, fold each frame's substeps into a single step. Controller moves and kinematic
+ * targets are only set once per frame, so individual substeps would see them jump.
+ */
+constexpr float kDefaultSubStepBudget = 0.f;
+
 /** Approximate size of objects in the simulation */
 constexpr float kToleranceScaleLength = 6.f;
 
@@ -82,6 +93,8 @@ plProfile_CreateCounter("  Total Bodies", "Simulation", TotalBodies);
 plProfile_CreateCounter("    Dynamics", "Simulation", Dynamics);
 plProfile_CreateCounter("    Kinematics", "Simulation", Kinematics);
 plProfile_CreateCounter("    Statics", "Simulation", Statics);
+plProfile_CreateCounter("  Sleeping Dynamics", "Simulation", SleepingDynamics);
+plProfile_CreateCounter("  Simulation Steps", "Simulation", SimSteps);
 plProfile_CreateTimer(  "Correct Controller Movement", "Simulation", CorrectController);
 
 // ==========================================================================
@@ -309,7 +322,7 @@ static physx::PxFilterFlags ISimulationFilterShader(physx::PxFilterObjectAttribu
 
 plPXSimulation::plPXSimulation()
     : fPxFoundation(), fDebugger(), fTransport(), fPxPhysics(), fPxCooking(),
-      fPxCpuDispatcher(), fAccumulator()
+      fPxCpuDispatcher(), fAccumulator(), fSubStepBudget(kDefaultSubStepBudget), fSubStepCost()
 {
 }
 
@@ -321,11 +334,13 @@ plPXSimulation::~plPXSimulation()
         world.fScene->release();
     }
     fWorlds.clear();
+    fMeshCache.reset();
 
     if (fPxCooking)
         fPxCooking->release();
     if (fPxCpuDispatcher)
         fPxCpuDispatcher->release();
+    fPoolDispatcher.reset();
     if (fPxPhysics)
         fPxPhysics->release();
     PxCloseExtensions();
@@ -339,6 +354,18 @@ plPXSimulation::~plPXSimulation()
 
 // ==========================================================================
 
+static plPXDispatcherType s_defaultDispatcher = plPXDispatcherType::kThreadPool;
+
+void plPXSimulation::SetDefaultDispatcher(plPXDispatcherType type)
+{
+    s_defaultDispatcher = type;
+}
+
+plPXDispatcherType plPXSimulation::GetDispatcherType() const
+{
+    return fPoolDispatcher ? plPXDispatcherType::kThreadPool : plPXDispatcherType::kSerial;
+}
+
 bool plPXSimulation::Init()
 {
     plStatusLog::AddLineSF("Simulation.log", "Attempting to initialize PhysX {}.{}.{}",
@@ -382,13 +409,21 @@ bool plPXSimulation::Init()
         return false;
     }
 
-    // Worker threads actually slow down our simulation - probably because Uru scenes are mostly
-    // composed of static geometry, so the thread synchronization adds more overhead than the
-    // threads help.
-    fPxCpuDispatcher = physx::PxDefaultCpuDispatcherCreate(0);
-    if (!fPxCpuDispatcher) {
-        plStatusLog::AddLineS("Simulation.log", plStatusLog::kRed, "PhysX CPU Dispatcher failed to initialize!");
-        return false;
+    // Dedicated PhysX worker threads actually slow down our simulation - probably because Uru
+    // scenes are mostly composed of static geometry, so the thread synchronization adds more
+    // overhead than the threads help. The engine's thread pool is already awake, though, so
+    // handing the tasks to it is cheap.
+    if (s_defaultDispatcher == plPXDispatcherType::kThreadPool && hsThreadPool::Instance().GetNumWorkers() > 0) {
+        fPoolDispatcher = std::make_unique<plPXCpuDispatcher>();
+        plStatusLog::AddLineSF("Simulation.log", "Running simulation tasks on {} thread pool workers",
+                               fPoolDispatcher->getWorkerCount());
+    } else {
+        fPxCpuDispatcher = physx::PxDefaultCpuDispatcherCreate(0);
+        if (!fPxCpuDispatcher) {
+            plStatusLog::AddLineS("Simulation.log", plStatusLog::kRed, "PhysX CPU Dispatcher failed to initialize!");
+            return false;
+        }
+        plStatusLog::AddLineS("Simulation.log", "Running simulation tasks serially");
     }
 
     physx::PxCookingParams params(scale);
@@ -403,6 +438,12 @@ bool plPXSimulation::Init()
         return false;
     }
 
+    fMeshCache = std::make_unique<plPXMeshCache>(plFileName::Join(plFileSystem::GetUserDataPath(), "MeshCache"),
+                                                 PX_PHYSICS_VERSION);
+    plStatusLog::AddLineSF("Simulation.log", "Cooked mesh cache at '{}' holds {}",
+                           fMeshCache->GetDirectory(),
+                           plFileSystem::ConvertFileSize(fMeshCache->GetSize()));
+
     // Purposefully create AND LEAK the default material so it's always the first one we check.
     // In most Cyan Ages, this is the one and only material. This material will be destroyed by
     // fPxPhysics->release() in the dtor.
@@ -475,8 +516,8 @@ bool plPXSimulation::IsDebuggerConnected() const
 
 // ==========================================================================
 
-physx::PxConvexMesh* plPXSimulation::InsertConvexHull(const std::vector<uint32_t>& tris,
-                                                      const std::vector<hsPoint3>& verts)
+static physx::PxConvexMeshDesc MakeConvexMeshDesc(const std::vector<uint32_t>& tris,
+                                                  const std::vector<hsPoint3>& verts)
 {
     physx::PxConvexMeshDesc desc;
     desc.indices.count = tris.size();
@@ -489,12 +530,11 @@ physx::PxConvexMesh* plPXSimulation::InsertConvexHull(const std::vector<uint32_t
                  physx::PxConvexFlag::eFAST_INERTIA_COMPUTATION;
     if (tris.empty())
         desc.flags |= physx::PxConvexFlag::eCOMPUTE_CONVEX;
-
-    return fPxCooking->createConvexMesh(desc, fPxPhysics->getPhysicsInsertionCallback());
+    return desc;
 }
 
-physx::PxTriangleMesh* plPXSimulation::InsertTriangleMesh(const std::vector<uint32_t>& tris,
-                                                          const std::vector<hsPoint3>& verts)
+static physx::PxTriangleMeshDesc MakeTriangleMeshDesc(const std::vector<uint32_t>& tris,
+                                                      const std::vector<hsPoint3>& verts)
 {
     physx::PxTriangleMeshDesc desc;
     desc.points.count = verts.size();
@@ -503,8 +543,223 @@ physx::PxTriangleMesh* plPXSimulation::InsertTriangleMesh(const std::vector<uint
     desc.triangles.count = tris.size() / 3;
     desc.triangles.stride = sizeof(uint32_t) * 3;
     desc.triangles.data = &tris[0];
+    return desc;
+}
+
+ST::string plPXSimulation::IMakeMeshKey(plPXMeshCache::Kind kind, const std::vector<uint32_t>& tris,
+                                        const std::vector<hsPoint3>& verts, uint32_t descFlags) const
+{
+    // Everything that changes the cooked output must be hashed here.
+    const physx::PxCookingParams& params = fPxCooking->getParams();
+    struct
+    {
+        float fLength;
+        float fSpeed;
+        float fWeldTolerance;
+        uint32_t fPreprocess;
+        uint32_t fDescFlags;
+    } state{
+        params.scale.length,
+        params.scale.speed,
+        params.meshWeldTolerance,
+        uint32_t(params.meshPreprocessParams),
+        descFlags
+    };
+
+    return fMeshCache->MakeKey(kind, tris, verts, &state, sizeof(state));
+}
+
+void plPXSimulation::ICookMesh(plPXCookJob& job) const
+{
+    uint64_t start = hsTimer::GetTicks();
+
+    physx::PxConvexMeshDesc convexDesc;
+    physx::PxTriangleMeshDesc triDesc;
+    uint32_t descFlags;
+    if (job.fKind == plPXMeshCache::Kind::kConvexHull) {
+        convexDesc = MakeConvexMeshDesc(job.fTris, job.fVerts);
+        descFlags = uint32_t(convexDesc.flags);
+    } else {
+        triDesc = MakeTriangleMeshDesc(job.fTris, job.fVerts);
+        descFlags = uint32_t(triDesc.flags);
+    }
+
+    job.fCooked.clear();
+    job.fFromCache = false;
+    if (fMeshCache) {
+        job.fCacheKey = IMakeMeshKey(job.fKind, job.fTris, job.fVerts, descFlags);
+        if (job.fCacheOnly)
+            job.fFromCache = fMeshCache->Contains(job.fCacheKey);
+        else
+            job.fFromCache = fMeshCache->Find(job.fCacheKey, job.fCooked);
+    }
+
+    if (!job.fFromCache) {
+        physx::PxDefaultMemoryOutputStream output;
+        bool result;
+        if (job.fKind == plPXMeshCache::Kind::kConvexHull)
+            result = fPxCooking->cookConvexMesh(convexDesc, output);
+        else
+            result = fPxCooking->cookTriangleMesh(triDesc, output);
+
+        if (result) {
+            job.fCooked.assign(output.getData(), output.getData() + output.getSize());
+            if (fMeshCache)
+                fMeshCache->Store(job.fCacheKey, job.fCooked.data(), job.fCooked.size());
+        }
+    }
+
+    job.fCookTicks = hsTimer::GetTicks() - start;
+}
+
+void plPXSimulation::IWaitForCook(plPXCookJob& job)
+{
+    uint64_t waitTicks = 0;
+    if (job.fDone.valid()) {
+        uint64_t start = hsTimer::GetTicks();
+        job.fDone.get();
+        waitTicks = hsTimer::GetTicks() - start;
+    }
+
+    if (job.fPage.IsValid()) {
+        PageCookStats& stats = fPageCookStats[job.fPage];
+        stats.fMeshes++;
+        if (job.fFromCache)
+            stats.fCached++;
+        stats.fCookTicks += job.fCookTicks;
+        stats.fWaitTicks += waitTicks;
+    }
+}
+
+std::unique_ptr<plPXCookJob> plPXSimulation::CookMeshAsync(plPXMeshCache::Kind kind, const plLocation& page,
+                                                           std::vector<uint32_t> tris,
+                                                           std::vector<hsPoint3> verts)
+{
+    auto job = std::make_unique<plPXCookJob>(kind, page, std::move(tris), std::move(verts));
+    plPXCookJob* jobPtr = job.get();
+    job->fDone = hsThreadPool::Instance().Submit([this, jobPtr] { ICookMesh(*jobPtr); });
+    return job;
+}
+
+physx::PxConvexMesh* plPXSimulation::FinishConvexHull(plPXCookJob& job)
+{
+    hsAssert(job.fKind == plPXMeshCache::Kind::kConvexHull, "Finishing the wrong kind of mesh");
+    IWaitForCook(job);
+
+    physx::PxConvexMesh* mesh = nullptr;
+    if (!job.fCooked.empty()) {
+        physx::PxDefaultMemoryInputData input(job.fCooked.data(), uint32_t(job.fCooked.size()));
+        mesh = fPxPhysics->createConvexMesh(input);
+    }
+
+    // PhysX didn't like what was in the cache, so throw it away and cook the mesh for real.
+    if (!mesh && job.fFromCache) {
+        fMeshCache->Remove(job.fCacheKey);
+        ICookMesh(job);
+        if (!job.fCooked.empty()) {
+            physx::PxDefaultMemoryInputData input(job.fCooked.data(), uint32_t(job.fCooked.size()));
+            mesh = fPxPhysics->createConvexMesh(input);
+        }
+    }
+
+    job.fCooked = {};
+    return mesh;
+}
+
+physx::PxTriangleMesh* plPXSimulation::FinishTriangleMesh(plPXCookJob& job)
+{
+    hsAssert(job.fKind == plPXMeshCache::Kind::kTriangleMesh, "Finishing the wrong kind of mesh");
+    IWaitForCook(job);
+
+    physx::PxTriangleMesh* mesh = nullptr;
+    if (!job.fCooked.empty()) {
+        physx::PxDefaultMemoryInputData input(job.fCooked.data(), uint32_t(job.fCooked.size()));
+        mesh = fPxPhysics->createTriangleMesh(input);
+    }
+
+    // PhysX didn't like what was in the cache, so throw it away and cook the mesh for real.
+    if (!mesh && job.fFromCache) {
+        fMeshCache->Remove(job.fCacheKey);
+        ICookMesh(job);
+        if (!job.fCooked.empty()) {
+            physx::PxDefaultMemoryInputData input(job.fCooked.data(), uint32_t(job.fCooked.size()));
+            mesh = fPxPhysics->createTriangleMesh(input);
+        }
+    }
+
+    job.fCooked = {};
+    return mesh;
+}
+
+void plPXSimulation::LogCookStats()
+{
+    for (const auto& [page, stats] : fPageCookStats) {
+        plStatusLog::AddLineSF("Simulation.log",
+                               "Page {}: {} meshes ({} cached), {.1f} ms cooking, {.1f} ms waiting",
+                               page, stats.fMeshes, stats.fCached,
+                               hsTimer::GetMilliSeconds<float>(stats.fCookTicks),
+                               hsTimer::GetMilliSeconds<float>(stats.fWaitTicks));
+    }
+    fPageCookStats.clear();
+}
+
+void plPXSimulation::RemovePendingPhysical(plPXPhysical* physical)
+{
+    auto it = std::find(fPendingPhysicals.begin(), fPendingPhysicals.end(), physical);
+    if (it != fPendingPhysicals.end())
+        fPendingPhysicals.erase(it);
+}
+
+void plPXSimulation::FinishCooking()
+{
+    // Finishing may create actors, which can in turn send messages... So, don't let anyone
+    // change the list out from under us.
+    std::vector<plPXPhysical*> pending;
+    pending.swap(fPendingPhysicals);
+    for (plPXPhysical* physical : pending)
+        physical->FinishCooking();
+
+    LogCookStats();
+}
+
+physx::PxConvexMesh* plPXSimulation::InsertConvexHull(const std::vector<uint32_t>& tris,
+                                                      const std::vector<hsPoint3>& verts)
+{
+    plPXCookJob job(plPXMeshCache::Kind::kConvexHull, plLocation::kInvalidLoc, tris, verts);
+    ICookMesh(job);
+    return FinishConvexHull(job);
+}
+
+physx::PxTriangleMesh* plPXSimulation::InsertTriangleMesh(const std::vector<uint32_t>& tris,
+                                                          const std::vector<hsPoint3>& verts)
+{
+    plPXCookJob job(plPXMeshCache::Kind::kTriangleMesh, plLocation::kInvalidLoc, tris, verts);
+    ICookMesh(job);
+    return FinishTriangleMesh(job);
+}
+
+bool plPXSimulation::CacheConvexHull(const std::vector<uint32_t>& tris,
+                                     const std::vector<hsPoint3>& verts)
+{
+    if (!fMeshCache)
+        return false;
 
-    return fPxCooking->createTriangleMesh(desc, fPxPhysics->getPhysicsInsertionCallback());
+    plPXCookJob job(plPXMeshCache::Kind::kConvexHull, plLocation::kInvalidLoc, tris, verts);
+    job.fCacheOnly = true;
+    ICookMesh(job);
+    return job.fFromCache || !job.fCooked.empty();
+}
+
+bool plPXSimulation::CacheTriangleMesh(const std::vector<uint32_t>& tris,
+                                       const std::vector<hsPoint3>& verts)
+{
+    if (!fMeshCache)
+        return false;
+
+    plPXCookJob job(plPXMeshCache::Kind::kTriangleMesh, plLocation::kInvalidLoc, tris, verts);
+    job.fCacheOnly = true;
+    ICookMesh(job);
+    return job.fFromCache || !job.fCooked.empty();
 }
 
 physx::PxRigidActor* plPXSimulation::CreateRigidActor(const physx::PxGeometry& geometry,
@@ -573,7 +828,10 @@ plPXSimulation::World& plPXSimulation::InitSubworld(const plKey& world)
     desc.frictionType = physx::PxFrictionType::eTWO_DIRECTIONAL;
     desc.solverType = physx::PxSolverType::eTGS;
     desc.flags = physx::PxSceneFlag::eENABLE_PCM;
-    desc.cpuDispatcher = fPxCpuDispatcher;
+    if (fPoolDispatcher)
+        desc.cpuDispatcher = fPoolDispatcher.get();
+    else
+        desc.cpuDispatcher = fPxCpuDispatcher;
     desc.userData = world ? world->ObjectIsLoaded() : nullptr;
 
     physx::PxScene* scene = fPxPhysics->createScene(desc);
@@ -703,6 +961,9 @@ void plPXSimulation::RemoveFromWorld(physx::PxController* controller)
 
 bool plPXSimulation::Advance(float delta)
 {
+    if (fBenchmark)
+        fBenchmark->fFrames++;
+
     fAccumulator += delta;
     if (fAccumulator < kDefaultStepSize) {
         // Not enough time has passed to perform a physics substep, but we need to propagate
@@ -729,27 +990,144 @@ bool plPXSimulation::Advance(float delta)
     plPXPhysicalControllerCore::Apply(delta);
     plProfile_EndTiming(ApplyController);
 
+    int numSimSteps = IPlanSimSteps(numSubSteps);
+    float simDelta = delta / numSimSteps;
+
     plProfile_BeginTiming(Step);
-    for (auto [key, world] : fWorlds) {
-        world.fScene->simulate(delta);
-        world.fScene->fetchResults(true);
+    uint64_t startTicks = hsTimer::GetTicks();
+    for (int i = 0; i < numSimSteps; ++i) {
+        // Start every subworld before waiting on any of them so their tasks can run side by side.
+        for (auto& [key, world] : fWorlds)
+            world.fScene->simulate(simDelta);
+        for (auto& [key, world] : fWorlds)
+            world.fScene->fetchResults(true);
+    }
+    uint64_t stepTicks = hsTimer::GetTicks() - startTicks;
+    plProfile_EndTiming(Step);
+    plProfile_IncCount(SimSteps, numSimSteps);
+
+    // Smooth out the cost so that one slow frame doesn't make us fold substeps for long.
+    float stepCost = hsTimer::GetSeconds<float>(stepTicks) / numSimSteps;
+    fSubStepCost = fSubStepCost > 0.f ? fSubStepCost * 0.9f + stepCost * 0.1f : stepCost;
+
+    if (fBenchmark) {
+        fBenchmark->fSubSteps += numSubSteps;
+        fBenchmark->fSimSteps += numSimSteps;
+        fBenchmark->fStepMs.push_back(hsTimer::GetMilliSeconds<float>(stepTicks));
+    }
+
+    IUpdateWorldStats();
+
+    // Propagate the simulated controller movement to the SceneObjects for rendering purposes.
+    plProfile_BeginTiming(CorrectController);
+    plPXPhysicalControllerCore::Update(numSubSteps, fAccumulator / kDefaultStepSize);
+    plProfile_EndTiming(CorrectController);
+
+    return true;
+}
 
+int plPXSimulation::IPlanSimSteps(int numSubSteps) const
+{
+    if (fSubStepBudget <= 0.f)
+        return 1;
+
+    // Until we know better, assume the steps are affordable.
+    if (fSubStepCost <= 0.f)
+        return numSubSteps;
+
+    int affordable = (int)(fSubStepBudget / fSubStepCost);
+    return std::clamp(affordable, 1, numSubSteps);
+}
+
+void plPXSimulation::IUpdateWorldStats()
+{
+    for (auto& [key, world] : fWorlds) {
         physx::PxSimulationStatistics stats;
         world.fScene->getSimulationStatistics(stats);
-        plProfile_IncCount(ActiveBodies, stats.nbActiveDynamicBodies + stats.nbActiveDynamicBodies);
+        plProfile_IncCount(ActiveBodies, stats.nbActiveDynamicBodies + stats.nbActiveKinematicBodies);
         plProfile_IncCount(ActiveDynamics, stats.nbActiveDynamicBodies);
         plProfile_IncCount(ActiveKinematics, stats.nbActiveKinematicBodies);
         plProfile_IncCount(TotalBodies, stats.nbDynamicBodies + stats.nbKinematicBodies + stats.nbStaticBodies);
         plProfile_IncCount(Dynamics, stats.nbDynamicBodies);
         plProfile_IncCount(Kinematics, stats.nbKinematicBodies);
         plProfile_IncCount(Statics, stats.nbStaticBodies);
+        plProfile_IncCount(SleepingDynamics, stats.nbDynamicBodies - stats.nbActiveDynamicBodies);
+
+        world.fFrames++;
+        if (stats.nbActiveDynamicBodies == 0 && stats.nbActiveKinematicBodies == 0)
+            world.fAsleepFrames++;
+        world.fDynamics += stats.nbDynamicBodies;
+        world.fActiveDynamics += stats.nbActiveDynamicBodies;
     }
-    plProfile_EndTiming(Step);
+}
 
-    // Propagate the simulated controller movement to the SceneObjects for rendering purposes.
-    plProfile_BeginTiming(CorrectController);
-    plPXPhysicalControllerCore::Update(numSubSteps, fAccumulator / kDefaultStepSize);
-    plProfile_EndTiming(CorrectController);
+void plPXSimulation::LogWorldStats()
+{
+    for (auto& [key, world] : fWorlds) {
+        if (world.fFrames == 0)
+            continue;
+
+        float asleep = 100.f * world.fAsleepFrames / world.fFrames;
+        float sleeping = 100.f;
+        if (world.fDynamics)
+            sleeping = 100.f * (world.fDynamics - world.fActiveDynamics) / world.fDynamics;
+        plStatusLog::AddLineSF("Simulation.log",
+                               "Subworld '{}': {} steps, fully asleep in {.1f}%, dynamics sleeping {.1f}% of the time",
+                               key ? key->GetName() : ST_LITERAL("(main world)"),
+                               world.fFrames, asleep, sleeping);
+
+        world.fFrames = 0;
+        world.fAsleepFrames = 0;
+        world.fDynamics = 0;
+        world.fActiveDynamics = 0;
+    }
+}
 
-    return true;
+// ==========================================================================
+
+void plPXSimulation::BeginBenchmark()
+{
+    // Only count the activity during the benchmark.
+    for (auto& [key, world] : fWorlds) {
+        world.fFrames = 0;
+        world.fAsleepFrames = 0;
+        world.fDynamics = 0;
+        world.fActiveDynamics = 0;
+    }
+
+    fBenchmark.emplace();
+    fBenchmark->fStartTicks = hsTimer::GetTicks();
+}
+
+void plPXSimulation::EndBenchmark()
+{
+    if (!fBenchmark)
+        return;
+
+    Benchmark bench = std::move(*fBenchmark);
+    fBenchmark.reset();
+
+    float seconds = hsTimer::GetSeconds<float>(hsTimer::GetTicks() - bench.fStartTicks);
+    plStatusLog::AddLineSF("Simulation.log",
+                           "Benchmark: {} frames in {.1f}s, {} substeps simulated in {} steps ({}, budget {.1f}ms)",
+                           bench.fFrames, seconds, bench.fSubSteps, bench.fSimSteps,
+                           GetDispatcherType() == plPXDispatcherType::kThreadPool ? "thread pool" : "serial",
+                           fSubStepBudget * 1000.f);
+
+    if (!bench.fStepMs.empty()) {
+        std::sort(bench.fStepMs.begin(), bench.fStepMs.end());
+        float total = 0.f;
+        for (float ms : bench.fStepMs)
+            total += ms;
+
+        auto percentile = [&bench](float p) {
+            return bench.fStepMs[(size_t)(p * (bench.fStepMs.size() - 1))];
+        };
+        plStatusLog::AddLineSF("Simulation.log",
+                               "  Step time: mean {.3f}ms, median {.3f}ms, 95th {.3f}ms, max {.3f}ms",
+                               total / bench.fStepMs.size(), percentile(0.5f), percentile(0.95f),
+                               bench.fStepMs.back());
+    }
+
+    LogWorldStats();
 }
@@ -42,16 +42,23 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #ifndef plPXSimulation_H
 #define plPXSimulation_H
 
+#include "hsGeometry3.h"
 #include "plFileSystem.h"
 #include "pnKeyedObject/plKey.h"
+#include "pnKeyedObject/plUoid.h"
 
+#include "plPXMeshCache.h"
+
+#include <algorithm>
+#include <future>
 #include <map>
+#include <memory>
 #include <optional>
 #include <string_theory/string>
 #include <vector>
 
 class hsKeyedObject;
-struct hsPoint3;
+class plPXCpuDispatcher;
 class plPXFilterData;
 class plPXPhysical;
 class plPXPhysicalControllerCore;
@@ -95,6 +102,15 @@ enum class plPXDebuggerStatus
     kDisconnected,
 };
 
+enum class plPXDispatcherType
+{
+    /** Runs all simulation work on the thread calling Advance(). */
+    kSerial,
+
+    /** Runs simulation tasks on hsThreadPool, or serially if the pool has no workers. */
+    kThreadPool,
+};
+
 class plPXActorData
 {
     plKey fKey;
@@ -126,6 +142,45 @@ public:
     ST::string str() const { return fNameBuf; }
 };
 
+/**
+ * A mesh being cooked, usually on the thread pool.
+ * \sa plPXSimulation::CookMeshAsync()
+ */
+class plPXCookJob
+{
+    friend class plPXSimulation;
+
+    plPXMeshCache::Kind fKind;
+    plLocation fPage;
+    std::vector<uint32_t> fTris;
+    std::vector<hsPoint3> fVerts;
+    std::vector<uint8_t> fCooked;
+    ST::string fCacheKey;
+    bool fFromCache;
+    bool fCacheOnly;
+    uint64_t fCookTicks;
+    std::future<void> fDone;
+
+public:
+    plPXCookJob(plPXMeshCache::Kind kind, const plLocation& page,
+                std::vector<uint32_t> tris, std::vector<hsPoint3> verts)
+        : fKind(kind), fPage(page), fTris(std::move(tris)), fVerts(std::move(verts)),
+          fFromCache(), fCacheOnly(), fCookTicks()
+    { }
+    plPXCookJob(const plPXCookJob&) = delete;
+    plPXCookJob(plPXCookJob&&) = delete;
+
+    /** The worker references our members, so we can't go away until it's done. */
+    ~plPXCookJob()
+    {
+        if (fDone.valid())
+            fDone.wait();
+    }
+
+    [[nodiscard]]
+    plPXMeshCache::Kind GetKind() const { return fKind; }
+};
+
 class plPXSimulation
 {
     friend class plSimulationMgr;
@@ -135,6 +190,21 @@ protected:
     {
         physx::PxScene* fScene{};
         physx::PxControllerManager* fControllers{};
+
+        // Statistics since the last LogWorldStats()
+        uint32_t fFrames{};
+        uint32_t fAsleepFrames{};
+        uint64_t fDynamics{};
+        uint64_t fActiveDynamics{};
+    };
+
+    struct Benchmark
+    {
+        uint64_t fStartTicks{};
+        uint32_t fFrames{};
+        uint32_t fSubSteps{};
+        uint32_t fSimSteps{};
+        std::vector<float> fStepMs;
     };
 
     physx::PxFoundation* fPxFoundation;
@@ -143,12 +213,46 @@ protected:
     physx::PxPhysics* fPxPhysics;
     physx::PxCooking* fPxCooking;
     physx::PxDefaultCpuDispatcher* fPxCpuDispatcher;
+    std::unique_ptr<plPXCpuDispatcher> fPoolDispatcher;
+    std::unique_ptr<plPXMeshCache> fMeshCache;
     std::map<plKey, World> fWorlds;
+
+    struct PageCookStats
+    {
+        uint32_t fMeshes{};
+        uint32_t fCached{};
+        uint64_t fCookTicks{};
+        uint64_t fWaitTicks{};
+    };
+    std::map<plLocation, PageCookStats> fPageCookStats;
+    std::vector<plPXPhysical*> fPendingPhysicals;
+
     float fAccumulator;
+    float fSubStepBudget;
+    float fSubStepCost;
+    std::optional<Benchmark> fBenchmark;
 
 protected:
     bool IConnectDebugger(physx::PxPvdTransport* transport);
 
+    /** Computes the mesh cache key for a mesh cooked with the current parameters. */
+    [[nodiscard]]
+    ST::string IMakeMeshKey(plPXMeshCache::Kind kind, const std::vector<uint32_t>& tris,
+                            const std::vector<hsPoint3>& verts, uint32_t descFlags) const;
+
+    /** Fills in the cooked data for a job from the mesh cache or by cooking it. Thread safe. */
+    void ICookMesh(plPXCookJob& job) const;
+
+    /** Waits for a job to finish and accounts for the time spent on it. */
+    void IWaitForCook(plPXCookJob& job);
+
+    /** Decides how many times to step the scenes for this many fixed substeps. */
+    [[nodiscard]]
+    int IPlanSimSteps(int numSubSteps) const;
+
+    /** Gathers the activity statistics of every subworld after a step. */
+    void IUpdateWorldStats();
+
 public:
     plPXSimulation();
     plPXSimulation(const plPXSimulation&) = delete;
@@ -183,6 +287,45 @@ public:
 
     bool IsDebuggerConnected() const;
 
+    /**
+     * Sets how PhysX runs the simulation tasks.
+     * Scenes keep the dispatcher they were created with, so this must be called before the
+     * simulation is initialized to have any effect.
+     */
+    static void SetDefaultDispatcher(plPXDispatcherType type);
+
+    [[nodiscard]]
+    plPXDispatcherType GetDispatcherType() const;
+
+    /**
+     * Sets how many seconds of each frame may be spent stepping the simulation.
+     * Every fixed substep is simulated separately as long as that has been fitting within the
+     * budget. Otherwise, the substeps are folded into fewer, longer steps. A budget of zero
+     * (the default) always folds all of a frame's substeps into a single step.
+     * \note Kinematic targets and controller moves are still set once per frame, so with
+     *       several steps they cover the whole frame's displacement in the first one.
+     */
+    void SetSubStepBudget(float seconds) { fSubStepBudget = std::max(seconds, 0.f); }
+
+    [[nodiscard]]
+    float GetSubStepBudget() const { return fSubStepBudget; }
+
+    /** Writes how active each subworld has been since the last call to Simulation.log. */
+    void LogWorldStats();
+
+    /**
+     * Starts recording how long each simulation step takes.
+     * Replay the same movement through an Age between BeginBenchmark() and EndBenchmark()
+     * to compare dispatchers and substep budgets.
+     */
+    void BeginBenchmark();
+
+    /** Stops recording and writes a summary of the steps to Simulation.log. */
+    void EndBenchmark();
+
+    [[nodiscard]]
+    bool IsBenchmarking() const { return fBenchmark.has_value(); }
+
 protected:
     /** Creates a scene/subworld. */
     [[nodiscard]]
@@ -196,16 +339,66 @@ protected:
     physx::PxMaterial* InitMaterial(float uStatic, float uDynamic, float restitution);
 
 public:
-    /** Cooks and inserts a convex mesh into the simulation. */
+    /**
+     * Cooks and inserts a convex mesh into the simulation.
+     * \remarks Previously cooked meshes are loaded from the mesh cache instead.
+     */
     [[nodiscard]]
     physx::PxConvexMesh* InsertConvexHull(const std::vector<uint32_t>& tris,
                                           const std::vector<hsPoint3>& verts);
 
-    /** Cooks and inserts a triangle mesh into the simulation. */
+    /**
+     * Cooks and inserts a triangle mesh into the simulation.
+     * \remarks Previously cooked meshes are loaded from the mesh cache instead.
+     */
     [[nodiscard]]
     physx::PxTriangleMesh* InsertTriangleMesh(const std::vector<uint32_t>& tris,
                                               const std::vector<hsPoint3>& verts);
 
+    /**
+     * Cooks a convex mesh into the mesh cache without inserting it into the simulation.
+     * \returns true if the mesh is now in the cache.
+     */
+    bool CacheConvexHull(const std::vector<uint32_t>& tris, const std::vector<hsPoint3>& verts);
+
+    /**
+     * Cooks a triangle mesh into the mesh cache without inserting it into the simulation.
+     * \returns true if the mesh is now in the cache.
+     */
+    bool CacheTriangleMesh(const std::vector<uint32_t>& tris, const std::vector<hsPoint3>& verts);
+
+    /**
+     * Starts cooking a mesh on the thread pool.
+     * The mesh is not usable until it has been passed to \sa FinishConvexHull() or
+     * \sa FinishTriangleMesh(), which will block until the cooking is done.
+     * \param page The page being loaded, for the cooking statistics in Simulation.log.
+     */
+    [[nodiscard]]
+    std::unique_ptr<plPXCookJob> CookMeshAsync(plPXMeshCache::Kind kind, const plLocation& page,
+                                               std::vector<uint32_t> tris, std::vector<hsPoint3> verts);
+
+    /** Waits for a convex mesh to be cooked and inserts it into the simulation. */
+    [[nodiscard]]
+    physx::PxConvexMesh* FinishConvexHull(plPXCookJob& job);
+
+    /** Waits for a triangle mesh to be cooked and inserts it into the simulation. */
+    [[nodiscard]]
+    physx::PxTriangleMesh* FinishTriangleMesh(plPXCookJob& job);
+
+    /** Writes how long each page spent cooking meshes since the last call to Simulation.log. */
+    void LogCookStats();
+
+    /** Remembers a physical whose mesh is cooking so that \sa FinishCooking() can find it. */
+    void AddPendingPhysical(plPXPhysical* physical) { fPendingPhysicals.push_back(physical); }
+    void RemovePendingPhysical(plPXPhysical* physical);
+
+    /** Finishes every mesh that is still cooking and inserts the actors waiting on them. */
+    void FinishCooking();
+
+    /** Gets the on-disk cache of cooked meshes, if there is one. */
+    [[nodiscard]]
+    plPXMeshCache* GetMeshCache() const { return fMeshCache.get(); }
+
     [[nodiscard]]
     physx::PxRigidActor* CreateRigidActor(const physx::PxGeometry& geometry,
                                           const physx::PxTransform& globalPose,
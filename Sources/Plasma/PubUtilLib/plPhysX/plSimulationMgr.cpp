@@ -224,6 +224,13 @@ void plSimulationMgr::ResetKickables()
 
 void plSimulationMgr::Advance(float delSecs)
 {
+    // Anything paged in since the last frame needs its actors in the scene now.
+    fSimulation->FinishCooking();
+
+    // Answer the line of sight requests from this frame's eval against the state
+    // they were made in.
+    fLOSDispatch->ProcessRequests();
+
     if (fSuspended)
         return;
 
@@ -49,12 +49,8 @@ plProfile_CreateTimer("VisSelect",              "PipeT", VisSelect);
 plProfile_CreateTimer("FindSceneLights",        "PipeT", FindSceneLights);
 plProfile_CreateTimer("  Find Lights",          "PipeT", FindLights);
 plProfile_CreateTimer("    Find Perms",         "PipeT", FindPerm);
-plProfile_CreateTimer("    FindSpan",           "PipeT", FindSpan);
 plProfile_CreateTimer("    FindActiveLights",   "PipeT", FindActiveLights);
 plProfile_CreateTimer("    ApplyActiveLights",  "PipeT", ApplyActiveLights);
-plProfile_CreateTimer("      ApplyMoving",      "PipeT", ApplyMoving);
-plProfile_CreateTimer("      ApplyToSpec",      "PipeT", ApplyToSpec);
-plProfile_CreateTimer("      ApplyToMoving",    "PipeT", ApplyToMoving);
 
 plProfile_CreateCounter("LightOn",              "PipeC", LightOn);
 plProfile_CreateCounter("LightVis",             "PipeC", LightVis);
@@ -63,6 +59,9 @@ plProfile_CreateCounter("LightActive",          "PipeC", LightActive);
 plProfile_CreateCounter("Lights Found",         "PipeC", FindLightsFound);
 plProfile_CreateCounter("Perms Found",          "PipeC", FindLightsPerm);
 
+plProfile_CreateTimer("  Skin",                 "PipeT", Skin);
+plProfile_CreateCounter("NumSkin",              "PipeC", NumSkin);
+
 plProfile_CreateCounter("Polys",                "General",  DrawTriangles);
 plProfile_CreateCounter("Material Change",      "Draw",     MatChange);
 
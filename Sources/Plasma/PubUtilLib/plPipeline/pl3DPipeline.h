@@ -44,6 +44,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include <stack>
 #include <string_theory/string>
+#include <unordered_set>
 #include <vector>
 
 #include "plPipeline.h"
@@ -53,11 +54,14 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "hsGDeviceRef.h"
 #include "plRenderTarget.h"
 #include "plCubicRenderTarget.h"
+#include "plLightTree.h"
+#include "plSoftwareSkin.h"
 
 #include "hsGMatState.inl"
 #include "plPipeDebugFlags.h"
 #include "plProfile.h"
 #include "plTweak.h"
+#include "hsThreadPool.h"
 #include "hsTimer.h"
 
 #include "pnSceneObject/plDrawInterface.h"
@@ -74,6 +78,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plGLight/plShadowSlave.h"
 #include "plGLight/plShadowCaster.h"
 #include "plIntersect/plVolumeIsect.h"
+#include "plScene/plPageTreeMgr.h"
 #include "plScene/plRenderRequest.h"
 #include "plScene/plVisMgr.h"
 #include "plSurface/hsGMaterial.h"
@@ -88,18 +93,17 @@ plProfile_Extern(VisSelect);
 plProfile_Extern(FindSceneLights);
 plProfile_Extern(FindLights);
 plProfile_Extern(FindPerm);
-plProfile_Extern(FindSpan);
 plProfile_Extern(FindActiveLights);
 plProfile_Extern(ApplyActiveLights);
-plProfile_Extern(ApplyMoving);
-plProfile_Extern(ApplyToSpec);
-plProfile_Extern(ApplyToMoving);
 plProfile_Extern(LightOn);
 plProfile_Extern(LightVis);
 plProfile_Extern(LightChar);
 plProfile_Extern(LightActive);
 plProfile_Extern(FindLightsFound);
 plProfile_Extern(FindLightsPerm);
+plProfile_Extern(HarvestLeaves);
+plProfile_Extern(Skin);
+plProfile_Extern(NumSkin);
 
 static const float kPerspLayerScale  = 0.00001f;
 static const float kPerspLayerScaleW = 0.001f;
@@ -176,6 +180,29 @@ protected:
     plLightInfo*                            fActiveLights;
     std::vector<plLightInfo*>               fCharLights;
     std::vector<plLightInfo*>               fVisLights;
+    plLightTree                             fLightTree;
+    hsBitVector                             fCharLightMask;
+    hsBitVector                             fVisLightMask;
+
+    // Scratch for working out the lights on one drawable.
+    struct LightScratch
+    {
+        std::vector<int16_t>        fMoveList;
+        std::vector<int16_t>        fSpecList;
+        std::vector<int16_t>        fLitList;
+        uint32_t                    fHarvested;
+    };
+
+    struct LightBatchEntry
+    {
+        plDrawableSpans*            fDrawable;
+        const std::vector<int16_t>* fVisList;
+        std::vector<plLightInfo*>   fLights;
+        uint32_t                    fFound;
+        uint32_t                    fHarvested;
+    };
+    std::vector<LightBatchEntry>            fLightBatch;
+    std::unordered_set<plDrawableSpans*>    fPreLit;    // Lit by PrepLightsForRender, awaiting PrepForRender
 
     std::vector<plShadowSlave*>             fShadows;
 
@@ -208,6 +235,8 @@ protected:
     uint16_t                                fAvRTWidth;
     uint32_t                                fAvNextFreeRT;
 
+    plSoftwareSkin                          fSkinner;
+
 
 public:
     pl3DPipeline(const hsG3DDeviceModeRecord* devModeRec);
@@ -247,6 +276,20 @@ public:
     void Render(plDrawable* d, const std::vector<int16_t>& visList) override;
 
 
+    /**
+     * Find the runtime lights for every drawable in the list ahead of their
+     * PrepForRender calls.
+     *
+     * Picking out the candidate lights (and anything else that touches
+     * shared state) is done here in order, then the per span work of
+     * applying them is spread across the thread pool, one drawable per job.
+     * Each drawable only gets its own spans written, so the end result is
+     * the same as lighting them one at a time. PrepForRender then just
+     * attaches the shadows.
+     */
+    void PrepLightsForRender(const std::vector<plDrawVisList>& drawList, plVisMgr* visMgr) override;
+
+
     /**
      * Convenience function for a drawable that needs to get drawn outside of
      * the normal scene graph render (i.e. something not managed by the
@@ -822,6 +865,45 @@ protected:
     void ICheckLighting(plDrawableSpans* drawable, std::vector<int16_t>& visList, plVisMgr* visMgr);
 
 
+    /**
+     * First half of ICheckLighting. Clears the spans' lights, sets up the
+     * permaLights and their shadows, and fills lightList with the runtime
+     * lights that might affect this drawable.
+     *
+     * Returns false if runtime lights are turned off.
+     */
+    bool IFindLights(plDrawableSpans* drawable, const std::vector<int16_t>& visList, std::vector<plLightInfo*>& lightList);
+
+
+    /**
+     * Second half of ICheckLighting. Adds each of the lights in lightList to
+     * the spans it affects, returning how many it added.
+     *
+     * This only writes to the drawable's spans (the lights were refreshed by
+     * IFindLights), so different drawables can be done at the same time.
+     */
+    uint32_t IApplyLights(plDrawableSpans* drawable, const std::vector<int16_t>& visList, const std::vector<plLightInfo*>& lightList, LightScratch& scratch) const;
+
+
+    /**
+     * Emulate matrix palette operations in software.
+     *
+     * The big difference between the hardware and software versions is we
+     * only want to touch each vertex buffer once and blend all the verts
+     * we're going to in software, so the vertex blend happens once for an
+     * entire drawable. In hardware, we want the opposite, to break it into
+     * managable chunks, manageable meaning few enough matrices to fit into
+     * hardware registers.
+     *
+     * All of the visible skinned spans are handed to fSkinner at once, so
+     * the blend itself can be spread across the thread pool.
+     *
+     * If copyColorsAndUVs is false, only the positions and normals in the
+     * destination are written.
+     */
+    bool ISoftwareVertexBlend(plDrawableSpans* drawable, const std::vector<int16_t>& visList, bool copyColorsAndUVs = true);
+
+
     /**
      * Get the camera to NDC transform.
      *
@@ -1062,39 +1144,57 @@ void pl3DPipeline<DeviceType>::BeginVisMgr(plVisMgr* visMgr)
     // These lists are only constructed once per render, but searched
     // multiple times
 
+    // The masks mirror the lists by index into fLightTree, which is kept in
+    // the same order as fActiveLights.
+
     plProfile_BeginTiming(FindSceneLights);
     fCharLights.clear();
     fVisLights.clear();
+    fCharLightMask.Clear();
+    fVisLightMask.Clear();
+
+    fLightTree.Update(fActiveLights);
+
     if (visMgr) {
         const hsBitVector& visSet = visMgr->GetVisSet();
         const hsBitVector& visNot = visMgr->GetVisNot();
         plLightInfo* light;
+        uint32_t idx = 0;
 
-        for (light = fActiveLights; light != nullptr; light = light->GetNext()) {
+        for (light = fActiveLights; light != nullptr; light = light->GetNext(), idx++) {
             plProfile_IncCount(LightActive, 1);
             if (!light->IsIdle() && !light->InVisNot(visNot) && light->InVisSet(visSet)) {
                 plProfile_IncCount(LightOn, 1);
                 if (light->GetProperty(plLightInfo::kLPHasIncludes)) {
-                    if (light->GetProperty(plLightInfo::kLPIncludesChars))
+                    if (light->GetProperty(plLightInfo::kLPIncludesChars)) {
                         fCharLights.emplace_back(light);
+                        fCharLightMask.SetBit(idx);
+                    }
                 } else {
                     fVisLights.emplace_back(light);
                     fCharLights.emplace_back(light);
+                    fVisLightMask.SetBit(idx);
+                    fCharLightMask.SetBit(idx);
                 }
             }
         }
     } else {
         plLightInfo* light;
-        for (light = fActiveLights; light != nullptr; light = light->GetNext()) {
+        uint32_t idx = 0;
+        for (light = fActiveLights; light != nullptr; light = light->GetNext(), idx++) {
             plProfile_IncCount(LightActive, 1);
             if (!light->IsIdle()) {
                 plProfile_IncCount(LightOn, 1);
                 if (light->GetProperty(plLightInfo::kLPHasIncludes)) {
-                    if (light->GetProperty(plLightInfo::kLPIncludesChars))
+                    if (light->GetProperty(plLightInfo::kLPIncludesChars)) {
                         fCharLights.emplace_back(light);
+                        fCharLightMask.SetBit(idx);
+                    }
                 } else {
                     fVisLights.emplace_back(light);
                     fCharLights.emplace_back(light);
+                    fVisLightMask.SetBit(idx);
+                    fCharLightMask.SetBit(idx);
                 }
             }
         }
@@ -1111,6 +1211,9 @@ void pl3DPipeline<DeviceType>::EndVisMgr(plVisMgr* visMgr)
 {
     fCharLights.clear();
     fVisLights.clear();
+    fCharLightMask.Clear();
+    fVisLightMask.Clear();
+    fPreLit.clear();
 }
 
 
@@ -1392,6 +1495,7 @@ void pl3DPipeline<DeviceType>::IAttachSlaveToReceivers(size_t which, plDrawableS
     static std::vector<int16_t> hitList;
     hitList.clear();
     space->HarvestEnabledLeaves(slave->fIsect, cache, hitList);
+    plProfile_IncCount(HarvestLeaves, hitList.size());
 
     // For the visible spans that intercect the shadow volume, attach the shadow
     // to all appropriate for receiving this shadow map.
@@ -1579,6 +1683,131 @@ void pl3DPipeline<DeviceType>::IFreeAvRT(plRenderTarget* tex)
 }
 
 
+template <class DeviceType>
+bool pl3DPipeline<DeviceType>::ISoftwareVertexBlend(plDrawableSpans* drawable, const std::vector<int16_t>& visList, bool copyColorsAndUVs)
+{
+    if (IsDebugFlagSet(plPipeDbg::kFlagNoSkinning))
+        return true;
+
+    if (drawable->GetSkinTime() == fRenderCnt)
+        return true;
+
+    const hsBitVector& blendBits = drawable->GetBlendingSpanVector();
+
+    if (blendBits.Empty()) {
+        // This sucker doesn't have any skinning spans anyway. Just return
+        drawable->SetSkinTime(fRenderCnt);
+        return true;
+    }
+
+    plProfile_BeginTiming(Skin);
+
+    const std::vector<plSpan*>& spans = drawable->GetSpanArray();
+    for (int16_t idx : visList) {
+        if (!blendBits.IsBitSet(idx))
+            continue;
+        drawable->SetBlendingSpanVectorBit(idx, false);
+
+        const plIcicle& span = *(plIcicle*)spans[idx];
+        typename DeviceType::VertexBufferRef* vRef = (typename DeviceType::VertexBufferRef*)drawable->GetVertexRef(span.fGroupIdx, span.fVBufferIdx);
+
+        hsAssert(vRef->fData, "Going into skinning with no place to put results!");
+        hsAssert(span.fLocalUVWChans == 0, "support for skinned UVWs dropped. reimplement me?");
+
+        plProfile_Inc(NumSkin);
+
+        hsMatrix44* matrixPalette = drawable->GetMatrixPalette(span.fBaseMatrix);
+        matrixPalette[0] = span.fLocalToWorld;
+
+        // Other spans on this palette may have a different local to world
+        // by the time we get to blending, so the span keeps its own.
+        plSoftwareSkin::Span skinSpan;
+        skinSpan.fPalette = matrixPalette;
+        skinSpan.fLocalToWorld = span.fLocalToWorld;
+        skinSpan.fSrc = vRef->fOwner->GetVertBufferData(vRef->fIndex) + span.fVStartIdx * vRef->fOwner->GetVertexSize();
+        skinSpan.fDest = vRef->fData + span.fVStartIdx * vRef->fVertexSize;
+        skinSpan.fSrcStride = vRef->fOwner->GetVertexSize();
+        skinSpan.fDestStride = vRef->fVertexSize;
+        skinSpan.fCount = span.fVLength;
+        skinSpan.fFormat = vRef->fOwner->GetVertexFormat();
+        skinSpan.fCopyColorsAndUVs = copyColorsAndUVs;
+        fSkinner.AddSpan(skinSpan);
+
+        vRef->SetDirty(true);
+    }
+
+    fSkinner.Blend();
+
+    plProfile_EndTiming(Skin);
+
+    if (blendBits.Empty()) {
+        // Only do this if we've blended ALL of the spans. Thus, this becomes a trivial
+        // rejection for all the skinning flags being cleared
+        drawable->SetSkinTime(fRenderCnt);
+    }
+
+    return true;
+}
+
+
+template <class DeviceType>
+void pl3DPipeline<DeviceType>::PrepLightsForRender(const std::vector<plDrawVisList>& drawList, plVisMgr* visMgr)
+{
+    fPreLit.clear();
+
+    if (fView.fRenderState & kRenderNoLights)
+        return;
+
+    // The shadows still get attached without runtime lights, so just let
+    // ICheckLighting handle it.
+    if (IsDebugFlagSet(plPipeDbg::kFlagNoRuntimeLights))
+        return;
+
+    plProfile_BeginTiming(FindLights);
+
+    size_t numBatch = 0;
+    for (const plDrawVisList& drawVis : drawList) {
+        plDrawableSpans* drawable = plDrawableSpans::ConvertNoRef(drawVis.fDrawable);
+        if (!drawable || drawVis.fVisList.empty())
+            continue;
+
+        // If it turns up twice, the second PrepForRender does it the long way.
+        if (!fPreLit.insert(drawable).second)
+            continue;
+
+        if (numBatch >= fLightBatch.size())
+            fLightBatch.emplace_back();
+        LightBatchEntry& entry = fLightBatch[numBatch++];
+        entry.fDrawable = drawable;
+        entry.fVisList = &drawVis.fVisList;
+        entry.fFound = 0;
+        entry.fHarvested = 0;
+        IFindLights(drawable, drawVis.fVisList, entry.fLights);
+    }
+
+    plProfile_BeginTiming(ApplyActiveLights);
+    hsThreadPool::Instance().ParallelFor(numBatch, 1,
+        [this](size_t begin, size_t end) {
+            LightScratch scratch;
+            for (size_t i = begin; i < end; i++) {
+                LightBatchEntry& entry = fLightBatch[i];
+                entry.fFound = IApplyLights(entry.fDrawable, *entry.fVisList, entry.fLights, scratch);
+                entry.fHarvested = scratch.fHarvested;
+            }
+        });
+    plProfile_EndTiming(ApplyActiveLights);
+
+    // The profile counters aren't thread safe, so the jobs only tally
+    // and we add it all up here.
+    for (size_t i = 0; i < numBatch; i++) {
+        plProfile_IncCount(FindLightsFound, fLightBatch[i].fFound);
+        plProfile_IncCount(HarvestLeaves, fLightBatch[i].fHarvested);
+    }
+
+    plProfile_EndTiming(FindLights);
+}
+
+
 template <class DeviceType>
 void pl3DPipeline<DeviceType>::ICheckLighting(plDrawableSpans* drawable, std::vector<int16_t>& visList, plVisMgr* visMgr)
 {
@@ -1590,6 +1819,36 @@ void pl3DPipeline<DeviceType>::ICheckLighting(plDrawableSpans* drawable, std::ve
 
     plProfile_BeginTiming(FindLights);
 
+    // PrepLightsForRender has already done the lights for us.
+    if (fPreLit.erase(drawable)) {
+        IAttachShadowsToReceivers(drawable, visList);
+        plProfile_EndTiming(FindLights);
+        return;
+    }
+
+    static std::vector<plLightInfo*> lightList;
+    if (!IFindLights(drawable, visList, lightList)) {
+        plProfile_EndTiming(FindLights);
+        return;
+    }
+
+    static LightScratch scratch;
+    plProfile_BeginTiming(ApplyActiveLights);
+    plProfile_IncCount(FindLightsFound, IApplyLights(drawable, visList, lightList, scratch));
+    plProfile_IncCount(HarvestLeaves, scratch.fHarvested);
+    plProfile_EndTiming(ApplyActiveLights);
+
+    IAttachShadowsToReceivers(drawable, visList);
+
+    plProfile_EndTiming(FindLights);
+}
+
+
+template <class DeviceType>
+bool pl3DPipeline<DeviceType>::IFindLights(plDrawableSpans* drawable, const std::vector<int16_t>& visList, std::vector<plLightInfo*>& lightList)
+{
+    lightList.clear();
+
     // First add in the explicit lights (from LightGroups).
     // Refresh the lights as they are added (actually a lazy eval).
     plProfile_BeginTiming(FindPerm);
@@ -1618,195 +1877,123 @@ void pl3DPipeline<DeviceType>::ICheckLighting(plDrawableSpans* drawable, std::ve
     }
     plProfile_EndTiming(FindPerm);
 
-    if (IsDebugFlagSet(plPipeDbg::kFlagNoRuntimeLights)) {
-        plProfile_EndTiming(FindLights);
-        return;
+    if (IsDebugFlagSet(plPipeDbg::kFlagNoRuntimeLights))
+        return false;
+
+    // Make a list of lights that can potentially affect spans in this drawable
+    // based on the drawables bounds and properties.
+    // If the drawable has the PropCharacter property, it is affected by lights
+    // in fCharLights, else only by the smaller list of fVisLights.
+    // The light tree gets us the ones whose bounds overlap the drawable, which
+    // are then checked against the real light volumes.
+
+    plProfile_BeginTiming(FindActiveLights);
+    static std::vector<plLightInfo*> candidates;
+    candidates.clear();
+
+    const hsBounds3Ext& drawBnd = drawable->GetSpaceTree()->GetWorldBounds();
+    if (drawable->GetNativeProperty(plDrawable::kPropCharacter))
+        fLightTree.Harvest(drawBnd, fCharLightMask, candidates);
+    else
+        fLightTree.Harvest(drawBnd, fVisLightMask, candidates);
+
+    for (plLightInfo* light : candidates) {
+        if (light->AffectsBound(drawBnd)) {
+            // Get any lazy evaluation out of the way, so applying the
+            // light only has to read from it.
+            light->Refresh();
+            lightList.emplace_back(light);
+        }
     }
+    plProfile_EndTiming(FindActiveLights);
+
+    return true;
+}
+
 
+template <class DeviceType>
+uint32_t pl3DPipeline<DeviceType>::IApplyLights(plDrawableSpans* drawable, const std::vector<int16_t>& visList, const std::vector<plLightInfo*>& lightList, LightScratch& scratch) const
+{
     // Sort the incoming spans as either
     // A) moving - affected by all lights - moveList
     // B) specular - affected by specular lights - specList
     // C) visible - affected by moving lights - visList
-    static std::vector<int16_t> tmpList;
-    static std::vector<int16_t> moveList;
-    static std::vector<int16_t> specList;
-
-    moveList.clear();
-    specList.clear();
+    scratch.fMoveList.clear();
+    scratch.fSpecList.clear();
+    scratch.fHarvested = 0;
 
-    plProfile_BeginTiming(FindSpan);
     for (int16_t idx : visList) {
         const plSpan* span = drawable->GetSpan(idx);
 
         if (span->fProps & plSpan::kPropRunTimeLight) {
-            moveList.emplace_back(idx);
-            specList.emplace_back(idx);
+            scratch.fMoveList.emplace_back(idx);
+            scratch.fSpecList.emplace_back(idx);
         } else if (span->fProps & plSpan::kPropMatHasSpecular) {
-            specList.emplace_back(idx);
-        }
-    }
-    plProfile_EndTiming(FindSpan);
-
-    // Make a list of lights that can potentially affect spans in this drawable
-    // based on the drawables bounds and properties.
-    // If the drawable has the PropCharacter property, it is affected by lights
-    // in fCharLights, else only by the smaller list of fVisLights.
-
-    plProfile_BeginTiming(FindActiveLights);
-    static std::vector<plLightInfo*> lightList;
-    lightList.clear();
-
-    if (drawable->GetNativeProperty(plDrawable::kPropCharacter)) {
-        for (plLightInfo* charLight : fCharLights) {
-            if (charLight->AffectsBound(drawable->GetSpaceTree()->GetWorldBounds()))
-                lightList.emplace_back(charLight);
-        }
-    } else {
-        for (plLightInfo* visLight : fVisLights) {
-            if (visLight->AffectsBound(drawable->GetSpaceTree()->GetWorldBounds()))
-                lightList.emplace_back(visLight);
+            scratch.fSpecList.emplace_back(idx);
         }
     }
-    plProfile_EndTiming(FindActiveLights);
 
     // Loop over the lights and for each light, extract a list of the spans that light
     // affects. Append the light to each spans list with a scalar strength of how strongly
     // the light affects it. Since the strength is based on the object's center position,
     // it's not very accurate, but good enough for selecting which lights to use.
+    // Use the light IF light is enabled and
+    //      1) light is movable
+    //      2) span is movable, or
+    //      3) Both the light and the span have specular
+
+    const bool isChar = drawable->GetNativeProperty(plDrawable::kPropCharacter);
+    uint32_t numFound = 0;
 
-    plProfile_BeginTiming(ApplyActiveLights);
     for (plLightInfo* light : lightList) {
-        tmpList.clear();
-        if (light->GetProperty(plLightInfo::kLPMovable)) {
-            plProfile_BeginTiming(ApplyMoving);
-
-            const std::vector<int16_t>& litList = light->GetAffected(drawable->GetSpaceTree(),
-                visList,
-                tmpList,
-                drawable->GetNativeProperty(plDrawable::kPropCharacter));
-
-            // PUT OVERRIDE FOR KILLING PROJECTORS HERE!!!!
-            bool proj = nullptr != light->GetProjection();
-            if (fView.fRenderState & kRenderNoProjection)
-                proj = false;
-
-            for (int16_t litIdx : litList) {
-                // Use the light IF light is enabled and
-                //      1) light is movable
-                //      2) span is movable, or
-                //      3) Both the light and the span have specular
-                const plSpan* span = drawable->GetSpan(litIdx);
-                bool currProj = proj;
-
-                if (span->fProps & plSpan::kPropProjAsVtx)
-                    currProj = false;
-
-                if (!(currProj && (span->fProps & plSpan::kPropSkipProjection))) {
-                    float strength, scale;
-
-                    light->GetStrengthAndScale(span->fWorldBounds, strength, scale);
-
-                    // We can't pitch a light because it's "strength" is zero, because the strength is based
-                    // on the center of the span and isn't conservative enough. We can pitch based on the
-                    // scale though, since a light scaled down to zero will have no effect no where.
-                    if (scale > 0) {
-                        plProfile_Inc(FindLightsFound);
-                        span->AddLight(light, strength, scale, currProj);
-                    }
-                }
-            }
-            plProfile_EndTiming(ApplyMoving);
-        } else if (light->GetProperty(plLightInfo::kLPHasSpecular)) {
-            if (specList.empty())
-                continue;
-
-            plProfile_BeginTiming(ApplyToSpec);
-
-            const std::vector<int16_t>& litList = light->GetAffected(drawable->GetSpaceTree(),
-                specList,
-                tmpList,
-                drawable->GetNativeProperty(plDrawable::kPropCharacter));
-
-            // PUT OVERRIDE FOR KILLING PROJECTORS HERE!!!!
-            bool proj = nullptr != light->GetProjection();
-            if (fView.fRenderState & kRenderNoProjection)
-                proj = false;
-
-            for (int16_t litIdx : litList) {
-                // Use the light IF light is enabled and
-                //      1) light is movable
-                //      2) span is movable, or
-                //      3) Both the light and the span have specular
-                const plSpan* span = drawable->GetSpan(litIdx);
-                bool currProj = proj;
-
-                if (span->fProps & plSpan::kPropProjAsVtx)
-                    currProj = false;
-
-                if (!(currProj && (span->fProps & plSpan::kPropSkipProjection))) {
-                    float strength, scale;
-
-                    light->GetStrengthAndScale(span->fWorldBounds, strength, scale);
-
-                    // We can't pitch a light because it's "strength" is zero, because the strength is based
-                    // on the center of the span and isn't conservative enough. We can pitch based on the
-                    // scale though, since a light scaled down to zero will have no effect no where.
-                    if (scale > 0) {
-                        plProfile_Inc(FindLightsFound);
-                        span->AddLight(light, strength, scale, currProj);
-                    }
-                }
-            }
-            plProfile_EndTiming(ApplyToSpec);
-        } else {
-            if (moveList.empty())
-                continue;
-
-            plProfile_BeginTiming(ApplyToMoving);
-
-            const std::vector<int16_t>& litList = light->GetAffected(drawable->GetSpaceTree(),
-                moveList,
-                tmpList,
-                drawable->GetNativeProperty(plDrawable::kPropCharacter));
-
-            // PUT OVERRIDE FOR KILLING PROJECTORS HERE!!!!
-            bool proj = nullptr != light->GetProjection();
-            if (fView.fRenderState & kRenderNoProjection)
-                proj = false;
-
-            for (int16_t litIdx : litList) {
-                // Use the light IF light is enabled and
-                //      1) light is movable
-                //      2) span is movable, or
-                //      3) Both the light and the span have specular
-                const plSpan* span = drawable->GetSpan(litIdx);
-                bool currProj = proj;
-
-                if (span->fProps & plSpan::kPropProjAsVtx)
-                    currProj = false;
-
-                if (!(currProj && (span->fProps & plSpan::kPropSkipProjection))) {
-                    float strength, scale;
-
-                    light->GetStrengthAndScale(span->fWorldBounds, strength, scale);
-
-                    // We can't pitch a light because it's "strength" is zero, because the strength is based
-                    // on the center of the span and isn't conservative enough. We can pitch based on the
-                    // scale though, since a light scaled down to zero will have no effect no where.
-                    if (scale > 0) {
-                        plProfile_Inc(FindLightsFound);
-                        span->AddLight(light, strength, scale, currProj);
-                    }
+        const std::vector<int16_t>* spanList;
+        if (light->GetProperty(plLightInfo::kLPMovable))
+            spanList = &visList;
+        else if (light->GetProperty(plLightInfo::kLPHasSpecular))
+            spanList = &scratch.fSpecList;
+        else
+            spanList = &scratch.fMoveList;
+
+        if (spanList->empty())
+            continue;
+
+        scratch.fLitList.clear();
+        const std::vector<int16_t>& litList = light->GetAffected(drawable->GetSpaceTree(),
+            *spanList,
+            scratch.fLitList,
+            isChar);
+        if (&litList == &scratch.fLitList)
+            scratch.fHarvested += uint32_t(litList.size());
+
+        // PUT OVERRIDE FOR KILLING PROJECTORS HERE!!!!
+        bool proj = nullptr != light->GetProjection();
+        if (fView.fRenderState & kRenderNoProjection)
+            proj = false;
+
+        for (int16_t litIdx : litList) {
+            const plSpan* span = drawable->GetSpan(litIdx);
+            bool currProj = proj;
+
+            if (span->fProps & plSpan::kPropProjAsVtx)
+                currProj = false;
+
+            if (!(currProj && (span->fProps & plSpan::kPropSkipProjection))) {
+                float strength, scale;
+
+                light->GetStrengthAndScale(span->fWorldBounds, strength, scale);
+
+                // We can't pitch a light because it's "strength" is zero, because the strength is based
+                // on the center of the span and isn't conservative enough. We can pitch based on the
+                // scale though, since a light scaled down to zero will have no effect no where.
+                if (scale > 0) {
+                    numFound++;
+                    span->AddLight(light, strength, scale, currProj);
                 }
             }
-            plProfile_EndTiming(ApplyToMoving);
         }
     }
-    plProfile_EndTiming(ApplyActiveLights);
 
-    IAttachShadowsToReceivers(drawable, visList);
-
-    plProfile_EndTiming(FindLights);
+    return numFound;
 }
 
 
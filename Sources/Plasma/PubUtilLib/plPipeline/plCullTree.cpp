@@ -150,6 +150,30 @@ plCullNode::plCullStatus plCullNode::TestBounds(const hsBounds3Ext& bnd) const
     return kSplit;
 }
 
+// Same answers as above for an axis aligned box, as handed out by the space tree's
+// compact nodes.
+plCullNode::plCullStatus plCullNode::TestBounds(const hsPoint3& mins, const hsPoint3& maxs) const
+{
+    float dist = fDist;
+    float rad = 0;
+    for( int i = 0; i < 3; i++ )
+    {
+        float c = (maxs[i] + mins[i]) * 0.5f;
+        float h = (maxs[i] - mins[i]) * 0.5f;
+        dist += fNorm[i] * c;
+        rad += h * (fNorm[i] < 0 ? -fNorm[i] : fNorm[i]);
+    }
+
+    const float kSafetyDist = -0.1f;
+    if( dist + rad < kSafetyDist )
+        return kCulled;
+
+    if( dist - rad >= 0 )
+        return kClear;
+
+    return kSplit;
+}
+
 plCullNode::plCullStatus plCullNode::ITestSphereRecur(const hsPoint3& center, float rad) const
 {
     plCullNode::plCullStatus retVal = TestSphere(center, rad);
@@ -215,14 +239,39 @@ plCullNode::plCullStatus plCullNode::ITestNode(const plSpaceTree* space, int16_t
                                                std::vector<int16_t>& clear, std::vector<int16_t>& split,
                                                std::vector<int16_t>& culled) const
 {
-    if( space->IsDisabled(who) || (space->GetNode(who).fWorldBounds.GetType() != kBoundsNormal) )
+    // Mostly only the compact nodes get touched here. Disabled nodes, and nodes
+    // without normal bounds, have empty hot boxes, so those go to the full node.
+    const plSpaceTreeHotNode& hot = space->GetHotNode(who);
+    plCullStatus stat;
+    if( hot.IsEmpty() || !plSpaceTree::GetHotCulling() )
+    {
+        if( space->IsDisabled(who) )
+        {
+            culled.emplace_back(who);
+            return kCulled;
+        }
+        stat = TestBounds(space->GetNode(who).fWorldBounds);
+    }
+    else if( space->IsCacheDisabled(who) )
     {
         culled.emplace_back(who);
         return kCulled;
     }
+    else
+    {
+        hsPoint3 mins, maxs;
+        space->GetHotBounds(who, mins, maxs);
+        stat = TestBounds(mins, maxs);
+
+        // The hot box holds the real bounds with a grid step to spare, so clear and
+        // culled are the same answers the real bounds would give. A split might not
+        // be, so let the real bounds settle it, and we walk and draw exactly what
+        // the full test would.
+        if( stat == kSplit )
+            stat = TestBounds(space->GetNode(who).fWorldBounds);
+    }
 
     plCullStatus retVal = kClear;
-    plCullStatus stat = TestBounds(space->GetNode(who).fWorldBounds);
 
     switch( stat )
     {
@@ -235,22 +284,22 @@ plCullNode::plCullStatus plCullNode::ITestNode(const plSpaceTree* space, int16_t
         retVal = kCulled;
         break;
     case kSplit:
-        if( space->GetNode(who).fFlags & plSpaceTreeNode::kIsLeaf )
+        if( hot.IsLeaf() )
         {
 //          split.Append(who);
             retVal = kPureSplit;
         }
         else
         {
-            plCullStatus child0 = ITestNode(space, space->GetNode(who).GetChild(0), clear, split, culled);
-            plCullStatus child1 = ITestNode(space, space->GetNode(who).GetChild(1), clear, split, culled);
+            plCullStatus child0 = ITestNode(space, hot.GetChild(0), clear, split, culled);
+            plCullStatus child1 = ITestNode(space, hot.GetChild(1), clear, split, culled);
 
             if( child0 != child1 )
             {
                 if( child0 == kPureSplit )
-                    split.emplace_back(space->GetNode(who).GetChild(0));
+                    split.emplace_back(hot.GetChild(0));
                 else if( child1 == kPureSplit )
-                    split.emplace_back(space->GetNode(who).GetChild(1));
+                    split.emplace_back(hot.GetChild(1));
                 retVal = kSplit;
             }
             else if( child0 == kPureSplit )
@@ -269,7 +318,9 @@ plCullNode::plCullStatus plCullNode::ITestNode(const plSpaceTree* space, int16_t
 // If a node is disabled, we can just ignore we ever got called.
 void plCullNode::ITestNode(const plSpaceTree* space, int16_t who, hsBitVector& totList, hsBitVector& outList) const
 {
-    if( space->IsDisabled(who) )
+    if( space->IsCacheDisabled(who) )
+        return;
+    if( (space->GetHotNode(who).IsEmpty() || !plSpaceTree::GetHotCulling()) && space->IsDisabled(who) )
         return;
 
     size_t myClearStart = ScratchClear().size();
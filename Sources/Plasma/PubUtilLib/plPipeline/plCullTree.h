@@ -211,6 +211,7 @@ public:
     float GetDist() const { return fDist; }
 
     plCullStatus    TestBounds(const hsBounds3Ext& bnd) const;
+    plCullStatus    TestBounds(const hsPoint3& mins, const hsPoint3& maxs) const;
     plCullStatus    TestSphere(const hsPoint3& center, float rad) const;
 };
 
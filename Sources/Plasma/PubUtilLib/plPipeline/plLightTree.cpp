@@ -0,0 +1,169 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "plLightTree.h"
+
+#include "hsBounds.h"
+
+#include "plProfile.h"
+
+#include "plDrawable/plSpaceTree.h"
+#include "plDrawable/plSpaceTreeMaker.h"
+#include "plGLight/plLightInfo.h"
+
+plProfile_CreateCounter("LightTreeBuild",       "PipeC", LightTreeBuild);
+plProfile_CreateCounter("LightTreeMove",        "PipeC", LightTreeMove);
+
+// Leaf indices are int16_t in plSpaceTree.
+static constexpr size_t kMaxLightLeaves = 0x7fff;
+
+static bool ISameBounds(const hsBounds3Ext& a, const hsBounds3Ext& b)
+{
+    return (a.GetMins() == b.GetMins()) && (a.GetMaxs() == b.GetMaxs());
+}
+
+plLightTree::~plLightTree()
+{
+    Reset();
+}
+
+void plLightTree::Reset()
+{
+    delete fTree;
+    fTree = nullptr;
+
+    fLights.clear();
+    fLeaves.clear();
+    fLeafLights.clear();
+    fBounds.clear();
+    fUnbounded.Clear();
+}
+
+void plLightTree::IRebuild()
+{
+    delete fTree;
+
+    fLeaves.assign(fLights.size(), -1);
+    fLeafLights.clear();
+    fUnbounded.Clear();
+
+    plSpaceTreeMaker maker;
+    maker.Reset();
+    for (size_t i = 0; i < fLights.size(); i++) {
+        if (fBounds[i].GetType() != kBoundsNormal || fLeafLights.size() >= kMaxLightLeaves) {
+            fUnbounded.SetBit(uint32_t(i));
+            continue;
+        }
+        fLeaves[i] = int16_t(maker.AddLeaf(fBounds[i]));
+        fLeafLights.emplace_back(uint16_t(i));
+    }
+    fTree = maker.MakeTree();
+
+    plProfile_Inc(LightTreeBuild);
+}
+
+void plLightTree::Update(plLightInfo* activeLights)
+{
+    bool rebuild = !fTree;
+    bool moved = false;
+
+    size_t idx = 0;
+    for (plLightInfo* light = activeLights; light != nullptr; light = light->GetNext(), idx++) {
+        light->Refresh();
+
+        hsBounds3Ext bnd;
+        if (!light->GetAffectedBounds(bnd))
+            bnd.MakeEmpty();
+
+        if (idx >= fLights.size()) {
+            fLights.emplace_back(light);
+            fBounds.emplace_back(bnd);
+            rebuild = true;
+            continue;
+        }
+
+        if (fLights[idx] != light) {
+            fLights[idx] = light;
+            rebuild = true;
+        }
+        if ((bnd.GetType() == kBoundsNormal) != (fBounds[idx].GetType() == kBoundsNormal))
+            rebuild = true;
+
+        if (!rebuild && fLeaves[idx] >= 0 && !ISameBounds(bnd, fBounds[idx])) {
+            fTree->MoveLeaf(fLeaves[idx], bnd);
+            moved = true;
+            plProfile_Inc(LightTreeMove);
+        }
+        fBounds[idx] = bnd;
+    }
+
+    if (idx != fLights.size()) {
+        fLights.resize(idx);
+        fBounds.resize(idx);
+        rebuild = true;
+    }
+
+    if (rebuild)
+        IRebuild();
+    else if (moved)
+        fTree->Refresh();
+}
+
+void plLightTree::Harvest(const hsBounds3Ext& bnd, const hsBitVector& mask, std::vector<plLightInfo*>& lights)
+{
+    fFound = fUnbounded;
+
+    if (fTree && !fTree->IsEmpty()) {
+        fHarvest.Clear();
+        fIsect.SetBounds(bnd);
+        fTree->HarvestLeaves(&fIsect, fHarvest);
+
+        fHarvest.Enumerate(fScratch);
+        for (int16_t leaf : fScratch)
+            fFound.SetBit(fLeafLights[leaf]);
+    }
+
+    fFound &= mask;
+    fFound.Enumerate(fScratch);
+    for (int16_t idx : fScratch)
+        lights.emplace_back(fLights[idx]);
+}
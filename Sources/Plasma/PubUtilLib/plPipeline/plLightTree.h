@@ -0,0 +1,104 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#ifndef _plLightTree_inc_
+#define _plLightTree_inc_
+
+#include "HeadSpin.h"
+#include "hsBitVector.h"
+
+#include <vector>
+
+#include "plIntersect/plVolumeIsect.h"
+
+class hsBounds3Ext;
+class plLightInfo;
+class plSpaceTree;
+
+//////////////////////////////////////////////////////////////////////////////
+// Bounding volume tree over the runtime lights, so finding the lights that
+// might touch a drawable doesn't mean testing every light in the scene.
+//
+// Lights are indexed in the order they appear in the pipeline's active
+// light list as of the last Update(). Callers build a mask with those
+// indices to pick which lights they care about, and Harvest() hands back
+// that subset in the same order, so results are identical to walking the
+// list. It only narrows things down, the lights' own AffectsBound() still
+// has the final say.
+//
+// The tree is only rebuilt when lights come or go. Lights that just move
+// or change range have their leaves refit in place.
+
+class plLightTree
+{
+protected:
+    std::vector<plLightInfo*>   fLights;
+    std::vector<int16_t>        fLeaves;        // Leaf for each light, -1 if unbounded
+    std::vector<uint16_t>       fLeafLights;    // Light for each leaf
+    std::vector<hsBounds3Ext>   fBounds;        // Affected bounds for each light
+    hsBitVector                 fUnbounded;
+
+    plSpaceTree*                fTree;
+    plBoundsIsect               fIsect;
+
+    hsBitVector                 fHarvest;
+    hsBitVector                 fFound;
+    std::vector<int16_t>        fScratch;
+
+    void IRebuild();
+
+public:
+    plLightTree() : fTree() { }
+    ~plLightTree();
+
+    // Refresh every light in the list and bring the tree up to date.
+    void Update(plLightInfo* activeLights);
+
+    size_t GetNumLights() const { return fLights.size(); }
+
+    // Add each light in mask that might affect bnd to lights.
+    void Harvest(const hsBounds3Ext& bnd, const hsBitVector& mask, std::vector<plLightInfo*>& lights);
+
+    void Reset();
+};
+
+#endif // _plLightTree_inc_
@@ -0,0 +1,142 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "plSoftwareSkin.h"
+
+#include <algorithm>
+
+#include "hsMatrix44.h"
+#include "hsThreadPool.h"
+
+#include "plDrawable/plGBufferGroup.h"
+
+//// IBlendSpanFPU ////////////////////////////////////////////////////////////
+// Since skinning is linear, we blend the (at most four) matrices first and
+// then transform the position and normal once, rather than transforming by
+// every matrix and blending the results.
+
+void plSoftwareSkin::IBlendSpanFPU(const Span& span)
+{
+    const uint8_t numWeights = (span.fFormat & plGBufferGroup::kSkinWeightMask) >> 4;
+    const bool hasIndices = (span.fFormat & plGBufferGroup::kSkinIndices) != 0;
+    const size_t tailSize = sizeof(uint32_t) * 2 + plGBufferGroup::CalcNumUVs(span.fFormat) * sizeof(float) * 3;
+
+    for (uint32_t i = 0; i < span.fCount; ++i) {
+        const uint8_t* src = span.fSrc + i * span.fSrcStride;
+        uint8_t* dest = span.fDest + i * span.fDestStride;
+
+        float pos[3], norm[3], weights[4];
+        uint32_t indices;
+
+        memcpy(pos, src, sizeof(pos));
+        src = IReadWeights(src + sizeof(pos), numWeights, hasIndices, weights, indices);
+        memcpy(norm, src, sizeof(norm));
+        src += sizeof(norm);
+
+        float xfm[3][4] = {};
+        for (uint8_t j = 0; j < numWeights + 1; ++j) {
+            const float wgt = weights[j];
+            if (wgt != 0.f) {
+                const uint8_t idx = indices & 0xFF;
+                const hsMatrix44& mat = idx ? span.fPalette[idx] : span.fLocalToWorld;
+                for (int r = 0; r < 3; ++r) {
+                    xfm[r][0] += mat.fMap[r][0] * wgt;
+                    xfm[r][1] += mat.fMap[r][1] * wgt;
+                    xfm[r][2] += mat.fMap[r][2] * wgt;
+                    xfm[r][3] += mat.fMap[r][3] * wgt;
+                }
+            }
+            indices >>= 8;
+        }
+
+        float destPos[3], destNorm[3];
+        for (int r = 0; r < 3; ++r) {
+            destPos[r] = pos[0] * xfm[r][0] + pos[1] * xfm[r][1] + pos[2] * xfm[r][2] + xfm[r][3];
+            destNorm[r] = norm[0] * xfm[r][0] + norm[1] * xfm[r][1] + norm[2] * xfm[r][2];
+        }
+
+        memcpy(dest, destPos, sizeof(destPos));
+        memcpy(dest + sizeof(destPos), destNorm, sizeof(destNorm));
+        if (span.fCopyColorsAndUVs)
+            memcpy(dest + sizeof(destPos) + sizeof(destNorm), src, tailSize);
+    }
+}
+
+hsCpuFunctionDispatcher<plSoftwareSkin::blend_span_ptr> plSoftwareSkin::blend_span {
+    &plSoftwareSkin::IBlendSpanFPU,
+    nullptr,                                // SSE1
+    &plSoftwareSkin::IBlendSpanSSE2
+};
+
+//// Blend ////////////////////////////////////////////////////////////////////
+// Every vert is independent, so chop the spans into chunks small enough to
+// keep all of the workers busy, even when there's only one big avatar.
+
+void plSoftwareSkin::Blend()
+{
+    constexpr uint32_t kVertsPerJob = 1024;
+
+    std::vector<Span> jobs;
+    jobs.reserve(fSpans.size());
+    for (const Span& span : fSpans) {
+        for (uint32_t first = 0; first < span.fCount; first += kVertsPerJob) {
+            Span job = span;
+            job.fSrc += first * span.fSrcStride;
+            job.fDest += first * span.fDestStride;
+            job.fCount = std::min(kVertsPerJob, span.fCount - first);
+            jobs.emplace_back(job);
+        }
+    }
+    fSpans.clear();
+
+    if (jobs.size() == 1) {
+        BlendSpan(jobs.front());
+        return;
+    }
+
+    hsThreadPool::Instance().ParallelFor(jobs.size(), 1,
+        [&jobs](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                BlendSpan(jobs[i]);
+        });
+}
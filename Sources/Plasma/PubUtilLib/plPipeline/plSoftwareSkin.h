@@ -0,0 +1,126 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#ifndef _plSoftwareSkin_inc_
+#define _plSoftwareSkin_inc_
+
+#include "HeadSpin.h"
+#include "hsCpuID.h"
+#include "hsMatrix44.h"
+
+#include <cstring>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+// CPU vertex skinning shared by all of the pipelines.
+//
+// Source verts are in plGBufferGroup's skinned layout (position, weights,
+// optional packed indices, normal, two colors, UVWs). They're blended into
+// a destination without the skinning data. As with the hardware path,
+// palette entry 0 is the span's local to world. Spans can share a palette
+// but not a local to world, so each span carries its own copy of that one.
+//
+// A frame's worth of spans is collected with AddSpan() and then blended in
+// one go by Blend(). Big spans are chopped up and spread across the shared
+// thread pool, so spans must not overlap in their destinations.
+
+class plSoftwareSkin
+{
+public:
+    struct Span
+    {
+        const hsMatrix44*   fPalette;       // Entry 0 is ignored
+        hsMatrix44          fLocalToWorld;  // Used for index 0 instead
+        const uint8_t*      fSrc;
+        uint8_t*            fDest;
+        uint32_t            fSrcStride;
+        uint32_t            fDestStride;
+        uint32_t            fCount;
+        uint8_t             fFormat;
+        bool                fCopyColorsAndUVs;
+    };
+
+protected:
+    std::vector<Span>   fSpans;
+
+public:
+    void AddSpan(const Span& span) { fSpans.emplace_back(span); }
+    size_t GetNumSpans() const { return fSpans.size(); }
+    void Clear() { fSpans.clear(); }
+
+    // Blends everything added since the last Clear(), and returns when done.
+    void Blend();
+
+    // Blends a single span on the calling thread.
+    static void BlendSpan(const Span& span) { blend_span.call(span); }
+
+protected:
+    typedef void(*blend_span_ptr)(const Span&);
+    static hsCpuFunctionDispatcher<blend_span_ptr> blend_span;
+
+    static void IBlendSpanFPU(const Span& span);
+    static void IBlendSpanSSE2(const Span& span);
+
+    // Pulls the weights and packed palette indices out of a source vert, and
+    // fills in the implied last weight. Returns a pointer to the normal.
+    static inline const uint8_t* IReadWeights(const uint8_t* src, uint8_t numWeights, bool hasIndices,
+                                              float* weights, uint32_t& indices)
+    {
+        float weightSum = 0.f;
+        for (uint8_t j = 0; j < numWeights; ++j) {
+            memcpy(&weights[j], src, sizeof(float));
+            src += sizeof(float);
+            weightSum += weights[j];
+        }
+        weights[numWeights] = 1.f - weightSum;
+
+        if (hasIndices) {
+            memcpy(&indices, src, sizeof(uint32_t));
+            src += sizeof(uint32_t);
+        } else {
+            indices = 1 << 8;
+        }
+        return src;
+    }
+};
+
+#endif // _plSoftwareSkin_inc_
@@ -0,0 +1,107 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "plSoftwareSkin.h"
+
+#include "hsMatrix44.h"
+#include "hsSIMD.h"
+
+#include "plDrawable/plGBufferGroup.h"
+
+//// IBlendSpanSSE2 ///////////////////////////////////////////////////////////
+// Same as IBlendSpanFPU, one matrix row per register. The blended rows are
+// transposed into columns so the transform is just three multiply-adds.
+
+void plSoftwareSkin::IBlendSpanSSE2(const Span& span)
+{
+#ifdef HAVE_SSE2
+    const uint8_t numWeights = (span.fFormat & plGBufferGroup::kSkinWeightMask) >> 4;
+    const bool hasIndices = (span.fFormat & plGBufferGroup::kSkinIndices) != 0;
+    const size_t tailSize = sizeof(uint32_t) * 2 + plGBufferGroup::CalcNumUVs(span.fFormat) * sizeof(float) * 3;
+
+    for (uint32_t i = 0; i < span.fCount; ++i) {
+        const uint8_t* src = span.fSrc + i * span.fSrcStride;
+        uint8_t* dest = span.fDest + i * span.fDestStride;
+
+        float pos[3], norm[3], weights[4];
+        uint32_t indices;
+
+        memcpy(pos, src, sizeof(pos));
+        src = IReadWeights(src + sizeof(pos), numWeights, hasIndices, weights, indices);
+        memcpy(norm, src, sizeof(norm));
+        src += sizeof(norm);
+
+        __m128 row0 = _mm_setzero_ps();
+        __m128 row1 = _mm_setzero_ps();
+        __m128 row2 = _mm_setzero_ps();
+        __m128 row3 = _mm_setzero_ps();
+        for (uint8_t j = 0; j < numWeights + 1; ++j) {
+            const float wgt = weights[j];
+            if (wgt != 0.f) {
+                const uint8_t idx = indices & 0xFF;
+                const hsMatrix44& mat = idx ? span.fPalette[idx] : span.fLocalToWorld;
+                const __m128 mwt = _mm_set1_ps(wgt);
+                row0 = _mm_add_ps(row0, _mm_mul_ps(_mm_loadu_ps(mat.fMap[0]), mwt));
+                row1 = _mm_add_ps(row1, _mm_mul_ps(_mm_loadu_ps(mat.fMap[1]), mwt));
+                row2 = _mm_add_ps(row2, _mm_mul_ps(_mm_loadu_ps(mat.fMap[2]), mwt));
+            }
+            indices >>= 8;
+        }
+        _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+
+        __m128 destNorm = _mm_add_ps(_mm_add_ps(_mm_mul_ps(row0, _mm_set1_ps(norm[0])),
+                                                _mm_mul_ps(row1, _mm_set1_ps(norm[1]))),
+                                     _mm_mul_ps(row2, _mm_set1_ps(norm[2])));
+        __m128 destPos = _mm_add_ps(_mm_add_ps(_mm_mul_ps(row0, _mm_set1_ps(pos[0])),
+                                               _mm_mul_ps(row1, _mm_set1_ps(pos[1]))),
+                                    _mm_add_ps(_mm_mul_ps(row2, _mm_set1_ps(pos[2])), row3));
+
+        alignas(16) float out[8];
+        _mm_store_ps(out, destPos);
+        _mm_store_ps(out + 4, destNorm);
+        memcpy(dest, out, sizeof(float) * 3);
+        memcpy(dest + sizeof(float) * 3, out + 4, sizeof(float) * 3);
+        if (span.fCopyColorsAndUVs)
+            memcpy(dest + sizeof(float) * 6, src, tailSize);
+    }
+#endif // HAVE_SSE2
+}
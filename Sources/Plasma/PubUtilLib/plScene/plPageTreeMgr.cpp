@@ -44,6 +44,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "HeadSpin.h"
 #include "hsFastMath.h"
+#include "hsThreadPool.h"
 #include "plDrawable.h"
 #include "plPipeline.h"
 #include "plProfile.h"
@@ -61,6 +62,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plMath/hsRadixSort.h"
 
 static std::vector<hsRadixSortElem> scratchList;
+static std::vector<hsRadixSortArray::Elem32> spanSortList;
+static hsRadixSortArray spanSorter;
 
 bool plPageTreeMgr::fDisableVisMgr = false;
 
@@ -199,6 +202,9 @@ size_t plPageTreeMgr::IRenderVisList(plPipeline* pipe, std::vector<plDrawVisList
 
     plVisMgr* visMgr = fDisableVisMgr ? nullptr : fVisMgr;
 
+    // Let the pipeline light everything in one go before we start drawing.
+    pipe->PrepLightsForRender(sortedDrawList, visMgr);
+
     // Going through the list in order, if we hit a drawable which doesn't need
     // its spans sorted, we can just draw it.
     // If we hit a drawable which does need its spans sorted, we could just draw
@@ -330,41 +336,39 @@ bool plPageTreeMgr::IRenderSortingSpans(plPipeline* pipe, std::vector<plDrawVisL
     plProfile_BeginTiming(DrawObjSort);
     plProfile_IncCount(DrawObjSorted, pairs.size());
 
-    hsRadixSort::Elem* listTrav;
-    scratchList.resize(pairs.size());
+    spanSortList.resize(pairs.size());
 
     // First, sort on distance to the camera (squared).
-    listTrav = nullptr;
-    int iSort = 0;
-    for (const plDrawSpanPair& pair : pairs)
-    {
-        plDrawable* drawable = drawList[pair.fDrawable]->fDrawable;
-
-        listTrav = &scratchList[iSort++];
-        listTrav->fBody = (intptr_t)&pair;
-        listTrav->fNext = listTrav + 1;
-
-        if( drawable->GetNativeProperty(plDrawable::kPropSortAsOne) )
+    // The keys don't depend on each other, so a big pile of them gets
+    // split up across the thread pool.
+    plConst(float) kDistFudge(1.e-1f);
+    plConst(size_t) kKeysPerJob(256);
+    const float distFudge = kDistFudge;
+    hsThreadPool::Instance().ParallelFor(pairs.size(), kKeysPerJob,
+        [&drawList, &pairs, &viewPos, distFudge](size_t begin, size_t end)
         {
-            const hsBounds3Ext& bnd = drawable->GetSpaceTree()->GetNode(drawable->GetSpaceTree()->GetRoot()).fWorldBounds;
-            plConst(float) kDistFudge(1.e-1f);
-            listTrav->fKey.fFloat = -(bnd.GetCenter() - viewPos).MagnitudeSquared() + float(pair.fSpan) * kDistFudge;
-        }
-        else
-        {
-            const hsBounds3Ext& bnd = drawable->GetSpaceTree()->GetNode(pair.fSpan).fWorldBounds;
-            listTrav->fKey.fFloat = -(bnd.GetCenter() - viewPos).MagnitudeSquared();
-        }
-    }
-    if( !listTrav )
-    {
-        plProfile_EndTiming(DrawObjSort);
-        return false;
-    }
-    listTrav->fNext = nullptr;
-
-    hsRadixSort rad;
-    hsRadixSort::Elem* sortedList = rad.Sort(scratchList.data(), 0);
+            for (size_t iSort = begin; iSort < end; iSort++)
+            {
+                const plDrawSpanPair& pair = pairs[iSort];
+                plDrawable* drawable = drawList[pair.fDrawable]->fDrawable;
+
+                hsRadixSortArray::Elem32* elem = &spanSortList[iSort];
+                elem->fBody = (intptr_t)&pair;
+
+                if( drawable->GetNativeProperty(plDrawable::kPropSortAsOne) )
+                {
+                    const hsBounds3Ext& bnd = drawable->GetSpaceTree()->GetNode(drawable->GetSpaceTree()->GetRoot()).fWorldBounds;
+                    elem->fKey.fFloat = -(bnd.GetCenter() - viewPos).MagnitudeSquared() + float(pair.fSpan) * distFudge;
+                }
+                else
+                {
+                    const hsBounds3Ext& bnd = drawable->GetSpaceTree()->GetNode(pair.fSpan).fWorldBounds;
+                    elem->fKey.fFloat = -(bnd.GetCenter() - viewPos).MagnitudeSquared();
+                }
+            }
+        });
+
+    spanSorter.Sort(spanSortList, hsRadixSort::kFloat);
 
     plProfile_EndTiming(DrawObjSort);
 
@@ -386,12 +390,10 @@ bool plPageTreeMgr::IRenderSortingSpans(plPipeline* pipe, std::vector<plDrawVisL
     // face sorting).
     for (plDrawVisList* dvList : drawList)
         dvList->fVisList.clear();
-    listTrav = sortedList;
-    while( listTrav )
+    for (const hsRadixSortArray::Elem32& elem : spanSortList)
     {
-        plDrawSpanPair& curPair = *(plDrawSpanPair*)listTrav->fBody;
+        const plDrawSpanPair& curPair = *(const plDrawSpanPair*)elem.fBody;
         drawList[curPair.fDrawable]->fVisList.emplace_back(curPair.fSpan);
-        listTrav = listTrav->fNext;
     }
     for (plDrawVisList* dvList : drawList)
     {
@@ -406,44 +408,14 @@ bool plPageTreeMgr::IRenderSortingSpans(plPipeline* pipe, std::vector<plDrawVisL
     // changes, we render what we have so far, and start again with the
     // next drawable. Repeat until done.
 
-#if 0
-    listTrav = sortedList;
-    plDrawSpanPair& curPair = *(plDrawSpanPair*)listTrav->fBody;
-    int curDraw = curPair.fDrawable;
-    visList.emplace_back(curPair.fSpan);
-    listTrav = listTrav->fNext;
-
-    while( listTrav )
-    {
-        curPair = *(plDrawSpanPair*)listTrav->fBody;
-        if( curPair.fDrawable != curDraw )
-        {
-            pipe->Render(drawList[curDraw]->fDrawable, visList);
-            curDraw = curPair.fDrawable;
-            visList.clear();
-            visList.emplace_back(curPair.fSpan);
-        }
-        else
-        {
-            visList.emplace_back(curPair.fSpan);
-        }
-        listTrav = listTrav->fNext;
-    }
-    pipe->Render(drawList[curDraw]->fDrawable, visList);
-#else
-    listTrav = sortedList;
-    plDrawSpanPair& curPair = *(plDrawSpanPair*)listTrav->fBody;
-    int curDraw = curPair.fDrawable;
-    listTrav = listTrav->fNext;
+    int curDraw = ((const plDrawSpanPair*)spanSortList[0].fBody)->fDrawable;
 
     static std::vector<uint32_t> numDrawn;
     numDrawn.assign(drawList.size(), 0);
 
-    visList.emplace_back(drawList[curDraw]->fVisList[numDrawn[curDraw]++]);
-
-    while( listTrav )
+    for (const hsRadixSortArray::Elem32& elem : spanSortList)
     {
-        curPair = *(plDrawSpanPair*)listTrav->fBody;
+        const plDrawSpanPair& curPair = *(const plDrawSpanPair*)elem.fBody;
         if( curPair.fDrawable != curDraw )
         {
             pipe->Render(drawList[curDraw]->fDrawable, visList);
@@ -451,10 +423,8 @@ bool plPageTreeMgr::IRenderSortingSpans(plPipeline* pipe, std::vector<plDrawVisL
             visList.clear();
         }
         visList.emplace_back(drawList[curDraw]->fVisList[numDrawn[curDraw]++]);
-        listTrav = listTrav->fNext;
     }
     pipe->Render(drawList[curDraw]->fDrawable, visList);
-#endif
 
     return true;
 }
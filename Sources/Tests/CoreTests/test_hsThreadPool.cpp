@@ -0,0 +1,173 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "hsThreadPool.h"
+
+// Runs ParallelFor and checks that every index was visited exactly once, in
+// ranges no bigger than the grain size.
+static void ICheckCoverage(hsThreadPool& pool, size_t count, size_t grainSize)
+{
+    std::unique_ptr<std::atomic<int>[]> visits(new std::atomic<int>[count ? count : 1]);
+    for (size_t i = 0; i < count; ++i)
+        visits[i] = 0;
+    std::atomic<size_t> oversized(0);
+
+    pool.ParallelFor(count, grainSize, [&](size_t begin, size_t end) {
+        if (end - begin > std::max<size_t>(grainSize, 1))
+            ++oversized;
+        for (size_t i = begin; i < end; ++i)
+            ++visits[i];
+    });
+
+    EXPECT_EQ(0u, oversized.load()) << "count " << count << " grain " << grainSize;
+    for (size_t i = 0; i < count; ++i)
+        ASSERT_EQ(1, visits[i].load()) << "index " << i << " count " << count << " grain " << grainSize;
+}
+
+TEST(hsThreadPool, ParallelForEmptyRange)
+{
+    hsThreadPool pool(3);
+
+    bool called = false;
+    pool.ParallelFor(0, 1, [&called](size_t, size_t) { called = true; });
+    EXPECT_FALSE(called);
+}
+
+TEST(hsThreadPool, ParallelForLessThanGrain)
+{
+    hsThreadPool pool(3);
+
+    // Fits in a single range, which runs right here on the caller
+    std::vector<std::pair<size_t, size_t>> ranges;
+    pool.ParallelFor(5, 16, [&ranges](size_t begin, size_t end) { ranges.emplace_back(begin, end); });
+    ASSERT_EQ(1u, ranges.size());
+    EXPECT_EQ(0u, ranges[0].first);
+    EXPECT_EQ(5u, ranges[0].second);
+
+    ICheckCoverage(pool, 5, 16);
+}
+
+TEST(hsThreadPool, ParallelForCoversEveryIndexOnce)
+{
+    hsThreadPool pool(3);
+
+    for (size_t count : { 1, 2, 7, 64, 1000, 1001 }) {
+        for (size_t grainSize : { 0, 1, 3, 16, 1000 })
+            ICheckCoverage(pool, count, grainSize);
+    }
+}
+
+TEST(hsThreadPool, ParallelForWithoutWorkers)
+{
+    hsThreadPool pool(0);
+    ICheckCoverage(pool, 100, 7);
+}
+
+TEST(hsThreadPool, NestedParallelFor)
+{
+    // Fewer workers than outer ranges, so every worker ends up blocked in
+    // an inner ParallelFor that only finishes because the callers help out.
+    hsThreadPool pool(2);
+
+    std::atomic<size_t> total(0);
+    pool.ParallelFor(16, 1, [&pool, &total](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            pool.ParallelFor(100, 10, [&total](size_t innerBegin, size_t innerEnd) {
+                total += innerEnd - innerBegin;
+            });
+        }
+    });
+    EXPECT_EQ(16u * 100u, total.load());
+
+    // Same thing, starting from a submitted task
+    total = 0;
+    std::future<void> task = pool.Submit([&pool, &total] {
+        pool.ParallelFor(50, 1, [&total](size_t begin, size_t end) { total += end - begin; });
+    });
+    task.get();
+    EXPECT_EQ(50u, total.load());
+}
+
+TEST(hsThreadPool, SubmitFutures)
+{
+    hsThreadPool pool(3);
+
+    std::vector<int> results(32, 0);
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < results.size(); ++i)
+        futures.push_back(pool.Submit([&results, i] { results[i] = int(i) * 2; }));
+
+    // Each task's writes are visible once its future is ready
+    for (size_t i = 0; i < futures.size(); ++i) {
+        futures[i].get();
+        EXPECT_EQ(int(i) * 2, results[i]);
+    }
+
+    // Exceptions come back through the future instead of killing the worker
+    std::future<void> failed = pool.Submit([] { throw std::runtime_error("task failed"); });
+    EXPECT_THROW(failed.get(), std::runtime_error);
+
+    bool ranAfter = false;
+    pool.Submit([&ranAfter] { ranAfter = true; }).get();
+    EXPECT_TRUE(ranAfter);
+}
+
+TEST(hsThreadPool, SubmitWithoutWorkers)
+{
+    hsThreadPool pool(0);
+
+    bool ran = false;
+    std::future<void> task = pool.Submit([&ran] { ran = true; });
+    EXPECT_TRUE(ran);
+    EXPECT_EQ(std::future_status::ready, task.wait_for(std::chrono::seconds(0)));
+}
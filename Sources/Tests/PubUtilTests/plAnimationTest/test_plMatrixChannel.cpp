@@ -0,0 +1,161 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include "hsThreadPool.h"
+
+#include "plAnimation/plMatrixChannel.h"
+#include "plInterp/hsKeys.h"
+#include "plInterp/plAnimTimeConvert.h"
+#include "plInterp/plController.h"
+
+#include <memory>
+#include <vector>
+
+static constexpr size_t kNumKeys = 12;
+static constexpr size_t kNumInstances = 64;
+static constexpr size_t kNumFrames = 40;
+
+// A position-only animation; rotation and scale come from the initial parts
+static plMatrixControllerChannel* IMakeChannel()
+{
+    plLeafController* pos = new plLeafController;
+    pos->AllocKeys(kNumKeys, hsKeyFrame::kPoint3KeyFrame);
+    hsPoint3Key* keys = static_cast<hsPoint3Key*>(pos->GetKeyBuffer());
+    for (size_t i = 0; i < kNumKeys; i++) {
+        keys[i].fFrame = uint16_t(i * 10);
+        keys[i].fValue.Set(float(i), float(i * i), -float(i));
+    }
+
+    plCompoundController* ctrl = new plCompoundController;
+    ctrl->SetPosController(pos);
+
+    hsAffineParts parts;
+    parts.Reset();
+    parts.fK.Set(2.f, 3.f, 4.f);
+    return new plMatrixControllerChannel(ctrl, &parts);
+}
+
+// Each instance plays the shared animation at its own rate and offset
+static double ITime(size_t instance, size_t frame)
+{
+    return double(instance % 5) * 0.3 + double(frame) * (0.02 + 0.005 * double(instance % 7));
+}
+
+class plMatrixCacheChannelTest : public ::testing::Test
+{
+protected:
+    plMatrixControllerChannel* fSource;
+    std::vector<std::unique_ptr<plAnimTimeConvert>> fConverts;
+    std::vector<plAGChannel*> fCaches;
+
+    void SetUp() override
+    {
+        fSource = IMakeChannel();
+        for (size_t i = 0; i < kNumInstances; i++)
+            fConverts.emplace_back(std::make_unique<plAnimTimeConvert>());
+    }
+
+    void TearDown() override
+    {
+        IClearCaches();
+        delete fSource;
+    }
+
+    void IMakeCaches()
+    {
+        IClearCaches();
+        for (size_t i = 0; i < kNumInstances; i++)
+            fCaches.push_back(fSource->MakeCacheChannel(fConverts[i].get()));
+    }
+
+    void IClearCaches()
+    {
+        for (plAGChannel* cache : fCaches)
+            delete cache;
+        fCaches.clear();
+    }
+
+    hsMatrix44 IEval(size_t instance, size_t frame)
+    {
+        plMatrixChannel* channel = plMatrixChannel::ConvertNoRef(fCaches[instance]);
+        return channel->Value(ITime(instance, frame));
+    }
+};
+
+TEST_F(plMatrixCacheChannelTest, keeps_initial_parts)
+{
+    IMakeCaches();
+
+    plMatrixChannel* channel = plMatrixChannel::ConvertNoRef(fCaches[0]);
+    ASSERT_NE(nullptr, channel);
+    const hsAffineParts& parts = channel->AffineValue(0.5);
+    EXPECT_EQ(2.f, parts.fK.fX);
+    EXPECT_EQ(3.f, parts.fK.fY);
+    EXPECT_EQ(4.f, parts.fK.fZ);
+}
+
+TEST_F(plMatrixCacheChannelTest, parallel_matches_serial)
+{
+    std::vector<hsMatrix44> expected(kNumInstances * kNumFrames);
+    std::vector<hsMatrix44> actual(kNumInstances * kNumFrames);
+
+    // Interleaved on one thread, the way a frame used to be evaluated
+    IMakeCaches();
+    for (size_t frame = 0; frame < kNumFrames; frame++) {
+        for (size_t i = 0; i < kNumInstances; i++)
+            expected[i * kNumFrames + frame] = IEval(i, frame);
+    }
+
+    // Each instance on whichever thread picks it up
+    IMakeCaches();
+    hsThreadPool::Instance().ParallelFor(kNumInstances, 1, [this, &actual](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            for (size_t frame = 0; frame < kNumFrames; frame++)
+                actual[i * kNumFrames + frame] = IEval(i, frame);
+        }
+    });
+
+    for (size_t i = 0; i < expected.size(); i++)
+        EXPECT_TRUE(expected[i] == actual[i]) << "instance " << (i / kNumFrames) << " frame " << (i % kNumFrames);
+}
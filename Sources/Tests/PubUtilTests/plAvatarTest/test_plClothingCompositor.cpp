@@ -0,0 +1,155 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011 Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include "hsBitVector.h"
+#include "hsResMgr.h"
+
+#include "plAvatar/plAvatarClothing.h"
+#include "plAvatar/plClothingCompositor.h"
+#include "plGImage/plMipmap.h"
+#include "plResMgr/plResManager.h"
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+// Assorted creatables needed to make it link...
+#include "pnAllCreatables.h"
+#include "plAllCreatables.h"
+#include "pfAnimation/pfAnimationCreatable.h"
+#include "pfAudio/pfAudioCreatable.h"
+#include "pfCamera/pfCameraCreatable.h"
+#include "pfConditional/plConditionalObjectCreatable.h"
+#include "pfMessage/pfMessageCreatable.h"
+
+static constexpr uint32_t kBaseWidth = 64;
+
+class plClothingCompositorTest : public ::testing::Test
+{
+protected:
+    plMipmap* fBaseTexture;
+    plClothingBase fBase;
+    plClothingItem fItem;
+    std::unique_ptr<plClothingOutfit> fOutfit;
+
+    // Same size, different spots in the layout
+    plClothingElement fLeft{ ST_LITERAL("Left"), 0, 0, 256, 256 };
+    plClothingElement fRight{ ST_LITERAL("Right"), 512, 512, 256, 256 };
+
+    void SetUp() override
+    {
+        hsgResMgr::Init(new plResManager);
+        plClothingMgr::Init();
+
+        // The cache only takes elements built from keyed textures
+        fBaseTexture = new plMipmap(kBaseWidth, kBaseWidth, plMipmap::kARGB32Config, 1);
+        hsgResMgr::ResMgr()->NewKey(ST_LITERAL("ClothingBase"), fBaseTexture, plLocation::kGlobalFixedLoc);
+
+        uint32_t* pixels = static_cast<uint32_t*>(fBaseTexture->GetImage());
+        for (uint32_t i = 0; i < kBaseWidth * kBaseWidth; i++)
+            pixels[i] = 0xff000000 | (i * 2654435761U >> 8);
+
+        fBase.fBaseTexture = fBaseTexture;
+        fBase.SetLayoutName(ST_LITERAL("BasicHuman"));
+
+        // An item that covers both elements without drawing anything
+        fItem.fElements = { &fLeft, &fRight };
+        for (size_t i = 0; i < fItem.fElements.size(); i++)
+            fItem.fTextures.emplace_back(new plMipmap*[plClothingElement::kLayerMax]());
+
+        fOutfit = std::make_unique<plClothingOutfit>();
+        fOutfit->fBase = &fBase;
+        fOutfit->fItems.emplace_back(&fItem);
+
+        plClothingCompositor::FlushCache();
+    }
+
+    void TearDown() override
+    {
+        // The cache holds on to texture keys
+        plClothingCompositor::FlushCache();
+        plClothingCompositor::SetCacheBudget(16 * 1024 * 1024);
+
+        // These all let go through the dispatcher
+        fOutfit.reset();
+        delete fBaseTexture;
+
+        plClothingMgr::DeInit();
+        hsgResMgr::Shutdown();
+    }
+
+    std::vector<uint32_t> IComposite()
+    {
+        hsBitVector dirty;
+        dirty.Set(plClothingLayout::kMaxTileset);
+
+        plClothingCompositor compositor;
+        plMipmap* texture = compositor.Update(fOutfit.get(), dirty);
+        if (texture == nullptr)
+            return {};
+
+        const uint32_t* pixels = static_cast<const uint32_t*>(texture->GetImage());
+        return std::vector<uint32_t>(pixels, pixels + texture->GetWidth() * texture->GetHeight());
+    }
+};
+
+TEST_F(plClothingCompositorTest, CachedElementsMatchUncached)
+{
+    // Nothing fits in the cache, so every element is composited
+    plClothingCompositor::SetCacheBudget(0);
+    std::vector<uint32_t> uncached = IComposite();
+    ASSERT_EQ(uncached.size(), kBaseWidth * kBaseWidth);
+
+    // Everything fits, so the second element would find the first one if
+    // the cache didn't know where they go
+    plClothingCompositor::SetCacheBudget(16 * 1024 * 1024);
+    std::vector<uint32_t> filled = IComposite();
+    ASSERT_EQ(filled.size(), uncached.size());
+    EXPECT_EQ(memcmp(filled.data(), uncached.data(), uncached.size() * sizeof(uint32_t)), 0);
+
+    // And built straight from the cache
+    std::vector<uint32_t> shared = IComposite();
+    ASSERT_EQ(shared.size(), uncached.size());
+    EXPECT_EQ(memcmp(shared.data(), uncached.data(), uncached.size() * sizeof(uint32_t)), 0);
+}
@@ -0,0 +1,290 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include "HeadSpin.h"
+#include "hsFastMath.h"
+#include "hsGeometry3.h"
+
+#include "plDrawable/plAccessSpan.h"
+#include "plDrawable/plMorphArray.h"
+#include "plDrawable/plMorphDelta.h"
+#include "plDrawable/plMorphSequence.h"
+
+#include <random>
+#include <vector>
+
+// Assorted creatables needed to make it link...
+#include "pnAllCreatables.h"
+#include "plAllCreatables.h"
+#include "pfAnimation/pfAnimationCreatable.h"
+#include "pfAudio/pfAudioCreatable.h"
+#include "pfCamera/pfCameraCreatable.h"
+#include "pfConditional/plConditionalObjectCreatable.h"
+#include "pfMessage/pfMessageCreatable.h"
+
+static constexpr uint16_t kNumVerts = 100;
+static constexpr uint16_t kMaxUVWs = 2;
+static constexpr size_t kNumSpans = 2;
+static constexpr size_t kNumDeltas = 6;
+
+// Gets at the incremental steps without needing a scene object
+class plTestMorphSequence : public plMorphSequence
+{
+public:
+    using plMorphSequence::INeedsRebuild;
+    using plMorphSequence::IGatherChanges;
+    using plMorphSequence::IAccumulate;
+    using plMorphSequence::IFlush;
+};
+
+struct plTestMorphVert
+{
+    hsPoint3    fPos;
+    hsVector3   fNorm;
+    hsPoint3    fUVWs[kMaxUVWs];
+};
+
+// A mesh of kNumSpans spans, each with a different number of UVWs
+struct plTestMorphMesh
+{
+    std::vector<plTestMorphVert> fVerts[kNumSpans];
+    std::vector<plAccessSpan> fSpans;
+
+    plTestMorphMesh() : fSpans(kNumSpans, plAccessSpan(plAccessSpan::kVtx))
+    {
+        for (size_t i = 0; i < kNumSpans; i++) {
+            fVerts[i].resize(kNumVerts);
+
+            plTestMorphVert* verts = fVerts[i].data();
+            plAccessVtxSpan& acc = fSpans[i].AccessVtx();
+            acc.ClearVerts();
+            acc.SetVertCount(kNumVerts);
+            acc.PositionStream(&verts->fPos, sizeof(plTestMorphVert), 0);
+            acc.NormalStream(&verts->fNorm, sizeof(plTestMorphVert), 0);
+            acc.UVWStream(verts->fUVWs, sizeof(plTestMorphVert), 0);
+            acc.SetNumUVWs(int(i + 1));
+        }
+    }
+
+    void CopyVerts(const plTestMorphMesh& src)
+    {
+        for (size_t i = 0; i < kNumSpans; i++)
+            fVerts[i] = src.fVerts[i];
+    }
+};
+
+class plMorphSequenceTest : public ::testing::Test
+{
+protected:
+    std::mt19937 fRng;
+    plTestMorphMesh fBase;
+    std::vector<plMorphArray> fMorphs;
+    std::vector<plMorphArrayWeights> fWeights;
+
+    plMorphSequenceTest() : fRng(1), fMorphs(1), fWeights(1) { }
+
+    float IRandom(float lo, float hi)
+    {
+        return std::uniform_real_distribution<float>(lo, hi)(fRng);
+    }
+
+    void SetUp() override
+    {
+        for (size_t i = 0; i < kNumSpans; i++) {
+            for (plTestMorphVert& vert : fBase.fVerts[i]) {
+                vert.fPos.Set(IRandom(-1.f, 1.f), IRandom(-1.f, 1.f), IRandom(-1.f, 1.f));
+                vert.fNorm.Set(IRandom(-1.f, 1.f), IRandom(-1.f, 1.f), 1.f);
+                vert.fNorm.Normalize();
+                for (hsPoint3& uvw : vert.fUVWs)
+                    uvw.Set(IRandom(0.f, 1.f), IRandom(0.f, 1.f), 0.f);
+            }
+        }
+
+        // Each delta moves a random third or so of each span
+        for (size_t iDel = 0; iDel < kNumDeltas; iDel++) {
+            plMorphDelta delta;
+            delta.SetNumSpans(kNumSpans);
+            for (size_t iSpan = 0; iSpan < kNumSpans; iSpan++) {
+                std::vector<plVertDelta> deltas;
+                std::vector<hsPoint3> uvws;
+                for (uint16_t iVtx = 0; iVtx < kNumVerts; iVtx++) {
+                    if (fRng() % 3)
+                        continue;
+                    hsVector3 pos(IRandom(-.5f, .5f), IRandom(-.5f, .5f), IRandom(-.5f, .5f));
+                    hsVector3 norm(IRandom(-.5f, .5f), IRandom(-.5f, .5f), IRandom(-.5f, .5f));
+                    deltas.emplace_back(iVtx, pos, norm);
+                    for (size_t iUVW = 0; iUVW <= iSpan; iUVW++)
+                        uvws.emplace_back(IRandom(-.1f, .1f), IRandom(-.1f, .1f), 0.f);
+                }
+                delta.SetDeltas(iSpan, deltas, iSpan + 1, uvws.data());
+            }
+            fMorphs[0].AddDelta(delta);
+        }
+        fWeights[0].fDeltaWeights.assign(kNumDeltas, 0.f);
+    }
+
+    // What plMorphSequence::Apply() does: start from the base, apply
+    // every weighted delta, then renormalize.
+    void IApplyFull(plTestMorphMesh& mesh) const
+    {
+        mesh.CopyVerts(fBase);
+        for (size_t iDel = 0; iDel < kNumDeltas; iDel++)
+            fMorphs[0].GetDelta(iDel).Apply(mesh.fSpans, fWeights[0].fDeltaWeights[iDel]);
+        for (size_t i = 0; i < kNumSpans; i++) {
+            for (plTestMorphVert& vert : mesh.fVerts[i])
+                hsFastMath::Normalize(vert.fNorm);
+        }
+    }
+
+    // What plMorphSequence::IApplyIncremental() does, returns whether the
+    // sums had to be rebuilt.
+    bool IApplyIncremental(plTestMorphMesh& mesh, plMorphMeshState& state) const
+    {
+        bool rebuilt = false;
+        if (plTestMorphSequence::INeedsRebuild(state)) {
+            state.Invalidate();
+            mesh.CopyVerts(fBase);
+            state.fSpans.resize(kNumSpans);
+            for (size_t i = 0; i < kNumSpans; i++)
+                state.fSpans[i].Init(mesh.fSpans[i].AccessVtx());
+            state.fValid = true;
+            rebuilt = true;
+        }
+
+        plTestMorphSequence::IGatherChanges(state, fMorphs, &fWeights);
+        plTestMorphSequence::IAccumulate({ &state });
+
+        std::vector<plMorphAccum*> accs;
+        for (plMorphAccum& acc : state.fSpans)
+            accs.emplace_back(&acc);
+        plTestMorphSequence::IFlush(accs, mesh.fSpans);
+        return rebuilt;
+    }
+};
+
+static void ICompareMeshes(const plTestMorphMesh& full, const plTestMorphMesh& incr, size_t update)
+{
+    for (size_t i = 0; i < kNumSpans; i++) {
+        for (uint16_t j = 0; j < kNumVerts; j++) {
+            const plTestMorphVert& a = full.fVerts[i][j];
+            const plTestMorphVert& b = incr.fVerts[i][j];
+            ASSERT_NEAR(a.fPos.fX, b.fPos.fX, 1.e-4f) << "update " << update << " span " << i << " vert " << j;
+            ASSERT_NEAR(a.fPos.fY, b.fPos.fY, 1.e-4f) << "update " << update << " span " << i << " vert " << j;
+            ASSERT_NEAR(a.fPos.fZ, b.fPos.fZ, 1.e-4f) << "update " << update << " span " << i << " vert " << j;
+
+            // The fast normalize is only good to a few bits, and the
+            // sums differ from the full reapply in the last few
+            ASSERT_NEAR(a.fNorm.fX, b.fNorm.fX, 1.e-3f) << "update " << update << " span " << i << " vert " << j;
+            ASSERT_NEAR(a.fNorm.fY, b.fNorm.fY, 1.e-3f) << "update " << update << " span " << i << " vert " << j;
+            ASSERT_NEAR(a.fNorm.fZ, b.fNorm.fZ, 1.e-3f) << "update " << update << " span " << i << " vert " << j;
+
+            for (size_t k = 0; k <= i; k++) {
+                ASSERT_NEAR(a.fUVWs[k].fX, b.fUVWs[k].fX, 1.e-4f) << "update " << update << " span " << i << " vert " << j;
+                ASSERT_NEAR(a.fUVWs[k].fY, b.fUVWs[k].fY, 1.e-4f) << "update " << update << " span " << i << " vert " << j;
+            }
+        }
+    }
+}
+
+TEST_F(plMorphSequenceTest, IncrementalMatchesFullApply)
+{
+    plTestMorphMesh full, incr;
+    plMorphMeshState state;
+
+    // Enough updates to go past the rebuild after 256 of them
+    const size_t kNumUpdates = 300;
+    size_t numRebuilds = 0;
+    for (size_t update = 0; update < kNumUpdates; update++) {
+        // Move a weight or two, sometimes down to nothing or up from nothing
+        std::vector<float>& weights = fWeights[0].fDeltaWeights;
+        weights[fRng() % kNumDeltas] = (fRng() % 4) ? IRandom(0.f, 1.f) : 0.f;
+        if (fRng() % 2)
+            weights[fRng() % kNumDeltas] = IRandom(0.f, 0.02f);
+        // Make sure something changes every time
+        weights[update % kNumDeltas] = float(update % 7 + 1) / 8.f;
+
+        IApplyFull(full);
+        if (IApplyIncremental(incr, state))
+            numRebuilds++;
+
+        ICompareMeshes(full, incr, update);
+        if (HasFatalFailure())
+            return;
+    }
+
+    // Once to start, and once more after 256 updates
+    EXPECT_EQ(numRebuilds, 2u);
+}
+
+TEST_F(plMorphSequenceTest, NoChangeWritesNothing)
+{
+    plTestMorphMesh incr;
+    plMorphMeshState state;
+
+    fWeights[0].fDeltaWeights[0] = 1.f;
+    IApplyIncremental(incr, state);
+    uint32_t numUpdates = state.fNumUpdates;
+
+    // Scribble on the output, an update with no changes shouldn't touch it
+    std::vector<plTestMorphVert> before = incr.fVerts[0];
+    incr.fVerts[0][0].fPos.Set(100.f, 100.f, 100.f);
+    IApplyIncremental(incr, state);
+    EXPECT_EQ(state.fNumUpdates, numUpdates);
+    EXPECT_EQ(incr.fVerts[0][0].fPos.fX, 100.f);
+}
+
+TEST(plMorphMeshState, EmptyMeshStaysValid)
+{
+    // A mesh with no spans is still a valid (if boring) mesh, and
+    // shouldn't be rebuilt every time it's applied
+    plMorphMeshState state;
+    EXPECT_TRUE(plTestMorphSequence::INeedsRebuild(state));
+
+    state.fValid = true;
+    EXPECT_TRUE(state.IsValid());
+    EXPECT_FALSE(plTestMorphSequence::INeedsRebuild(state));
+
+    state.Invalidate();
+    EXPECT_FALSE(state.IsValid());
+}
@@ -0,0 +1,590 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include "HeadSpin.h"
+#include "hsBitVector.h"
+#include "hsBounds.h"
+#include "hsGeometry3.h"
+#include "hsMatrix44.h"
+#include "plViewTransform.h"
+
+#include "plDrawable/plSpaceTree.h"
+#include "plDrawable/plSpaceTreeMaker.h"
+#include "plIntersect/plVolumeIsect.h"
+#include "plPipeline/plCullTree.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Assorted creatables needed to make it link...
+#include "pnAllCreatables.h"
+#include "plAllCreatables.h"
+#include "pfAnimation/pfAnimationCreatable.h"
+#include "pfAudio/pfAudioCreatable.h"
+#include "pfCamera/pfCameraCreatable.h"
+#include "pfConditional/plConditionalObjectCreatable.h"
+#include "pfMessage/pfMessageCreatable.h"
+
+static constexpr size_t kNumLeaves = 300;
+static constexpr float kRange = 100.f;
+
+class plSpaceTreeTest : public ::testing::Test
+{
+protected:
+    std::mt19937 fRng;
+    std::vector<hsBounds3Ext> fLeaves;
+    std::vector<bool> fDisabled;
+    std::vector<bool> fMoved;
+    float fOldThreshold;
+
+    plSpaceTreeTest() : fRng(1), fOldThreshold() { }
+
+    float IRandom(float lo, float hi)
+    {
+        return std::uniform_real_distribution<float>(lo, hi)(fRng);
+    }
+
+    // Mostly axis aligned boxes, every fourth one turned so it carries its own axes.
+    hsBounds3Ext IRandomBounds(float range, float size = 5.f)
+    {
+        hsPoint3 mins(-IRandom(0.1f, size), -IRandom(0.1f, size), -IRandom(0.1f, size));
+        hsPoint3 maxs(IRandom(0.1f, size), IRandom(0.1f, size), IRandom(0.1f, size));
+        hsBounds3Ext bnd;
+        bnd.Reset(&mins);
+        bnd.Union(&maxs);
+
+        hsMatrix44 l2w;
+        if (fRng() % 4)
+            l2w.Reset();
+        else
+            l2w.MakeRotateMat(int(fRng() % 3), IRandom(0.1f, 1.5f));
+        l2w.fMap[0][3] = IRandom(-range, range);
+        l2w.fMap[1][3] = IRandom(-range, range);
+        l2w.fMap[2][3] = IRandom(-range, range);
+        l2w.NotIdentity();
+        bnd.Transform(&l2w);
+
+        return bnd;
+    }
+
+    void SetUp() override
+    {
+        fOldThreshold = plSpaceTree::GetRebuildThreshold();
+
+        for (size_t i = 0; i < kNumLeaves; i++) {
+            fLeaves.emplace_back(IRandomBounds(kRange));
+            fDisabled.emplace_back(fRng() % 10 == 0);
+        }
+        fMoved.assign(kNumLeaves, false);
+    }
+
+    void TearDown() override
+    {
+        plSpaceTree::SetRebuildThreshold(fOldThreshold);
+        plSpaceTree::SetHotCulling(true);
+    }
+
+    plSpaceTree* IMakeTree(const std::vector<hsBounds3Ext>& leaves) const
+    {
+        plSpaceTreeMaker maker;
+        maker.Reset();
+        for (size_t i = 0; i < leaves.size(); i++)
+            maker.AddLeaf(leaves[i], fDisabled[i]);
+        return maker.MakeTree();
+    }
+
+    // Moves every third leaf or so, a few of them onto empty bounds.
+    void IMoveLeaves(plSpaceTree* tree, float range)
+    {
+        for (size_t i = 0; i < kNumLeaves; i++) {
+            if (fRng() % 3)
+                continue;
+            if (fRng() % 20)
+                fLeaves[i] = IRandomBounds(range);
+            else
+                fLeaves[i].MakeEmpty();
+            tree->MoveLeaf(int16_t(i), fLeaves[i]);
+            fMoved[i] = true;
+        }
+    }
+
+    void IRandomSphere(plSphereIsect& sphere)
+    {
+        hsMatrix44 ident;
+        ident.Reset();
+
+        sphere.SetCenter(hsPoint3(IRandom(-kRange, kRange), IRandom(-kRange, kRange), IRandom(-kRange, kRange)));
+        sphere.SetRadius(IRandom(1.f, kRange));
+        sphere.SetTransform(ident, ident);
+    }
+
+    std::vector<plSphereIsect> IMakeSpheres(size_t n)
+    {
+        std::vector<plSphereIsect> spheres(n);
+        for (plSphereIsect& sphere : spheres)
+            IRandomSphere(sphere);
+        return spheres;
+    }
+
+    void IRandomFrustum(plCullTree& cull, float range)
+    {
+        hsPoint3 from(IRandom(-range, range), IRandom(-range, range), IRandom(-range, range));
+        hsPoint3 at(IRandom(-range, range), IRandom(-range, range), IRandom(-range, range));
+        hsMatrix44 w2c, c2w;
+        hsMatrix44::MakeCameraMatrices(from, at, hsVector3(0.f, 0.f, 1.f), w2c, c2w);
+
+        plViewTransform view;
+        view.SetCameraTransform(w2c, c2w);
+        view.SetPerspective(true);
+        view.SetFovDeg(IRandom(30.f, 90.f), IRandom(30.f, 90.f));
+        view.SetDepth(0.3f, IRandom(range * 0.5f, range * 4.f));
+
+        cull.SetViewPos(from);
+        cull.InitFrustum(view.GetWorldToNDC());
+    }
+
+    plBoundsIsect* IRandomBoxIsect(float size)
+    {
+        plBoundsIsect* box = new plBoundsIsect;
+        box->SetBounds(IRandomBounds(kRange, size));
+        return box;
+    }
+
+    // Every kind of volume that says what box it fits in: spheres, boxes (some of
+    // them oriented), and unions and intersections of those. The last kind is two
+    // boxes with a gap between them, which plenty of leaves reach across.
+    std::vector<std::unique_ptr<plVolumeIsect>> IMakeVolumes(size_t n)
+    {
+        std::vector<std::unique_ptr<plVolumeIsect>> volumes;
+        for (size_t i = 0; i < n; i++) {
+            switch (i % 5) {
+            case 0:
+                {
+                    plSphereIsect* sphere = new plSphereIsect;
+                    IRandomSphere(*sphere);
+                    volumes.emplace_back(sphere);
+                }
+                break;
+            case 1:
+                volumes.emplace_back(IRandomBoxIsect(kRange * 0.5f));
+                break;
+            case 2:
+            case 3:
+                {
+                    plComplexIsect* complex;
+                    if (i % 5 == 2)
+                        complex = new plUnionIsect;
+                    else
+                        complex = new plIntersectionIsect;
+                    plSphereIsect* sphere = new plSphereIsect;
+                    IRandomSphere(*sphere);
+                    complex->AddVolume(sphere);
+                    complex->AddVolume(IRandomBoxIsect(kRange * 0.5f));
+                    volumes.emplace_back(complex);
+                }
+                break;
+            case 4:
+                {
+                    hsBounds3Ext bnd = IRandomBounds(kRange, kRange * 0.25f);
+                    plBoundsIsect* box = new plBoundsIsect;
+                    box->SetBounds(bnd);
+                    bnd.Translate(hsVector3(bnd.GetMaxs().fX - bnd.GetMins().fX + 1.f, 0.f, 0.f));
+                    plBoundsIsect* next = new plBoundsIsect;
+                    next->SetBounds(bnd);
+
+                    plIntersectionIsect* complex = new plIntersectionIsect;
+                    complex->AddVolume(box);
+                    complex->AddVolume(next);
+                    volumes.emplace_back(complex);
+                }
+                break;
+            }
+        }
+        return volumes;
+    }
+
+    static std::vector<int16_t> IHarvest(const plSpaceTree& tree, plVolumeIsect& cull)
+    {
+        std::vector<int16_t> list;
+        tree.HarvestLeaves(&cull, list);
+        std::sort(list.begin(), list.end());
+        return list;
+    }
+
+    static std::vector<int16_t> IHarvestEnabled(const plSpaceTree& tree, plVolumeIsect& cull, const hsBitVector& cache)
+    {
+        std::vector<int16_t> list;
+        tree.HarvestEnabledLeaves(&cull, cache, list);
+        std::sort(list.begin(), list.end());
+        return list;
+    }
+
+    static void ICheckSameBounds(const hsBounds3Ext& a, const hsBounds3Ext& b)
+    {
+        ASSERT_EQ(a.GetType(), b.GetType());
+        if (a.GetType() != kBoundsNormal)
+            return;
+        for (int i = 0; i < 3; i++) {
+            EXPECT_EQ(a.GetMins()[i], b.GetMins()[i]);
+            EXPECT_EQ(a.GetMaxs()[i], b.GetMaxs()[i]);
+        }
+    }
+
+    static void ICheckContains(const hsBounds3Ext& outer, const hsBounds3Ext& inner)
+    {
+        if (inner.GetType() != kBoundsNormal)
+            return;
+        ASSERT_EQ(outer.GetType(), kBoundsNormal);
+        for (int i = 0; i < 3; i++) {
+            EXPECT_LE(outer.GetMins()[i], inner.GetMins()[i]);
+            EXPECT_GE(outer.GetMaxs()[i], inner.GetMaxs()[i]);
+        }
+    }
+
+    // Every interior node holds its enabled children, every leaf
+    // is reached exactly once from the root, and leaf i is still fLeaves[i].
+    void ICheckTree(const plSpaceTree& tree) const
+    {
+        ASSERT_EQ(tree.GetNumLeaves(), int32_t(kNumLeaves));
+
+        std::vector<int> seen(kNumLeaves);
+        std::vector<int16_t> stack { tree.GetRoot() };
+        ASSERT_EQ(tree.GetNode(tree.GetRoot()).GetParent(), int16_t(plSpaceTree::kRootParent));
+        while (!stack.empty()) {
+            int16_t idx = stack.back();
+            stack.pop_back();
+
+            const plSpaceTreeNode& node = tree.GetNode(idx);
+            EXPECT_FALSE(node.fFlags & plSpaceTreeNode::kDirty);
+            if (node.IsLeaf()) {
+                ASSERT_EQ(node.GetLeaf(), idx);
+                ASSERT_LT(size_t(idx), kNumLeaves);
+                seen[idx]++;
+                continue;
+            }
+
+            hsBounds3Ext expected;
+            expected.MakeEmpty();
+            for (int i = 0; i < 2; i++) {
+                const plSpaceTreeNode& child = tree.GetNode(node.GetChild(i));
+                ASSERT_EQ(child.GetParent(), idx);
+                if (!(child.fFlags & plSpaceTreeNode::kDisabled))
+                    expected.Union(&child.fWorldBounds);
+                stack.emplace_back(node.GetChild(i));
+            }
+            SCOPED_TRACE(idx);
+            ICheckContains(node.fWorldBounds, expected);
+        }
+
+        for (size_t i = 0; i < kNumLeaves; i++) {
+            SCOPED_TRACE(i);
+            EXPECT_EQ(seen[i], 1);
+            EXPECT_EQ(bool(tree.HasLeafFlag(int16_t(i), plSpaceTreeNode::kDisabled)), bool(fDisabled[i]));
+            ICheckSameBounds(tree.GetNode(int16_t(i)).fWorldBounds, fLeaves[i]);
+        }
+    }
+};
+
+TEST_F(plSpaceTreeTest, RefitMatchesFullRefresh)
+{
+    plSpaceTree::SetRebuildThreshold(0.f);
+
+    const std::vector<hsBounds3Ext> initial = fLeaves;
+    std::unique_ptr<plSpaceTree> refit(IMakeTree(initial));
+    refit->Refresh();
+
+    for (int pass = 0; pass < 20; pass++) {
+        IMoveLeaves(refit.get(), kRange * 1.5f);
+        refit->Refresh();
+
+        // The first Refresh on a tree does the full top down IRefreshRecur. Built
+        // from the same starting bounds, the node layout matches the refit tree,
+        // and dirtying every leaf that has ever moved dirties the same nodes.
+        std::unique_ptr<plSpaceTree> full(IMakeTree(initial));
+        for (size_t i = 0; i < kNumLeaves; i++) {
+            if (fMoved[i])
+                full->MoveLeaf(int16_t(i), fLeaves[i]);
+        }
+        full->Refresh();
+
+        for (int16_t i = 0; i <= full->GetRoot(); i++) {
+            SCOPED_TRACE(i);
+            ASSERT_EQ(refit->GetNode(i).fFlags, full->GetNode(i).fFlags) << "node " << i;
+            ICheckSameBounds(refit->GetNode(i).fWorldBounds, full->GetNode(i).fWorldBounds);
+        }
+        ICheckTree(*refit);
+    }
+    EXPECT_EQ(refit->GetRebuildSerial(), 0u);
+}
+
+TEST_F(plSpaceTreeTest, RebuildKeepsEveryLeaf)
+{
+    plSpaceTree::SetRebuildThreshold(1.5f);
+
+    std::unique_ptr<plSpaceTree> tree(IMakeTree(fLeaves));
+    tree->Refresh();
+
+    // Scattering leaves across a much bigger space wrecks the original split.
+    uint32_t rebuilds = 0;
+    for (int pass = 0; pass < 20; pass++) {
+        uint32_t serial = tree->GetRebuildSerial();
+        IMoveLeaves(tree.get(), kRange * 10.f);
+        tree->Refresh();
+        if (tree->GetRebuildSerial() != serial) {
+            rebuilds++;
+            EXPECT_LE(tree->GetQuality(), 1.f + 1.e-4f);
+        }
+        ICheckTree(*tree);
+    }
+    EXPECT_GT(rebuilds, 0u);
+}
+
+TEST_F(plSpaceTreeTest, HarvestUnchangedByRefitAndRebuild)
+{
+    std::unique_ptr<plSpaceTree> tree(IMakeTree(fLeaves));
+    tree->Refresh();
+
+    std::vector<plSphereIsect> spheres = IMakeSpheres(50);
+    std::vector<std::vector<int16_t>> before;
+    for (plSphereIsect& sphere : spheres)
+        before.emplace_back(IHarvest(*tree, sphere));
+
+    const std::vector<hsBounds3Ext> initial = fLeaves;
+
+    // Refit: move things around, then put them back
+    plSpaceTree::SetRebuildThreshold(0.f);
+    IMoveLeaves(tree.get(), kRange);
+    tree->Refresh();
+    for (size_t i = 0; i < kNumLeaves; i++) {
+        fLeaves[i] = initial[i];
+        tree->MoveLeaf(int16_t(i), fLeaves[i]);
+    }
+    tree->Refresh();
+    ASSERT_EQ(tree->GetRebuildSerial(), 0u);
+    for (size_t i = 0; i < spheres.size(); i++)
+        EXPECT_EQ(IHarvest(*tree, spheres[i]), before[i]) << "sphere " << i;
+
+    // Rebuild: any dirty node sends this over the threshold
+    plSpaceTree::SetRebuildThreshold(0.01f);
+    tree->MoveLeaf(0, fLeaves[0]);
+    tree->Refresh();
+    ASSERT_EQ(tree->GetRebuildSerial(), 1u);
+    ICheckTree(*tree);
+    for (size_t i = 0; i < spheres.size(); i++)
+        EXPECT_EQ(IHarvest(*tree, spheres[i]), before[i]) << "sphere " << i;
+}
+
+TEST_F(plSpaceTreeTest, HotCullMatchesFullBounds)
+{
+    std::unique_ptr<plSpaceTree> tree(IMakeTree(fLeaves));
+    tree->Refresh();
+
+    // Some leaves end up with empty bounds, and so empty hot boxes. Those still
+    // have to reach Test(), like they do on the full bounds path.
+    plSpaceTree::SetRebuildThreshold(0.f);
+    IMoveLeaves(tree.get(), kRange);
+    tree->Refresh();
+
+    hsBitVector cache;
+    for (size_t i = 0; i < kNumLeaves; i++) {
+        if (fRng() % 2)
+            tree->EnableLeaf(int16_t(i), cache);
+    }
+
+    size_t emptyHarvested = 0;
+    std::vector<std::unique_ptr<plVolumeIsect>> volumes = IMakeVolumes(500);
+    for (size_t i = 0; i < volumes.size(); i++) {
+        SCOPED_TRACE(i);
+
+        plSpaceTree::SetHotCulling(false);
+        std::vector<int16_t> full = IHarvest(*tree, *volumes[i]);
+        std::vector<int16_t> fullEnabled = IHarvestEnabled(*tree, *volumes[i], cache);
+
+        plSpaceTree::SetHotCulling(true);
+        EXPECT_EQ(IHarvest(*tree, *volumes[i]), full);
+        EXPECT_EQ(IHarvestEnabled(*tree, *volumes[i], cache), fullEnabled);
+
+        for (int16_t leaf : full) {
+            if (fLeaves[leaf].GetType() != kBoundsNormal)
+                emptyHarvested++;
+        }
+    }
+    EXPECT_GT(emptyHarvested, 0u);
+}
+
+// Two thin rods at right angles, each turned 45 degrees about its length, one
+// just above the other. Only the cross of their lengths separates them, which
+// neither box's own axes show, but their world boxes miss each other.
+TEST(plSpaceTree, HotCullMatchesFullBoundsOnSkewBoxes)
+{
+    hsPoint3 mins(-5.f, -0.1f, -0.1f);
+    hsPoint3 maxs(5.f, 0.1f, 0.1f);
+    hsBounds3Ext rodX;
+    rodX.Reset(&mins);
+    rodX.Union(&maxs);
+
+    hsMatrix44 l2w;
+    l2w.MakeRotateMat(0, hsConstants::pi<float> * 0.25f);
+    rodX.Transform(&l2w);
+
+    mins.Set(-0.1f, -5.f, -0.1f);
+    maxs.Set(0.1f, 5.f, 0.1f);
+    hsBounds3Ext rodY;
+    rodY.Reset(&mins);
+    rodY.Union(&maxs);
+
+    l2w.MakeRotateMat(1, hsConstants::pi<float> * 0.25f);
+    l2w.fMap[2][3] = 0.5f;
+    rodY.Transform(&l2w);
+
+    plBoundsIsect isect;
+    isect.SetBounds(rodY);
+    EXPECT_EQ(isect.Test(rodX), kVolumeCulled);
+
+    // A far away leaf keeps the rod from being the whole tree.
+    mins.Set(50.f, 50.f, 50.f);
+    maxs.Set(51.f, 51.f, 51.f);
+    hsBounds3Ext other;
+    other.Reset(&mins);
+    other.Union(&maxs);
+
+    plSpaceTreeMaker maker;
+    maker.Reset();
+    maker.AddLeaf(rodX);
+    maker.AddLeaf(other);
+    std::unique_ptr<plSpaceTree> tree(maker.MakeTree());
+
+    std::vector<int16_t> hot, full;
+    tree->HarvestLeaves(&isect, hot);
+    plSpaceTree::SetHotCulling(false);
+    tree->HarvestLeaves(&isect, full);
+    plSpaceTree::SetHotCulling(true);
+
+    EXPECT_TRUE(hot.empty());
+    EXPECT_EQ(hot, full);
+}
+
+TEST_F(plSpaceTreeTest, HotCullMatchesFullBoundsInFrusta)
+{
+    std::unique_ptr<plSpaceTree> tree(IMakeTree(fLeaves));
+    tree->Refresh();
+
+    plSpaceTree::SetRebuildThreshold(0.f);
+    IMoveLeaves(tree.get(), kRange);
+    tree->Refresh();
+
+    hsBitVector cache;
+    for (size_t i = 0; i < kNumLeaves; i++) {
+        if (fRng() % 2)
+            tree->EnableLeaf(int16_t(i), cache);
+    }
+
+    size_t harvested = 0;
+    plCullTree cull;
+    for (int i = 0; i < 500; i++) {
+        SCOPED_TRACE(i);
+        IRandomFrustum(cull, kRange);
+        tree->SetCache(i % 2 ? &cache : nullptr);
+
+        std::vector<int16_t> full, hot;
+        plSpaceTree::SetHotCulling(false);
+        cull.Harvest(tree.get(), full);
+        plSpaceTree::SetHotCulling(true);
+        cull.Harvest(tree.get(), hot);
+
+        EXPECT_EQ(hot, full);
+        harvested += full.size();
+    }
+    tree->SetCache(nullptr);
+    EXPECT_GT(harvested, 0u);
+}
+
+// Not run by default, use --gtest_also_run_disabled_tests.
+TEST_F(plSpaceTreeTest, DISABLED_HotCullBenchmark)
+{
+    // About as many spans as a big age's drawables
+    const size_t kNumBigLeaves = 8000;
+    const float kBigRange = kRange * 10.f;
+    const size_t kNumCulls = 64;
+    const int kReps = 50;
+
+    plSpaceTreeMaker maker;
+    maker.Reset();
+    for (size_t i = 0; i < kNumBigLeaves; i++)
+        maker.AddLeaf(IRandomBounds(kBigRange), fRng() % 10 == 0);
+    std::unique_ptr<plSpaceTree> tree(maker.MakeTree());
+    tree->Refresh();
+
+    std::vector<std::unique_ptr<plCullTree>> frusta;
+    for (size_t i = 0; i < kNumCulls; i++) {
+        frusta.emplace_back(new plCullTree);
+        IRandomFrustum(*frusta.back(), kBigRange);
+    }
+    std::vector<plSphereIsect> spheres = IMakeSpheres(kNumCulls);
+
+    auto time = [&](auto harvest) {
+        std::vector<int16_t> list;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kReps; i++) {
+            for (size_t j = 0; j < kNumCulls; j++) {
+                list.clear();
+                harvest(j, list);
+            }
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::micro>(elapsed).count() / (kReps * kNumCulls);
+    };
+
+    for (bool hot : { false, true }) {
+        plSpaceTree::SetHotCulling(hot);
+        double frustum = time([&](size_t j, std::vector<int16_t>& list) { frusta[j]->Harvest(tree.get(), list); });
+        double sphere = time([&](size_t j, std::vector<int16_t>& list) { tree->HarvestLeaves(&spheres[j], list); });
+        printf("%s: frustum harvest %8.2f us, sphere harvest %8.2f us\n",
+               hot ? "hot nodes  " : "full bounds", frustum, sphere);
+    }
+}
@@ -0,0 +1,252 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include "plGImage/hsCodecManager.h"
+#include "plGImage/hsDXTSoftwareCodec.h"
+#include "plGImage/plMipmap.h"
+
+#include "hsCpuID.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+
+// Smooth gradients with some noise on top, which is where the endpoint fit
+// makes a visible difference
+static std::unique_ptr<plMipmap> IMakeTestImage(uint32_t width, uint32_t height, bool alpha)
+{
+    auto image = std::make_unique<plMipmap>(width, height, plMipmap::kARGB32Config, 1);
+    if (alpha)
+        image->SetFlags(image->GetFlags() | plMipmap::kAlphaChannelFlag);
+
+    std::mt19937 rng(7);
+    uint32_t* pixels = static_cast<uint32_t*>(image->GetImage());
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            uint32_t r = (x + rng() % 24) & 0xff;
+            uint32_t g = (2 * y + rng() % 16) & 0xff;
+            uint32_t b = ((x ^ y) + rng() % 32) & 0xff;
+            uint32_t a = alpha ? (x + y) & 0xff : 0xff;
+            pixels[y * width + x] = (a << 24) | (r << 16) | (g << 8) | b;
+        }
+    }
+    return image;
+}
+
+// PSNR of the color channels after a round trip through the codec
+static double IRoundTripPSNR(plMipmap* source, hsDXTSoftwareCodec::Quality quality, double* compressMs = nullptr)
+{
+    hsDXTSoftwareCodec& codec = hsDXTSoftwareCodec::Instance();
+
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<plMipmap> compressed(codec.CreateCompressedMipmap(source, quality));
+    if (compressMs)
+        *compressMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_TRUE(compressed);
+    if (!compressed)
+        return 0.0;
+
+    std::unique_ptr<plMipmap> decoded(codec.CreateUncompressedMipmap(compressed.get(), hsCodecManager::k32BitDepth));
+    EXPECT_TRUE(decoded);
+    if (!decoded)
+        return 0.0;
+
+    const uint32_t numPixels = source->GetWidth() * source->GetHeight();
+    const uint32_t* srcPixels = static_cast<const uint32_t*>(source->GetImage());
+    const uint32_t* outPixels = static_cast<const uint32_t*>(decoded->GetImage());
+    double squaredError = 0.0;
+    for (uint32_t i = 0; i < numPixels; i++) {
+        for (uint32_t shift = 0; shift < 24; shift += 8) {
+            double diff = double((srcPixels[i] >> shift) & 0xff) - double((outPixels[i] >> shift) & 0xff);
+            squaredError += diff * diff;
+        }
+    }
+
+    double mse = squaredError / (numPixels * 3);
+    return mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+TEST(hsDXTSoftwareCodec, HighQualityIsNoWorseThanFast)
+{
+    hsDXTSoftwareCodec::Init();
+
+    for (bool alpha : { false, true }) {
+        std::unique_ptr<plMipmap> source = IMakeTestImage(64, 64, alpha);
+
+        double fast = IRoundTripPSNR(source.get(), hsDXTSoftwareCodec::kQualityFast);
+        double high = IRoundTripPSNR(source.get(), hsDXTSoftwareCodec::kQualityHigh);
+        EXPECT_GE(high, fast) << (alpha ? "DXT5" : "DXT1");
+    }
+}
+
+TEST(hsDXTSoftwareCodec, DefaultIsFastQuality)
+{
+    hsDXTSoftwareCodec::Init();
+    hsDXTSoftwareCodec& codec = hsDXTSoftwareCodec::Instance();
+
+    std::unique_ptr<plMipmap> source = IMakeTestImage(32, 32, false);
+    std::unique_ptr<plMipmap> byDefault(codec.CreateCompressedMipmap(source.get()));
+    std::unique_ptr<plMipmap> fast(codec.CreateCompressedMipmap(source.get(), hsDXTSoftwareCodec::kQualityFast));
+    ASSERT_TRUE(byDefault);
+    ASSERT_TRUE(fast);
+    ASSERT_EQ(byDefault->GetLevelSize(0), fast->GetLevelSize(0));
+    EXPECT_EQ(0, memcmp(byDefault->GetImage(), fast->GetImage(), fast->GetLevelSize(0)));
+}
+
+// Gets at the decoders without going through the CPU dispatcher
+class hsTestDXTSoftwareCodec : public hsDXTSoftwareCodec
+{
+public:
+    using hsDXTSoftwareCodec::IUncompressMipmapDXT1To32FPU;
+    using hsDXTSoftwareCodec::IUncompressMipmapDXT5To32FPU;
+    using hsDXTSoftwareCodec::IUncompressMipmapDXT1To32SSSE3;
+    using hsDXTSoftwareCodec::IUncompressMipmapDXT5To32SSSE3;
+};
+
+static bool IHaveSSSE3()
+{
+#ifdef HAVE_SSSE3
+    return hsCpuId::Instance().has_ssse3;
+#else
+    return false;
+#endif
+}
+
+// Random blocks, with the endpoints ordered so that both color modes and
+// both alpha modes show up, including equal endpoints.
+static std::unique_ptr<plMipmap> IMakeRandomBlocks(uint32_t width, uint32_t height, uint8_t format)
+{
+    auto compressed = std::make_unique<plMipmap>(width, height, plMipmap::kARGB32Config, 1,
+                                                 plMipmap::kDirectXCompression, format);
+    const uint32_t blockSize = compressed->fDirectXInfo.fBlockSize;
+    const uint32_t numBlocks = (width / 4) * (height / 4);
+    uint8_t* blocks = static_cast<uint8_t*>(compressed->GetImage());
+
+    std::mt19937 rng(format);
+    for (uint32_t i = 0; i < numBlocks; i++) {
+        uint8_t* block = blocks + i * blockSize;
+        for (uint32_t j = 0; j < blockSize; j++)
+            block[j] = uint8_t(rng());
+
+        uint8_t* color = block;
+        if (format == plMipmap::DirectXInfo::kDXT5) {
+            // alpha0 > alpha1 interpolates six values, otherwise four plus 0 and 255
+            uint8_t lo = std::min(block[0], block[1]);
+            uint8_t hi = std::max(block[0], block[1]);
+            switch (i % 3) {
+            case 0: block[0] = hi; block[1] = lo; break;
+            case 1: block[0] = lo; block[1] = hi; break;
+            case 2: block[1] = block[0]; break;
+            }
+            color = block + 8;
+        }
+
+        // color0 <= color1 is the three color mode with transparent black in DXT1
+        uint16_t c0 = color[0] | (color[1] << 8);
+        uint16_t c1 = color[2] | (color[3] << 8);
+        switch (i % 4) {
+        case 0: if (c0 < c1) std::swap(c0, c1); break;
+        case 1: if (c0 > c1) std::swap(c0, c1); break;
+        case 2: c1 = c0; break;
+        }
+        color[0] = uint8_t(c0);
+        color[1] = uint8_t(c0 >> 8);
+        color[2] = uint8_t(c1);
+        color[3] = uint8_t(c1 >> 8);
+    }
+    return compressed;
+}
+
+TEST(hsDXTSoftwareCodec, SSSE3DecodersMatchFPU)
+{
+    if (!IHaveSSSE3())
+        GTEST_SKIP() << "No SSSE3 here";
+
+    hsDXTSoftwareCodec::Init();
+
+    for (uint8_t format : { plMipmap::DirectXInfo::kDXT1, plMipmap::DirectXInfo::kDXT5 }) {
+        std::unique_ptr<plMipmap> compressed = IMakeRandomBlocks(64, 32, format);
+        compressed->SetCurrLevel(0);
+
+        plMipmap fpu(64, 32, plMipmap::kARGB32Config, 1);
+        plMipmap ssse3(64, 32, plMipmap::kARGB32Config, 1);
+        memset(fpu.GetImage(), 0xcd, fpu.GetLevelSize(0));
+        memset(ssse3.GetImage(), 0x5a, ssse3.GetLevelSize(0));
+
+        if (format == plMipmap::DirectXInfo::kDXT1) {
+            hsTestDXTSoftwareCodec::IUncompressMipmapDXT1To32FPU(&fpu, compressed.get());
+            hsTestDXTSoftwareCodec::IUncompressMipmapDXT1To32SSSE3(&ssse3, compressed.get());
+        } else {
+            hsTestDXTSoftwareCodec::IUncompressMipmapDXT5To32FPU(&fpu, compressed.get());
+            hsTestDXTSoftwareCodec::IUncompressMipmapDXT5To32SSSE3(&ssse3, compressed.get());
+        }
+
+        const uint32_t* fpuPixels = static_cast<const uint32_t*>(fpu.GetImage());
+        const uint32_t* ssse3Pixels = static_cast<const uint32_t*>(ssse3.GetImage());
+        for (uint32_t i = 0; i < 64 * 32; i++)
+            ASSERT_EQ(fpuPixels[i], ssse3Pixels[i]) << (format == plMipmap::DirectXInfo::kDXT1 ? "DXT1" : "DXT5")
+                                                    << " pixel " << i % 64 << "," << i / 64;
+    }
+}
+
+// Not run by default, use --gtest_also_run_disabled_tests.
+TEST(hsDXTSoftwareCodec, DISABLED_BenchmarkQuality)
+{
+    hsDXTSoftwareCodec::Init();
+
+    for (bool alpha : { false, true }) {
+        std::unique_ptr<plMipmap> source = IMakeTestImage(1024, 1024, alpha);
+
+        for (auto quality : { hsDXTSoftwareCodec::kQualityFast, hsDXTSoftwareCodec::kQualityHigh }) {
+            double ms = 0.0;
+            double psnr = IRoundTripPSNR(source.get(), quality, &ms);
+            printf("%s %-4s: %8.2f ms, %6.2f dB\n", alpha ? "DXT5" : "DXT1",
+                   quality == hsDXTSoftwareCodec::kQualityFast ? "fast" : "high", ms, psnr);
+        }
+    }
+}
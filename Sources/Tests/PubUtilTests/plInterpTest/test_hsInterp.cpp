@@ -0,0 +1,130 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include "plInterp/hsInterp.h"
+
+#include <vector>
+
+static std::vector<hsScalarKey> IMakeKeys()
+{
+    // Uneven spacing, with a repeated frame in the middle
+    const uint16_t frames[] = { 0, 3, 4, 10, 10, 25, 26, 40, 90, 91 };
+
+    std::vector<hsScalarKey> keys;
+    for (uint16_t frame : frames) {
+        hsScalarKey key;
+        key.fFrame = frame;
+        key.fValue = float(frame);
+        keys.emplace_back(key);
+    }
+    return keys;
+}
+
+static void ICheckBoundary(const std::vector<hsScalarKey>& keys, float time,
+                           hsKeyFrame* k1, hsKeyFrame* k2, uint32_t idx, float p)
+{
+    float frame = time * MAX_FRAMES_PER_SEC;
+    if (frame > keys.back().fFrame) {
+        EXPECT_EQ(&keys.back(), k1);
+        EXPECT_EQ(k1, k2);
+        EXPECT_EQ(0.f, p);
+    } else if (frame < keys.front().fFrame) {
+        EXPECT_EQ(&keys.front(), k1);
+        EXPECT_EQ(k1, k2);
+        EXPECT_EQ(0.f, p);
+    } else {
+        ASSERT_LT(idx + 1, keys.size());
+        EXPECT_EQ(&keys[idx], k1);
+        EXPECT_EQ(&keys[idx + 1], k2);
+        EXPECT_LE(k1->fFrame, frame);
+        EXPECT_GE(k2->fFrame, frame);
+        EXPECT_GE(p, 0.f);
+        EXPECT_LE(p, 1.f);
+    }
+}
+
+TEST(hsInterp, GetBoundaryKeyFramesPlayback)
+{
+    std::vector<hsScalarKey> keys = IMakeKeys();
+
+    for (bool forwards : { true, false }) {
+        uint32_t idx = 0;
+        for (int step = 0; step <= 400; ++step) {
+            float frame = forwards ? step * 0.25f : 100.f - step * 0.25f;
+            float time = frame / MAX_FRAMES_PER_SEC;
+
+            hsKeyFrame *k1, *k2;
+            float p;
+            hsInterp::GetBoundaryKeyFrames(time, uint32_t(keys.size()), keys.data(), sizeof(hsScalarKey),
+                                           &k1, &k2, &idx, &p, forwards);
+            ICheckBoundary(keys, time, k1, k2, idx, p);
+        }
+    }
+}
+
+TEST(hsInterp, GetBoundaryKeyFramesSeek)
+{
+    std::vector<hsScalarKey> keys = IMakeKeys();
+
+    // Jump around with stale hints, including ones that are out of range
+    const float frames[] = { 95.f, 50.f, 0.f, 91.f, 10.f, 3.5f, 89.f, 26.f, 10.f, -1.f, 25.5f };
+    const uint32_t hints[] = { 0, 3, 8, 9, 42 };
+    for (uint32_t hint : hints) {
+        for (float frame : frames) {
+            float time = frame / MAX_FRAMES_PER_SEC;
+            uint32_t idx = hint;
+
+            hsKeyFrame *k1, *k2;
+            float p;
+            hsInterp::GetBoundaryKeyFrames(time, uint32_t(keys.size()), keys.data(), sizeof(hsScalarKey),
+                                           &k1, &k2, &idx, &p, true);
+            ICheckBoundary(keys, time, k1, k2, idx, p);
+
+            float value;
+            hsInterp::LinInterp(((hsScalarKey*)k1)->fValue, ((hsScalarKey*)k2)->fValue, p, &value);
+            if (frame >= 0.f && frame <= 91.f)
+                EXPECT_NEAR(frame, value, 0.001f);
+        }
+    }
+}
@@ -0,0 +1,276 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include "plInterp/hsInterp.h"
+#include "plInterp/plAffineKeyProgram.h"
+#include "plInterp/plController.h"
+#include "plTransform/hsAffineParts.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+static const uint16_t kFrames[] = { 0, 4, 5, 12, 12, 30, 31, 47, 90 };
+static const uint32_t kNumKeys = sizeof(kFrames) / sizeof(kFrames[0]);
+
+static hsQuat IRandomQuat(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+    hsQuat quat(dist(rng), dist(rng), dist(rng), dist(rng));
+    quat.Normalize();
+    return quat;
+}
+
+static hsPoint3 IRandomPoint(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> dist(-10.f, 10.f);
+    return hsPoint3(dist(rng), dist(rng), dist(rng));
+}
+
+// A pos/rot/scale controller like the exporter makes, with random keys.
+// Neighboring rotations land on both sides of the 90 degree flip.
+static std::unique_ptr<plCompoundController> IMakeController(std::mt19937& rng, bool bezier)
+{
+    plLeafController* pos = new plLeafController;
+    plLeafController* rot = new plLeafController;
+    plLeafController* scale = new plLeafController;
+    pos->AllocKeys(kNumKeys, bezier ? hsKeyFrame::kBezPoint3KeyFrame : hsKeyFrame::kPoint3KeyFrame);
+    rot->AllocKeys(kNumKeys, hsKeyFrame::kQuatKeyFrame);
+    scale->AllocKeys(kNumKeys, bezier ? hsKeyFrame::kBezScaleKeyFrame : hsKeyFrame::kScaleKeyFrame);
+
+    for (uint32_t i = 0; i < kNumKeys; i++) {
+        hsScaleValue scaleValue;
+        scaleValue.fS.Set(1.f + i * 0.1f, 2.f - i * 0.1f, 1.f);
+        scaleValue.fQ = IRandomQuat(rng);
+
+        if (bezier) {
+            hsBezPoint3Key* posKey = pos->GetBezPoint3Key(i);
+            posKey->fFrame = kFrames[i];
+            posKey->fValue = IRandomPoint(rng);
+            posKey->fInTan = IRandomPoint(rng) * 0.001f;
+            posKey->fOutTan = IRandomPoint(rng) * 0.001f;
+
+            hsBezScaleKey* scaleKey = scale->GetBezScaleKey(i);
+            scaleKey->fFrame = kFrames[i];
+            scaleKey->fValue = scaleValue;
+            scaleKey->fInTan = IRandomPoint(rng) * 0.001f;
+            scaleKey->fOutTan = IRandomPoint(rng) * 0.001f;
+        } else {
+            hsPoint3Key* posKey = pos->GetPoint3Key(i);
+            posKey->fFrame = kFrames[i];
+            posKey->fValue = IRandomPoint(rng);
+
+            hsScaleKey* scaleKey = scale->GetScaleKey(i);
+            scaleKey->fFrame = kFrames[i];
+            scaleKey->fValue = scaleValue;
+        }
+
+        hsQuatKey* rotKey = rot->GetQuatKey(i);
+        rotKey->fFrame = kFrames[i];
+        rotKey->fValue = IRandomQuat(rng);
+    }
+
+    auto controller = std::make_unique<plCompoundController>();
+    controller->SetPosController(pos);
+    controller->SetRotController(rot);
+    controller->SetScaleController(scale);
+    return controller;
+}
+
+static void IExpectPartsNear(const hsAffineParts& expected, const hsAffineParts& actual, float time)
+{
+    const float kTolerance = 1e-5f;
+    EXPECT_NEAR(expected.fT.fX, actual.fT.fX, kTolerance) << "time " << time;
+    EXPECT_NEAR(expected.fT.fY, actual.fT.fY, kTolerance) << "time " << time;
+    EXPECT_NEAR(expected.fT.fZ, actual.fT.fZ, kTolerance) << "time " << time;
+    EXPECT_NEAR(expected.fQ.fX, actual.fQ.fX, kTolerance) << "time " << time;
+    EXPECT_NEAR(expected.fQ.fY, actual.fQ.fY, kTolerance) << "time " << time;
+    EXPECT_NEAR(expected.fQ.fZ, actual.fQ.fZ, kTolerance) << "time " << time;
+    EXPECT_NEAR(expected.fQ.fW, actual.fQ.fW, kTolerance) << "time " << time;
+    EXPECT_NEAR(expected.fU.fX, actual.fU.fX, kTolerance) << "time " << time;
+    EXPECT_NEAR(expected.fU.fY, actual.fU.fY, kTolerance) << "time " << time;
+    EXPECT_NEAR(expected.fU.fZ, actual.fU.fZ, kTolerance) << "time " << time;
+    EXPECT_NEAR(expected.fU.fW, actual.fU.fW, kTolerance) << "time " << time;
+    EXPECT_NEAR(expected.fK.fX, actual.fK.fX, kTolerance) << "time " << time;
+    EXPECT_NEAR(expected.fK.fY, actual.fK.fY, kTolerance) << "time " << time;
+    EXPECT_NEAR(expected.fK.fZ, actual.fK.fZ, kTolerance) << "time " << time;
+}
+
+TEST(plAffineKeyProgram, MatchesControllerInterp)
+{
+    std::mt19937 rng(1234);
+
+    for (bool bezier : { false, true }) {
+        std::unique_ptr<plCompoundController> controller = IMakeController(rng, bezier);
+        std::unique_ptr<plAffineKeyProgram> program(plAffineKeyProgram::Compile(controller.get()));
+        ASSERT_TRUE(program);
+
+        // Enough requests for several jobs, each at its own time, including
+        // times before, after and exactly on the keys
+        std::vector<float> times;
+        for (int i = -10; i <= 100; i++)
+            times.push_back(i / MAX_FRAMES_PER_SEC);
+        for (int i = 0; i < 300; i++)
+            times.push_back(std::uniform_real_distribution<float>(-0.5f, 3.5f)(rng));
+
+        std::vector<plAffineKeyProgram::State> states(times.size());
+        std::vector<hsAffineParts> results(times.size());
+        std::vector<plAffineKeyProgram::Request> requests;
+        for (size_t i = 0; i < times.size(); i++)
+            requests.push_back({ program.get(), &states[i], &results[i], times[i], true });
+
+        plAffineKeyProgram::Evaluate(requests);
+
+        for (size_t i = 0; i < times.size(); i++) {
+            hsAffineParts expected;
+            controller->Interp(times[i], &expected);
+            IExpectPartsNear(expected, results[i], times[i]);
+            EXPECT_TRUE(states[i].IsPreparedAt(times[i]));
+        }
+    }
+}
+
+TEST(plAffineKeyProgram, PlaybackKeepsHints)
+{
+    std::mt19937 rng(99);
+    std::unique_ptr<plCompoundController> controller = IMakeController(rng, false);
+    std::unique_ptr<plAffineKeyProgram> program(plAffineKeyProgram::Compile(controller.get()));
+    ASSERT_TRUE(program);
+
+    // One instance played backwards a frame at a time, like an avatar would be
+    plAffineKeyProgram::State state;
+    hsAffineParts result;
+    for (int frame = 95; frame >= -5; frame--) {
+        float time = frame / MAX_FRAMES_PER_SEC;
+        plAffineKeyProgram::Request request = { program.get(), &state, &result, time, false };
+        plAffineKeyProgram::Evaluate(&request, 1);
+
+        hsAffineParts expected;
+        controller->Interp(time, &expected);
+        IExpectPartsNear(expected, result, time);
+    }
+}
+
+TEST(plAffineKeyProgram, OnlyCompilesLeafKeys)
+{
+    std::mt19937 rng(7);
+
+    // A rotation made of Euler angle curves has to go through Interp
+    std::unique_ptr<plCompoundController> controller = IMakeController(rng, false);
+    plCompoundController* euler = new plCompoundController;
+    for (int i = 0; i < 3; i++) {
+        plLeafController* angle = new plLeafController;
+        angle->AllocKeys(2, hsKeyFrame::kScalarKeyFrame);
+        euler->SetController(i, angle);
+    }
+    controller->SetRotController(euler);
+    EXPECT_FALSE(plAffineKeyProgram::Compile(controller.get()));
+
+    // So does anything that isn't a compound controller at all
+    plLeafController leaf;
+    leaf.AllocKeys(2, hsKeyFrame::kMatrix44KeyFrame);
+    EXPECT_FALSE(plAffineKeyProgram::Compile(&leaf));
+
+    // Missing parts are fine, they're just left alone
+    controller->SetRotController(nullptr);
+    controller->SetScaleController(nullptr);
+    std::unique_ptr<plAffineKeyProgram> program(plAffineKeyProgram::Compile(controller.get()));
+    ASSERT_TRUE(program);
+
+    plAffineKeyProgram::State state;
+    hsAffineParts result;
+    result.fQ.Set(0.f, 0.f, 0.f, 1.f);
+    plAffineKeyProgram::Request request = { program.get(), &state, &result, 0.5f, true };
+    plAffineKeyProgram::Evaluate(&request, 1);
+    EXPECT_EQ(1.f, result.fQ.fW);
+}
+
+// Not run by default, use --gtest_also_run_disabled_tests.
+TEST(plAffineKeyProgram, DISABLED_Benchmark)
+{
+    // Roughly a crowd of avatars, one leaf per bone, all playing along
+    const size_t kLeaves = 2000;
+    const int kFrames = 200;
+
+    std::mt19937 rng(42);
+    std::vector<std::unique_ptr<plCompoundController>> controllers;
+    std::vector<std::unique_ptr<plAffineKeyProgram>> programs;
+    for (size_t i = 0; i < 16; i++) {
+        controllers.push_back(IMakeController(rng, (i & 1) != 0));
+        programs.emplace_back(plAffineKeyProgram::Compile(controllers.back().get()));
+    }
+
+    std::vector<plAffineKeyProgram::State> states(kLeaves);
+    std::vector<hsAffineParts> results(kLeaves);
+    std::vector<plAffineKeyProgram::Request> requests(kLeaves);
+    std::vector<float> offsets(kLeaves);
+    for (size_t i = 0; i < kLeaves; i++)
+        offsets[i] = std::uniform_real_distribution<float>(0.f, 3.f)(rng);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < kFrames; frame++) {
+        for (size_t i = 0; i < kLeaves; i++) {
+            float time = std::fmod(offsets[i] + frame / 60.f, 3.f);
+            controllers[i % controllers.size()]->Interp(time, &results[i]);
+        }
+    }
+    auto interp = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < kFrames; frame++) {
+        for (size_t i = 0; i < kLeaves; i++) {
+            float time = std::fmod(offsets[i] + frame / 60.f, 3.f);
+            requests[i] = { programs[i % programs.size()].get(), &states[i], &results[i], time, true };
+        }
+        plAffineKeyProgram::Evaluate(requests);
+    }
+    auto batched = std::chrono::steady_clock::now() - start;
+
+    printf("%zu leaves: Interp %8.1f us, batched %8.1f us\n", kLeaves,
+           std::chrono::duration<double, std::micro>(interp).count() / kFrames,
+           std::chrono::duration<double, std::micro>(batched).count() / kFrames);
+}
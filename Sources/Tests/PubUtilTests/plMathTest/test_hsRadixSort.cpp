@@ -0,0 +1,257 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include "HeadSpin.h"
+#include "plMath/hsRadixSort.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+typedef hsRadixSortArray::Elem32 Elem32;
+typedef hsRadixSortArray::Elem64 Elem64;
+
+// Bodies are the original index, so stability shows up in the results.
+static std::vector<Elem32> IMakeFloats(size_t count, float lo, float hi, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(lo, hi);
+    std::vector<Elem32> elems(count);
+    for (size_t i = 0; i < count; i++) {
+        elems[i].fKey.fFloat = dist(rng);
+        elems[i].fBody = intptr_t(i);
+    }
+    return elems;
+}
+
+// Sorts with the old linked list hsRadixSort, which everything else has to
+// match, ties and all.
+static void ICheckMatchesList(const std::vector<Elem32>& sorted, const std::vector<Elem32>& elems, uint32_t flags)
+{
+    std::vector<hsRadixSortElem> list(elems.size());
+    for (size_t i = 0; i < elems.size(); i++) {
+        list[i].fKey.fULong = elems[i].fKey.fUInt;
+        list[i].fBody = elems[i].fBody;
+        list[i].fNext = (i + 1 < list.size()) ? &list[i + 1] : nullptr;
+    }
+
+    hsRadixSort listSort;
+    const hsRadixSortElem* head = listSort.Sort(list.data(), flags);
+
+    ASSERT_EQ(sorted.size(), elems.size());
+    for (size_t i = 0; i < sorted.size(); i++) {
+        ASSERT_NE(head, nullptr);
+        ASSERT_EQ(sorted[i].fBody, head->fBody) << "at " << i << " with flags " << flags;
+        head = head->fNext;
+    }
+    EXPECT_EQ(head, nullptr);
+}
+
+template <typename E, typename Less>
+static void ICheckSorted(const std::vector<E>& sorted, std::vector<E> expected, Less less)
+{
+    std::stable_sort(expected.begin(), expected.end(), less);
+    ASSERT_EQ(sorted.size(), expected.size());
+    for (size_t i = 0; i < sorted.size(); i++)
+        ASSERT_EQ(sorted[i].fBody, expected[i].fBody) << "at " << i;
+}
+
+TEST(hsRadixSortArray, Floats)
+{
+    std::vector<Elem32> elems = IMakeFloats(5000, -1000.f, 1000.f, 1);
+    // Plenty of duplicates to check stability
+    for (size_t i = 0; i < elems.size(); i += 7)
+        elems[i].fKey.fFloat = 3.f;
+    for (size_t i = 3; i < elems.size(); i += 11)
+        elems[i].fKey.fFloat = -3.f;
+    std::vector<Elem32> sorted = elems;
+
+    hsRadixSortArray sorter;
+    sorter.Sort(sorted, hsRadixSort::kFloat);
+    ICheckMatchesList(sorted, elems, hsRadixSort::kFloat);
+
+    sorted = elems;
+    sorter.Sort(sorted, hsRadixSort::kFloat | hsRadixSort::kReverse);
+    ICheckMatchesList(sorted, elems, hsRadixSort::kFloat | hsRadixSort::kReverse);
+}
+
+TEST(hsRadixSortArray, Integers)
+{
+    std::mt19937 rng(2);
+    std::vector<Elem32> elems(3000);
+    for (size_t i = 0; i < elems.size(); i++) {
+        elems[i].fKey.fInt = int32_t(rng());
+        elems[i].fBody = intptr_t(i);
+    }
+    std::vector<Elem32> sorted = elems;
+
+    hsRadixSortArray sorter;
+    sorter.Sort(sorted, hsRadixSort::kSignedInt);
+    ICheckSorted(sorted, elems, [](const Elem32& a, const Elem32& b) { return a.fKey.fInt < b.fKey.fInt; });
+
+    sorted = elems;
+    sorter.Sort(sorted, hsRadixSort::kUnsigned);
+    ICheckSorted(sorted, elems, [](const Elem32& a, const Elem32& b) { return a.fKey.fUInt < b.fKey.fUInt; });
+
+    // Small keys only need the low byte pass
+    for (Elem32& elem : elems)
+        elem.fKey.fUInt &= 0xff;
+    sorted = elems;
+    sorter.Sort(sorted, hsRadixSort::kUnsigned);
+    ICheckSorted(sorted, elems, [](const Elem32& a, const Elem32& b) { return a.fKey.fUInt < b.fKey.fUInt; });
+}
+
+TEST(hsRadixSortArray, Wide)
+{
+    std::mt19937_64 rng(3);
+    std::vector<Elem64> elems(3000);
+    for (size_t i = 0; i < elems.size(); i++) {
+        elems[i].fKey.fDouble = double(int64_t(rng())) * 1.e-9;
+        elems[i].fBody = intptr_t(i);
+    }
+    std::vector<Elem64> sorted = elems;
+
+    hsRadixSortArray sorter;
+    sorter.Sort(sorted, hsRadixSort::kFloat);
+    ICheckSorted(sorted, elems, [](const Elem64& a, const Elem64& b) { return a.fKey.fDouble < b.fKey.fDouble; });
+
+    for (Elem64& elem : elems)
+        elem.fKey.fInt = int64_t(rng());
+    sorted = elems;
+    sorter.Sort(sorted, hsRadixSort::kSignedInt | hsRadixSort::kReverse);
+    ICheckSorted(sorted, elems, [](const Elem64& a, const Elem64& b) { return a.fKey.fInt > b.fKey.fInt; });
+}
+
+TEST(hsRadixSortArray, ParallelCounts)
+{
+    std::vector<Elem32> elems = IMakeFloats(100000, -50.f, 50.f, 4);
+    std::vector<Elem32> sorted = elems;
+
+    hsRadixSortArray sorter;
+    sorter.SetParallelThreshold(1024);
+    sorter.Sort(sorted, hsRadixSort::kFloat);
+    ICheckMatchesList(sorted, elems, hsRadixSort::kFloat);
+}
+
+TEST(hsRadixSortArray, MatchesListSort)
+{
+    // Camera distance keys like plPageTreeMgr uses for sorted spans.
+    std::vector<Elem32> elems = IMakeFloats(2000, -1.e4f, 0.f, 5);
+    std::vector<Elem32> sorted = elems;
+
+    hsRadixSortArray sorter;
+    sorter.Sort(sorted, hsRadixSort::kFloat);
+    ICheckMatchesList(sorted, elems, hsRadixSort::kFloat);
+}
+
+TEST(hsRadixSortArray, MatchesListSortWithTies)
+{
+    // Lots of equal keys on both sides of zero, including both zeros, so
+    // the order ties come out in has to match too.
+    std::mt19937 rng(6);
+    std::vector<Elem32> elems(3000);
+    for (size_t i = 0; i < elems.size(); i++) {
+        elems[i].fKey.fFloat = float(int(rng() % 41) - 20) * 0.25f;
+        if (i % 50 == 0)
+            elems[i].fKey.fFloat = (i % 100) ? -0.f : 0.f;
+        elems[i].fBody = intptr_t(i);
+    }
+
+    const uint32_t kFlags[] = {
+        hsRadixSort::kFloat,
+        hsRadixSort::kFloat | hsRadixSort::kReverse,
+        hsRadixSort::kSignedInt,
+        hsRadixSort::kSignedInt | hsRadixSort::kReverse,
+        hsRadixSort::kUnsigned,
+        hsRadixSort::kUnsigned | hsRadixSort::kReverse,
+    };
+
+    hsRadixSortArray sorter;
+    for (uint32_t flags : kFlags) {
+        std::vector<Elem32> sorted = elems;
+        sorter.Sort(sorted, flags);
+        ICheckMatchesList(sorted, elems, flags);
+        if (HasFatalFailure())
+            return;
+    }
+
+    // And again with the counts done in parallel
+    sorter.SetParallelThreshold(1024);
+    std::vector<Elem32> sorted = elems;
+    sorter.Sort(sorted, hsRadixSort::kFloat);
+    ICheckMatchesList(sorted, elems, hsRadixSort::kFloat);
+}
+
+// Not run by default, use --gtest_also_run_disabled_tests.
+TEST(hsRadixSortArray, DISABLED_BenchmarkVsStdSort)
+{
+    const size_t kCounts[] = { 256, 2048, 16384, 131072 };
+    const int kReps = 50;
+
+    hsRadixSortArray sorter;
+    for (size_t count : kCounts) {
+        std::vector<Elem32> elems = IMakeFloats(count, -1.e4f, 0.f, uint32_t(count));
+        std::vector<Elem32> work;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kReps; i++) {
+            work = elems;
+            sorter.Sort(work, hsRadixSort::kFloat);
+        }
+        auto radix = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kReps; i++) {
+            work = elems;
+            std::sort(work.begin(), work.end(), [](const Elem32& a, const Elem32& b) { return a.fKey.fFloat < b.fKey.fFloat; });
+        }
+        auto stdSort = std::chrono::steady_clock::now() - start;
+
+        printf("%7zu spans: radix %8.1f us, std::sort %8.1f us\n", count,
+               std::chrono::duration<double, std::micro>(radix).count() / kReps,
+               std::chrono::duration<double, std::micro>(stdSort).count() / kReps);
+    }
+}
@@ -0,0 +1,290 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include "HeadSpin.h"
+#include "hsGeometry3.h"
+#include "plFileSystem.h"
+
+#include "plPhysX/plPXMeshCache.h"
+
+#include <string_theory/format>
+#include <vector>
+
+// Assorted creatables needed to make it link...
+#include "pnAllCreatables.h"
+#include "plAllCreatables.h"
+#include "pfAnimation/pfAnimationCreatable.h"
+#include "pfAudio/pfAudioCreatable.h"
+#include "pfCamera/pfCameraCreatable.h"
+#include "pfConditional/plConditionalObjectCreatable.h"
+#include "pfMessage/pfMessageCreatable.h"
+
+static constexpr uint32_t kSdkVersion = 0x05010000;
+static constexpr uint32_t kHeaderSize = 16;
+static constexpr size_t kEntrySize = 100;
+
+class plPXMeshCacheTest : public ::testing::Test
+{
+protected:
+    plFileName fDir{ "meshcache" };
+
+    void SetUp() override
+    {
+        plFileSystem::CreateDir(fDir);
+        IEmptyDir();
+    }
+
+    void TearDown() override
+    {
+        IEmptyDir();
+    }
+
+    void IEmptyDir()
+    {
+        for (const plFileName& file : plFileSystem::ListDir(fDir))
+            plFileSystem::Unlink(file);
+    }
+
+    std::vector<uint8_t> IMakeData(size_t size, uint8_t seed) const
+    {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; i++)
+            data[i] = uint8_t(seed + i * 7);
+        return data;
+    }
+
+    ST::string IMakeKey(const plPXMeshCache& cache, uint32_t seed) const
+    {
+        std::vector<uint32_t> tris = { 0, 1, 2 };
+        std::vector<hsPoint3> verts = { { 0.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, { float(seed), 1.f, 0.f } };
+        return cache.MakeKey(plPXMeshCache::Kind::kTriangleMesh, tris, verts, nullptr, 0);
+    }
+
+    void IWriteRaw(const plFileName& path, const void* data, size_t size)
+    {
+        FILE* f = plFileSystem::Open(path, "wb");
+        ASSERT_NE(f, nullptr);
+        fwrite(data, 1, size, f);
+        fclose(f);
+    }
+
+    uint64_t IDiskSize() const
+    {
+        uint64_t size = 0;
+        for (const plFileName& entry : plFileSystem::ListDir(fDir, "*.pxm"))
+            size += plFileInfo(entry).FileSize();
+        return size;
+    }
+
+    size_t ICountEntries() const
+    {
+        return plFileSystem::ListDir(fDir, "*.pxm").size();
+    }
+};
+
+TEST_F(plPXMeshCacheTest, KeysDependOnEveryInput)
+{
+    plPXMeshCache cache(fDir, kSdkVersion);
+    plPXMeshCache other(fDir, kSdkVersion + 1);
+
+    std::vector<uint32_t> tris = { 0, 1, 2 };
+    std::vector<hsPoint3> verts = { { 0.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f } };
+    float skin = 0.f;
+    float thick = 1.f;
+
+    ST::string key = cache.MakeKey(plPXMeshCache::Kind::kConvexHull, tris, verts, &skin, sizeof(skin));
+    EXPECT_EQ(key, cache.MakeKey(plPXMeshCache::Kind::kConvexHull, tris, verts, &skin, sizeof(skin)));
+    EXPECT_NE(key, cache.MakeKey(plPXMeshCache::Kind::kTriangleMesh, tris, verts, &skin, sizeof(skin)));
+    EXPECT_NE(key, cache.MakeKey(plPXMeshCache::Kind::kConvexHull, tris, verts, &thick, sizeof(thick)));
+    EXPECT_NE(key, other.MakeKey(plPXMeshCache::Kind::kConvexHull, tris, verts, &skin, sizeof(skin)));
+
+    verts[2].fX = 0.5f;
+    EXPECT_NE(key, cache.MakeKey(plPXMeshCache::Kind::kConvexHull, tris, verts, &skin, sizeof(skin)));
+}
+
+TEST_F(plPXMeshCacheTest, RoundTrip)
+{
+    std::vector<uint8_t> data = IMakeData(kEntrySize, 1);
+    ST::string key;
+    {
+        plPXMeshCache cache(fDir, kSdkVersion);
+        key = IMakeKey(cache, 0);
+        EXPECT_FALSE(cache.Contains(key));
+
+        cache.Store(key, data.data(), data.size());
+        EXPECT_TRUE(cache.Contains(key));
+        EXPECT_EQ(cache.GetSize(), kHeaderSize + data.size());
+        EXPECT_EQ(cache.GetSize(), IDiskSize());
+
+        std::vector<uint8_t> found;
+        EXPECT_TRUE(cache.Find(key, found));
+        EXPECT_EQ(found, data);
+        EXPECT_EQ(cache.GetHits(), 1);
+        EXPECT_EQ(cache.GetMisses(), 0);
+
+        // Storing the same key again replaces the entry rather than adding to it.
+        data = IMakeData(kEntrySize / 2, 2);
+        cache.Store(key, data.data(), data.size());
+        EXPECT_EQ(cache.GetSize(), kHeaderSize + data.size());
+        EXPECT_EQ(cache.GetSize(), IDiskSize());
+        EXPECT_EQ(ICountEntries(), 1);
+    }
+
+    // A fresh cache on the same directory picks the entry back up.
+    plPXMeshCache cache(fDir, kSdkVersion);
+    EXPECT_EQ(cache.GetSize(), kHeaderSize + data.size());
+
+    std::vector<uint8_t> found;
+    EXPECT_TRUE(cache.Find(key, found));
+    EXPECT_EQ(found, data);
+
+    std::vector<uint8_t> missing = { 1, 2, 3 };
+    EXPECT_FALSE(cache.Find(IMakeKey(cache, 1), missing));
+    EXPECT_TRUE(missing.empty());
+    EXPECT_EQ(cache.GetHits(), 1);
+    EXPECT_EQ(cache.GetMisses(), 1);
+
+    cache.Remove(key);
+    EXPECT_FALSE(cache.Contains(key));
+    EXPECT_EQ(cache.GetSize(), 0);
+}
+
+TEST_F(plPXMeshCacheTest, StaleEntriesAreDiscarded)
+{
+    std::vector<uint8_t> data = IMakeData(kEntrySize, 3);
+    ST::string key;
+    {
+        plPXMeshCache cache(fDir, kSdkVersion + 1);
+        key = IMakeKey(cache, 0);
+        cache.Store(key, data.data(), data.size());
+    }
+
+    // Cooked by another SDK version
+    plPXMeshCache cache(fDir, kSdkVersion);
+    EXPECT_EQ(cache.GetSize(), kHeaderSize + data.size());
+
+    std::vector<uint8_t> found;
+    EXPECT_FALSE(cache.Find(key, found));
+    EXPECT_TRUE(found.empty());
+    EXPECT_FALSE(cache.Contains(key));
+    EXPECT_EQ(cache.GetSize(), 0);
+    EXPECT_EQ(cache.GetMisses(), 1);
+
+    // Shorter than a header
+    plFileName path = plFileName::Join(fDir, ST::format("{}.pxm", key));
+    const char shortHeader[] = { 'P', 'X', 'M', 'C', 1, 0 };
+    IWriteRaw(path, shortHeader, sizeof(shortHeader));
+    EXPECT_FALSE(cache.Find(key, found));
+    EXPECT_FALSE(cache.Contains(key));
+    EXPECT_EQ(cache.GetMisses(), 2);
+
+    // Valid header, truncated contents
+    cache.Store(key, data.data(), data.size());
+    std::vector<uint8_t> raw(kHeaderSize + data.size());
+    FILE* f = plFileSystem::Open(path, "rb");
+    ASSERT_NE(f, nullptr);
+    ASSERT_EQ(fread(raw.data(), 1, raw.size(), f), raw.size());
+    fclose(f);
+    IWriteRaw(path, raw.data(), raw.size() - 1);
+    EXPECT_FALSE(cache.Find(key, found));
+    EXPECT_FALSE(cache.Contains(key));
+    EXPECT_EQ(cache.GetMisses(), 3);
+    EXPECT_EQ(cache.GetHits(), 0);
+
+    // The entries were changed behind the cache's back, so only a trim gets the size right again.
+    cache.Trim();
+    EXPECT_EQ(cache.GetSize(), IDiskSize());
+}
+
+TEST_F(plPXMeshCacheTest, KeepsOtherClientsTemporaries)
+{
+    // Another client still writing an entry into the shared directory
+    plFileName tmp = plFileName::Join(fDir, "0123456789abcdef.pxm.1.tmp");
+    const char partial[] = { 'P', 'X' };
+    IWriteRaw(tmp, partial, sizeof(partial));
+
+    plPXMeshCache cache(fDir, kSdkVersion);
+    EXPECT_TRUE(plFileInfo(tmp).Exists());
+    EXPECT_EQ(cache.GetSize(), 0);
+
+    std::vector<uint8_t> data = IMakeData(kEntrySize, 4);
+    cache.Store(IMakeKey(cache, 0), data.data(), data.size());
+    EXPECT_TRUE(plFileInfo(tmp).Exists());
+    EXPECT_EQ(plFileSystem::ListDir(fDir, "*.tmp").size(), 1);
+}
+
+TEST_F(plPXMeshCacheTest, EvictsDownToBudget)
+{
+    constexpr uint64_t kBudget = (kHeaderSize + kEntrySize) * 10;
+    plPXMeshCache cache(fDir, kSdkVersion, kBudget);
+
+    std::vector<uint8_t> data = IMakeData(kEntrySize, 5);
+    for (uint32_t i = 0; i < 30; i++) {
+        SCOPED_TRACE(i);
+        cache.Store(IMakeKey(cache, i), data.data(), data.size());
+        EXPECT_LE(cache.GetSize(), kBudget);
+        EXPECT_EQ(cache.GetSize(), IDiskSize());
+    }
+
+    // Trimming stops at three quarters of the budget and the cache fills back up from there.
+    size_t count = ICountEntries();
+    EXPECT_GE(count, kBudget * 3 / 4 / (kHeaderSize + kEntrySize));
+    EXPECT_LE(count, 10);
+
+    // Shrinking the budget trims immediately.
+    cache.SetBudget(kBudget / 2);
+    EXPECT_LE(cache.GetSize(), kBudget / 2);
+    EXPECT_EQ(cache.GetSize(), IDiskSize());
+
+    // So does reopening the directory with a smaller budget.
+    {
+        plPXMeshCache small(fDir, kSdkVersion, kBudget / 4);
+        EXPECT_LE(small.GetSize(), kBudget / 4);
+        EXPECT_EQ(small.GetSize(), IDiskSize());
+    }
+
+    cache.Clear();
+    EXPECT_EQ(cache.GetSize(), 0);
+    EXPECT_EQ(ICountEntries(), 0);
+}
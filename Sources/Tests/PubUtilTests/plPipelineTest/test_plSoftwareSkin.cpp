@@ -0,0 +1,278 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include "HeadSpin.h"
+#include "hsCpuID.h"
+#include "hsMatrix44.h"
+
+#include "plDrawable/plGBufferGroup.h"
+#include "plPipeline/plSoftwareSkin.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Three weights, packed indices and one UVW, like an avatar's body
+static constexpr uint8_t kFormat = plGBufferGroup::kSkin3Weights | plGBufferGroup::kSkinIndices | 1;
+static constexpr uint32_t kSrcStride = sizeof(float) * 3 + sizeof(float) * 3 + sizeof(uint32_t)
+                                     + sizeof(float) * 3 + sizeof(uint32_t) * 2 + sizeof(float) * 3;
+static constexpr uint32_t kDestStride = sizeof(float) * 3 + sizeof(float) * 3
+                                      + sizeof(uint32_t) * 2 + sizeof(float) * 3;
+static constexpr size_t kPaletteSize = 48;
+
+// Gets at the kernels without going through the CPU dispatcher
+class plTestSoftwareSkin : public plSoftwareSkin
+{
+public:
+    using plSoftwareSkin::IBlendSpanFPU;
+    using plSoftwareSkin::IBlendSpanSSE2;
+};
+
+struct plTestSkinData
+{
+    std::vector<hsMatrix44> fPalette;
+    std::vector<uint8_t> fSrc;
+    std::vector<uint8_t> fDest;
+    uint32_t fCount;
+
+    plTestSkinData(uint32_t count, uint32_t seed)
+        : fPalette(kPaletteSize), fSrc(count * kSrcStride), fDest(count * kDestStride), fCount(count)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+
+        for (hsMatrix44& mat : fPalette) {
+            mat.Reset(false);
+            for (int r = 0; r < 3; r++) {
+                for (int c = 0; c < 4; c++)
+                    mat.fMap[r][c] = dist(rng);
+            }
+        }
+
+        for (uint32_t i = 0; i < count; i++) {
+            uint8_t* src = fSrc.data() + i * kSrcStride;
+            float pos[3] = { dist(rng), dist(rng), dist(rng) };
+            float weights[3] = { std::abs(dist(rng)) * 0.5f, std::abs(dist(rng)) * 0.3f, std::abs(dist(rng)) * 0.2f };
+            uint32_t indices = 0;
+            for (int j = 0; j < 4; j++)
+                indices |= (rng() % kPaletteSize) << (j * 8);
+            float norm[3] = { dist(rng), dist(rng), dist(rng) };
+            uint32_t tail[5];
+            for (uint32_t& t : tail)
+                t = uint32_t(rng());
+
+            memcpy(src, pos, sizeof(pos));
+            memcpy(src + 12, weights, sizeof(weights));
+            memcpy(src + 24, &indices, sizeof(indices));
+            memcpy(src + 28, norm, sizeof(norm));
+            memcpy(src + 40, tail, sizeof(tail));
+        }
+    }
+
+    plSoftwareSkin::Span GetSpan(uint32_t first, uint32_t count)
+    {
+        plSoftwareSkin::Span span;
+        span.fPalette = fPalette.data();
+        span.fLocalToWorld = fPalette[0];
+        span.fSrc = fSrc.data() + first * kSrcStride;
+        span.fDest = fDest.data() + first * kDestStride;
+        span.fSrcStride = kSrcStride;
+        span.fDestStride = kDestStride;
+        span.fCount = count;
+        span.fFormat = kFormat;
+        span.fCopyColorsAndUVs = true;
+        return span;
+    }
+};
+
+static bool IHaveSSE2()
+{
+#ifdef HAVE_SSE2
+    return hsCpuId::Instance().has_sse2;
+#else
+    return false;
+#endif
+}
+
+// The SSE2 kernel adds things up in a different order, so allow for a little rounding.
+static void ICompareVerts(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        const uint8_t* va = a.data() + i * kDestStride;
+        const uint8_t* vb = b.data() + i * kDestStride;
+
+        float fa[6], fb[6];
+        memcpy(fa, va, sizeof(fa));
+        memcpy(fb, vb, sizeof(fb));
+        for (int j = 0; j < 6; j++)
+            ASSERT_NEAR(fa[j], fb[j], 1.e-4f) << "vert " << i << " component " << j;
+
+        ASSERT_EQ(memcmp(va + sizeof(fa), vb + sizeof(fb), kDestStride - sizeof(fa)), 0) << "vert " << i;
+    }
+}
+
+TEST(plSoftwareSkin, SSE2MatchesFPU)
+{
+    if (!IHaveSSE2())
+        GTEST_SKIP() << "No SSE2 here";
+
+    plTestSkinData data(1000, 1);
+    plTestSoftwareSkin::IBlendSpanFPU(data.GetSpan(0, data.fCount));
+    std::vector<uint8_t> fpu = data.fDest;
+
+    std::fill(data.fDest.begin(), data.fDest.end(), 0);
+    plTestSoftwareSkin::IBlendSpanSSE2(data.GetSpan(0, data.fCount));
+    ICompareVerts(fpu, data.fDest, data.fCount);
+}
+
+TEST(plSoftwareSkin, ThreadedMatchesSerial)
+{
+    // Enough verts in the spans to be chopped into several jobs
+    const uint32_t kSpanSizes[] = { 5000, 37, 2048, 1 };
+
+    uint32_t total = 0;
+    for (uint32_t size : kSpanSizes)
+        total += size;
+
+    plTestSkinData data(total, 2);
+    plSoftwareSkin::BlendSpan(data.GetSpan(0, total));
+    std::vector<uint8_t> serial = data.fDest;
+
+    std::fill(data.fDest.begin(), data.fDest.end(), 0);
+    plSoftwareSkin skin;
+    uint32_t first = 0;
+    for (uint32_t size : kSpanSizes) {
+        skin.AddSpan(data.GetSpan(first, size));
+        first += size;
+    }
+    skin.Blend();
+    EXPECT_EQ(skin.GetNumSpans(), 0u);
+
+    // Same kernel either way, so these should match exactly
+    EXPECT_EQ(memcmp(serial.data(), data.fDest.data(), serial.size()), 0);
+}
+
+TEST(plSoftwareSkin, SharedPaletteKeepsEachLocalToWorld)
+{
+    // Two spans on the same palette, with different local to worlds, like
+    // the pipeline sees when a drawable's spans share a base matrix
+    const uint32_t kSpanSize = 1000;
+    plTestSkinData data(kSpanSize * 2, 3);
+
+    hsMatrix44 l2w[2];
+    for (int s = 0; s < 2; s++) {
+        l2w[s].Reset(false);
+        for (int r = 0; r < 3; r++)
+            l2w[s].fMap[r][3] = float(s * 10 + r + 1);
+    }
+
+    // What the pipeline used to do, set entry 0 and blend right away
+    for (int s = 0; s < 2; s++) {
+        data.fPalette[0] = l2w[s];
+        plSoftwareSkin::Span span = data.GetSpan(s * kSpanSize, kSpanSize);
+        plSoftwareSkin::BlendSpan(span);
+    }
+    std::vector<uint8_t> serial = data.fDest;
+
+    // Now batch them up, with entry 0 left at whatever was written last
+    std::fill(data.fDest.begin(), data.fDest.end(), 0);
+    plSoftwareSkin skin;
+    for (int s = 0; s < 2; s++) {
+        data.fPalette[0] = l2w[s];
+        skin.AddSpan(data.GetSpan(s * kSpanSize, kSpanSize));
+    }
+    skin.Blend();
+    EXPECT_EQ(memcmp(serial.data(), data.fDest.data(), serial.size()), 0);
+
+    // Make sure entry 0 was actually used, or the above proves nothing
+    plSoftwareSkin::Span span = data.GetSpan(0, kSpanSize);
+    span.fLocalToWorld = l2w[1];
+    plSoftwareSkin::BlendSpan(span);
+    EXPECT_NE(memcmp(serial.data(), data.fDest.data(), kSpanSize * kDestStride), 0);
+}
+
+// Not run by default, use --gtest_also_run_disabled_tests.
+TEST(plSoftwareSkin, DISABLED_Benchmark)
+{
+    // Roughly one avatar's worth of verts per span
+    const size_t kNumSpans[] = { 1, 4, 16, 64 };
+    const uint32_t kVertsPerSpan = 6000;
+    const int kReps = 20;
+
+    for (size_t numSpans : kNumSpans) {
+        plTestSkinData data(uint32_t(numSpans) * kVertsPerSpan, uint32_t(numSpans));
+
+        auto time = [&](auto blend) {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < kReps; i++)
+                blend();
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            return std::chrono::duration<double, std::micro>(elapsed).count() / kReps;
+        };
+
+        double fpu = time([&] {
+            for (size_t s = 0; s < numSpans; s++)
+                plTestSoftwareSkin::IBlendSpanFPU(data.GetSpan(uint32_t(s) * kVertsPerSpan, kVertsPerSpan));
+        });
+        double sse2 = 0.;
+        if (IHaveSSE2()) {
+            sse2 = time([&] {
+                for (size_t s = 0; s < numSpans; s++)
+                    plTestSoftwareSkin::IBlendSpanSSE2(data.GetSpan(uint32_t(s) * kVertsPerSpan, kVertsPerSpan));
+            });
+        }
+        double pooled = time([&] {
+            plSoftwareSkin skin;
+            for (size_t s = 0; s < numSpans; s++)
+                skin.AddSpan(data.GetSpan(uint32_t(s) * kVertsPerSpan, kVertsPerSpan));
+            skin.Blend();
+        });
+
+        printf("%3zu spans: FPU %9.1f us, SSE2 %9.1f us, best kernel on the thread pool %9.1f us\n",
+               numSpans, fpu, sse2, pooled);
+    }
+}